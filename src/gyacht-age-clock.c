@@ -0,0 +1,464 @@
+/* gyacht-age-clock.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-age-clock.h"
+#include "gyacht-debug.h"
+
+#include <glib/gi18n.h>
+
+/* Keeps "3 minutes ago" labels current with a single timer for a list.
+ *
+ * Each row remembers its text and when that text changes next. The timer
+ * fires at the earliest of these times among the rows on screen, and then
+ * only the rows on screen whose time has come are rendered again. Rows
+ * scrolled into view are caught up once scrolling settles. The timer is
+ * stopped while the list is unmapped or its window is minimized.
+ */
+
+#define AGE_DATA  "age-data"
+
+#define MINUTE    (60)
+#define HOUR      (60 * MINUTE)
+#define DAY       (24 * HOUR)
+#define MONTH     (30 * DAY)
+
+typedef struct
+{
+  gint64  time;
+  gint64  next_change;
+  gchar   *text;
+} AgeData;
+
+struct _GyachtAgeClock
+{
+  GObject             parent_instance;
+
+  GtkListBox          *list_box;
+  GyachtAgeClockFunc  func;
+  gpointer            user_data;
+
+  GtkAdjustment       *vadjustment;
+  GtkWidget           *toplevel;
+  gboolean            running;
+
+  guint               timeout_id;
+  gint64              wakeup;     /* When timeout_id fires, in seconds */
+  guint               idle_id;
+};
+
+G_DEFINE_TYPE (GyachtAgeClock, gyacht_age_clock, G_TYPE_OBJECT)
+
+
+static void
+internal_age_data_free (gpointer data)
+{
+  AgeData *age = data;
+
+  g_free (age->text);
+  g_free (age);
+}
+
+static gint64
+internal_now (void)
+{
+  return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+static void
+internal_schedule (GyachtAgeClock *self,
+                   gint64          next_change,
+                   gint64          now);
+
+/* Renders @row again if its text is due, and lowers @next_change to when
+ * it is due next.
+ */
+static void
+internal_update_row (GyachtAgeClock *self,
+                     GtkListBoxRow  *row,
+                     gint64          now,
+                     gint64         *next_change)
+{
+  AgeData *age = g_object_get_data (G_OBJECT (row), AGE_DATA);
+
+  if (age == NULL)
+    return;
+
+  if (now >= age->next_change)
+    {
+      g_autofree gchar *text = gyacht_age_format (age->time, now, &age->next_change);
+
+      if (g_strcmp0 (text, age->text) != 0)
+        {
+          g_free (age->text);
+          age->text = g_steal_pointer (&text);
+          self->func (row, age->text, self->user_data);
+        }
+    }
+
+  *next_change = MIN (*next_change, age->next_change);
+}
+
+static void
+internal_refresh (GyachtAgeClock *self)
+{
+  GtkWidget *scrolled;
+  GtkListBoxRow *row;
+  gint64 now = internal_now ();
+  gint64 next_change = G_MAXINT64;
+  gint top, bottom;
+  gint x, y;
+  gint index_;
+
+  scrolled = gtk_widget_get_ancestor (GTK_WIDGET (self->list_box), GTK_TYPE_SCROLLED_WINDOW);
+  if (scrolled == NULL ||
+      !gtk_widget_translate_coordinates (GTK_WIDGET (self->list_box), scrolled, 0, 0, &x, &y))
+    return;
+
+  /* The part of the list box on screen */
+  top = MAX (0, -y);
+  bottom = -y + gtk_widget_get_allocated_height (scrolled);
+
+  row = gtk_list_box_get_row_at_y (self->list_box, top);
+  for (index_ = row ? gtk_list_box_row_get_index (row) : 0;
+       row;
+       row = gtk_list_box_get_row_at_index (self->list_box, ++index_))
+    {
+      gint row_y;
+
+      if (!gtk_widget_get_child_visible (GTK_WIDGET (row)))
+        continue;
+
+      if (!gtk_widget_translate_coordinates (GTK_WIDGET (row), GTK_WIDGET (self->list_box),
+                                             0, 0, NULL, &row_y) ||
+          row_y > bottom)
+        break;
+
+      internal_update_row (self, row, now, &next_change);
+    }
+
+  gyacht_trace ("Next age change in %" G_GINT64_FORMAT "s", next_change - now);
+
+  internal_schedule (self, next_change, now);
+}
+
+/* Any row changing before the next wakeup reschedules it */
+static void
+internal_clear_timeout (GyachtAgeClock *self)
+{
+  if (self->timeout_id != 0)
+    {
+      g_source_remove (self->timeout_id);
+      self->timeout_id = 0;
+    }
+  self->wakeup = G_MAXINT64;
+}
+
+static gboolean
+internal_timeout_cb (gpointer user_data)
+{
+  GyachtAgeClock *self = GYACHT_AGE_CLOCK (user_data);
+
+  self->timeout_id = 0;
+  self->wakeup = G_MAXINT64;
+  internal_refresh (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+internal_schedule (GyachtAgeClock *self,
+                   gint64          next_change,
+                   gint64          now)
+{
+  internal_clear_timeout (self);
+
+  if (!self->running || next_change == G_MAXINT64)
+    return;
+
+  self->wakeup = MAX (next_change, now + 1);
+  self->timeout_id = g_timeout_add_seconds_full (G_PRIORITY_LOW,
+                                                 self->wakeup - now,
+                                                 internal_timeout_cb,
+                                                 self,
+                                                 NULL);
+}
+
+static gboolean
+internal_idle_cb (gpointer user_data)
+{
+  GyachtAgeClock *self = GYACHT_AGE_CLOCK (user_data);
+
+  self->idle_id = 0;
+  internal_refresh (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+internal_queue_refresh (GyachtAgeClock *self)
+{
+  if (self->running && self->idle_id == 0)
+    self->idle_id = g_idle_add_full (G_PRIORITY_LOW, internal_idle_cb, self, NULL);
+}
+
+static void
+internal_set_running (GyachtAgeClock *self,
+                      gboolean        running)
+{
+  if (self->running == running)
+    return;
+
+  self->running = running;
+
+  if (running)
+    {
+      internal_queue_refresh (self);
+      return;
+    }
+
+  internal_clear_timeout (self);
+  if (self->idle_id != 0)
+    {
+      g_source_remove (self->idle_id);
+      self->idle_id = 0;
+    }
+}
+
+static gboolean
+internal_window_state_cb (GtkWidget           *toplevel,
+                          GdkEventWindowState *event,
+                          GyachtAgeClock      *self)
+{
+  internal_set_running (self,
+                        !(event->new_window_state & (GDK_WINDOW_STATE_ICONIFIED |
+                                                     GDK_WINDOW_STATE_WITHDRAWN)));
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+internal_disconnect_ancestors (GyachtAgeClock *self)
+{
+  if (self->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (self->vadjustment,
+                                            G_CALLBACK (internal_queue_refresh),
+                                            self);
+      g_clear_object (&self->vadjustment);
+    }
+
+  if (self->toplevel)
+    {
+      g_signal_handlers_disconnect_by_func (self->toplevel,
+                                            G_CALLBACK (internal_window_state_cb),
+                                            self);
+      g_clear_object (&self->toplevel);
+    }
+}
+
+static void
+internal_map_cb (GtkWidget      *list_box,
+                 GyachtAgeClock *self)
+{
+  GtkWidget *scrolled;
+  GtkWidget *toplevel;
+
+  internal_disconnect_ancestors (self);
+
+  scrolled = gtk_widget_get_ancestor (list_box, GTK_TYPE_SCROLLED_WINDOW);
+  if (scrolled)
+    {
+      self->vadjustment = g_object_ref (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (scrolled)));
+      g_signal_connect_swapped (self->vadjustment,
+                                "value-changed",
+                                G_CALLBACK (internal_queue_refresh),
+                                self);
+    }
+
+  toplevel = gtk_widget_get_toplevel (list_box);
+  if (GTK_IS_WINDOW (toplevel))
+    {
+      self->toplevel = g_object_ref (toplevel);
+      g_signal_connect (self->toplevel,
+                        "window-state-event",
+                        G_CALLBACK (internal_window_state_cb),
+                        self);
+    }
+
+  internal_set_running (self, TRUE);
+}
+
+static void
+internal_unmap_cb (GtkWidget      *list_box,
+                   GyachtAgeClock *self)
+{
+  internal_set_running (self, FALSE);
+  internal_disconnect_ancestors (self);
+}
+
+/* --- GObject --- */
+static void
+gyacht_age_clock_finalize (GObject *object)
+{
+  GyachtAgeClock *self = GYACHT_AGE_CLOCK (object);
+
+  internal_set_running (self, FALSE);
+  internal_disconnect_ancestors (self);
+
+  g_signal_handlers_disconnect_by_func (self->list_box, G_CALLBACK (internal_map_cb), self);
+  g_signal_handlers_disconnect_by_func (self->list_box, G_CALLBACK (internal_unmap_cb), self);
+  g_clear_object (&self->list_box);
+
+  G_OBJECT_CLASS (gyacht_age_clock_parent_class)->finalize (object);
+}
+
+static void
+gyacht_age_clock_class_init (GyachtAgeClockClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_age_clock_finalize;
+}
+
+static void
+gyacht_age_clock_init (GyachtAgeClock *self)
+{
+  self->running = FALSE;
+  self->timeout_id = 0;
+  self->wakeup = G_MAXINT64;
+  self->idle_id = 0;
+}
+
+/* --- Public APIs --- */
+/**
+ * gyacht_age_format:
+ * @time: a unix time
+ * @now: the current unix time
+ * @next_change: (out): when the text changes next, or %G_MAXINT64
+ *
+ * Return value: (transfer full): How long ago @time is, or its date once
+ *   it is older than a month.
+ */
+gchar *
+gyacht_age_format (gint64  time,
+                   gint64  now,
+                   gint64 *next_change)
+{
+  g_autoptr(GDateTime) date = NULL;
+  gint64 age = now - time;
+  gint64 n;
+
+  if (age < MINUTE)
+    {
+      *next_change = time + MINUTE;
+      return g_strdup (_("Just now"));
+    }
+
+  if (age < HOUR)
+    {
+      n = age / MINUTE;
+      *next_change = time + (n + 1) * MINUTE;
+      return g_strdup_printf (ngettext ("%d minute ago", "%d minutes ago", n), (gint) n);
+    }
+
+  if (age < DAY)
+    {
+      n = age / HOUR;
+      *next_change = time + (n + 1) * HOUR;
+      return g_strdup_printf (ngettext ("%d hour ago", "%d hours ago", n), (gint) n);
+    }
+
+  if (age < MONTH)
+    {
+      n = age / DAY;
+      *next_change = time + (n + 1) * DAY;
+      return g_strdup_printf (ngettext ("%d day ago", "%d days ago", n), (gint) n);
+    }
+
+  *next_change = G_MAXINT64;
+
+  date = g_date_time_new_from_unix_local (time);
+  return g_date_time_format (date, _("%B %e, %Y"));
+}
+
+/**
+ * gyacht_age_clock_new:
+ * @list_box: the #GtkListBox whose rows show ages
+ * @func: sets the text of a row
+ * @user_data: user data for @func
+ *
+ * Return value: (transfer full): A new #GyachtAgeClock.
+ */
+GyachtAgeClock *
+gyacht_age_clock_new (GtkListBox         *list_box,
+                      GyachtAgeClockFunc  func,
+                      gpointer            user_data)
+{
+  GyachtAgeClock *self;
+
+  g_return_val_if_fail (GTK_IS_LIST_BOX (list_box), NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  self = g_object_new (GYACHT_TYPE_AGE_CLOCK, NULL);
+  self->list_box = g_object_ref (list_box);
+  self->func = func;
+  self->user_data = user_data;
+
+  g_signal_connect (list_box, "map", G_CALLBACK (internal_map_cb), self);
+  g_signal_connect (list_box, "unmap", G_CALLBACK (internal_unmap_cb), self);
+  if (gtk_widget_get_mapped (GTK_WIDGET (list_box)))
+    internal_map_cb (GTK_WIDGET (list_box), self);
+
+  return self;
+}
+
+/**
+ * gyacht_age_clock_add_row:
+ * @self: a #GyachtAgeClock
+ * @row: a new #GtkListBoxRow
+ * @time: (nullable): what @row shows the age of
+ *
+ * Sets the text of @row right away and keeps it current from then on.
+ */
+void
+gyacht_age_clock_add_row (GyachtAgeClock  *self,
+                          GtkListBoxRow   *row,
+                          const GDateTime *time)
+{
+  gint64 now = internal_now ();
+  AgeData *age;
+
+  g_return_if_fail (GYACHT_IS_AGE_CLOCK (self));
+  g_return_if_fail (GTK_IS_LIST_BOX_ROW (row));
+
+  if (time == NULL)
+    return;
+
+  age = g_new0 (AgeData, 1);
+  age->time = g_date_time_to_unix ((GDateTime *) time);
+  age->text = gyacht_age_format (age->time, now, &age->next_change);
+  g_object_set_data_full (G_OBJECT (row), AGE_DATA, age, internal_age_data_free);
+
+  self->func (row, age->text, self->user_data);
+
+  /* Whether it is on screen is only known once it is allocated */
+  if (self->running && age->next_change < self->wakeup)
+    internal_schedule (self, age->next_change, now);
+}
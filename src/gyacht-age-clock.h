@@ -0,0 +1,45 @@
+/* gyacht-age-clock.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef void (*GyachtAgeClockFunc) (GtkListBoxRow *row,
+                                    const gchar   *text,
+                                    gpointer       user_data);
+
+#define GYACHT_TYPE_AGE_CLOCK (gyacht_age_clock_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtAgeClock, gyacht_age_clock, GYACHT, AGE_CLOCK, GObject)
+
+gchar *           gyacht_age_format         (gint64              time,
+                                             gint64              now,
+                                             gint64             *next_change);
+GyachtAgeClock *  gyacht_age_clock_new      (GtkListBox         *list_box,
+                                             GyachtAgeClockFunc  func,
+                                             gpointer            user_data);
+void              gyacht_age_clock_add_row  (GyachtAgeClock     *self,
+                                             GtkListBoxRow      *row,
+                                             const GDateTime    *time);
+
+G_END_DECLS
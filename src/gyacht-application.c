@@ -22,7 +22,11 @@
 
 #include "gyacht-application.h"
 #include "gyacht-debug.h"
+#include "gyacht-layer-verify.h"
 #include "gyacht-macros.h"
+#include "gyacht-path-finder.h"
+#include "gyacht-service.h"
+#include "gyacht-storage-check.h"
 #include "gyacht-window.h"
 
 #include <glib/gi18n.h>
@@ -32,16 +36,43 @@ struct _GyachtApplication
   GtkApplication  parent_instance;
 
   GtkWidget       *window;
+
+  /* Shared by every view, but owned by them. They are weak pointers which
+   * are cleared when the last view drops its reference.
+   */
+  GyachtContainerService  *container_service;
+  GyachtImageService      *image_service;
+  GyachtLayerService      *layer_service;
+  GyachtMountService      *mount_service;
+  GyachtReclaimIndex      *reclaim_index;
+  GyachtDiskUsage         *disk_usage;
+  GyachtPathIndex         *path_index;
 };
 
 G_DEFINE_TYPE (GyachtApplication, gyacht_application, GTK_TYPE_APPLICATION)
 
+/* Lines of the report dialogs */
+#define REPORT_LINES_SHOWN  500
+
 /* Forward declarations */
 static void
 internal_application_show_about (GSimpleAction *, GVariant *, gpointer);
+static void
+internal_application_check_storage (GSimpleAction *, GVariant *, gpointer);
+static void
+internal_application_verify_layers (GSimpleAction *, GVariant *, gpointer);
+static void
+internal_application_find_path (GSimpleAction *, GVariant *, gpointer);
 
 static const GActionEntry gyacht_application_entries[] = {
-    { "about", internal_application_show_about }
+    { "about", internal_application_show_about },
+    { "check-storage", internal_application_check_storage },
+    { "verify-layers", internal_application_verify_layers },
+    { "find-path", internal_application_find_path },
+    /* Toggled by the default handler, views follow its state */
+    { "compact-rows", NULL, NULL, "true", NULL },
+    { "sort-by", NULL, "s", "'default'", NULL },
+    { "group-by", NULL, "s", "'none'", NULL }
 };
 
 
@@ -69,7 +100,349 @@ internal_application_show_about (GSimpleAction *simple,
                          NULL);
 }
 
+/* @lines are the first of @n_items, listed below @detail; NULL for a
+ * dialog with no list.
+ */
+static void
+internal_show_report (GyachtApplication *self,
+                      GtkMessageType     type,
+                      const gchar       *title,
+                      const gchar       *detail,
+                      GPtrArray         *lines,
+                      guint              n_items)
+{
+  g_autoptr(GString) list = NULL;
+  GtkWidget *dialog;
+  GtkWidget *scrolled;
+  GtkWidget *label;
+  guint i;
+
+  dialog = gtk_message_dialog_new (GTK_WINDOW (self->window),
+                                   GTK_DIALOG_DESTROY_WITH_PARENT,
+                                   type,
+                                   GTK_BUTTONS_CLOSE,
+                                   "%s", title);
+  if (detail)
+    gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+                                              "%s", detail);
+  g_signal_connect (dialog, "response", G_CALLBACK (gtk_widget_destroy), NULL);
+
+  if (lines == NULL)
+    {
+      gtk_widget_show (dialog);
+      return;
+    }
+
+  list = g_string_new (NULL);
+  for (i = 0; i < lines->len; i++)
+    {
+      g_string_append (list, g_ptr_array_index (lines, i));
+      g_string_append_c (list, '\n');
+    }
+  if (n_items > lines->len)
+    g_string_append_printf (list, _("and %u more"), n_items - lines->len);
+
+  label = gtk_label_new (list->str);
+  gtk_label_set_selectable (GTK_LABEL (label), TRUE);
+  gtk_label_set_xalign (GTK_LABEL (label), 0);
+  gtk_label_set_yalign (GTK_LABEL (label), 0);
+
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_min_content_height (GTK_SCROLLED_WINDOW (scrolled), 200);
+  gtk_scrolled_window_set_min_content_width (GTK_SCROLLED_WINDOW (scrolled), 500);
+  gtk_container_add (GTK_CONTAINER (scrolled), label);
+  gtk_widget_show_all (scrolled);
+  gtk_box_pack_start (GTK_BOX (gtk_message_dialog_get_message_area (GTK_MESSAGE_DIALOG (dialog))),
+                      scrolled, TRUE, TRUE, 0);
+
+  gtk_widget_show (dialog);
+}
+
+static void
+internal_storage_checked_cb (GObject      *source_object,
+                             GAsyncResult *res,
+                             gpointer      user_data)
+{
+  g_autoptr(GyachtApplication) self = user_data;
+  g_autoptr(GyachtStorageReport) report = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) lines = NULL;
+  g_autofree gchar *total = NULL;
+  g_autofree gchar *title = NULL;
+  GAction *action;
+  guint n_orphans;
+  guint i;
+
+  action = g_action_map_lookup_action (G_ACTION_MAP (self), "check-storage");
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (action), TRUE);
+
+  report = gyacht_storage_check_finish (res, &error);
+  if (report == NULL)
+    {
+      internal_show_report (self, GTK_MESSAGE_ERROR,
+                            _("Unable to check the storage"), error->message,
+                            NULL, 0);
+      return;
+    }
+
+  n_orphans = gyacht_storage_report_get_n_orphans (report);
+  if (n_orphans == 0)
+    {
+      internal_show_report (self, GTK_MESSAGE_INFO,
+                            _("No orphaned storage found"), NULL,
+                            NULL, 0);
+      return;
+    }
+
+  total = g_format_size (gyacht_storage_report_get_total_size (report));
+  title = g_strdup_printf (ngettext ("%u orphaned entry uses %s",
+                                     "%u orphaned entries use %s",
+                                     n_orphans),
+                           n_orphans, total);
+
+  /* The largest come first */
+  lines = g_ptr_array_new_with_free_func (g_free);
+  for (i = 0; i < MIN (n_orphans, REPORT_LINES_SHOWN); i++)
+    {
+      g_autofree gchar *size = g_format_size (gyacht_storage_report_get_orphan_size (report, i));
+
+      g_ptr_array_add (lines, g_strdup_printf ("%s\t%s",
+                                               size,
+                                               gyacht_storage_report_get_orphan_path (report, i)));
+    }
+
+  internal_show_report (self, GTK_MESSAGE_WARNING,
+                        title, _("No layer or container record refers to them."),
+                        lines, n_orphans);
+}
+
+/* Orphans are looked for once all the records are loaded */
+static void
+internal_application_check_storage (GSimpleAction *simple,
+                                    GVariant      *parameter,
+                                    gpointer       user_data)
+{
+  GyachtApplication *self = GYACHT_APPLICATION (user_data);
+  g_autoptr(GyachtLayerService) layers = NULL;
+  g_autoptr(GyachtContainerService) containers = NULL;
+  g_autoptr(GyachtDiskUsage) disk_usage = NULL;
+
+  g_simple_action_set_enabled (simple, FALSE);
+
+  layers = gyacht_application_dup_layer_service (self);
+  containers = gyacht_application_dup_container_service (self);
+  disk_usage = gyacht_application_dup_disk_usage (self);
+
+  gyacht_storage_check_async (layers,
+                              containers,
+                              disk_usage,
+                              NULL,
+                              internal_storage_checked_cb,
+                              g_object_ref (self));
+}
+
+static void
+internal_layers_verified_cb (GObject      *source_object,
+                             GAsyncResult *res,
+                             gpointer      user_data)
+{
+  g_autoptr(GyachtApplication) self = user_data;
+  g_autoptr(GyachtVerifyReport) report = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) lines = NULL;
+  g_autofree gchar *hashed = NULL;
+  g_autofree gchar *title = NULL;
+  g_autofree gchar *detail = NULL;
+  GAction *action;
+  guint n_verified;
+  guint n_failures;
+  guint i;
+
+  action = g_action_map_lookup_action (G_ACTION_MAP (self), "verify-layers");
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (action), TRUE);
+
+  report = gyacht_layer_verify_finish (res, &error);
+  if (report == NULL)
+    {
+      internal_show_report (self, GTK_MESSAGE_ERROR,
+                            _("Unable to verify the layers"), error->message,
+                            NULL, 0);
+      return;
+    }
+
+  n_verified = gyacht_verify_report_get_n_verified (report);
+  n_failures = gyacht_verify_report_get_n_failures (report);
+  hashed = g_format_size (gyacht_verify_report_get_hashed_size (report));
+
+  if (n_failures == 0)
+    {
+      title = g_strdup_printf (ngettext ("%u layer matches its digest",
+                                         "All %u layers match their digest",
+                                         n_verified),
+                               n_verified);
+      detail = g_strdup_printf (_("%s hashed, %u layers without a digest skipped."),
+                                hashed,
+                                gyacht_verify_report_get_n_skipped (report));
+      internal_show_report (self, GTK_MESSAGE_INFO, title, detail, NULL, 0);
+      return;
+    }
+
+  title = g_strdup_printf (ngettext ("%u of %u layers does not match its digest",
+                                     "%u of %u layers do not match their digest",
+                                     n_failures),
+                           n_failures, n_verified);
+
+  lines = g_ptr_array_new_with_free_func (g_free);
+  for (i = 0; i < MIN (n_failures, REPORT_LINES_SHOWN); i++)
+    g_ptr_array_add (lines, g_strdup_printf ("%s\t%s",
+                                             gyacht_verify_report_get_failure_id (report, i),
+                                             gyacht_verify_report_get_failure_reason (report, i)));
+
+  internal_show_report (self, GTK_MESSAGE_WARNING,
+                        title, _("Their files were changed or lost since they were stored."),
+                        lines, n_failures);
+}
+
+static void
+internal_application_verify_layers (GSimpleAction *simple,
+                                    GVariant      *parameter,
+                                    gpointer       user_data)
+{
+  GyachtApplication *self = GYACHT_APPLICATION (user_data);
+  g_autoptr(GyachtLayerService) layers = NULL;
+
+  g_simple_action_set_enabled (simple, FALSE);
+
+  layers = gyacht_application_dup_layer_service (self);
+  gyacht_layer_verify_async (layers,
+                             NULL,
+                             internal_layers_verified_cb,
+                             g_object_ref (self));
+}
+
+/* The finder keeps the index, and so its mapped layers, while it is open */
+static void
+internal_application_find_path (GSimpleAction *simple,
+                                GVariant      *parameter,
+                                gpointer       user_data)
+{
+  GyachtApplication *self = GYACHT_APPLICATION (user_data);
+  g_autoptr(GyachtPathIndex) index = NULL;
+  GtkWidget *finder;
+
+  index = gyacht_application_dup_path_index (self);
+  finder = gyacht_path_finder_new (index);
+  gtk_window_set_transient_for (GTK_WINDOW (finder), GTK_WINDOW (self->window));
+  gtk_window_present (GTK_WINDOW (finder));
+}
+
+typedef struct
+{
+  GMainLoop *loop;
+  gint      status;
+} FindPathData;
+
+static void
+internal_path_found_cb (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+  FindPathData *data = user_data;
+  g_autoptr(GPtrArray) matches = NULL;
+  g_autoptr(GError) error = NULL;
+  guint i;
+
+  matches = gyacht_path_index_query_finish (GYACHT_PATH_INDEX (source_object), res, &error);
+  if (matches == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      data->status = 2;
+    }
+  else
+    {
+      for (i = 0; i < matches->len; i++)
+        {
+          GyachtPathMatch *match = g_ptr_array_index (matches, i);
+          const gchar *name = gyacht_image_get_name (match->image);
+
+          g_print ("%s\t%s\t%s\n",
+                   name ? name : "<none>",
+                   gyacht_image_get_id (match->image),
+                   gyacht_layer_get_id (match->layer));
+        }
+      data->status = matches->len > 0 ? 0 : 1;
+    }
+
+  g_main_loop_quit (data->loop);
+}
+
+/* Lists the images containing @path, without any window. Exits with 0 if
+ * some do, 1 if none does and 2 on errors, like grep.
+ */
+static gint
+internal_find_path (GyachtApplication *self,
+                    const gchar       *path)
+{
+  g_autoptr(GyachtPathIndex) index = NULL;
+  FindPathData data = { NULL, 2 };
+
+  index = gyacht_application_dup_path_index (self);
+  data.loop = g_main_loop_new (NULL, FALSE);
+
+  gyacht_path_index_query_async (index, path, NULL, internal_path_found_cb, &data);
+  g_main_loop_run (data.loop);
+  g_main_loop_unref (data.loop);
+
+  return data.status;
+}
+
 /* --- GObject --- */
+static void
+gyacht_application_finalize (GObject *object)
+{
+  GyachtApplication *self = GYACHT_APPLICATION (object);
+
+  if (self->container_service)
+    g_object_remove_weak_pointer (G_OBJECT (self->container_service),
+                                  (gpointer *) &self->container_service);
+  if (self->image_service)
+    g_object_remove_weak_pointer (G_OBJECT (self->image_service),
+                                  (gpointer *) &self->image_service);
+  if (self->layer_service)
+    g_object_remove_weak_pointer (G_OBJECT (self->layer_service),
+                                  (gpointer *) &self->layer_service);
+  if (self->mount_service)
+    g_object_remove_weak_pointer (G_OBJECT (self->mount_service),
+                                  (gpointer *) &self->mount_service);
+  if (self->reclaim_index)
+    g_object_remove_weak_pointer (G_OBJECT (self->reclaim_index),
+                                  (gpointer *) &self->reclaim_index);
+  if (self->disk_usage)
+    g_object_remove_weak_pointer (G_OBJECT (self->disk_usage),
+                                  (gpointer *) &self->disk_usage);
+  if (self->path_index)
+    g_object_remove_weak_pointer (G_OBJECT (self->path_index),
+                                  (gpointer *) &self->path_index);
+
+  G_OBJECT_CLASS (gyacht_application_parent_class)->finalize (object);
+}
+
+static gint
+gyacht_application_handle_local_options (GApplication *application,
+                                         GVariantDict *options)
+{
+  const gchar *path;
+
+  if (g_variant_dict_contains (options, "podman-api"))
+    gyacht_service_set_default_source (SOURCE_PODMAN_API);
+
+  if (g_variant_dict_lookup (options, "find-path", "^&ay", &path))
+    return internal_find_path (GYACHT_APPLICATION (application), path);
+
+  /* Go on with the default processing */
+  return -1;
+}
+
 static void
 gyacht_application_startup (GApplication *application)
 {
@@ -99,15 +472,29 @@ gyacht_application_activate (GApplication *application)
 static void
 gyacht_application_class_init (GyachtApplicationClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GApplicationClass *application_class = G_APPLICATION_CLASS (klass);
 
+  object_class->finalize = gyacht_application_finalize;
+
   application_class->startup = gyacht_application_startup;
   application_class->activate = gyacht_application_activate;
+  application_class->handle_local_options = gyacht_application_handle_local_options;
 }
 
 static void
 gyacht_application_init (GyachtApplication *self)
 {
+  g_application_add_main_option (G_APPLICATION (self),
+                                 "podman-api", 0,
+                                 G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE,
+                                 _("Read containers and images from the podman service"),
+                                 NULL);
+  g_application_add_main_option (G_APPLICATION (self),
+                                 "find-path", 0,
+                                 G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME,
+                                 _("Print the images which contain PATH and exit"),
+                                 _("PATH"));
 }
 
 GyachtApplication *
@@ -118,3 +505,198 @@ gyacht_application_new (void)
                        "flags", G_APPLICATION_FLAGS_NONE,
                        NULL);
 }
+
+/**
+ * gyacht_application_dup_container_service:
+ * @self: A #GyachtApplication.
+ *
+ * Every caller shares the same service, and so its loads, monitors and
+ * list. It is created on the first call and finalized once the last
+ * reference is dropped.
+ *
+ * Return value: (transfer full): A #GyachtContainerService.
+ */
+GyachtContainerService *
+gyacht_application_dup_container_service (GyachtApplication *self)
+{
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->container_service)
+    return g_object_ref (self->container_service);
+
+  self->container_service = gyacht_container_service_new (RUN_LEVEL_USER);
+  g_object_add_weak_pointer (G_OBJECT (self->container_service),
+                             (gpointer *) &self->container_service);
+
+  return self->container_service;
+}
+
+/**
+ * gyacht_application_dup_image_service:
+ * @self: A #GyachtApplication.
+ *
+ * See gyacht_application_dup_container_service().
+ *
+ * Return value: (transfer full): A #GyachtImageService.
+ */
+GyachtImageService *
+gyacht_application_dup_image_service (GyachtApplication *self)
+{
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->image_service)
+    return g_object_ref (self->image_service);
+
+  self->image_service = gyacht_image_service_new (RUN_LEVEL_USER);
+  g_object_add_weak_pointer (G_OBJECT (self->image_service),
+                             (gpointer *) &self->image_service);
+
+  return self->image_service;
+}
+
+/**
+ * gyacht_application_dup_layer_service:
+ * @self: A #GyachtApplication.
+ *
+ * See gyacht_application_dup_container_service(). It accounts the images
+ * and containers of the other services, which it keeps alive.
+ *
+ * Return value: (transfer full): A #GyachtLayerService.
+ */
+GyachtLayerService *
+gyacht_application_dup_layer_service (GyachtApplication *self)
+{
+  g_autoptr(GyachtImageService) images = NULL;
+  g_autoptr(GyachtContainerService) containers = NULL;
+
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->layer_service)
+    return g_object_ref (self->layer_service);
+
+  images = gyacht_application_dup_image_service (self);
+  containers = gyacht_application_dup_container_service (self);
+  self->layer_service = gyacht_layer_service_new (RUN_LEVEL_USER, images, containers);
+  g_object_add_weak_pointer (G_OBJECT (self->layer_service),
+                             (gpointer *) &self->layer_service);
+
+  return self->layer_service;
+}
+
+/**
+ * gyacht_application_dup_mount_service:
+ * @self: A #GyachtApplication.
+ *
+ * See gyacht_application_dup_container_service().
+ *
+ * Return value: (transfer full): A #GyachtMountService.
+ */
+GyachtMountService *
+gyacht_application_dup_mount_service (GyachtApplication *self)
+{
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->mount_service)
+    return g_object_ref (self->mount_service);
+
+  self->mount_service = gyacht_mount_service_new (RUN_LEVEL_USER);
+  g_object_add_weak_pointer (G_OBJECT (self->mount_service),
+                             (gpointer *) &self->mount_service);
+
+  return self->mount_service;
+}
+
+/**
+ * gyacht_application_dup_reclaim_index:
+ * @self: A #GyachtApplication.
+ *
+ * The selections of every view add up in the same index, so that what
+ * removing all of them frees is told at once.
+ *
+ * Return value: (transfer full): A #GyachtReclaimIndex.
+ */
+GyachtReclaimIndex *
+gyacht_application_dup_reclaim_index (GyachtApplication *self)
+{
+  g_autoptr(GyachtLayerService) layers = NULL;
+
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->reclaim_index)
+    return g_object_ref (self->reclaim_index);
+
+  layers = gyacht_application_dup_layer_service (self);
+  self->reclaim_index = gyacht_reclaim_index_new (layers);
+  g_object_add_weak_pointer (G_OBJECT (self->reclaim_index),
+                             (gpointer *) &self->reclaim_index);
+
+  return self->reclaim_index;
+}
+
+/**
+ * gyacht_application_peek_reclaim_index:
+ * @self: A #GyachtApplication.
+ *
+ * Return value: (transfer none) (nullable): The #GyachtReclaimIndex if
+ *   a view holds one, without creating it.
+ */
+GyachtReclaimIndex *
+gyacht_application_peek_reclaim_index (GyachtApplication *self)
+{
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  return self->reclaim_index;
+}
+
+/**
+ * gyacht_application_dup_disk_usage:
+ * @self: A #GyachtApplication.
+ *
+ * Every view sizes its directories on the same worker pool, and a tree
+ * scanned by one of them is known to the others.
+ *
+ * Return value: (transfer full): A #GyachtDiskUsage.
+ */
+GyachtDiskUsage *
+gyacht_application_dup_disk_usage (GyachtApplication *self)
+{
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->disk_usage)
+    return g_object_ref (self->disk_usage);
+
+  self->disk_usage = gyacht_disk_usage_new ();
+  g_object_add_weak_pointer (G_OBJECT (self->disk_usage),
+                             (gpointer *) &self->disk_usage);
+
+  return self->disk_usage;
+}
+
+/**
+ * gyacht_application_dup_path_index:
+ * @self: A #GyachtApplication.
+ *
+ * Indexing the layers costs a read of their metadata on the first time,
+ * so it starts on the first lookup of a path rather than with the views.
+ *
+ * Return value: (transfer full): A #GyachtPathIndex.
+ */
+GyachtPathIndex *
+gyacht_application_dup_path_index (GyachtApplication *self)
+{
+  g_autoptr(GyachtLayerService) layers = NULL;
+  g_autoptr(GyachtImageService) images = NULL;
+
+  g_return_val_if_fail (GYACHT_IS_APPLICATION (self), NULL);
+
+  if (self->path_index)
+    return g_object_ref (self->path_index);
+
+  layers = gyacht_application_dup_layer_service (self);
+  images = gyacht_application_dup_image_service (self);
+  self->path_index = gyacht_path_index_new (layers, images);
+  g_object_add_weak_pointer (G_OBJECT (self->path_index),
+                             (gpointer *) &self->path_index);
+
+  return self->path_index;
+}
@@ -22,12 +22,28 @@
 
 #include <gtk/gtk.h>
 
+#include "gyacht-container-service.h"
+#include "gyacht-disk-usage.h"
+#include "gyacht-image-service.h"
+#include "gyacht-layer-service.h"
+#include "gyacht-mount-service.h"
+#include "gyacht-path-index.h"
+#include "gyacht-reclaim-index.h"
+
 G_BEGIN_DECLS
 
 #define GYACHT_TYPE_APPLICATION (gyacht_application_get_type())
 
 G_DECLARE_FINAL_TYPE (GyachtApplication, gyacht_application, GYACHT, APPLICATION, GtkApplication)
 
-GyachtApplication *   gyacht_application_new    (void);
+GyachtApplication *       gyacht_application_new                    (void);
+GyachtContainerService *  gyacht_application_dup_container_service  (GyachtApplication *self);
+GyachtImageService *      gyacht_application_dup_image_service      (GyachtApplication *self);
+GyachtLayerService *      gyacht_application_dup_layer_service      (GyachtApplication *self);
+GyachtMountService *      gyacht_application_dup_mount_service      (GyachtApplication *self);
+GyachtReclaimIndex *      gyacht_application_dup_reclaim_index      (GyachtApplication *self);
+GyachtReclaimIndex *      gyacht_application_peek_reclaim_index     (GyachtApplication *self);
+GyachtDiskUsage *         gyacht_application_dup_disk_usage         (GyachtApplication *self);
+GyachtPathIndex *         gyacht_application_dup_path_index         (GyachtApplication *self);
 
 G_END_DECLS
@@ -0,0 +1,649 @@
+/* gyacht-big-data.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-big-data.h"
+#include "gyacht-debug.h"
+#include "gyacht-path-manager.h"
+
+#include <json-glib/json-glib.h>
+
+/* The big data of an image are the files aside images.json: its
+ * manifest, its signatures and its configuration. None is read before a
+ * view asks for it.
+ *
+ * Decoded configurations are kept in a LRU cache keyed by the digest of
+ * the file rather than by image, since the contents behind a digest never
+ * change and images may share them.
+ */
+
+struct _GyachtImageConfig
+{
+  gint      ref_count;
+
+  gchar     *architecture;
+  gchar     *os;
+  gchar     **entrypoint;
+  gchar     **cmd;
+  GPtrArray *history;   /* GyachtImageHistory */
+};
+
+typedef struct
+{
+  gchar             *digest;
+  GyachtImageConfig *config;    /* NULL while loading */
+  GList             *waiting;   /* GTask */
+  GList             *link;      /* In lru */
+} CacheEntry;
+
+struct _GyachtBigDataCache
+{
+  GObject     parent_instance;
+
+  guint       capacity;
+  GHashTable  *entries;   /* digest -> CacheEntry */
+  GQueue      *lru;       /* CacheEntry, the most recently used first */
+};
+
+G_DEFINE_TYPE (GyachtBigDataCache, gyacht_big_data_cache, G_TYPE_OBJECT)
+
+
+static void
+internal_history_free (gpointer data)
+{
+  GyachtImageHistory *history = data;
+
+  g_free (history->created);
+  g_free (history->created_by);
+  g_free (history->comment);
+  g_free (history);
+}
+
+static void
+internal_cache_entry_free (gpointer data)
+{
+  CacheEntry *entry = data;
+
+  g_free (entry->digest);
+  g_clear_pointer (&entry->config, gyacht_image_config_unref);
+  g_list_free_full (entry->waiting, g_object_unref);
+  g_free (entry);
+}
+
+/* Names made of other characters than [.0-9a-z] are stored base64
+ * encoded, as containers/storage does.
+ */
+static gchar *
+internal_dup_base_name (const gchar *name)
+{
+  g_autofree gchar *encoded = NULL;
+  const gchar *p;
+
+  for (p = name; *p; p++)
+    if (*p != '.' && !g_ascii_isdigit (*p) && !(*p >= 'a' && *p <= 'z'))
+      break;
+
+  if (*p == '\0')
+    return g_strdup (name);
+
+  encoded = g_base64_encode ((const guchar *) name, strlen (name));
+  return g_strconcat ("=", encoded, NULL);
+}
+
+static const gchar *
+internal_get_string_member (JsonObject  *object,
+                            const gchar *member_name)
+{
+  JsonNode *member = json_object_get_member (object, member_name);
+
+  if (member == NULL || json_node_get_value_type (member) != G_TYPE_STRING)
+    return NULL;
+
+  return json_node_get_string (member);
+}
+
+/* Return value: (nullable): The strings of an array, %NULL for null */
+static gchar **
+internal_dup_strv_member (JsonObject  *object,
+                          const gchar *member_name)
+{
+  JsonNode *member = json_object_get_member (object, member_name);
+  JsonArray *array;
+  GPtrArray *strv;
+  guint i;
+
+  if (member == NULL || !JSON_NODE_HOLDS_ARRAY (member))
+    return NULL;
+
+  array = json_node_get_array (member);
+  strv = g_ptr_array_new ();
+  for (i = 0; i < json_array_get_length (array); i++)
+    {
+      const gchar *str = json_array_get_string_element (array, i);
+
+      if (str)
+        g_ptr_array_add (strv, g_strdup (str));
+    }
+  g_ptr_array_add (strv, NULL);
+
+  return (gchar **) g_ptr_array_free (strv, FALSE);
+}
+
+static GyachtImageConfig *
+internal_parse_config (JsonNode  *root,
+                       GError   **error)
+{
+  GyachtImageConfig *config;
+  JsonObject *object;
+  JsonNode *member;
+
+  if (root == NULL || !JSON_NODE_HOLDS_OBJECT (root))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           "The configuration is not an object");
+      return NULL;
+    }
+
+  object = json_node_get_object (root);
+
+  config = g_new0 (GyachtImageConfig, 1);
+  config->ref_count = 1;
+  config->architecture = g_strdup (internal_get_string_member (object, "architecture"));
+  config->os = g_strdup (internal_get_string_member (object, "os"));
+  config->history = g_ptr_array_new_with_free_func (internal_history_free);
+
+  member = json_object_get_member (object, "config");
+  if (member && JSON_NODE_HOLDS_OBJECT (member))
+    {
+      JsonObject *exec = json_node_get_object (member);
+
+      config->entrypoint = internal_dup_strv_member (exec, "Entrypoint");
+      config->cmd = internal_dup_strv_member (exec, "Cmd");
+    }
+
+  member = json_object_get_member (object, "history");
+  if (member && JSON_NODE_HOLDS_ARRAY (member))
+    {
+      JsonArray *array = json_node_get_array (member);
+      guint i;
+
+      for (i = 0; i < json_array_get_length (array); i++)
+        {
+          JsonNode *node = json_array_get_element (array, i);
+          JsonObject *step;
+          GyachtImageHistory *history;
+
+          if (!JSON_NODE_HOLDS_OBJECT (node))
+            continue;
+
+          step = json_node_get_object (node);
+          history = g_new0 (GyachtImageHistory, 1);
+          history->created = g_strdup (internal_get_string_member (step, "created"));
+          history->created_by = g_strdup (internal_get_string_member (step, "created_by"));
+          history->comment = g_strdup (internal_get_string_member (step, "comment"));
+          history->empty_layer = json_object_has_member (step, "empty_layer") &&
+                                 json_object_get_boolean_member (step, "empty_layer");
+          g_ptr_array_add (config->history, history);
+        }
+    }
+
+  return config;
+}
+
+static void
+internal_read_io_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  const gchar *path = task_data;
+  g_autoptr(GError) error = NULL;
+  gchar *contents = NULL;
+  gsize length = 0;
+
+  if (!g_file_get_contents (path, &contents, &length, &error))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  g_task_return_pointer (task,
+                         g_bytes_new_take (contents, length),
+                         (GDestroyNotify) g_bytes_unref);
+}
+
+static void
+internal_config_io_thread (GTask        *task,
+                           gpointer      source_object,
+                           gpointer      task_data,
+                           GCancellable *cancellable)
+{
+  const gchar *path = task_data;
+  g_autoptr(JsonParser) parser = json_parser_new ();
+  g_autoptr(GError) error = NULL;
+  GyachtImageConfig *config;
+
+  if (!json_parser_load_from_file (parser, path, &error))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  config = internal_parse_config (json_parser_get_root (parser), &error);
+  if (config == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  g_task_return_pointer (task, config, (GDestroyNotify) gyacht_image_config_unref);
+}
+
+/* The digest is recorded by recent versions of containers/storage only,
+ * the name of the configuration is its digest anyway.
+ */
+static const gchar *
+internal_get_config_digest (GyachtImage *image)
+{
+  const gchar *name = gyacht_image_get_config_name (image);
+  const gchar *digest;
+
+  if (name == NULL)
+    return NULL;
+
+  digest = gyacht_image_get_big_data_digest (image, name);
+  return digest ? digest : name;
+}
+
+static void
+internal_touch (GyachtBigDataCache *self,
+                CacheEntry         *entry)
+{
+  g_queue_unlink (self->lru, entry->link);
+  g_queue_push_head_link (self->lru, entry->link);
+}
+
+/* Entries which are still loading are never evicted */
+static void
+internal_evict (GyachtBigDataCache *self)
+{
+  GList *link = self->lru->tail;
+
+  while (link && g_hash_table_size (self->entries) > self->capacity)
+    {
+      CacheEntry *entry = link->data;
+      GList *prev = link->prev;
+
+      if (entry->config)
+        {
+          g_queue_delete_link (self->lru, link);
+          g_hash_table_remove (self->entries, entry->digest);
+        }
+
+      link = prev;
+    }
+}
+
+static void
+internal_config_loaded_cb (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  GyachtBigDataCache *self = GYACHT_BIG_DATA_CACHE (source_object);
+  g_autofree gchar *digest = user_data;
+  g_autoptr(GError) error = NULL;
+  GyachtImageConfig *config;
+  CacheEntry *entry;
+  GList *waiting;
+  GList *l;
+
+  config = g_task_propagate_pointer (G_TASK (res), &error);
+
+  entry = g_hash_table_lookup (self->entries, digest);
+  g_assert (entry != NULL && entry->config == NULL);
+
+  waiting = g_steal_pointer (&entry->waiting);
+
+  if (config == NULL)
+    {
+      gyacht_debug ("Unable to load the configuration %s: %s", digest, error->message);
+
+      /* Asking again reads the file again */
+      g_queue_delete_link (self->lru, entry->link);
+      g_hash_table_remove (self->entries, digest);
+
+      for (l = waiting; l; l = l->next)
+        g_task_return_error (l->data, g_error_copy (error));
+      g_list_free_full (waiting, g_object_unref);
+      return;
+    }
+
+  entry->config = config;
+
+  for (l = waiting; l; l = l->next)
+    g_task_return_pointer (l->data,
+                           gyacht_image_config_ref (config),
+                           (GDestroyNotify) gyacht_image_config_unref);
+  g_list_free_full (waiting, g_object_unref);
+
+  internal_evict (self);
+}
+
+/* --- GObject --- */
+static void
+gyacht_big_data_cache_finalize (GObject *object)
+{
+  GyachtBigDataCache *self = GYACHT_BIG_DATA_CACHE (object);
+
+  g_queue_free (self->lru);
+  g_hash_table_unref (self->entries);
+
+  G_OBJECT_CLASS (gyacht_big_data_cache_parent_class)->finalize (object);
+}
+
+static void
+gyacht_big_data_cache_class_init (GyachtBigDataCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_big_data_cache_finalize;
+}
+
+static void
+gyacht_big_data_cache_init (GyachtBigDataCache *self)
+{
+  self->capacity = 0;
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL, internal_cache_entry_free);
+  self->lru = g_queue_new ();
+}
+
+/* --- Public APIs --- */
+GyachtImageConfig *
+gyacht_image_config_ref (GyachtImageConfig *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+  return self;
+}
+
+void
+gyacht_image_config_unref (GyachtImageConfig *self)
+{
+  g_return_if_fail (self != NULL);
+
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_free (self->architecture);
+  g_free (self->os);
+  g_strfreev (self->entrypoint);
+  g_strfreev (self->cmd);
+  g_ptr_array_unref (self->history);
+  g_free (self);
+}
+
+const gchar *
+gyacht_image_config_get_architecture (GyachtImageConfig *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return self->architecture;
+}
+
+const gchar *
+gyacht_image_config_get_os (GyachtImageConfig *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return self->os;
+}
+
+const gchar * const *
+gyacht_image_config_get_entrypoint (GyachtImageConfig *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return (const gchar * const *) self->entrypoint;
+}
+
+const gchar * const *
+gyacht_image_config_get_cmd (GyachtImageConfig *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return (const gchar * const *) self->cmd;
+}
+
+guint
+gyacht_image_config_get_n_history (GyachtImageConfig *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->history->len;
+}
+
+/* Steps are in build order, the oldest first */
+const GyachtImageHistory *
+gyacht_image_config_get_history (GyachtImageConfig *self,
+                                 guint              index)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (index < self->history->len, NULL);
+
+  return g_ptr_array_index (self->history, index);
+}
+
+/**
+ * gyacht_image_dup_big_data_path:
+ * @image: a #GyachtImage
+ * @name: one of the big data names of @image
+ *
+ * Return value: (transfer full): Where the big data @name of @image is
+ *   stored, whether it exists or not.
+ */
+gchar *
+gyacht_image_dup_big_data_path (GyachtImage *image,
+                                const gchar *name)
+{
+  g_autofree gchar *images_dir = NULL;
+  g_autofree gchar *base_name = NULL;
+
+  g_return_val_if_fail (GYACHT_IS_IMAGE (image), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+
+  images_dir = gyacht_dup_user_images_dir ();
+  base_name = internal_dup_base_name (name);
+
+  return g_build_filename (images_dir, gyacht_image_get_id (image), base_name, NULL);
+}
+
+/* Return value: (nullable): The big data name of the configuration, the
+ *   image id being the digest of its configuration.
+ */
+const gchar *
+gyacht_image_get_config_name (GyachtImage *image)
+{
+  const GPtrArray *names;
+  const gchar *fallback = NULL;
+  guint i;
+
+  g_return_val_if_fail (GYACHT_IS_IMAGE (image), NULL);
+
+  names = gyacht_image_get_big_data_names (image);
+  for (i = 0; names && i < names->len; i++)
+    {
+      const gchar *name = g_ptr_array_index ((GPtrArray *) names, i);
+
+      if (!g_str_has_prefix (name, "sha256:"))
+        continue;
+
+      if (g_str_equal (name + strlen ("sha256:"), gyacht_image_get_id (image)))
+        return name;
+
+      if (fallback == NULL)
+        fallback = name;
+    }
+
+  return fallback;
+}
+
+GyachtBigDataCache *
+gyacht_big_data_cache_new (guint capacity)
+{
+  GyachtBigDataCache *self;
+
+  self = g_object_new (GYACHT_TYPE_BIG_DATA_CACHE, NULL);
+  self->capacity = MAX (capacity, 1);
+
+  return self;
+}
+
+/* Reads the big data @name of @image as is, nothing is kept */
+void
+gyacht_big_data_cache_read_async (GyachtBigDataCache  *self,
+                                  GyachtImage         *image,
+                                  const gchar         *name,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (GYACHT_IS_BIG_DATA_CACHE (self));
+  g_return_if_fail (GYACHT_IS_IMAGE (image));
+  g_return_if_fail (name != NULL);
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_big_data_cache_read_async);
+  g_task_set_task_data (task, gyacht_image_dup_big_data_path (image, name), g_free);
+  g_task_run_in_thread (task, internal_read_io_thread);
+}
+
+GBytes *
+gyacht_big_data_cache_read_finish (GyachtBigDataCache  *self,
+                                   GAsyncResult        *res,
+                                   GError             **error)
+{
+  g_return_val_if_fail (GYACHT_IS_BIG_DATA_CACHE (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * gyacht_big_data_cache_lookup_config:
+ * @self: a #GyachtBigDataCache
+ * @image: a #GyachtImage
+ *
+ * Return value: (transfer full) (nullable): The configuration of @image
+ *   if it is decoded already.
+ */
+GyachtImageConfig *
+gyacht_big_data_cache_lookup_config (GyachtBigDataCache *self,
+                                     GyachtImage        *image)
+{
+  const gchar *digest;
+  CacheEntry *entry;
+
+  g_return_val_if_fail (GYACHT_IS_BIG_DATA_CACHE (self), NULL);
+  g_return_val_if_fail (GYACHT_IS_IMAGE (image), NULL);
+
+  digest = internal_get_config_digest (image);
+  if (digest == NULL)
+    return NULL;
+
+  entry = g_hash_table_lookup (self->entries, digest);
+  if (entry == NULL || entry->config == NULL)
+    return NULL;
+
+  internal_touch (self, entry);
+  return gyacht_image_config_ref (entry->config);
+}
+
+void
+gyacht_big_data_cache_load_config_async (GyachtBigDataCache  *self,
+                                         GyachtImage         *image,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  g_autoptr(GTask) load = NULL;
+  const gchar *digest;
+  CacheEntry *entry;
+
+  g_return_if_fail (GYACHT_IS_BIG_DATA_CACHE (self));
+  g_return_if_fail (GYACHT_IS_IMAGE (image));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_big_data_cache_load_config_async);
+
+  digest = internal_get_config_digest (image);
+  if (digest == NULL)
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                               "No configuration is stored with the image %s",
+                               gyacht_image_get_id (image));
+      return;
+    }
+
+  entry = g_hash_table_lookup (self->entries, digest);
+  if (entry && entry->config)
+    {
+      internal_touch (self, entry);
+      g_task_return_pointer (task,
+                             gyacht_image_config_ref (entry->config),
+                             (GDestroyNotify) gyacht_image_config_unref);
+      return;
+    }
+
+  /* Images sharing the configuration wait for the same load */
+  if (entry == NULL)
+    {
+      entry = g_new0 (CacheEntry, 1);
+      entry->digest = g_strdup (digest);
+      g_hash_table_insert (self->entries, entry->digest, entry);
+
+      g_queue_push_head (self->lru, entry);
+      entry->link = self->lru->head;
+
+      load = g_task_new (self, NULL, internal_config_loaded_cb, g_strdup (digest));
+      g_task_set_source_tag (load, internal_config_loaded_cb);
+      g_task_set_task_data (load,
+                            gyacht_image_dup_big_data_path (image,
+                                                            gyacht_image_get_config_name (image)),
+                            g_free);
+      g_task_run_in_thread (load, internal_config_io_thread);
+    }
+
+  entry->waiting = g_list_prepend (entry->waiting, g_steal_pointer (&task));
+}
+
+GyachtImageConfig *
+gyacht_big_data_cache_load_config_finish (GyachtBigDataCache  *self,
+                                          GAsyncResult        *res,
+                                          GError             **error)
+{
+  g_return_val_if_fail (GYACHT_IS_BIG_DATA_CACHE (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
@@ -0,0 +1,82 @@
+/* gyacht-big-data.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "gyacht-image.h"
+
+G_BEGIN_DECLS
+
+/* A step of the build history recorded in the configuration of an image */
+typedef struct
+{
+  gchar     *created;
+  gchar     *created_by;
+  gchar     *comment;
+  gboolean  empty_layer;
+} GyachtImageHistory;
+
+/* What is decoded from the configuration of an image, immutable once loaded */
+typedef struct _GyachtImageConfig GyachtImageConfig;
+
+GyachtImageConfig *         gyacht_image_config_ref               (GyachtImageConfig *self);
+void                        gyacht_image_config_unref             (GyachtImageConfig *self);
+const gchar *               gyacht_image_config_get_architecture  (GyachtImageConfig *self);
+const gchar *               gyacht_image_config_get_os            (GyachtImageConfig *self);
+const gchar * const *       gyacht_image_config_get_entrypoint    (GyachtImageConfig *self);
+const gchar * const *       gyacht_image_config_get_cmd           (GyachtImageConfig *self);
+guint                       gyacht_image_config_get_n_history     (GyachtImageConfig *self);
+const GyachtImageHistory *  gyacht_image_config_get_history       (GyachtImageConfig *self,
+                                                                   guint              index);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtImageConfig, gyacht_image_config_unref)
+
+gchar *             gyacht_image_dup_big_data_path      (GyachtImage *image,
+                                                         const gchar *name);
+const gchar *       gyacht_image_get_config_name        (GyachtImage *image);
+
+#define GYACHT_TYPE_BIG_DATA_CACHE (gyacht_big_data_cache_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtBigDataCache, gyacht_big_data_cache, GYACHT, BIG_DATA_CACHE, GObject)
+
+GyachtBigDataCache *  gyacht_big_data_cache_new                (guint                 capacity);
+void                  gyacht_big_data_cache_read_async         (GyachtBigDataCache   *self,
+                                                                GyachtImage          *image,
+                                                                const gchar          *name,
+                                                                GCancellable         *cancellable,
+                                                                GAsyncReadyCallback   callback,
+                                                                gpointer              user_data);
+GBytes *              gyacht_big_data_cache_read_finish        (GyachtBigDataCache   *self,
+                                                                GAsyncResult         *res,
+                                                                GError              **error);
+GyachtImageConfig *   gyacht_big_data_cache_lookup_config      (GyachtBigDataCache   *self,
+                                                                GyachtImage          *image);
+void                  gyacht_big_data_cache_load_config_async  (GyachtBigDataCache   *self,
+                                                                GyachtImage          *image,
+                                                                GCancellable         *cancellable,
+                                                                GAsyncReadyCallback   callback,
+                                                                gpointer              user_data);
+GyachtImageConfig *   gyacht_big_data_cache_load_config_finish (GyachtBigDataCache   *self,
+                                                                GAsyncResult         *res,
+                                                                GError              **error);
+
+G_END_DECLS
@@ -0,0 +1,346 @@
+/* gyacht-compact-row.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-compact-row.h"
+#include "gyacht-debug.h"
+
+/* A list box row without any child. It draws its texts from cached
+ * PangoLayouts, and the separator above itself when the header function of
+ * the list box asks for one, so a list of thousands of rows costs thousands
+ * of widgets rather than tens of thousands.
+ */
+
+#define ROW_PADDING       6
+#define LINE_SPACING      6
+#define COLUMN_SPACING    12
+#define DIM_ALPHA         0.55
+#define SEPARATOR_ALPHA   0.15
+
+struct _GyachtCompactRow
+{
+  GtkListBoxRow parent_instance;
+
+  gchar         *texts [N_COMPACT_ROW_FIELDS];
+
+  /* Created when first drawn, dropped when the text or the style changes */
+  PangoLayout   *layouts [N_COMPACT_ROW_FIELDS];
+  gint          natural_widths [N_COMPACT_ROW_FIELDS];
+  gint          line_height;
+
+  gboolean      separator;
+};
+
+G_DEFINE_TYPE (GyachtCompactRow, gyacht_compact_row, GTK_TYPE_LIST_BOX_ROW)
+
+/* Shared by the titles of all rows */
+static PangoAttrList *title_attrs = NULL;
+
+
+static void
+internal_clear_layouts (GyachtCompactRow *self)
+{
+  guint i;
+
+  for (i = 0; i < N_COMPACT_ROW_FIELDS; i++)
+    g_clear_object (&self->layouts[i]);
+
+  self->line_height = 0;
+}
+
+static PangoLayout *
+internal_get_layout (GyachtCompactRow      *self,
+                     GyachtCompactRowField  field)
+{
+  PangoLayout *layout;
+
+  if (self->layouts[field])
+    return self->layouts[field];
+
+  if (self->texts[field] == NULL || *self->texts[field] == '\0')
+    return NULL;
+
+  layout = gtk_widget_create_pango_layout (GTK_WIDGET (self), self->texts[field]);
+  pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+  if (field == COMPACT_ROW_TITLE)
+    pango_layout_set_attributes (layout, title_attrs);
+
+  pango_layout_get_pixel_size (layout, &self->natural_widths[field], NULL);
+  self->layouts[field] = layout;
+
+  return layout;
+}
+
+static gint
+internal_get_line_height (GyachtCompactRow *self)
+{
+  g_autoptr(PangoLayout) layout = NULL;
+
+  if (self->line_height > 0)
+    return self->line_height;
+
+  /* Every row is as high, whatever its texts are */
+  layout = gtk_widget_create_pango_layout (GTK_WIDGET (self), "Xy");
+  pango_layout_set_attributes (layout, title_attrs);
+  pango_layout_get_pixel_size (layout, NULL, &self->line_height);
+
+  return self->line_height;
+}
+
+/* Draws @field right-aligned to @x_end, taking at most half the room left.
+ *
+ * Return value: Where the next field of the line has to end.
+ */
+static gint
+internal_draw_end (GyachtCompactRow      *self,
+                   cairo_t               *cr,
+                   GyachtCompactRowField  field,
+                   const GdkRGBA         *color,
+                   gdouble                alpha,
+                   gint                   x_end,
+                   gint                   y)
+{
+  PangoLayout *layout;
+  gint width;
+  gint max_width;
+
+  layout = internal_get_layout (self, field);
+  if (layout == NULL)
+    return x_end;
+
+  max_width = MAX (0, (x_end - ROW_PADDING) / 2);
+  width = MIN (self->natural_widths[field], max_width);
+  if (width <= 0)
+    return x_end;
+
+  pango_layout_set_width (layout, width < self->natural_widths[field] ?
+                                    width * PANGO_SCALE : -1);
+
+  cairo_set_source_rgba (cr, color->red, color->green, color->blue, color->alpha * alpha);
+  cairo_move_to (cr, x_end - width, y);
+  pango_cairo_show_layout (cr, layout);
+
+  return x_end - width - COLUMN_SPACING;
+}
+
+static void
+internal_draw_start (GyachtCompactRow      *self,
+                     cairo_t               *cr,
+                     GyachtCompactRowField  field,
+                     const GdkRGBA         *color,
+                     gdouble                alpha,
+                     gint                   x_end,
+                     gint                   y)
+{
+  PangoLayout *layout;
+  gint width;
+
+  layout = internal_get_layout (self, field);
+  if (layout == NULL)
+    return;
+
+  width = x_end - ROW_PADDING;
+  if (width <= 0)
+    return;
+
+  pango_layout_set_width (layout, width < self->natural_widths[field] ?
+                                    width * PANGO_SCALE : -1);
+
+  cairo_set_source_rgba (cr, color->red, color->green, color->blue, color->alpha * alpha);
+  cairo_move_to (cr, ROW_PADDING, y);
+  pango_cairo_show_layout (cr, layout);
+}
+
+/* --- GtkWidget --- */
+static gboolean
+gyacht_compact_row_draw (GtkWidget *widget,
+                         cairo_t   *cr)
+{
+  GyachtCompactRow *self = GYACHT_COMPACT_ROW (widget);
+  GtkStyleContext *context = gtk_widget_get_style_context (widget);
+  gint width = gtk_widget_get_allocated_width (widget);
+  GdkRGBA color;
+  gint x_end;
+  gint y;
+
+  /* Background, selection and focus */
+  GTK_WIDGET_CLASS (gyacht_compact_row_parent_class)->draw (widget, cr);
+
+  gtk_style_context_get_color (context, gtk_style_context_get_state (context), &color);
+
+  if (self->separator)
+    {
+      cairo_set_source_rgba (cr, color.red, color.green, color.blue,
+                             color.alpha * SEPARATOR_ALPHA);
+      cairo_rectangle (cr, 0, 0, width, 1);
+      cairo_fill (cr);
+    }
+
+  y = ROW_PADDING;
+  x_end = internal_draw_end (self, cr, COMPACT_ROW_STATUS, &color, 1.0,
+                             width - ROW_PADDING, y);
+  internal_draw_start (self, cr, COMPACT_ROW_TITLE, &color, 1.0, x_end, y);
+
+  y += internal_get_line_height (self) + LINE_SPACING;
+  x_end = internal_draw_end (self, cr, COMPACT_ROW_DATE, &color, 1.0,
+                             width - ROW_PADDING, y);
+  x_end = internal_draw_end (self, cr, COMPACT_ROW_DETAIL, &color, DIM_ALPHA,
+                             x_end, y);
+  internal_draw_start (self, cr, COMPACT_ROW_SUBTITLE, &color, DIM_ALPHA, x_end, y);
+
+  return FALSE;
+}
+
+static void
+gyacht_compact_row_get_preferred_width (GtkWidget *widget,
+                                        gint      *minimum_width,
+                                        gint      *natural_width)
+{
+  GyachtCompactRow *self = GYACHT_COMPACT_ROW (widget);
+  gint natural = 0;
+
+  internal_get_layout (self, COMPACT_ROW_TITLE);
+  internal_get_layout (self, COMPACT_ROW_STATUS);
+
+  if (self->layouts[COMPACT_ROW_TITLE])
+    natural += self->natural_widths[COMPACT_ROW_TITLE];
+  if (self->layouts[COMPACT_ROW_STATUS])
+    natural += COLUMN_SPACING + self->natural_widths[COMPACT_ROW_STATUS];
+
+  *minimum_width = 2 * ROW_PADDING;
+  *natural_width = 2 * ROW_PADDING + natural;
+}
+
+static void
+gyacht_compact_row_get_preferred_height (GtkWidget *widget,
+                                         gint      *minimum_height,
+                                         gint      *natural_height)
+{
+  GyachtCompactRow *self = GYACHT_COMPACT_ROW (widget);
+
+  *minimum_height = 2 * ROW_PADDING + 2 * internal_get_line_height (self) + LINE_SPACING;
+  *natural_height = *minimum_height;
+}
+
+static void
+gyacht_compact_row_style_updated (GtkWidget *widget)
+{
+  GyachtCompactRow *self = GYACHT_COMPACT_ROW (widget);
+
+  GTK_WIDGET_CLASS (gyacht_compact_row_parent_class)->style_updated (widget);
+
+  /* The font may have changed */
+  internal_clear_layouts (self);
+  gtk_widget_queue_resize (widget);
+}
+
+/* --- GObject --- */
+static void
+gyacht_compact_row_finalize (GObject *object)
+{
+  GyachtCompactRow *self = GYACHT_COMPACT_ROW (object);
+  guint i;
+
+  internal_clear_layouts (self);
+  for (i = 0; i < N_COMPACT_ROW_FIELDS; i++)
+    g_free (self->texts[i]);
+
+  G_OBJECT_CLASS (gyacht_compact_row_parent_class)->finalize (object);
+}
+
+static void
+gyacht_compact_row_class_init (GyachtCompactRowClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->finalize = gyacht_compact_row_finalize;
+
+  widget_class->draw = gyacht_compact_row_draw;
+  widget_class->get_preferred_width = gyacht_compact_row_get_preferred_width;
+  widget_class->get_preferred_height = gyacht_compact_row_get_preferred_height;
+  widget_class->style_updated = gyacht_compact_row_style_updated;
+
+  title_attrs = pango_attr_list_new ();
+  pango_attr_list_insert (title_attrs, pango_attr_weight_new (PANGO_WEIGHT_SEMIBOLD));
+}
+
+static void
+gyacht_compact_row_init (GyachtCompactRow *self)
+{
+  self->line_height = 0;
+}
+
+/* --- Public APIs --- */
+GtkWidget *
+gyacht_compact_row_new (void)
+{
+  return g_object_new (GYACHT_TYPE_COMPACT_ROW, NULL);
+}
+
+void
+gyacht_compact_row_set_text (GyachtCompactRow      *self,
+                             GyachtCompactRowField  field,
+                             const gchar           *text)
+{
+  g_return_if_fail (GYACHT_IS_COMPACT_ROW (self));
+  g_return_if_fail (field < N_COMPACT_ROW_FIELDS);
+
+  if (g_strcmp0 (self->texts[field], text) == 0)
+    return;
+
+  g_free (self->texts[field]);
+  self->texts[field] = g_strdup (text);
+  g_clear_object (&self->layouts[field]);
+
+  /* The natural width follows the texts */
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+}
+
+/**
+ * gyacht_compact_row_set_separator:
+ * @self: A #GyachtCompactRow.
+ * @separator: Whether to draw a separator above the row.
+ *
+ * Meant to be called from a #GtkListBoxUpdateHeaderFunc, which knows the
+ * previous visible row, instead of giving the row a header widget.
+ */
+void
+gyacht_compact_row_set_separator (GyachtCompactRow *self,
+                                  gboolean          separator)
+{
+  g_return_if_fail (GYACHT_IS_COMPACT_ROW (self));
+
+  separator = !!separator;
+  if (self->separator == separator)
+    return;
+
+  self->separator = separator;
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+const gchar *
+gyacht_compact_row_get_text (GyachtCompactRow      *self,
+                             GyachtCompactRowField  field)
+{
+  g_return_val_if_fail (GYACHT_IS_COMPACT_ROW (self), NULL);
+  g_return_val_if_fail (field < N_COMPACT_ROW_FIELDS, NULL);
+
+  return self->texts[field];
+}
@@ -0,0 +1,55 @@
+/* gyacht-compact-row.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The texts a row draws, in two lines:
+ *
+ *   TITLE                       STATUS
+ *   SUBTITLE          DETAIL      DATE
+ */
+typedef enum {
+  COMPACT_ROW_TITLE = 0,
+  COMPACT_ROW_STATUS,
+  COMPACT_ROW_SUBTITLE,
+  COMPACT_ROW_DETAIL,
+  COMPACT_ROW_DATE,
+  N_COMPACT_ROW_FIELDS
+} GyachtCompactRowField;
+
+#define GYACHT_TYPE_COMPACT_ROW (gyacht_compact_row_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtCompactRow, gyacht_compact_row, GYACHT, COMPACT_ROW, GtkListBoxRow)
+
+GtkWidget *   gyacht_compact_row_new        (void);
+void          gyacht_compact_row_set_text   (GyachtCompactRow      *self,
+                                             GyachtCompactRowField  field,
+                                             const gchar           *text);
+const gchar * gyacht_compact_row_get_text   (GyachtCompactRow      *self,
+                                             GyachtCompactRowField  field);
+void          gyacht_compact_row_set_separator
+                                            (GyachtCompactRow      *self,
+                                             gboolean               separator);
+
+G_END_DECLS
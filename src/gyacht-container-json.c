@@ -104,15 +104,18 @@ internal_flags_new (JsonObject *jobj)
   return new_ht;
 }
 
-static void
-internal_container_json_foreach_cb (JsonArray *array,
-                                    guint      index_,
-                                    JsonNode  *element_node,
-                                    gpointer   user_data)
+/**
+ * gyacht_container_parse_json_element:
+ * @element_node: An element of the array of containers.json.
+ *
+ * It can be called from any thread.
+ *
+ * Return value: (transfer full) (nullable): A new #GyachtContainer.
+ */
+GyachtContainer *
+gyacht_container_parse_json_element (JsonNode *element_node)
 {
-  GSequence *seq;
   JsonObject *elem;
-  GyachtContainer *new_container;
   /* container data */
   const gchar *id = NULL;
   GPtrArray *names = NULL;
@@ -124,13 +127,17 @@ internal_container_json_foreach_cb (JsonArray *array,
   GPtrArray *gidmap = NULL;
   GHashTable *flags = NULL;
 
-  seq = (GSequence *)user_data;
+  if (element_node == NULL || !JSON_NODE_HOLDS_OBJECT (element_node))
+    return NULL;
+
   elem = json_node_get_object (element_node);
 
   if (json_object_has_member (elem, "id"))
     {
       id = json_object_get_string_member (elem, "id");
     }
+  if (id == NULL)
+    return NULL;
   if (json_object_has_member (elem, "names"))
     {
       JsonArray *member = json_object_get_array_member (elem, "names");
@@ -170,10 +177,23 @@ internal_container_json_foreach_cb (JsonArray *array,
       flags = internal_flags_new (member);
     }
 
-  new_container = gyacht_container_new (id, names, image,
-                                        layer, metadata, created,
-                                        uidmap, gidmap, flags);
-  g_sequence_append (seq, new_container);
+  return gyacht_container_new (id, names, image,
+                               layer, metadata, created,
+                               uidmap, gidmap, flags);
+}
+
+static void
+internal_container_json_foreach_cb (JsonArray *array,
+                                    guint      index_,
+                                    JsonNode  *element_node,
+                                    gpointer   user_data)
+{
+  GSequence *seq = (GSequence *)user_data;
+  GyachtContainer *new_container;
+
+  new_container = gyacht_container_parse_json_element (element_node);
+  if (new_container)
+    g_sequence_append (seq, new_container);
 }
 
 /**
@@ -218,3 +238,195 @@ gyacht_container_parse_json_contents (JsonParser  *parser,
 
   return seq;
 }
+
+/* podman's API does not expose the metadata string of containers.json, so
+ * the fields the rest of gyacht reads from it are put back together.
+ */
+static gchar *
+internal_api_metadata_new (const gchar *image_name,
+                           const gchar *image_id,
+                           const gchar *name,
+                           const gchar *pod_name)
+{
+  g_autoptr(JsonBuilder) builder = json_builder_new ();
+  g_autoptr(JsonGenerator) generator = json_generator_new ();
+  g_autoptr(JsonNode) root = NULL;
+
+  json_builder_begin_object (builder);
+  if (image_name)
+    {
+      json_builder_set_member_name (builder, "image-name");
+      json_builder_add_string_value (builder, image_name);
+    }
+  if (image_id)
+    {
+      json_builder_set_member_name (builder, "image-id");
+      json_builder_add_string_value (builder, image_id);
+    }
+  if (name)
+    {
+      json_builder_set_member_name (builder, "name");
+      json_builder_add_string_value (builder, name);
+    }
+  if (pod_name && *pod_name)
+    {
+      json_builder_set_member_name (builder, "pod-name");
+      json_builder_add_string_value (builder, pod_name);
+    }
+  json_builder_end_object (builder);
+
+  root = json_builder_get_root (builder);
+  json_generator_set_root (generator, root);
+
+  return json_generator_to_data (generator, NULL);
+}
+
+static GyachtContainerState
+internal_api_state_parse (const gchar *state)
+{
+  if (state == NULL)
+    return CONTAINER_STATE_UNKNOWN;
+
+  if (g_str_equal (state, "running") || g_str_equal (state, "paused"))
+    return CONTAINER_STATE_RUNNING;
+  if (g_str_equal (state, "exited") || g_str_equal (state, "stopped"))
+    return CONTAINER_STATE_EXITED;
+  if (g_str_equal (state, "created") || g_str_equal (state, "configured"))
+    return CONTAINER_STATE_CREATED;
+
+  return CONTAINER_STATE_UNKNOWN;
+}
+
+static void
+internal_container_api_foreach_cb (JsonArray *array,
+                                   guint      index_,
+                                   JsonNode  *element_node,
+                                   gpointer   user_data)
+{
+  GSequence *seq;
+  JsonObject *elem;
+  GyachtContainer *new_container;
+  g_autofree gchar *metadata = NULL;
+  /* container data */
+  const gchar *id = NULL;
+  GPtrArray *names = NULL;
+  const gchar *image = NULL;
+  const gchar *image_name = NULL;
+  GDateTime *created = NULL;
+  const gchar *state = NULL;
+  const gchar *pod_name = NULL;
+  gint exit_code = 0;
+
+  seq = (GSequence *)user_data;
+  elem = json_node_get_object (element_node);
+
+  if (json_object_has_member (elem, "Id"))
+    {
+      id = json_object_get_string_member (elem, "Id");
+    }
+  if (json_object_has_member (elem, "Names"))
+    {
+      JsonArray *member = json_object_get_array_member (elem, "Names");
+      names = internal_names_new (member);
+    }
+  if (json_object_has_member (elem, "ImageID"))
+    {
+      image = json_object_get_string_member (elem, "ImageID");
+    }
+  if (json_object_has_member (elem, "Image"))
+    {
+      image_name = json_object_get_string_member (elem, "Image");
+    }
+  if (json_object_has_member (elem, "Created"))
+    {
+      JsonNode *member = json_object_get_member (elem, "Created");
+
+      /* A RFC 3339 string since podman 3, a unix timestamp before */
+      if (json_node_get_value_type (member) == G_TYPE_STRING)
+        {
+          g_autoptr(GTimeZone) time_zone = g_time_zone_new_local ();
+          created = g_date_time_new_from_iso8601 (json_node_get_string (member),
+                                                  time_zone);
+        }
+      else
+        {
+          g_autoptr(GDateTime) utc = NULL;
+
+          utc = g_date_time_new_from_unix_utc (json_node_get_int (member));
+          created = g_date_time_to_local (utc);
+        }
+    }
+  if (json_object_has_member (elem, "State"))
+    {
+      state = json_object_get_string_member (elem, "State");
+    }
+  if (json_object_has_member (elem, "ExitCode"))
+    {
+      exit_code = json_object_get_int_member (elem, "ExitCode");
+    }
+  if (json_object_has_member (elem, "PodName"))
+    {
+      pod_name = json_object_get_string_member (elem, "PodName");
+    }
+
+  if (id == NULL)
+    {
+      if (names)
+        g_ptr_array_unref (names);
+      if (created)
+        g_date_time_unref (created);
+      return;
+    }
+
+  metadata = internal_api_metadata_new (image_name, image,
+                                        names && names->len > 0 ?
+                                          g_ptr_array_index (names, 0) : NULL,
+                                        pod_name);
+
+  new_container = gyacht_container_new (id, names, image,
+                                        NULL, metadata, created,
+                                        NULL, NULL, NULL);
+  gyacht_container_set_state (new_container,
+                              internal_api_state_parse (state),
+                              exit_code);
+  g_sequence_append (seq, new_container);
+}
+
+/**
+ * gyacht_container_parse_api_contents:
+ * @parser: #JsonParser in which has the response of /containers/json.
+ * @error: (nullable): A #GError.
+ *
+ * Return value: (transfer full): Null if it is on failure and error is set,
+ *    otherwise returns #GSequence and error is NULL.
+ */
+GSequence *
+gyacht_container_parse_api_contents (JsonParser  *parser,
+                                     GError     **error)
+{
+  JsonNode *root;
+  GSequence *seq;
+
+  GYACHT_TRACE_ENTRY;
+
+  g_return_val_if_fail (JSON_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  root = json_parser_get_root (parser);
+  if (root == NULL || !JSON_NODE_HOLDS_ARRAY (root))
+    {
+      if (error != NULL)
+        g_set_error (error, GYACHT_CONTAINER_JSON_ERROR, 0,
+                     "Failed to get an array from the parser");
+      return NULL;
+    }
+
+  seq = g_sequence_new (g_object_unref);
+  json_array_foreach_element (json_node_get_array (root),
+                              internal_container_api_foreach_cb,
+                              seq);
+
+  GYACHT_TRACE_EXIT;
+
+  return seq;
+}
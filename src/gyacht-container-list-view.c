@@ -18,13 +18,36 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include "gyacht-age-clock.h"
+#include "gyacht-application.h"
+#include "gyacht-compact-row.h"
 #include "gyacht-container-list-view.h"
 #include "gyacht-container-private.h"
 #include "gyacht-container-service.h"
 #include "gyacht-debug.h"
+#include "gyacht-details-cache.h"
+#include "gyacht-disk-usage.h"
+#include "gyacht-filter.h"
+#include "gyacht-frame-queue.h"
+#include "gyacht-group-row.h"
+#include "gyacht-inspect-pane.h"
 #include "gyacht-macros.h"
+#include "gyacht-path-manager.h"
+#include "gyacht-row-sort.h"
+#include "gyacht-search-index.h"
 
 #include <glib/gi18n.h>
+#include <string.h>
+
+#define DETAILS_CACHE_SIZE  64
+#define SIZE_REFRESH_SECS   30
+
+typedef enum {
+  GROUP_BY_NONE = 0,
+  GROUP_BY_IMAGE,
+  GROUP_BY_REPOSITORY,
+  GROUP_BY_POD
+} GroupBy;
 
 struct _GyachtContainerListView
 {
@@ -32,31 +55,399 @@ struct _GyachtContainerListView
 
   /* Widgets */
   GtkListBox              *list_box;
+  GtkWidget               *progress_label;
+  GtkWidget               *selection_label;
+  GtkSearchBar            *search_bar;
+  GtkWidget               *search_entry;
+  GtkWidget               *inspect_revealer;
+  GtkWidget               *inspect_pane;
 
   GyachtContainerService  *service;
+  GHashTable              *rows;  /* id -> GtkListBoxRow */
+  GyachtFrameQueue        *updates;
+  GyachtAgeClock          *ages;
+  gboolean                compact;
+  GyachtSearchIndex       *index;   /* Follows the rows */
+  GyachtFilter            *filter;
+
+  GroupBy                 group_by;
+  GHashTable              *groups;  /* key -> GyachtGroupRow */
+
+  GyachtDetailsCache      *details;
+  GCancellable            *inspect_cancellable;
+  GtkListBoxRow           *hovered_row;   /* Only compared, never used */
+
+  GyachtReclaimIndex      *reclaim;     /* Shared with the other views */
+  GHashTable              *selection;   /* GtkListBoxRow -> layer id */
+
+  /* Sizes of the writable layers */
+  GyachtDiskUsage         *disk_usage;
+  GCancellable            *size_cancellable;
+  gchar                   *overlay_dir;
+  guint                   size_refresh_id;
+
+  /* Mount state, joined through the layers */
+  GyachtMountService      *mounts;
+  GHashTable              *layer_rows;  /* layer id -> GtkListBoxRow */
 };
 
+typedef struct
+{
+  GyachtContainerListView *self;
+  gchar                   *id;
+} SizeData;
+
 G_DEFINE_TYPE (GyachtContainerListView, gyacht_container_list_view, GTK_TYPE_BOX)
 
+static const gchar *internal_get_state_name (GyachtContainer *container);
+
+static const GyachtFilterField filter_fields[] = {
+  { "id",       FILTER_FIELD_ID,      GYACHT_FILTER_GET_FUNC (gyacht_container_get_id) },
+  { "name",     FILTER_FIELD_STRINGS, GYACHT_FILTER_GET_FUNC (gyacht_container_get_names) },
+  { "names",    FILTER_FIELD_STRINGS, GYACHT_FILTER_GET_FUNC (gyacht_container_get_names) },
+  { "image",    FILTER_FIELD_STRING,  GYACHT_FILTER_GET_FUNC (gyacht_container_get_image_name) },
+  { "image-id", FILTER_FIELD_ID,      GYACHT_FILTER_GET_FUNC (gyacht_container_get_image) },
+  { "created",  FILTER_FIELD_TIME,    GYACHT_FILTER_GET_FUNC (gyacht_container_get_created) },
+  { "state",    FILTER_FIELD_STRING,  GYACHT_FILTER_GET_FUNC (internal_get_state_name) },
+  { NULL, }
+};
+
+
+static const gchar *
+internal_get_state_name (GyachtContainer *container)
+{
+  switch (gyacht_container_get_state (container))
+    {
+    case CONTAINER_STATE_CREATED: return "created";
+    case CONTAINER_STATE_RUNNING: return "running";
+    case CONTAINER_STATE_EXITED:  return "exited";
+    default:                      return "unknown";
+    }
+}
+
+/* The filter is evaluated once per container, when its row is added or
+ * changes, and the verdict is kept on the row for the filter func.
+ *
+ * Return value: Whether the verdict changed.
+ */
+static gboolean
+internal_filter_row (GyachtContainerListView *self,
+                     GtkWidget               *row,
+                     GyachtContainer         *container)
+{
+  gboolean hidden;
+
+  hidden = self->filter && !gyacht_filter_matches (self->filter, container);
+  if (hidden == GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "filtered-out")))
+    return FALSE;
+
+  g_object_set_data (G_OBJECT (row), "filtered-out", GINT_TO_POINTER (hidden));
+  return TRUE;
+}
+
+/* Records whether @row passes both the filter terms and the text search.
+ * Its group counts the members which do, and is hidden when there is none.
+ */
+static void
+internal_update_match (GyachtContainerListView *self,
+                       GtkWidget               *row)
+{
+  GyachtGroupRow *group;
+  gboolean matches;
+
+  matches = !g_object_get_data (G_OBJECT (row), "filtered-out") &&
+            gyacht_search_index_matches (self->index,
+                                         g_object_get_data (G_OBJECT (row), "id"));
+  if (matches == GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "matches")))
+    return;
+
+  g_object_set_data (G_OBJECT (row), "matches", GINT_TO_POINTER (matches));
+
+  group = g_object_get_data (G_OBJECT (row), "group");
+  if (group && gyacht_group_row_set_member_visible (group, matches))
+    gtk_list_box_row_changed (GTK_LIST_BOX_ROW (group));
+}
+
+/* The mount state joins the status. A layer still mounted while its
+ * container is not running is a leaked mount.
+ */
+static void
+internal_update_status (GyachtContainerListView *self,
+                        GtkWidget               *row,
+                        GyachtContainer         *container)
+{
+  g_autofree gchar *status = NULL;
+  g_autofree gchar *text = NULL;
+  GyachtMount *mount;
+  guint count = 0;
+
+  status = gyacht_container_get_status (container);
+
+  mount = gyacht_mount_service_lookup (self->mounts, gyacht_container_get_layer (container));
+  if (mount)
+    count = gyacht_mount_get_count (mount);
+
+  if (count > 0)
+    text = g_strdup_printf (ngettext ("%s, mounted", "%s, mounted %u times", count),
+                            status ? status : _("Unknown"),
+                            count);
+  else
+    text = g_strdup (status ? status : "");
+
+  if (GYACHT_IS_COMPACT_ROW (row))
+    {
+      gyacht_compact_row_set_text (GYACHT_COMPACT_ROW (row), COMPACT_ROW_STATUS, text);
+      return;
+    }
+
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "status-label"), text);
+  gtk_widget_set_tooltip_text (g_object_get_data (G_OBJECT (row), "status-label"),
+                               count > 0 ? gyacht_mount_get_mountpoint (mount) : NULL);
+}
+
+static void
+internal_mount_changed_cb (GyachtMountService      *service,
+                           GyachtMount             *mount,
+                           GyachtContainerListView *self)
+{
+  GtkWidget *row;
+
+  row = g_hash_table_lookup (self->layer_rows, gyacht_mount_get_id (mount));
+  if (row == NULL)
+    return;
+
+  internal_update_status (self, row, g_object_get_data (G_OBJECT (row), "container"));
+}
+
+static void
+internal_set_age (GtkListBoxRow *row,
+                  const gchar   *text,
+                  gpointer       user_data)
+{
+  GtkWidget *label;
+
+  if (GYACHT_IS_COMPACT_ROW (row))
+    {
+      gyacht_compact_row_set_text (GYACHT_COMPACT_ROW (row), COMPACT_ROW_DATE, text);
+      return;
+    }
+
+  label = g_object_get_data (G_OBJECT (row), "date-label");
+  if (label)
+    gtk_label_set_text (GTK_LABEL (label), text);
+}
+
+static GtkWidget *
+internal_create_compact_row (GyachtContainer *container)
+{
+  GyachtCompactRow *row;
+
+  row = GYACHT_COMPACT_ROW (gyacht_compact_row_new ());
+
+  gyacht_compact_row_set_text (row, COMPACT_ROW_TITLE, gyacht_container_get_name (container));
+  gyacht_compact_row_set_text (row, COMPACT_ROW_SUBTITLE, gyacht_container_get_id (container));
+  gyacht_compact_row_set_text (row, COMPACT_ROW_DETAIL, gyacht_container_get_image_name (container));
+  gtk_widget_show (GTK_WIDGET (row));
+
+  return GTK_WIDGET (row);
+}
+
+static gchar *
+internal_dup_diff_path (GyachtContainerListView *self,
+                        GyachtContainer         *container)
+{
+  const gchar *layer = gyacht_container_get_layer (container);
+
+  if (layer == NULL)
+    return NULL;
+
+  return g_build_filename (self->overlay_dir, layer, OVERLAY_DIFF, NULL);
+}
+
+static void
+internal_set_size (GtkWidget       *row,
+                   GyachtContainer *container,
+                   guint64          size)
+{
+  g_autofree gchar *text = g_format_size (size);
+  GyachtGroupRow *group;
+
+  group = g_object_get_data (G_OBJECT (row), "group");
+  if (group)
+    gyacht_group_row_resize_member (group,
+                                    gyacht_row_sort_get_size (GTK_LIST_BOX_ROW (row)),
+                                    size);
+  gyacht_row_sort_set_size (GTK_LIST_BOX_ROW (row), size);
+
+  if (GYACHT_IS_COMPACT_ROW (row))
+    {
+      const gchar *image_name = gyacht_container_get_image_name (container);
+      g_autofree gchar *detail = NULL;
+
+      detail = image_name ? g_strdup_printf ("%s — %s", image_name, text) : g_strdup (text);
+      gyacht_compact_row_set_text (GYACHT_COMPACT_ROW (row), COMPACT_ROW_DETAIL, detail);
+      return;
+    }
+
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "size-label"), text);
+}
+
+static void
+internal_size_data_free (SizeData *data)
+{
+  g_free (data->id);
+  g_free (data);
+}
+
+static void
+internal_size_scanned_cb (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+  SizeData *data = user_data;
+  g_autoptr(GError) error = NULL;
+  GyachtContainerListView *self;
+  GtkWidget *row;
+  guint64 size = 0;
+
+  if (!gyacht_disk_usage_scan_finish (GYACHT_DISK_USAGE (source_object), res, &size, &error))
+    {
+      /* Not created yet, or the view is gone */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        gyacht_debug ("Unable to size container %s: %s", data->id, error->message);
+      internal_size_data_free (data);
+      return;
+    }
+
+  self = data->self;
+  row = g_hash_table_lookup (self->rows, data->id);
+  if (row)
+    internal_set_size (row, g_object_get_data (G_OBJECT (row), "container"), size);
+
+  internal_size_data_free (data);
+}
+
+/* Only the directories which changed since the last scan are read again */
+static void
+internal_scan_size (GyachtContainerListView *self,
+                    GyachtContainer         *container)
+{
+  g_autofree gchar *path = NULL;
+  SizeData *data;
+
+  path = internal_dup_diff_path (self, container);
+  if (path == NULL)
+    return;
 
+  data = g_new0 (SizeData, 1);
+  data->self = self;
+  data->id = g_strdup (gyacht_container_get_id (container));
+
+  gyacht_disk_usage_scan_async (self->disk_usage,
+                                path,
+                                self->size_cancellable,
+                                internal_size_scanned_cb,
+                                data);
+}
+
+static gboolean
+internal_size_refresh_cb (gpointer user_data)
+{
+  GyachtContainerListView *self = GYACHT_CONTAINER_LIST_VIEW (user_data);
+  GHashTableIter iter;
+  gpointer value;
+
+  if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+    return G_SOURCE_CONTINUE;
+
+  g_hash_table_iter_init (&iter, self->rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    internal_scan_size (self, g_object_get_data (G_OBJECT (value), "container"));
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+internal_details_loaded_cb (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
+{
+  g_autoptr(GyachtContainerDetails) details = NULL;
+  GyachtContainerListView *self;
+
+  /* Cancelled if another container got shown or the view is gone */
+  details = gyacht_details_cache_load_finish (GYACHT_DETAILS_CACHE (source_object),
+                                              res,
+                                              NULL);
+  if (details == NULL)
+    return;
+
+  self = GYACHT_CONTAINER_LIST_VIEW (user_data);
+  gyacht_inspect_pane_set_details (GYACHT_INSPECT_PANE (self->inspect_pane), details);
+}
+
+/* What the model knows is shown at once, the details as soon as they are
+ * loaded, which they usually are by the prefetching already.
+ */
 static void
-internal_clear_list_box_rows (GyachtContainerListView *self)
+internal_inspect_container (GyachtContainerListView *self,
+                            GyachtContainer         *container)
 {
-  GList *children, *iter;
+  g_autoptr(GyachtContainerDetails) details = NULL;
 
-  children = gtk_container_get_children (GTK_CONTAINER (self->list_box));
-  for (iter = children; iter != NULL; iter = g_list_next (iter))
-    gtk_widget_destroy (GTK_WIDGET (iter->data));
-  g_list_free (children);
+  g_cancellable_cancel (self->inspect_cancellable);
+  g_clear_object (&self->inspect_cancellable);
+
+  gyacht_inspect_pane_set_container (GYACHT_INSPECT_PANE (self->inspect_pane), container);
+  gtk_revealer_set_reveal_child (GTK_REVEALER (self->inspect_revealer), TRUE);
+
+  details = gyacht_details_cache_lookup (self->details, container);
+  if (details)
+    {
+      gyacht_inspect_pane_set_details (GYACHT_INSPECT_PANE (self->inspect_pane), details);
+      return;
+    }
+
+  self->inspect_cancellable = g_cancellable_new ();
+  gyacht_details_cache_load_async (self->details,
+                                   container,
+                                   self->inspect_cancellable,
+                                   internal_details_loaded_cb,
+                                   self);
+}
+
+static void
+internal_prefetch_row (GyachtContainerListView *self,
+                       GtkListBoxRow           *row)
+{
+  GyachtContainer *container;
+
+  if (row == NULL)
+    return;
+
+  container = g_object_get_data (G_OBJECT (row), "container");
+  if (container)
+    gyacht_details_cache_prefetch (self->details, container);
+}
+
+static void
+internal_inspect_clicked_cb (GtkButton               *button,
+                             GyachtContainerListView *self)
+{
+  GtkWidget *row = g_object_get_data (G_OBJECT (button), "row");
+
+  internal_inspect_container (self, g_object_get_data (G_OBJECT (row), "container"));
 }
 
 static GtkWidget *
-internal_create_row (GyachtContainer *container)
+internal_create_row (GyachtContainerListView *self,
+                     GyachtContainer         *container)
 {
   GtkWidget *row = NULL;
   GtkWidget *grid = NULL;
   GtkWidget *widget = NULL;
   gconstpointer buffer = NULL;
+  g_autofree gchar *date = NULL;
   PangoAttrList *attrlist = NULL;
   PangoAttribute *attr = NULL;
 
@@ -97,9 +488,21 @@ internal_create_row (GyachtContainer *container)
 
   gtk_grid_attach (GTK_GRID (grid), widget, 0, 1, 2, 1);
 
-  /* ??? */
+  /* Status, set once the row is added */
   widget = gtk_label_new ("");
-  gtk_grid_attach (GTK_GRID (grid), widget, 0, 2, 2, 1);
+  gtk_label_set_xalign (GTK_LABEL (widget), 0);
+  g_object_set_data (G_OBJECT (row), "status-label", widget);
+
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 2, 1, 1);
+
+  /* Size of the writable layer, set once scanned */
+  widget = gtk_label_new ("");
+  gtk_label_set_xalign (GTK_LABEL (widget), 1);
+  gtk_widget_set_sensitive (widget, FALSE);
+  gtk_widget_set_tooltip_text (widget, _("Size of the writable layer"));
+  g_object_set_data (G_OBJECT (row), "size-label", widget);
+
+  gtk_grid_attach (GTK_GRID (grid), widget, 1, 2, 1, 1);
 
   /* Image name */
   buffer = gyacht_container_get_image_name (container);
@@ -109,10 +512,12 @@ internal_create_row (GyachtContainer *container)
 
   gtk_grid_attach (GTK_GRID (grid), widget, 1, 3, 1, 1);
 
-  /* Created */
-  buffer = gyacht_container_get_calendar_date (container);
-  widget = gtk_label_new (buffer);
+  /* Created, the age clock sets its text */
+  date = gyacht_container_get_calendar_date (container);
+  widget = gtk_label_new ("");
   gtk_label_set_xalign (GTK_LABEL (widget), 0);
+  gtk_widget_set_tooltip_text (widget, date);
+  g_object_set_data (G_OBJECT (row), "date-label", widget);
 
   gtk_grid_attach (GTK_GRID (grid), widget, 0, 3, 1, 1);
 
@@ -125,7 +530,7 @@ internal_create_row (GyachtContainer *container)
   gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
   g_object_set_data (G_OBJECT (widget), "row", row);
   gtk_widget_set_tooltip_text (widget, _("Open the information dialog on the container"));
-  /*g_signal_connect (G_OBJECT (widget), "clicked", NULL, self);*/
+  g_signal_connect (G_OBJECT (widget), "clicked", G_CALLBACK (internal_inspect_clicked_cb), self);
   gtk_button_set_relief (GTK_BUTTON (widget), GTK_RELIEF_NONE);
 
   gtk_grid_attach (GTK_GRID (grid), widget, 3, 0, 1, 4);
@@ -136,39 +541,492 @@ internal_create_row (GyachtContainer *container)
   return row;
 }
 
+/* Short ids are prefixes of the ids, they need no texts of their own */
+static void
+internal_index_container (GyachtContainerListView *self,
+                          GyachtContainer         *container)
+{
+  g_autoptr(GPtrArray) texts = NULL;
+  const GPtrArray *names;
+  const gchar *buffer;
+  guint i;
+
+  texts = g_ptr_array_new ();
+
+  names = gyacht_container_get_names (container);
+  for (i = 0; names && i < names->len; i++)
+    g_ptr_array_add (texts, g_ptr_array_index (names, i));
+
+  g_ptr_array_add (texts, (gpointer) gyacht_container_get_id (container));
+  if ((buffer = gyacht_container_get_image_name (container)))
+    g_ptr_array_add (texts, (gpointer) buffer);
+  if ((buffer = gyacht_container_get_image (container)))
+    g_ptr_array_add (texts, (gpointer) buffer);
+  g_ptr_array_add (texts, NULL);
+
+  gyacht_search_index_add (self->index,
+                           gyacht_container_get_id (container),
+                           (const gchar *const *) texts->pdata);
+}
+
+static GroupBy
+internal_group_by_from_string (const gchar *name)
+{
+  if (g_strcmp0 (name, "image") == 0)
+    return GROUP_BY_IMAGE;
+  if (g_strcmp0 (name, "repository") == 0)
+    return GROUP_BY_REPOSITORY;
+  if (g_strcmp0 (name, "pod") == 0)
+    return GROUP_BY_POD;
+
+  return GROUP_BY_NONE;
+}
+
+/* The image name without its tag or digest */
+static gchar *
+internal_dup_repository (const gchar *image_name)
+{
+  const gchar *slash;
+  const gchar *tag;
+
+  tag = strchr (image_name, '@');
+  if (tag == NULL)
+    {
+      slash = strrchr (image_name, '/');
+      tag = strrchr (slash ? slash : image_name, ':');
+    }
+
+  return tag ? g_strndup (image_name, tag - image_name) : g_strdup (image_name);
+}
+
+/* Return value: The key of the group @container belongs to */
+static gchar *
+internal_dup_group (GyachtContainerListView  *self,
+                    GyachtContainer          *container,
+                    gchar                   **title)
+{
+  const gchar *image_name = gyacht_container_get_image_name (container);
+  const gchar *buffer;
+
+  switch (self->group_by)
+    {
+    case GROUP_BY_IMAGE:
+      buffer = gyacht_container_get_image (container);
+      *title = g_strdup (image_name ? image_name : buffer ? buffer : _("Unknown image"));
+      return g_strdup (buffer ? buffer : "");
+
+    case GROUP_BY_REPOSITORY:
+      if (image_name == NULL)
+        {
+          *title = g_strdup (_("Unknown repository"));
+          return g_strdup ("");
+        }
+      *title = internal_dup_repository (image_name);
+      return g_strdup (*title);
+
+    case GROUP_BY_POD:
+      buffer = gyacht_container_get_pod_name (container);
+      *title = g_strdup (buffer ? buffer : _("No pod"));
+      return g_strdup (buffer ? buffer : "");
+
+    case GROUP_BY_NONE:
+    default:
+      *title = NULL;
+      return NULL;
+    }
+}
+
+/* The count of a group is updated as its members come and go */
+static void
+internal_join_group (GyachtContainerListView *self,
+                     GtkWidget               *row,
+                     GyachtContainer         *container)
+{
+  g_autofree gchar *title = NULL;
+  g_autofree gchar *key = NULL;
+  GtkWidget *group;
+  gboolean matches;
+  gboolean was_visible;
+
+  key = internal_dup_group (self, container, &title);
+  if (key == NULL)
+    return;
+
+  matches = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "matches"));
+
+  group = g_hash_table_lookup (self->groups, key);
+  if (group == NULL)
+    {
+      group = gyacht_group_row_new (key, title);
+      gyacht_row_sort_set_keys (GTK_LIST_BOX_ROW (group), NULL, title, NULL, NULL);
+      gyacht_row_sort_set_group (GTK_LIST_BOX_ROW (group), title, key, TRUE);
+
+      /* Inserted with its first member, the list box filters it right away */
+      gyacht_group_row_add_member (GYACHT_GROUP_ROW (group),
+                                   gyacht_row_sort_get_size (GTK_LIST_BOX_ROW (row)),
+                                   matches);
+      g_hash_table_insert (self->groups, g_strdup (key), group);
+      gtk_list_box_insert (self->list_box, group, -1);
+    }
+  else
+    {
+      was_visible = gyacht_group_row_has_visible (GYACHT_GROUP_ROW (group));
+      gyacht_group_row_add_member (GYACHT_GROUP_ROW (group),
+                                   gyacht_row_sort_get_size (GTK_LIST_BOX_ROW (row)),
+                                   matches);
+      if (matches && !was_visible)
+        gtk_list_box_row_changed (GTK_LIST_BOX_ROW (group));
+    }
+  gyacht_row_sort_set_group (GTK_LIST_BOX_ROW (row), title, key, FALSE);
+  g_object_set_data (G_OBJECT (row), "group", group);
+}
+
+static void
+internal_leave_group (GyachtContainerListView *self,
+                      GtkWidget               *row)
+{
+  GyachtGroupRow *group;
+  gboolean matches;
+
+  group = g_object_steal_data (G_OBJECT (row), "group");
+  if (group == NULL)
+    return;
+
+  matches = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "matches"));
+  if (gyacht_group_row_remove_member (group,
+                                      gyacht_row_sort_get_size (GTK_LIST_BOX_ROW (row)),
+                                      matches) == 0)
+    {
+      g_hash_table_remove (self->groups, gyacht_group_row_get_key (group));
+      gtk_widget_destroy (GTK_WIDGET (group));
+    }
+  else if (matches && !gyacht_group_row_has_visible (group))
+    gtk_list_box_row_changed (GTK_LIST_BOX_ROW (group));
+}
+
+static void
+internal_add_row (GyachtContainerListView *self,
+                  GyachtContainer         *container)
+{
+  const gchar *id = gyacht_container_get_id (container);
+  GtkWidget *row = NULL;
+  GtkWidget *old_row;
+  gint position = -1;
+
+  if (self->compact)
+    row = internal_create_compact_row (container);
+  else
+    row = internal_create_row (self, container);
+  g_object_set_data_full (G_OBJECT (row), "id", g_strdup (id), g_free);
+  g_object_set_data_full (G_OBJECT (row), "container",
+                          g_object_ref (container), g_object_unref);
+  internal_filter_row (self, row, container);
+
+  /* Before inserting, the list box filters the row right away */
+  internal_index_container (self, container);
+  internal_update_match (self, row);
+
+  /* A replaced container keeps its place */
+  old_row = g_hash_table_lookup (self->rows, id);
+  gyacht_row_sort_set_keys (GTK_LIST_BOX_ROW (row),
+                            old_row ? GTK_LIST_BOX_ROW (old_row) : NULL,
+                            gyacht_container_get_name (container),
+                            gyacht_container_get_image_name (container),
+                            gyacht_container_get_created (container));
+  internal_join_group (self, row, container);
+  if (old_row)
+    {
+      position = gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (old_row));
+      internal_leave_group (self, old_row);
+      gtk_widget_destroy (old_row);
+    }
+
+  g_hash_table_insert (self->rows, g_strdup (id), row);
+  gtk_list_box_insert (GTK_LIST_BOX (self->list_box), row, position);
+  gyacht_age_clock_add_row (self->ages, GTK_LIST_BOX_ROW (row),
+                            gyacht_container_get_created (container));
+  internal_scan_size (self, container);
+
+  if (gyacht_container_get_layer (container))
+    g_hash_table_insert (self->layer_rows,
+                         g_strdup (gyacht_container_get_layer (container)),
+                         row);
+  internal_update_status (self, row, container);
+}
+
+static void
+internal_remove_row (GyachtContainerListView *self,
+                     const gchar             *id)
+{
+  g_autofree gchar *path = NULL;
+  GyachtContainer *container;
+  const gchar *layer;
+  GtkWidget *row;
+
+  row = g_hash_table_lookup (self->rows, id);
+  if (row == NULL)
+    return;
+
+  container = g_object_get_data (G_OBJECT (row), "container");
+  path = internal_dup_diff_path (self, container);
+  if (path)
+    gyacht_disk_usage_forget (self->disk_usage, path);
+
+  layer = gyacht_container_get_layer (container);
+  if (layer && g_hash_table_lookup (self->layer_rows, layer) == row)
+    g_hash_table_remove (self->layer_rows, layer);
+
+  gyacht_search_index_remove (self->index, id);
+  internal_leave_group (self, row);
+  g_hash_table_remove (self->rows, id);
+  gtk_widget_destroy (row);
+}
+
+static void
+internal_update_row (GyachtContainerListView *self,
+                     GyachtContainer         *container)
+{
+  GtkWidget *row;
+
+  row = g_hash_table_lookup (self->rows, gyacht_container_get_id (container));
+  if (row == NULL)
+    return;
+
+  g_object_set_data_full (G_OBJECT (row), "container",
+                          g_object_ref (container), g_object_unref);
+  if (internal_filter_row (self, row, container))
+    {
+      internal_update_match (self, row);
+      gtk_list_box_row_changed (GTK_LIST_BOX_ROW (row));
+    }
+
+  internal_scan_size (self, container);
+  internal_update_status (self, row, container);
+}
+
+static void
+internal_apply_update (GyachtFrameOp  op,
+                       const gchar   *key,
+                       GObject       *item,
+                       gpointer       user_data)
+{
+  GyachtContainerListView *self = GYACHT_CONTAINER_LIST_VIEW (user_data);
+
+  switch (op)
+    {
+    case FRAME_OP_ADD:
+      internal_add_row (self, GYACHT_CONTAINER (item));
+      break;
+
+    case FRAME_OP_REMOVE:
+      internal_remove_row (self, key);
+      break;
+
+    case FRAME_OP_CHANGE:
+      internal_update_row (self, GYACHT_CONTAINER (item));
+      break;
+
+    default:
+      break;
+    }
+}
+
 static void
 internal_set_rows_foreach_cb (gpointer data,
                               gpointer user_data)
 {
   GyachtContainerListView *self = GYACHT_CONTAINER_LIST_VIEW (user_data);
   GyachtContainer *container = GYACHT_CONTAINER (data);
-  GtkWidget *row = NULL;
-
-  row = internal_create_row (container);
 
-  gtk_list_box_insert (GTK_LIST_BOX (self->list_box), row, -1);
+  gyacht_frame_queue_push (self->updates, FRAME_OP_ADD,
+                           gyacht_container_get_id (container),
+                           G_OBJECT (container));
 }
 
+/* Queues the whole list, an existing row is replaced in place over the next
+ * frames. The rows of removed containers already have a REMOVE pending.
+ */
 static void
 internal_container_list_set_rows (GyachtContainerListView *self)
 {
   GSequence *containers = NULL;
 
-  internal_clear_list_box_rows (self);
-
   containers = gyacht_container_service_get_containers (self->service);
   if (containers)
     g_sequence_foreach (containers, internal_set_rows_foreach_cb, self);
 }
 
+/* Moves the rows to the groups of the current group_by, without replacing them */
+static void
+internal_regroup_rows (GyachtContainerListView *self)
+{
+  GHashTableIter iter;
+  gpointer widget;
+
+  g_hash_table_iter_init (&iter, self->groups);
+  while (g_hash_table_iter_next (&iter, NULL, &widget))
+    gtk_widget_destroy (GTK_WIDGET (widget));
+  g_hash_table_remove_all (self->groups);
+
+  g_hash_table_iter_init (&iter, self->rows);
+  while (g_hash_table_iter_next (&iter, NULL, &widget))
+    {
+      g_object_set_data (G_OBJECT (widget), "group", NULL);
+      gyacht_row_sort_set_group (GTK_LIST_BOX_ROW (widget), NULL, NULL, FALSE);
+      internal_join_group (self,
+                           GTK_WIDGET (widget),
+                           g_object_get_data (G_OBJECT (widget), "container"));
+    }
+
+  /* Rows in collapsed groups were filtered out */
+  gtk_list_box_invalidate_filter (self->list_box);
+  gtk_list_box_invalidate_sort (self->list_box);
+}
+
+static void
+internal_container_added_cb (GyachtContainerListView *self,
+                             GyachtContainer         *container)
+{
+  gyacht_frame_queue_push (self->updates, FRAME_OP_ADD,
+                           gyacht_container_get_id (container),
+                           G_OBJECT (container));
+}
+
+static void
+internal_container_removed_cb (GyachtContainerListView *self,
+                               GyachtContainer         *container)
+{
+  gyacht_frame_queue_push (self->updates, FRAME_OP_REMOVE,
+                           gyacht_container_get_id (container),
+                           G_OBJECT (container));
+}
+
+static void
+internal_container_changed_cb (GyachtContainerListView *self,
+                               GyachtContainer         *container)
+{
+  gyacht_frame_queue_push (self->updates, FRAME_OP_CHANGE,
+                           gyacht_container_get_id (container),
+                           G_OBJECT (container));
+}
+
+static void
+internal_reclaim_changed_cb (GyachtContainerListView *self)
+{
+  g_autofree gchar *size = NULL;
+  g_autofree gchar *text = NULL;
+  guint n_items = gyacht_reclaim_index_get_n_items (self->reclaim);
+
+  if (n_items == 0)
+    {
+      gtk_widget_hide (self->selection_label);
+      return;
+    }
+
+  size = g_format_size (gyacht_reclaim_index_get_size (self->reclaim));
+  text = g_strdup_printf (ngettext ("Removing %u selected item frees %s",
+                                    "Removing %u selected items frees %s",
+                                    n_items),
+                          n_items, size);
+  gtk_label_set_text (GTK_LABEL (self->selection_label), text);
+  gtk_widget_show (self->selection_label);
+}
+
+/* The index needs the layer and image services, which load both storage
+ * files, so it is only taken on the first selection. Selections of the
+ * other views are shown once they made one.
+ */
+static void
+internal_ensure_reclaim (GyachtContainerListView *self,
+                         gboolean                 create)
+{
+  GyachtApplication *app = GYACHT_APPLICATION (g_application_get_default ());
+  GyachtReclaimIndex *shared;
+
+  if (self->reclaim)
+    return;
+
+  if (create)
+    self->reclaim = gyacht_application_dup_reclaim_index (app);
+  else if ((shared = gyacht_application_peek_reclaim_index (app)))
+    self->reclaim = g_object_ref (shared);
+  else
+    return;
+
+  g_signal_connect_swapped (self->reclaim,
+                            "changed",
+                            G_CALLBACK (internal_reclaim_changed_cb),
+                            self);
+  internal_reclaim_changed_cb (self);
+}
+
+static void
+internal_map_cb (GyachtContainerListView *self)
+{
+  internal_ensure_reclaim (self, FALSE);
+}
+
+/* Only the rows which joined or left the selection walk their chains */
+static void
+internal_selected_rows_changed_cb (GtkListBox              *list_box,
+                                   GyachtContainerListView *self)
+{
+  g_autoptr(GHashTable) fresh = NULL;
+  GList *rows, *l;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  fresh = g_hash_table_new (NULL, NULL);
+
+  rows = gtk_list_box_get_selected_rows (list_box);
+  for (l = rows; l; l = l->next)
+    {
+      GyachtContainer *item = g_object_get_data (G_OBJECT (l->data), "container");
+      const gchar *top;
+
+      /* Group rows */
+      if (item == NULL)
+        continue;
+
+      g_hash_table_add (fresh, l->data);
+      if (g_hash_table_contains (self->selection, l->data))
+        continue;
+
+      internal_ensure_reclaim (self, TRUE);
+
+      top = gyacht_container_get_layer (item);
+      g_hash_table_insert (self->selection, l->data, g_strdup (top));
+      gyacht_reclaim_index_add (self->reclaim, top);
+    }
+  g_list_free (rows);
+
+  g_hash_table_iter_init (&iter, self->selection);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (g_hash_table_contains (fresh, key))
+        continue;
+
+      gyacht_reclaim_index_remove (self->reclaim, value);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
 static void
 internal_box_header_func (GtkListBoxRow *row,
                           GtkListBoxRow *before,
                           gpointer       user_data)
 {
   GtkWidget *cur;
+  gboolean separator;
+
+  /* @before is the previous visible row, whatever the filter and groups */
+  separator = before && !GYACHT_IS_GROUP_ROW (row) && !GYACHT_IS_GROUP_ROW (before);
+
+  /* Compact rows draw their separator themselves */
+  if (GYACHT_IS_COMPACT_ROW (row))
+    gyacht_compact_row_set_separator (GYACHT_COMPACT_ROW (row), separator);
 
-  if (!before)
+  if (!separator || GYACHT_IS_COMPACT_ROW (row))
     {
       gtk_list_box_row_set_header (row, NULL);
       return;
@@ -183,19 +1041,242 @@ internal_box_header_func (GtkListBoxRow *row,
     }
 }
 
+static gboolean
+internal_box_filter_func (GtkListBoxRow *row,
+                          gpointer       user_data)
+{
+  GyachtGroupRow *group;
+
+  if (GYACHT_IS_GROUP_ROW (row))
+    return gyacht_group_row_has_visible (GYACHT_GROUP_ROW (row));
+
+  group = g_object_get_data (G_OBJECT (row), "group");
+  if (group && !gyacht_group_row_get_expanded (group))
+    return FALSE;
+
+  return GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "matches"));
+}
+
+static void
+internal_refilter_row_cb (gpointer data,
+                          gpointer user_data)
+{
+  internal_filter_row (GYACHT_CONTAINER_LIST_VIEW (user_data),
+                       GTK_WIDGET (data),
+                       g_object_get_data (G_OBJECT (data), "container"));
+}
+
+static void
+internal_search_changed_cb (GtkSearchEntry          *entry,
+                            GyachtContainerListView *self)
+{
+  g_autofree gchar *text = NULL;
+  GHashTableIter iter;
+  gpointer value;
+
+  if (!gyacht_filter_update_from_entry (&self->filter,
+                                        filter_fields,
+                                        GTK_ENTRY (entry),
+                                        self->rows,
+                                        internal_refilter_row_cb,
+                                        self,
+                                        &text))
+    return;
+
+  gyacht_search_index_set_query (self->index, text);
+
+  g_hash_table_iter_init (&iter, self->rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    internal_update_match (self, value);
+
+  gtk_list_box_invalidate_filter (self->list_box);
+}
+
+static void
+internal_sort_by_changed_cb (GActionGroup            *action_group,
+                             const gchar             *action_name,
+                             GVariant                *value,
+                             GyachtContainerListView *self)
+{
+  gyacht_row_sort_apply (self->list_box,
+                         gyacht_sort_column_from_string (g_variant_get_string (value, NULL)));
+}
+
+static void
+internal_row_activated_cb (GtkListBox              *list_box,
+                           GtkListBoxRow           *row,
+                           GyachtContainerListView *self)
+{
+  GyachtGroupRow *group;
+
+  if (!GYACHT_IS_GROUP_ROW (row))
+    {
+      internal_inspect_container (self, g_object_get_data (G_OBJECT (row), "container"));
+      return;
+    }
+
+  group = GYACHT_GROUP_ROW (row);
+  gyacht_group_row_set_expanded (group, !gyacht_group_row_get_expanded (group));
+  gtk_list_box_invalidate_filter (list_box);
+}
+
+static gboolean
+internal_list_box_motion_cb (GtkWidget               *list_box,
+                             GdkEventMotion          *event,
+                             GyachtContainerListView *self)
+{
+  GtkListBoxRow *row;
+
+  row = gtk_list_box_get_row_at_y (GTK_LIST_BOX (list_box), event->y);
+  if (row != self->hovered_row)
+    {
+      self->hovered_row = row;
+      internal_prefetch_row (self, row);
+    }
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+static void
+internal_list_box_focus_cb (GtkContainer            *list_box,
+                            GtkWidget               *child,
+                            GyachtContainerListView *self)
+{
+  if (GTK_IS_LIST_BOX_ROW (child))
+    internal_prefetch_row (self, GTK_LIST_BOX_ROW (child));
+}
+
+static void
+internal_inspect_close_cb (GyachtInspectPane       *pane,
+                           GyachtContainerListView *self)
+{
+  gtk_revealer_set_reveal_child (GTK_REVEALER (self->inspect_revealer), FALSE);
+}
+
+static void
+internal_group_by_changed_cb (GActionGroup            *action_group,
+                              const gchar             *action_name,
+                              GVariant                *value,
+                              GyachtContainerListView *self)
+{
+  GroupBy group_by = internal_group_by_from_string (g_variant_get_string (value, NULL));
+
+  if (self->group_by == group_by)
+    return;
+
+  self->group_by = group_by;
+  internal_regroup_rows (self);
+}
+
+static void
+internal_compact_rows_changed_cb (GActionGroup            *action_group,
+                                  const gchar             *action_name,
+                                  GVariant                *value,
+                                  GyachtContainerListView *self)
+{
+  gboolean compact = g_variant_get_boolean (value);
+
+  if (self->compact == compact)
+    return;
+
+  self->compact = compact;
+  internal_container_list_set_rows (self);
+}
+
+static void
+internal_load_progress_cb (GyachtContainerListView *self,
+                           guint                    n_items,
+                           gboolean                 done)
+{
+  g_autofree gchar *text = NULL;
+
+  if (done)
+    {
+      gtk_widget_hide (self->progress_label);
+      return;
+    }
+
+  text = g_strdup_printf (ngettext ("Loading… %u container",
+                                    "Loading… %u containers",
+                                    n_items),
+                          n_items);
+  gtk_label_set_text (GTK_LABEL (self->progress_label), text);
+  gtk_widget_show (self->progress_label);
+}
+
 /* --- GObject --- */
 static void
 gyacht_container_list_view_finalize (GObject *object)
 {
   GyachtContainerListView *self = GYACHT_CONTAINER_LIST_VIEW (object);
+  GHashTableIter selection_iter;
+  gpointer value;
 
   GYACHT_TRACE_ENTRY;
 
+  g_signal_handlers_disconnect_by_func (g_application_get_default (),
+                                        internal_compact_rows_changed_cb,
+                                        self);
+  g_signal_handlers_disconnect_by_func (g_application_get_default (),
+                                        internal_sort_by_changed_cb,
+                                        self);
+  g_signal_handlers_disconnect_by_func (g_application_get_default (),
+                                        internal_group_by_changed_cb,
+                                        self);
+
   if (self->service)
-    g_signal_handlers_disconnect_by_func (self->service,
-                                          internal_container_list_set_rows,
-                                          self);
+    {
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_container_added_cb,
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_container_removed_cb,
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_container_changed_cb,
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_load_progress_cb,
+                                            self);
+    }
   g_clear_object (&self->service);
+  g_clear_object (&self->updates);
+
+  g_cancellable_cancel (self->inspect_cancellable);
+  g_clear_object (&self->inspect_cancellable);
+  g_clear_object (&self->details);
+
+  if (self->size_refresh_id)
+    g_source_remove (self->size_refresh_id);
+  g_cancellable_cancel (self->size_cancellable);
+  g_clear_object (&self->size_cancellable);
+  g_clear_object (&self->disk_usage);
+  g_free (self->overlay_dir);
+
+  g_signal_handlers_disconnect_by_func (self->mounts,
+                                        G_CALLBACK (internal_mount_changed_cb),
+                                        self);
+  g_clear_object (&self->mounts);
+  g_hash_table_unref (self->layer_rows);
+
+  /* Its rows leave the selection */
+  if (self->reclaim)
+    {
+      g_signal_handlers_disconnect_by_func (self->reclaim,
+                                            G_CALLBACK (internal_reclaim_changed_cb),
+                                            self);
+      g_hash_table_iter_init (&selection_iter, self->selection);
+      while (g_hash_table_iter_next (&selection_iter, NULL, &value))
+        gyacht_reclaim_index_remove (self->reclaim, value);
+    }
+  g_hash_table_unref (self->selection);
+  g_clear_object (&self->reclaim);
+
+  g_clear_object (&self->ages);
+  g_clear_object (&self->index);
+  g_clear_pointer (&self->filter, gyacht_filter_free);
+  g_hash_table_unref (self->rows);
+  g_hash_table_unref (self->groups);
 
   GYACHT_TRACE_EXIT;
 
@@ -213,20 +1294,177 @@ gyacht_container_list_view_class_init (GyachtContainerListViewClass *klass)
   gtk_widget_class_set_template_from_resource (widget_class,
                                                GYACHT_UI_PREFIX "gyacht-container-list-view.ui");
   gtk_widget_class_bind_template_child (widget_class, GyachtContainerListView, list_box);
+  gtk_widget_class_bind_template_child (widget_class, GyachtContainerListView, progress_label);
+  gtk_widget_class_bind_template_child (widget_class, GyachtContainerListView, selection_label);
+  gtk_widget_class_bind_template_child (widget_class, GyachtContainerListView, search_bar);
+  gtk_widget_class_bind_template_child (widget_class, GyachtContainerListView, search_entry);
 }
 
 static void
 gyacht_container_list_view_init (GyachtContainerListView *self)
 {
+  GyachtApplication *app;
+  g_autoptr(GVariant) compact = NULL;
+  g_autoptr(GVariant) sort_by = NULL;
+  g_autoptr(GVariant) group_by = NULL;
+
   gtk_widget_init_template (GTK_WIDGET (self));
 
   gtk_list_box_set_header_func (GTK_LIST_BOX (self->list_box),
                                 internal_box_header_func,
                                 NULL, NULL);
+  gtk_list_box_set_filter_func (GTK_LIST_BOX (self->list_box),
+                                internal_box_filter_func,
+                                self, NULL);
+
+  self->index = gyacht_search_index_new ();
+  g_signal_connect (self->search_entry,
+                    "search-changed",
+                    G_CALLBACK (internal_search_changed_cb),
+                    self);
 
-  self->service = gyacht_container_service_new (RUN_LEVEL_USER);
+  self->rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->updates = gyacht_frame_queue_new (GTK_WIDGET (self->list_box),
+                                          internal_apply_update,
+                                          self);
+  self->ages = gyacht_age_clock_new (self->list_box, internal_set_age, NULL);
+
+  /* The service reports every change of its list one container at a time.
+   * It is shared with the other views, so it may be loaded already.
+   */
+  app = GYACHT_APPLICATION (g_application_get_default ());
+
+  self->selection = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  g_signal_connect (self,
+                    "map",
+                    G_CALLBACK (internal_map_cb),
+                    NULL);
+  g_signal_connect (self->list_box,
+                    "selected-rows-changed",
+                    G_CALLBACK (internal_selected_rows_changed_cb),
+                    self);
+
+  /* Running containers keep writing, their sizes are scanned again while
+   * the view is shown. A rescan reads only what changed.
+   */
+  self->disk_usage = gyacht_application_dup_disk_usage (app);
+  self->size_cancellable = g_cancellable_new ();
+  self->overlay_dir = gyacht_dup_user_overlay_dir ();
+  self->size_refresh_id = g_timeout_add_seconds_full (G_PRIORITY_LOW,
+                                                      SIZE_REFRESH_SECS,
+                                                      internal_size_refresh_cb,
+                                                      self,
+                                                      NULL);
+
+  /* Only the rows whose layer changed its mount state are updated */
+  self->mounts = gyacht_application_dup_mount_service (app);
+  self->layer_rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_signal_connect (self->mounts,
+                    "item-added",
+                    G_CALLBACK (internal_mount_changed_cb),
+                    self);
+  g_signal_connect (self->mounts,
+                    "item-removed",
+                    G_CALLBACK (internal_mount_changed_cb),
+                    self);
+  g_signal_connect (self->mounts,
+                    "item-changed",
+                    G_CALLBACK (internal_mount_changed_cb),
+                    self);
+
+  compact = g_action_group_get_action_state (G_ACTION_GROUP (app), "compact-rows");
+  self->compact = compact ? g_variant_get_boolean (compact) : FALSE;
+  g_signal_connect (app,
+                    "action-state-changed::compact-rows",
+                    G_CALLBACK (internal_compact_rows_changed_cb),
+                    self);
+
+  sort_by = g_action_group_get_action_state (G_ACTION_GROUP (app), "sort-by");
+  gyacht_row_sort_apply (self->list_box,
+                         gyacht_sort_column_from_string (sort_by ? g_variant_get_string (sort_by, NULL) : NULL));
+  g_signal_connect (app,
+                    "action-state-changed::sort-by",
+                    G_CALLBACK (internal_sort_by_changed_cb),
+                    self);
+
+  group_by = g_action_group_get_action_state (G_ACTION_GROUP (app), "group-by");
+  self->group_by = internal_group_by_from_string (group_by ? g_variant_get_string (group_by, NULL) : NULL);
+  g_signal_connect (app,
+                    "action-state-changed::group-by",
+                    G_CALLBACK (internal_group_by_changed_cb),
+                    self);
+  g_signal_connect (self->list_box,
+                    "row-activated",
+                    G_CALLBACK (internal_row_activated_cb),
+                    self);
+
+  /* Details are loaded ahead of a click on the row under the pointer or
+   * with the focus.
+   */
+  self->details = gyacht_details_cache_new (DETAILS_CACHE_SIZE);
+  self->inspect_pane = gyacht_inspect_pane_new ();
+  self->inspect_revealer = gtk_revealer_new ();
+  gtk_revealer_set_transition_type (GTK_REVEALER (self->inspect_revealer),
+                                    GTK_REVEALER_TRANSITION_TYPE_SLIDE_UP);
+  gtk_container_add (GTK_CONTAINER (self->inspect_revealer), self->inspect_pane);
+  gtk_widget_show (self->inspect_revealer);
+  gtk_box_pack_end (GTK_BOX (self), self->inspect_revealer, FALSE, TRUE, 0);
+  g_signal_connect (self->inspect_pane,
+                    "close",
+                    G_CALLBACK (internal_inspect_close_cb),
+                    self);
+
+  gtk_widget_add_events (GTK_WIDGET (self->list_box), GDK_POINTER_MOTION_MASK);
+  g_signal_connect (self->list_box,
+                    "motion-notify-event",
+                    G_CALLBACK (internal_list_box_motion_cb),
+                    self);
+  g_signal_connect (self->list_box,
+                    "set-focus-child",
+                    G_CALLBACK (internal_list_box_focus_cb),
+                    self);
+
+  self->service = gyacht_application_dup_container_service (app);
+  internal_container_list_set_rows (self);
+  g_signal_connect_swapped (self->service,
+                            "item-added",
+                            G_CALLBACK (internal_container_added_cb),
+                            self);
   g_signal_connect_swapped (self->service,
-                            "list-updated",
-                            G_CALLBACK (internal_container_list_set_rows),
+                            "item-removed",
+                            G_CALLBACK (internal_container_removed_cb),
                             self);
+  g_signal_connect_swapped (self->service,
+                            "item-changed",
+                            G_CALLBACK (internal_container_changed_cb),
+                            self);
+
+  /* Containers come in batches while the first load is running */
+  internal_load_progress_cb (self,
+                             g_sequence_get_length (gyacht_container_service_get_containers (self->service)),
+                             gyacht_service_is_loaded (GYACHT_SERVICE (self->service)));
+  g_signal_connect_swapped (self->service,
+                            "load-progress",
+                            G_CALLBACK (internal_load_progress_cb),
+                            self);
+}
+
+/* --- Public APIs --- */
+/**
+ * gyacht_container_list_view_handle_event:
+ * @self: a #GyachtContainerListView
+ * @event: a key press event of the toplevel
+ *
+ * Starts searching when @event types some text.
+ *
+ * Returns: %GDK_EVENT_STOP if the search bar handled @event
+ */
+gboolean
+gyacht_container_list_view_handle_event (GyachtContainerListView *self,
+                                         GdkEvent                *event)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER_LIST_VIEW (self), GDK_EVENT_PROPAGATE);
+
+  return gtk_search_bar_handle_event (self->search_bar, event);
 }
@@ -28,4 +28,7 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GyachtContainerListView, gyacht_container_list_view, GYACHT, CONTAINER_LIST_VIEW, GtkBox)
 
+gboolean  gyacht_container_list_view_handle_event (GyachtContainerListView *self,
+                                                   GdkEvent                *event);
+
 G_END_DECLS
@@ -29,5 +29,19 @@ G_BEGIN_DECLS
 
 GSequence * gyacht_container_parse_json_contents        (JsonParser  *parser,
                                                          GError     **error);
+GyachtContainer *
+            gyacht_container_parse_json_element         (JsonNode    *element_node);
+GSequence * gyacht_container_parse_api_contents         (JsonParser  *parser,
+                                                         GError     **error);
+GyachtContainer *
+            gyacht_container_new_from_event             (const gchar *id,
+                                                         const gchar *name,
+                                                         const gchar *image_name,
+                                                         gint64       created);
+void        gyacht_container_set_volatile               (GyachtContainer *self,
+                                                         gboolean         is_volatile);
+gboolean    gyacht_container_set_state                  (GyachtContainer      *self,
+                                                         GyachtContainerState  state,
+                                                         gint                  exit_code);
 
 G_END_DECLS
@@ -20,24 +20,52 @@
 
 #include "gyacht-container-private.h"
 #include "gyacht-container-service.h"
+#include "gyacht-container-state-monitor.h"
 #include "gyacht-debug.h"
+#include "gyacht-events-log.h"
 #include "gyacht-file-utils.h"
 #include "gyacht-path-manager.h"
+#include "gyacht-podman-client.h"
 
 #include <gio/gio.h>
 #include <json-glib/json-glib.h>
 
+/* While podman's events log is followed, changes of containers.json are
+ * already applied one by one. The file is then only reloaded to catch up
+ * with what the events could not tell, at most once per this delay.
+ */
+#define CONSISTENCY_RELOAD_DELAY  30  /* seconds */
+
+#define VOLATILE_CONTAINERS_JSON  "volatile-containers.json"
+
+#define API_CONTAINERS_PATH       PODMAN_API_PREFIX "/containers/json?all=true"
+
 struct _GyachtContainerService
 {
   GyachtService   parent_instance;
 
   GSequence       *containers;
+  GHashTable      *index;     /* id -> GSequenceIter of containers */
   GQueue          *jobs;
+  GHashTable      *seen;      /* ids met by the running load */
+  guint           reload_source;
+
+  /* --rm and other transient containers live in the runroot */
+  GFile           *volatile_location;
+  GFileMonitor    *volatile_monitor;
+
+  GyachtContainerStateMonitor *state_monitor;
+  GyachtEventsLog             *events_log;
+
+  /* Only with SOURCE_PODMAN_API */
+  GyachtPodmanClient          *client;
+  GHashTable                  *refreshing;  /* id -> whether it is stale */
 };
 
 enum {
   ASYNC_JOB_ERROR = 0,
-  ASYNC_JOB_LOAD
+  ASYNC_JOB_LOAD,
+  ASYNC_JOB_LOAD_VOLATILE
 };
 
 G_DEFINE_TYPE (GyachtContainerService, gyacht_container_service, GYACHT_TYPE_SERVICE)
@@ -46,6 +74,13 @@ G_DEFINE_TYPE (GyachtContainerService, gyacht_container_service, GYACHT_TYPE_SER
 static void internal_load_json_callback (GObject      *source_object,
                                          GAsyncResult *res,
                                          gpointer      user_data);
+static void internal_load_api_callback  (GObject      *source_object,
+                                         GAsyncResult *res,
+                                         gpointer      user_data);
+static void internal_load_contents      (GyachtContainerService *self,
+                                         gint                    job);
+static void internal_refresh_container  (GyachtContainerService *self,
+                                         const gchar            *id);
 
 
 static GFile *
@@ -74,16 +109,482 @@ internal_get_json_path (GyachtService *service)
   return g_file_new_for_path (json_path);
 }
 
+static const gchar *
+internal_get_api_path (GyachtService *service)
+{
+  return API_CONTAINERS_PATH;
+}
+
+static GFile *
+internal_get_volatile_json_path (GyachtContainerService *self)
+{
+  g_autofree gchar *json_path = NULL;
+  g_autofree gchar *file_dir = NULL;
+
+  /* TODO System level container dir */
+  file_dir = gyacht_dup_user_run_containers_dir ();
+
+  json_path = g_build_filename (file_dir, VOLATILE_CONTAINERS_JSON, NULL);
+  return g_file_new_for_path (json_path);
+}
+
 static void
-internal_clear_container_list (GyachtService *service)
+internal_state_changed_cb (GyachtContainerStateMonitor *monitor,
+                           const gchar                 *id,
+                           guint                        state,
+                           gint                         exit_code,
+                           gpointer                     user_data)
 {
-  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (service);
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (user_data);
+  GSequenceIter *iter;
+  GyachtContainer *container;
 
-  if (self->containers == NULL)
+  iter = g_hash_table_lookup (self->index, id);
+  if (iter == NULL)
     return;
 
-  g_sequence_free (self->containers);
-  self->containers = NULL;
+  container = g_sequence_get (iter);
+  if (gyacht_container_set_state (container, state, exit_code))
+    g_signal_emit_by_name (self, "item-changed", container);
+}
+
+/* Takes the ownership of @container. It does not start watching its state,
+ * callers either watch it on their own or sync the state monitor.
+ */
+static void
+internal_insert_container (GyachtContainerService *self,
+                           GyachtContainer        *container)
+{
+  const gchar *id = gyacht_container_get_id (container);
+  GyachtContainerState state;
+  GSequenceIter *iter;
+  gint exit_code;
+
+  /* Containers which are replaced keep their runtime state */
+  if (self->state_monitor &&
+      gyacht_container_state_monitor_lookup (self->state_monitor, id,
+                                             &state, &exit_code))
+    gyacht_container_set_state (container, state, exit_code);
+
+  iter = g_sequence_append (self->containers, container);
+  g_hash_table_insert (self->index, (gpointer) id, iter);
+
+  g_signal_emit_by_name (self, "item-added", container);
+}
+
+static void
+internal_remove_container (GyachtContainerService *self,
+                           GSequenceIter          *iter)
+{
+  GyachtContainer *container = g_sequence_get (iter);
+
+  /* The key is owned by the container, drop it first */
+  g_hash_table_remove (self->index, gyacht_container_get_id (container));
+
+  g_signal_emit_by_name (self, "item-removed", container);
+  g_sequence_remove (iter);
+}
+
+/* Merges a batch of a freshly parsed containers.json or
+ * volatile-containers.json into the model. Only containers which come from
+ * the same file are affected, and only the ones which actually differ are
+ * reported to the views. Those the load does not meet are removed by
+ * internal_merge_finish().
+ */
+static void
+internal_merge_batch (GyachtContainerService *self,
+                      GSequence              *new_containers,
+                      gboolean                is_volatile)
+{
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (new_containers);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GyachtContainer *container = g_sequence_get (iter);
+      const gchar *id = gyacht_container_get_id (container);
+      GSequenceIter *old_iter;
+
+      gyacht_container_set_volatile (container, is_volatile);
+      g_hash_table_add (self->seen, g_strdup (id));
+
+      old_iter = g_hash_table_lookup (self->index, id);
+      if (old_iter)
+        {
+          GyachtContainer *old = g_sequence_get (old_iter);
+
+          if (gyacht_container_is_volatile (old) == is_volatile &&
+              gyacht_container_equal (old, container))
+            {
+              /* Without the state monitor, the record carries the state */
+              if (self->state_monitor == NULL &&
+                  gyacht_container_set_state (old,
+                                              gyacht_container_get_state (container),
+                                              gyacht_container_get_exit_code (container)))
+                g_signal_emit_by_name (self, "item-changed", old);
+              continue;
+            }
+
+          internal_remove_container (self, old_iter);
+        }
+
+      internal_insert_container (self, g_object_ref (container));
+    }
+}
+
+static void
+internal_merge_finish (GyachtContainerService *self,
+                       gboolean                is_volatile)
+{
+  GSequenceIter *iter;
+  GSequenceIter *next;
+
+  GYACHT_TRACE_ENTRY;
+
+  for (iter = g_sequence_get_begin_iter (self->containers);
+       !g_sequence_iter_is_end (iter);
+       iter = next)
+    {
+      GyachtContainer *container = g_sequence_get (iter);
+
+      next = g_sequence_iter_next (iter);
+
+      if (gyacht_container_is_volatile (container) == is_volatile &&
+          !g_hash_table_contains (self->seen, gyacht_container_get_id (container)))
+        internal_remove_container (self, iter);
+    }
+
+  g_hash_table_remove_all (self->seen);
+
+  if (self->state_monitor)
+    gyacht_container_state_monitor_sync (self->state_monitor, self->containers);
+
+  GYACHT_TRACE_EXIT;
+}
+
+/* Merges a whole list at once, takes the ownership of @new_containers */
+static void
+internal_merge_containers (GyachtContainerService *self,
+                           GSequence              *new_containers,
+                           gboolean                is_volatile)
+{
+  internal_merge_batch (self, new_containers, is_volatile);
+  internal_merge_finish (self, is_volatile);
+  g_sequence_free (new_containers);
+}
+
+static gboolean
+internal_reload_timeout_cb (gpointer user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (user_data);
+
+  self->reload_source = 0;
+  internal_load_contents (self, ASYNC_JOB_LOAD);
+  internal_load_contents (self, ASYNC_JOB_LOAD_VOLATILE);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+internal_schedule_reload (GyachtContainerService *self)
+{
+  if (self->reload_source != 0)
+    return;
+
+  self->reload_source = g_timeout_add_seconds (CONSISTENCY_RELOAD_DELAY,
+                                               internal_reload_timeout_cb,
+                                               self);
+}
+
+static void
+internal_reload_now (GyachtContainerService *self)
+{
+  if (self->reload_source != 0)
+    {
+      g_source_remove (self->reload_source);
+      self->reload_source = 0;
+    }
+
+  internal_load_contents (self, ASYNC_JOB_LOAD);
+  internal_load_contents (self, ASYNC_JOB_LOAD_VOLATILE);
+}
+
+static void
+internal_container_event_cb (GyachtEventsLog *events_log,
+                             guint            status,
+                             const gchar     *id,
+                             const gchar     *name,
+                             const gchar     *image,
+                             gint64           time,
+                             gint             exit_code,
+                             gpointer         user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (user_data);
+  GSequenceIter *iter;
+
+  gyacht_trace ("%s: %u", id, status);
+
+  iter = g_hash_table_lookup (self->index, id);
+
+  switch (status)
+    {
+    case EVENT_STATUS_CREATE:
+      if (iter == NULL)
+        {
+          internal_insert_container (self,
+                                     gyacht_container_new_from_event (id, name, image, time));
+          gyacht_container_state_monitor_watch (self->state_monitor, id);
+        }
+      break;
+
+    case EVENT_STATUS_START:
+    case EVENT_STATUS_DIED:
+      if (iter == NULL)
+        {
+          /* We missed its creation */
+          internal_schedule_reload (self);
+          break;
+        }
+      gyacht_container_state_monitor_update (self->state_monitor, id,
+                                             status == EVENT_STATUS_START ?
+                                               CONTAINER_STATE_RUNNING :
+                                               CONTAINER_STATE_EXITED,
+                                             exit_code);
+      break;
+
+    case EVENT_STATUS_REMOVE:
+      if (iter)
+        {
+          gyacht_container_state_monitor_unwatch (self->state_monitor, id);
+          internal_remove_container (self, iter);
+        }
+      break;
+
+    default:
+      break;
+    }
+}
+
+/* Takes the ownership of @container, the freshly requested record of a
+ * single container.
+ */
+static void
+internal_merge_container (GyachtContainerService *self,
+                          GyachtContainer        *container)
+{
+  GSequenceIter *iter;
+
+  iter = g_hash_table_lookup (self->index, gyacht_container_get_id (container));
+  if (iter)
+    {
+      GyachtContainer *old = g_sequence_get (iter);
+
+      if (gyacht_container_equal (old, container))
+        {
+          if (gyacht_container_set_state (old,
+                                          gyacht_container_get_state (container),
+                                          gyacht_container_get_exit_code (container)))
+            g_signal_emit_by_name (self, "item-changed", old);
+
+          g_object_unref (container);
+          return;
+        }
+
+      internal_remove_container (self, iter);
+    }
+
+  internal_insert_container (self, container);
+}
+
+static void
+internal_refresh_callback (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (source_object);
+  g_autofree gchar *id = user_data;
+  g_autoptr(JsonParser) parser = NULL;
+  g_autoptr(GError) error = NULL;
+  GSequence *found = NULL;
+
+  parser = gyacht_service_load_json_finish (GYACHT_SERVICE (self),
+                                            res,
+                                            &error);
+  if (parser)
+    found = gyacht_container_parse_api_contents (parser, &error);
+
+  if (error)
+    {
+      gyacht_warn ("Unable to refresh container %s: %s", id, error->message);
+    }
+  else if (g_sequence_get_length (found) == 0)
+    {
+      GSequenceIter *iter = g_hash_table_lookup (self->index, id);
+
+      if (iter)
+        internal_remove_container (self, iter);
+    }
+  else
+    {
+      GSequenceIter *first = g_sequence_get_begin_iter (found);
+
+      internal_merge_container (self, g_object_ref (g_sequence_get (first)));
+    }
+
+  g_clear_pointer (&found, g_sequence_free);
+
+  /* More events came in while it was requested */
+  if (GPOINTER_TO_INT (g_hash_table_lookup (self->refreshing, id)))
+    {
+      g_hash_table_insert (self->refreshing, g_strdup (id), GINT_TO_POINTER (FALSE));
+      internal_refresh_container (self, id);
+    }
+  else
+    g_hash_table_remove (self->refreshing, id);
+}
+
+static void
+internal_refresh_container (GyachtContainerService *self,
+                            const gchar            *id)
+{
+  g_autofree gchar *filters = NULL;
+  g_autofree gchar *escaped = NULL;
+  g_autofree gchar *path = NULL;
+
+  /* Coalesce with the request on the fly, it is repeated when done */
+  if (g_hash_table_contains (self->refreshing, id))
+    {
+      g_hash_table_insert (self->refreshing, g_strdup (id), GINT_TO_POINTER (TRUE));
+      return;
+    }
+
+  g_hash_table_insert (self->refreshing, g_strdup (id), GINT_TO_POINTER (FALSE));
+
+  filters = g_strdup_printf ("{\"id\":[\"%s\"]}", id);
+  escaped = g_uri_escape_string (filters, NULL, FALSE);
+  path = g_strdup_printf ("%s&filters=%s", API_CONTAINERS_PATH, escaped);
+
+  gyacht_service_load_api_async (GYACHT_SERVICE (self),
+                                 path,
+                                 NULL,
+                                 internal_refresh_callback,
+                                 g_strdup (id));
+}
+
+static void
+internal_api_event_cb (GyachtPodmanClient *client,
+                       const gchar        *type,
+                       const gchar        *action,
+                       const gchar        *id,
+                       const gchar        *name,
+                       const gchar        *image,
+                       gint                exit_code,
+                       gpointer            user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (user_data);
+  GSequenceIter *iter;
+
+  if (g_strcmp0 (type, "container") != 0)
+    return;
+
+  gyacht_trace ("%s: %s", id, action);
+
+  if (g_str_equal (action, "remove"))
+    {
+      iter = g_hash_table_lookup (self->index, id);
+      if (iter)
+        internal_remove_container (self, iter);
+      return;
+    }
+
+  /* Only the container the event is about is requested again */
+  internal_refresh_container (self, id);
+}
+
+static void
+internal_monitor_event_cb (GyachtContainerService *self)
+{
+  if (gyacht_events_log_is_active (self->events_log))
+    internal_schedule_reload (self);
+  else
+    internal_load_contents (self, ASYNC_JOB_LOAD);
+}
+
+static void
+internal_volatile_monitor_changed_cb (GFileMonitor      *monitor,
+                                      GFile             *file,
+                                      GFile             *other_file,
+                                      GFileMonitorEvent  event_type,
+                                      gpointer           user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (user_data);
+
+  switch (event_type)
+    {
+    /* See internal_file_monitor_changed_cb() of GyachtService. The file
+     * disappears when the last volatile container is gone.
+     */
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_DELETED:
+      if (gyacht_events_log_is_active (self->events_log))
+        internal_schedule_reload (self);
+      else
+        internal_load_contents (self, ASYNC_JOB_LOAD_VOLATILE);
+      break;
+
+    default:
+      break;
+    }
+}
+
+static GObject *
+internal_parse_element (JsonNode *node)
+{
+  return (GObject *) gyacht_container_parse_json_element (node);
+}
+
+static void
+internal_load_batch_cb (GyachtService *service,
+                        GSequence     *batch,
+                        gpointer       user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (service);
+  gboolean is_volatile = GPOINTER_TO_INT (user_data) == ASYNC_JOB_LOAD_VOLATILE;
+
+  internal_merge_batch (self, batch, is_volatile);
+  gyacht_service_report_progress (service, g_sequence_get_length (self->containers), FALSE);
+}
+
+static void
+internal_run_job (GyachtContainerService *self,
+                  gint                    job)
+{
+  g_autoptr(GFile) location = NULL;
+
+  if (gyacht_service_get_source (GYACHT_SERVICE (self)) == SOURCE_PODMAN_API)
+    {
+      gyacht_service_load_api_async (GYACHT_SERVICE (self),
+                                     NULL,
+                                     NULL,
+                                     internal_load_api_callback,
+                                     GINT_TO_POINTER (job));
+      return;
+    }
+
+  if (job == ASYNC_JOB_LOAD_VOLATILE)
+    location = g_object_ref (self->volatile_location);
+  else
+    location = internal_get_json_path (GYACHT_SERVICE (self));
+
+  /* Containers show up batch by batch while the file is read */
+  gyacht_service_stream_json_file_async (GYACHT_SERVICE (self),
+                                         location,
+                                         internal_parse_element,
+                                         internal_load_batch_cb,
+                                         NULL,
+                                         internal_load_json_callback,
+                                         GINT_TO_POINTER (job));
 }
 
 static void
@@ -92,16 +593,48 @@ internal_execute_next_job (GyachtContainerService *self)
   g_queue_pop_head (self->jobs);
 
   if (!g_queue_is_empty (self->jobs))
-    gyacht_service_load_json_async (GYACHT_SERVICE (self),
-                                    NULL,
-                                    internal_load_json_callback,
-                                    NULL);
+    internal_run_job (self, GPOINTER_TO_INT (g_queue_peek_head (self->jobs)));
+  else
+    gyacht_service_report_progress (GYACHT_SERVICE (self),
+                                    g_sequence_get_length (self->containers),
+                                    TRUE);
 }
 
 static void
 internal_load_json_callback (GObject      *source_object,
                              GAsyncResult *res,
                              gpointer      user_data)
+{
+  GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (source_object);
+  gboolean is_volatile = GPOINTER_TO_INT (user_data) == ASYNC_JOB_LOAD_VOLATILE;
+  g_autoptr(GError) error = NULL;
+
+  gyacht_service_stream_json_finish (GYACHT_SERVICE (self), res, &error);
+  if (is_volatile && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+    {
+      /* No volatile container at all */
+      g_hash_table_remove_all (self->seen);
+    }
+  else if (error)
+    {
+      /* Keep what the batches brought, but do not drop anything */
+      gyacht_warn ("Unable to load json contents from file: %s",
+                   error->message);
+      g_hash_table_remove_all (self->seen);
+      goto do_next_job;
+    }
+
+  internal_merge_finish (self, is_volatile);
+  g_signal_emit_by_name (self, "list-updated", 0);
+
+do_next_job:
+  internal_execute_next_job (self);
+}
+
+static void
+internal_load_api_callback (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
 {
   GyachtContainerService *self = GYACHT_CONTAINER_SERVICE (source_object);
   g_autoptr(JsonParser) parser = NULL;
@@ -113,12 +646,12 @@ internal_load_json_callback (GObject      *source_object,
                                             &error);
   if (error)
     {
-      gyacht_warn ("Unable to load json contents from file: %s",
+      gyacht_warn ("Unable to load containers from podman: %s",
                    error->message);
       goto do_next_job;
     }
 
-  new_containers = gyacht_container_parse_json_contents (parser, &error);
+  new_containers = gyacht_container_parse_api_contents (parser, &error);
   if (error)
     {
       gyacht_warn ("Unable to parse json contents: %s",
@@ -126,7 +659,7 @@ internal_load_json_callback (GObject      *source_object,
       goto do_next_job;
     }
 
-  self->containers = new_containers;
+  internal_merge_containers (self, new_containers, FALSE);
   g_signal_emit_by_name (self, "list-updated", 0);
 
 do_next_job:
@@ -134,18 +667,36 @@ do_next_job:
 }
 
 static void
-internal_load_contents (GyachtContainerService *self)
+internal_load_contents (GyachtContainerService *self,
+                        gint                    job)
 {
+  GList *pending;
+
   GYACHT_TRACE_ENTRY;
 
-  g_queue_push_tail (self->jobs, GINT_TO_POINTER (ASYNC_JOB_LOAD));
+  /* podman lists the volatile containers along with the others */
+  if (job == ASYNC_JOB_LOAD_VOLATILE &&
+      gyacht_service_get_source (GYACHT_SERVICE (self)) == SOURCE_PODMAN_API)
+    {
+      GYACHT_TRACE_EXIT;
+      return;
+    }
+
+  /* The same load is already waiting behind the running one, it will
+   * read the latest contents anyway.
+   */
+  pending = g_queue_peek_head_link (self->jobs);
+  if (pending && g_list_find (pending->next, GINT_TO_POINTER (job)))
+    {
+      GYACHT_TRACE_EXIT;
+      return;
+    }
+
+  g_queue_push_tail (self->jobs, GINT_TO_POINTER (job));
 
   /* Run if it has only one job in which is just pushed */
   if (g_queue_get_length (self->jobs) == 1)
-    gyacht_service_load_json_async (GYACHT_SERVICE (self),
-                                    NULL,
-                                    internal_load_json_callback,
-                                    NULL);
+    internal_run_job (self, job);
 
   GYACHT_TRACE_EXIT;
 }
@@ -158,13 +709,53 @@ gyacht_container_service_finalize (GObject *object)
 
   GYACHT_TRACE_ENTRY;
 
-  internal_clear_container_list (GYACHT_SERVICE (self));
-
   g_signal_handlers_disconnect_by_func (self,
-                                        G_CALLBACK (internal_load_contents),
+                                        G_CALLBACK (internal_monitor_event_cb),
                                         NULL);
 
+  if (self->reload_source != 0)
+    g_source_remove (self->reload_source);
+
   g_queue_free (self->jobs);
+  g_hash_table_unref (self->seen);
+  g_hash_table_unref (self->index);
+  g_sequence_free (self->containers);
+
+  if (self->volatile_monitor)
+    g_signal_handlers_disconnect_by_func (self->volatile_monitor,
+                                          G_CALLBACK (internal_volatile_monitor_changed_cb),
+                                          self);
+  g_clear_object (&self->volatile_monitor);
+  g_clear_object (&self->volatile_location);
+
+  if (self->state_monitor)
+    g_signal_handlers_disconnect_by_func (self->state_monitor,
+                                          G_CALLBACK (internal_state_changed_cb),
+                                          self);
+  g_clear_object (&self->state_monitor);
+
+  if (self->events_log)
+    {
+      g_signal_handlers_disconnect_by_func (self->events_log,
+                                            G_CALLBACK (internal_container_event_cb),
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->events_log,
+                                            G_CALLBACK (internal_reload_now),
+                                            self);
+    }
+  g_clear_object (&self->events_log);
+
+  if (self->client)
+    {
+      g_signal_handlers_disconnect_by_func (self->client,
+                                            G_CALLBACK (internal_api_event_cb),
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->client,
+                                            G_CALLBACK (internal_reload_now),
+                                            self);
+      gyacht_podman_client_unwatch_events (self->client);
+    }
+  g_hash_table_unref (self->refreshing);
 
   GYACHT_TRACE_EXIT;
 
@@ -179,15 +770,64 @@ gyacht_container_service_constructed (GObject *object)
 
   G_OBJECT_CLASS (gyacht_container_service_parent_class)->constructed (object);
 
-  if (!gyacht_service_error_occur (service))
+  if (gyacht_service_get_source (service) == SOURCE_PODMAN_API)
+    {
+      /* podman knows the state and the volatile containers itself */
+      self->client = gyacht_podman_client_get_default ();
+      g_signal_connect (self->client,
+                        "event",
+                        G_CALLBACK (internal_api_event_cb),
+                        self);
+      g_signal_connect_swapped (self->client,
+                                "resync-needed",
+                                G_CALLBACK (internal_reload_now),
+                                self);
+      gyacht_podman_client_watch_events (self->client);
+
+      internal_load_contents (self, ASYNC_JOB_LOAD);
+    }
+  else if (!gyacht_service_error_occur (service))
     {
       g_signal_connect (self,
                         "monitor-event-triggered",
-                        G_CALLBACK (internal_load_contents),
+                        G_CALLBACK (internal_monitor_event_cb),
                         NULL);
 
-      internal_load_contents (self);
+      self->state_monitor = gyacht_container_state_monitor_new ();
+      g_signal_connect (self->state_monitor,
+                        "state-changed",
+                        G_CALLBACK (internal_state_changed_cb),
+                        self);
+
+      self->events_log = gyacht_events_log_new ();
+      g_signal_connect (self->events_log,
+                        "container-event",
+                        G_CALLBACK (internal_container_event_cb),
+                        self);
+      g_signal_connect_swapped (self->events_log,
+                                "resync-needed",
+                                G_CALLBACK (internal_reload_now),
+                                self);
+
+      /* The file comes and goes with the volatile containers, so it is
+       * not an error for it to be missing.
+       */
+      self->volatile_location = internal_get_volatile_json_path (self);
+      self->volatile_monitor = g_file_monitor_file (self->volatile_location,
+                                                    G_FILE_MONITOR_NONE,
+                                                    NULL,
+                                                    NULL);
+      if (self->volatile_monitor)
+        g_signal_connect (self->volatile_monitor,
+                          "changed",
+                          G_CALLBACK (internal_volatile_monitor_changed_cb),
+                          self);
+
+      internal_load_contents (self, ASYNC_JOB_LOAD);
+      internal_load_contents (self, ASYNC_JOB_LOAD_VOLATILE);
     }
+  else
+    gyacht_service_report_progress (service, 0, TRUE);
 }
 
 static void
@@ -199,15 +839,19 @@ gyacht_container_service_class_init (GyachtContainerServiceClass *klass)
   object_class->finalize = gyacht_container_service_finalize;
   object_class->constructed = gyacht_container_service_constructed;
 
-  service_class->clear_list = internal_clear_container_list;
   service_class->get_json_path = internal_get_json_path;
+  service_class->get_api_path = internal_get_api_path;
 }
 
 static void
 gyacht_container_service_init (GyachtContainerService *self)
 {
-  self->containers = NULL;
+  self->containers = g_sequence_new (g_object_unref);
+  self->index = g_hash_table_new (g_str_hash, g_str_equal);
   self->jobs = g_queue_new ();
+  self->seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->reload_source = 0;
+  self->refreshing = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 /* --- Public APIs --- */
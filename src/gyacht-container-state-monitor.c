@@ -0,0 +1,711 @@
+/* gyacht-container-state-monitor.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-container-state-monitor.h"
+#include "gyacht-debug.h"
+#include "gyacht-path-manager.h"
+
+#include <gio/gio.h>
+
+/* The monitor never reads containers.json. It follows the files which
+ * conmon and podman leave in the runroot,
+ *
+ *   libpod/tmp/exits/<id>                      written when a container exits
+ *   overlay-containers/<id>/userdata/pidfile   written when a container starts
+ *
+ * and reports a single container whenever one of them changes.
+ */
+
+typedef struct
+{
+  gchar                 *id;
+  GyachtContainerState  state;
+  gint                  exit_code;
+} StateEntry;
+
+struct _GyachtContainerStateMonitor
+{
+  GObject       parent_instance;
+
+  gchar         *exits_dir;
+  gchar         *run_dir;
+
+  GFileMonitor  *exits_monitor;
+  GFileMonitor  *run_monitor;
+  GHashTable    *userdata_monitors;  /* id -> GFileMonitor */
+  GHashTable    *states;             /* id -> StateEntry */
+
+  GCancellable  *cancellable;
+};
+
+/* Signals */
+enum {
+  STATE_CHANGED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtContainerStateMonitor, gyacht_container_state_monitor, G_TYPE_OBJECT)
+
+static void internal_container_dir_monitor_changed_cb (GFileMonitor      *monitor,
+                                                       GFile             *file,
+                                                       GFile             *other_file,
+                                                       GFileMonitorEvent  event_type,
+                                                       gpointer           user_data);
+
+
+static StateEntry *
+internal_state_entry_new (const gchar          *id,
+                          GyachtContainerState  state,
+                          gint                  exit_code)
+{
+  StateEntry *entry = g_new0 (StateEntry, 1);
+
+  entry->id = g_strdup (id);
+  entry->state = state;
+  entry->exit_code = exit_code;
+
+  return entry;
+}
+
+static void
+internal_state_entry_free (gpointer data)
+{
+  StateEntry *entry = data;
+
+  g_free (entry->id);
+  g_free (entry);
+}
+
+static gboolean
+internal_parse_exit_code (const gchar *contents,
+                          gint        *exit_code)
+{
+  gchar *end = NULL;
+  gint64 code;
+
+  if (contents == NULL || *contents == '\0')
+    return FALSE;
+
+  code = g_ascii_strtoll (contents, &end, 10);
+  if (end == contents)
+    return FALSE;
+
+  *exit_code = (gint) code;
+  return TRUE;
+}
+
+/* May be called from a worker thread, so it only touches the paths. */
+static GyachtContainerState
+internal_probe_state (const gchar *exits_dir,
+                      const gchar *run_dir,
+                      const gchar *id,
+                      gint        *exit_code)
+{
+  g_autofree gchar *exit_path = NULL;
+  g_autofree gchar *userdata_path = NULL;
+  g_autofree gchar *pid_path = NULL;
+  g_autofree gchar *contents = NULL;
+
+  *exit_code = 0;
+
+  exit_path = g_build_filename (exits_dir, id, NULL);
+  if (g_file_get_contents (exit_path, &contents, NULL, NULL) &&
+      internal_parse_exit_code (contents, exit_code))
+    return CONTAINER_STATE_EXITED;
+
+  userdata_path = g_build_filename (run_dir, id, USERDATA_DIR, NULL);
+  pid_path = g_build_filename (userdata_path, PIDFILE, NULL);
+  if (g_file_test (pid_path, G_FILE_TEST_EXISTS))
+    return CONTAINER_STATE_RUNNING;
+
+  if (g_file_test (userdata_path, G_FILE_TEST_IS_DIR))
+    return CONTAINER_STATE_CREATED;
+
+  return CONTAINER_STATE_UNKNOWN;
+}
+
+static void
+internal_update_state (GyachtContainerStateMonitor *self,
+                       const gchar                 *id,
+                       GyachtContainerState         state,
+                       gint                         exit_code)
+{
+  StateEntry *entry;
+
+  /* Ignore containers which are not part of the model (anymore) */
+  entry = g_hash_table_lookup (self->states, id);
+  if (entry == NULL)
+    return;
+
+  if (entry->state == state && entry->exit_code == exit_code)
+    return;
+
+  gyacht_trace ("%s: %d -> %d (%d)", id, entry->state, state, exit_code);
+
+  entry->state = state;
+  entry->exit_code = exit_code;
+
+  g_signal_emit (self, signals[STATE_CHANGED], 0, id, state, exit_code);
+}
+
+/* --- Probing --- */
+static void
+internal_probe_io_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (source_object);
+  gchar **ids = task_data;
+  GPtrArray *results;
+  guint i;
+
+  results = g_ptr_array_new_with_free_func (internal_state_entry_free);
+
+  for (i = 0; ids[i] != NULL; i++)
+    {
+      GyachtContainerState state;
+      gint exit_code;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      state = internal_probe_state (self->exits_dir, self->run_dir,
+                                    ids[i], &exit_code);
+      g_ptr_array_add (results,
+                       internal_state_entry_new (ids[i], state, exit_code));
+    }
+
+  g_task_return_pointer (task, results, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+internal_probe_callback (GObject      *source_object,
+                         GAsyncResult *res,
+                         gpointer      user_data)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (source_object);
+  g_autoptr(GPtrArray) results = NULL;
+  guint i;
+
+  results = g_task_propagate_pointer (G_TASK (res), NULL);
+  if (results == NULL)
+    return;
+
+  for (i = 0; i < results->len; i++)
+    {
+      StateEntry *result = g_ptr_array_index (results, i);
+
+      internal_update_state (self, result->id, result->state, result->exit_code);
+    }
+}
+
+static void
+internal_probe_async (GyachtContainerStateMonitor *self,
+                      GPtrArray                   *ids)
+{
+  g_autoptr(GTask) task = NULL;
+  gchar **strv;
+
+  if (ids->len == 0)
+    {
+      g_ptr_array_unref (ids);
+      return;
+    }
+
+  g_ptr_array_add (ids, NULL);
+  strv = (gchar **) g_ptr_array_free (ids, FALSE);
+
+  task = g_task_new (self, self->cancellable, internal_probe_callback, NULL);
+  g_task_set_task_data (task, strv, (GDestroyNotify) g_strfreev);
+  g_task_run_in_thread (task, internal_probe_io_thread);
+}
+
+static void
+internal_probe_one (GyachtContainerStateMonitor *self,
+                    const gchar                 *id)
+{
+  GPtrArray *ids = g_ptr_array_new ();
+
+  g_ptr_array_add (ids, g_strdup (id));
+  internal_probe_async (self, ids);
+}
+
+/* --- File monitors --- */
+static void
+internal_exit_file_loaded_cb (GObject      *source_object,
+                              GAsyncResult *res,
+                              gpointer      user_data)
+{
+  g_autoptr(GyachtContainerStateMonitor) self = user_data;
+  g_autofree gchar *contents = NULL;
+  g_autofree gchar *id = NULL;
+  g_autoptr(GError) error = NULL;
+  gint exit_code;
+
+  if (!g_file_load_contents_finish (G_FILE (source_object), res,
+                                    &contents, NULL, NULL, &error))
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        gyacht_debug ("Unable to read exit file: %s", error->message);
+      return;
+    }
+
+  /* conmon creates the file before writing the code, wait for the next hint */
+  if (!internal_parse_exit_code (contents, &exit_code))
+    return;
+
+  id = g_file_get_basename (G_FILE (source_object));
+  internal_update_state (self, id, CONTAINER_STATE_EXITED, exit_code);
+}
+
+static void
+internal_exits_monitor_changed_cb (GFileMonitor      *monitor,
+                                   GFile             *file,
+                                   GFile             *other_file,
+                                   GFileMonitorEvent  event_type,
+                                   gpointer           user_data)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (user_data);
+  g_autofree gchar *id = g_file_get_basename (file);
+
+  if (!g_hash_table_contains (self->states, id))
+    return;
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+      g_file_load_contents_async (file,
+                                  self->cancellable,
+                                  internal_exit_file_loaded_cb,
+                                  g_object_ref (self));
+      break;
+
+    /* podman removes the exit file right before restarting a container */
+    case G_FILE_MONITOR_EVENT_DELETED:
+      internal_probe_one (self, id);
+      break;
+
+    default:
+      break;
+    }
+}
+
+static void
+internal_userdata_monitor_changed_cb (GFileMonitor      *monitor,
+                                      GFile             *file,
+                                      GFile             *other_file,
+                                      GFileMonitorEvent  event_type,
+                                      gpointer           user_data)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (user_data);
+  g_autofree gchar *basename = g_file_get_basename (file);
+  const gchar *id;
+
+  if (g_strcmp0 (basename, PIDFILE) != 0)
+    return;
+
+  id = g_object_get_data (G_OBJECT (monitor), "id");
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+      internal_update_state (self, id, CONTAINER_STATE_RUNNING, 0);
+      break;
+
+    case G_FILE_MONITOR_EVENT_DELETED:
+      internal_probe_one (self, id);
+      break;
+
+    default:
+      break;
+    }
+}
+
+static void
+internal_userdata_monitor_free (gpointer data)
+{
+  GFileMonitor *monitor = data;
+
+  g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_FUNC,
+                                        0, 0, NULL,
+                                        internal_userdata_monitor_changed_cb,
+                                        NULL);
+  g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_FUNC,
+                                        0, 0, NULL,
+                                        internal_container_dir_monitor_changed_cb,
+                                        NULL);
+  g_file_monitor_cancel (monitor);
+  g_object_unref (monitor);
+}
+
+static void
+internal_attach (GyachtContainerStateMonitor *self,
+                 const gchar                 *id)
+{
+  g_autofree gchar *dir = NULL;
+  g_autofree gchar *userdata = NULL;
+  g_autoptr(GFile) location = NULL;
+  GFileMonitor *monitor;
+  GCallback callback;
+
+  /* GIO polls a directory which does not exist yet, so follow the deepest
+   * one which does and move down as conmon creates the others. Until the
+   * container directory shows up, the run directory monitor reports it.
+   */
+  dir = g_build_filename (self->run_dir, id, NULL);
+  userdata = g_build_filename (dir, USERDATA_DIR, NULL);
+  if (g_file_test (userdata, G_FILE_TEST_IS_DIR))
+    {
+      location = g_file_new_for_path (userdata);
+      callback = G_CALLBACK (internal_userdata_monitor_changed_cb);
+    }
+  else if (g_file_test (dir, G_FILE_TEST_IS_DIR))
+    {
+      location = g_file_new_for_path (dir);
+      callback = G_CALLBACK (internal_container_dir_monitor_changed_cb);
+    }
+  else
+    {
+      g_hash_table_remove (self->userdata_monitors, id);
+      return;
+    }
+
+  monitor = g_file_monitor_directory (location, G_FILE_MONITOR_NONE, NULL, NULL);
+  if (monitor == NULL)
+    return;
+
+  g_object_set_data_full (G_OBJECT (monitor), "id", g_strdup (id), g_free);
+  g_signal_connect (monitor, "changed", callback, self);
+
+  g_hash_table_insert (self->userdata_monitors, g_strdup (id), monitor);
+}
+
+static void
+internal_container_dir_monitor_changed_cb (GFileMonitor      *monitor,
+                                           GFile             *file,
+                                           GFile             *other_file,
+                                           GFileMonitorEvent  event_type,
+                                           gpointer           user_data)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (user_data);
+  g_autofree gchar *basename = g_file_get_basename (file);
+  g_autofree gchar *id = NULL;
+
+  if (event_type != G_FILE_MONITOR_EVENT_CREATED ||
+      g_strcmp0 (basename, USERDATA_DIR) != 0)
+    return;
+
+  /* Attaching replaces, and so frees, this monitor */
+  id = g_strdup (g_object_get_data (G_OBJECT (monitor), "id"));
+  internal_attach (self, id);
+
+  /* The pidfile may have been written before the new monitor was set up */
+  internal_probe_one (self, id);
+}
+
+static void
+internal_run_monitor_changed_cb (GFileMonitor      *monitor,
+                                 GFile             *file,
+                                 GFile             *other_file,
+                                 GFileMonitorEvent  event_type,
+                                 gpointer           user_data)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (user_data);
+  g_autofree gchar *id = g_file_get_basename (file);
+
+  if (event_type != G_FILE_MONITOR_EVENT_CREATED ||
+      !g_hash_table_contains (self->states, id) ||
+      g_hash_table_contains (self->userdata_monitors, id))
+    return;
+
+  internal_attach (self, id);
+  internal_probe_one (self, id);
+}
+
+static void
+internal_watch (GyachtContainerStateMonitor *self,
+                const gchar                 *id)
+{
+  g_hash_table_insert (self->states,
+                       g_strdup (id),
+                       internal_state_entry_new (id, CONTAINER_STATE_UNKNOWN, 0));
+
+  internal_attach (self, id);
+}
+
+/* --- GObject --- */
+static void
+gyacht_container_state_monitor_finalize (GObject *object)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (object);
+
+  GYACHT_TRACE_ENTRY;
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  if (self->exits_monitor)
+    g_signal_handlers_disconnect_by_func (self->exits_monitor,
+                                          G_CALLBACK (internal_exits_monitor_changed_cb),
+                                          self);
+  g_clear_object (&self->exits_monitor);
+
+  if (self->run_monitor)
+    g_signal_handlers_disconnect_by_func (self->run_monitor,
+                                          G_CALLBACK (internal_run_monitor_changed_cb),
+                                          self);
+  g_clear_object (&self->run_monitor);
+
+  g_hash_table_unref (self->userdata_monitors);
+  g_hash_table_unref (self->states);
+
+  g_free (self->exits_dir);
+  g_free (self->run_dir);
+
+  GYACHT_TRACE_EXIT;
+
+  G_OBJECT_CLASS (gyacht_container_state_monitor_parent_class)->finalize (object);
+}
+
+static void
+gyacht_container_state_monitor_constructed (GObject *object)
+{
+  GyachtContainerStateMonitor *self = GYACHT_CONTAINER_STATE_MONITOR (object);
+  g_autoptr(GFile) location = NULL;
+  g_autoptr(GError) error = NULL;
+
+  G_OBJECT_CLASS (gyacht_container_state_monitor_parent_class)->constructed (object);
+
+  location = g_file_new_for_path (self->run_dir);
+  self->run_monitor = g_file_monitor_directory (location,
+                                                G_FILE_MONITOR_NONE,
+                                                NULL,
+                                                &error);
+  if (error)
+    {
+      gyacht_debug ("Unable to monitor %s: %s", self->run_dir, error->message);
+      g_clear_error (&error);
+    }
+  else
+    g_signal_connect (self->run_monitor,
+                      "changed",
+                      G_CALLBACK (internal_run_monitor_changed_cb),
+                      self);
+  g_clear_object (&location);
+
+  location = g_file_new_for_path (self->exits_dir);
+  self->exits_monitor = g_file_monitor_directory (location,
+                                                  G_FILE_MONITOR_NONE,
+                                                  NULL,
+                                                  &error);
+  if (error)
+    {
+      gyacht_warn ("Unable to monitor exit files: %s", error->message);
+      return;
+    }
+
+  g_signal_connect (self->exits_monitor,
+                    "changed",
+                    G_CALLBACK (internal_exits_monitor_changed_cb),
+                    self);
+}
+
+static void
+gyacht_container_state_monitor_class_init (GyachtContainerStateMonitorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_container_state_monitor_finalize;
+  object_class->constructed = gyacht_container_state_monitor_constructed;
+
+  signals [STATE_CHANGED] =
+    g_signal_new ("state-changed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 3,
+                  G_TYPE_STRING,
+                  G_TYPE_UINT,
+                  G_TYPE_INT);
+}
+
+static void
+gyacht_container_state_monitor_init (GyachtContainerStateMonitor *self)
+{
+  self->exits_dir = gyacht_dup_user_exits_dir ();
+  self->run_dir = gyacht_dup_user_run_containers_dir ();
+
+  self->userdata_monitors = g_hash_table_new_full (g_str_hash,
+                                                   g_str_equal,
+                                                   g_free,
+                                                   internal_userdata_monitor_free);
+  self->states = g_hash_table_new_full (g_str_hash,
+                                        g_str_equal,
+                                        g_free,
+                                        internal_state_entry_free);
+
+  self->cancellable = g_cancellable_new ();
+}
+
+/* --- Public APIs --- */
+GyachtContainerStateMonitor *
+gyacht_container_state_monitor_new (void)
+{
+  return g_object_new (GYACHT_TYPE_CONTAINER_STATE_MONITOR, NULL);
+}
+
+/**
+ * gyacht_container_state_monitor_sync:
+ * @self: A #GyachtContainerStateMonitor.
+ * @containers: (nullable): #GSequence of #GyachtContainer.
+ *
+ * Makes the set of watched containers match @containers. Containers which
+ * are new to the monitor are probed in a worker thread and reported through
+ * #GyachtContainerStateMonitor::state-changed, the others keep their state.
+ */
+void
+gyacht_container_state_monitor_sync (GyachtContainerStateMonitor *self,
+                                     GSequence                   *containers)
+{
+  g_autoptr(GHashTable) alive = NULL;
+  GPtrArray *new_ids;
+  GHashTableIter iter;
+  GSequenceIter *it;
+  gpointer key;
+
+  GYACHT_TRACE_ENTRY;
+
+  g_return_if_fail (GYACHT_IS_CONTAINER_STATE_MONITOR (self));
+
+  alive = g_hash_table_new (g_str_hash, g_str_equal);
+  new_ids = g_ptr_array_new ();
+
+  if (containers)
+    for (it = g_sequence_get_begin_iter (containers);
+         !g_sequence_iter_is_end (it);
+         it = g_sequence_iter_next (it))
+      {
+        const gchar *id = gyacht_container_get_id (g_sequence_get (it));
+
+        g_hash_table_add (alive, (gpointer) id);
+
+        if (!g_hash_table_contains (self->states, id))
+          {
+            internal_watch (self, id);
+            g_ptr_array_add (new_ids, g_strdup (id));
+          }
+      }
+
+  g_hash_table_iter_init (&iter, self->states);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      if (g_hash_table_contains (alive, key))
+        continue;
+
+      g_hash_table_remove (self->userdata_monitors, key);
+      g_hash_table_iter_remove (&iter);
+    }
+
+  internal_probe_async (self, new_ids);
+
+  GYACHT_TRACE_EXIT;
+}
+
+/**
+ * gyacht_container_state_monitor_lookup:
+ * @self: A #GyachtContainerStateMonitor.
+ * @id: The container id.
+ * @state: (out): Return location for the last known state.
+ * @exit_code: (out): Return location for the last known exit code.
+ *
+ * Return value: %TRUE if @id is watched and its state has been probed.
+ */
+gboolean
+gyacht_container_state_monitor_lookup (GyachtContainerStateMonitor *self,
+                                       const gchar                 *id,
+                                       GyachtContainerState        *state,
+                                       gint                        *exit_code)
+{
+  StateEntry *entry;
+
+  g_return_val_if_fail (GYACHT_IS_CONTAINER_STATE_MONITOR (self), FALSE);
+  g_return_val_if_fail (id != NULL, FALSE);
+
+  entry = g_hash_table_lookup (self->states, id);
+  if (entry == NULL || entry->state == CONTAINER_STATE_UNKNOWN)
+    return FALSE;
+
+  *state = entry->state;
+  *exit_code = entry->exit_code;
+
+  return TRUE;
+}
+
+/**
+ * gyacht_container_state_monitor_update:
+ * @self: A #GyachtContainerStateMonitor.
+ * @id: The container id.
+ * @state: The new state.
+ * @exit_code: The exit code, only meaningful for %CONTAINER_STATE_EXITED.
+ *
+ * Records a state learned from another source, e.g. the events log.
+ * #GyachtContainerStateMonitor::state-changed is emitted if it differs
+ * from the last known state of a watched container.
+ */
+void
+gyacht_container_state_monitor_update (GyachtContainerStateMonitor *self,
+                                       const gchar                 *id,
+                                       GyachtContainerState         state,
+                                       gint                         exit_code)
+{
+  g_return_if_fail (GYACHT_IS_CONTAINER_STATE_MONITOR (self));
+  g_return_if_fail (id != NULL);
+
+  internal_update_state (self, id, state, exit_code);
+}
+
+void
+gyacht_container_state_monitor_watch (GyachtContainerStateMonitor *self,
+                                      const gchar                 *id)
+{
+  g_return_if_fail (GYACHT_IS_CONTAINER_STATE_MONITOR (self));
+  g_return_if_fail (id != NULL);
+
+  if (g_hash_table_contains (self->states, id))
+    return;
+
+  internal_watch (self, id);
+  internal_probe_one (self, id);
+}
+
+void
+gyacht_container_state_monitor_unwatch (GyachtContainerStateMonitor *self,
+                                        const gchar                 *id)
+{
+  g_return_if_fail (GYACHT_IS_CONTAINER_STATE_MONITOR (self));
+  g_return_if_fail (id != NULL);
+
+  g_hash_table_remove (self->userdata_monitors, id);
+  g_hash_table_remove (self->states, id);
+}
@@ -0,0 +1,50 @@
+/* gyacht-container-state-monitor.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "gyacht-container.h"
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_CONTAINER_STATE_MONITOR (gyacht_container_state_monitor_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtContainerStateMonitor, gyacht_container_state_monitor, GYACHT, CONTAINER_STATE_MONITOR, GObject)
+
+GyachtContainerStateMonitor *
+          gyacht_container_state_monitor_new      (void);
+void      gyacht_container_state_monitor_sync     (GyachtContainerStateMonitor *self,
+                                                   GSequence                   *containers);
+gboolean  gyacht_container_state_monitor_lookup   (GyachtContainerStateMonitor *self,
+                                                   const gchar                 *id,
+                                                   GyachtContainerState        *state,
+                                                   gint                        *exit_code);
+void      gyacht_container_state_monitor_update   (GyachtContainerStateMonitor *self,
+                                                   const gchar                 *id,
+                                                   GyachtContainerState         state,
+                                                   gint                         exit_code);
+void      gyacht_container_state_monitor_watch    (GyachtContainerStateMonitor *self,
+                                                   const gchar                 *id);
+void      gyacht_container_state_monitor_unwatch  (GyachtContainerStateMonitor *self,
+                                                   const gchar                 *id);
+
+G_END_DECLS
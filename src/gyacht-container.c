@@ -19,6 +19,7 @@
  */
 
 #include "gyacht-container.h"
+#include "gyacht-container-private.h"
 #include "gyacht-debug.h"
 #include "gyacht-macros.h"
 
@@ -34,12 +35,18 @@ struct _GyachtContainer
   GPtrArray     *names;
   gchar         *image;
   gchar         *image_name;
+  gchar         *pod_name;  /* Only given by podman's API */
   gchar         *layer;
   gchar         *metadata;
   GDateTime     *created;
   GPtrArray     *uidmaps;
   GPtrArray     *gidmaps;
   GHashTable    *flags;
+
+  /* Runtime information, not stored in containers.json */
+  GyachtContainerState  state;
+  gint                  exit_code;
+  gboolean              is_volatile;  /* From volatile-containers.json */
 };
 
 G_DEFINE_TYPE (GyachtContainer, gyacht_container, G_TYPE_OBJECT)
@@ -89,6 +96,7 @@ gyacht_container_finalize (GObject *object)
     g_ptr_array_unref (self->names);
   g_free (self->image);
   g_free (self->image_name);
+  g_free (self->pod_name);
   g_free (self->layer);
   g_free (self->metadata);
   if (self->created)
@@ -252,7 +260,8 @@ gyacht_container_class_init (GyachtContainerClass *klass)
 static void
 gyacht_container_init (GyachtContainer *self)
 {
-
+  self->state = CONTAINER_STATE_UNKNOWN;
+  self->exit_code = 0;
 }
 
 /* --- Setters --- */
@@ -372,6 +381,31 @@ gyacht_container_set_layer (GyachtContainer *self,
 }
 
 
+/* Metadata is a flat json object of strings */
+static gchar *
+internal_metadata_dup_member (const gchar *metadata,
+                              const gchar *member)
+{
+  g_autofree gchar *needle = g_strdup_printf ("\"%s\"", member);
+  const gchar *start, *end;
+
+  start = strstr (metadata, needle);
+  if (start == NULL)
+    return NULL;
+
+  start = strchr (start + strlen (needle), ':');
+  if (start)
+    start = strchr (start, '"');
+  if (start == NULL)
+    return NULL;
+
+  end = strchr (++start, '"');
+  if (end == NULL)
+    return NULL;
+
+  return g_strndup (start, end - start);
+}
+
 static void
 gyacht_container_set_metadata (GyachtContainer *self,
                                const gchar     *new_metadata)
@@ -383,6 +417,9 @@ gyacht_container_set_metadata (GyachtContainer *self,
       g_free (self->metadata);
       self->metadata = g_strdup (new_metadata);
       gyacht_container_set_image_name (self, new_metadata);
+
+      g_free (self->pod_name);
+      self->pod_name = internal_metadata_dup_member (new_metadata, "pod-name");
     }
 }
 
@@ -442,6 +479,89 @@ gyacht_container_set_flags (GyachtContainer *self,
     }
 }
 
+/* --- Private APIs --- */
+
+/**
+ * gyacht_container_set_state:
+ * @self: A #GyachtContainer.
+ * @state: The new #GyachtContainerState.
+ * @exit_code: The exit code, only meaningful for %CONTAINER_STATE_EXITED.
+ *
+ * Return value: %TRUE if the state of @self has been changed.
+ */
+gboolean
+gyacht_container_set_state (GyachtContainer      *self,
+                            GyachtContainerState  state,
+                            gint                  exit_code)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), FALSE);
+  g_return_val_if_fail (state < N_CONTAINER_STATES, FALSE);
+
+  if (state != CONTAINER_STATE_EXITED)
+    exit_code = 0;
+
+  if (self->state == state && self->exit_code == exit_code)
+    return FALSE;
+
+  self->state = state;
+  self->exit_code = exit_code;
+
+  return TRUE;
+}
+
+void
+gyacht_container_set_volatile (GyachtContainer *self,
+                               gboolean         is_volatile)
+{
+  g_return_if_fail (GYACHT_IS_CONTAINER (self));
+
+  self->is_volatile = !!is_volatile;
+}
+
+/**
+ * gyacht_container_new_from_event:
+ * @id: The container id.
+ * @name: (nullable): The container name.
+ * @image_name: (nullable): The name of the image the container is based on.
+ * @created: The creation time as a unix timestamp.
+ *
+ * Creates a container from the few fields a podman event carries. It stands
+ * in until the next load of containers.json brings the complete record.
+ *
+ * Return value: (transfer full): A new #GyachtContainer.
+ */
+GyachtContainer *
+gyacht_container_new_from_event (const gchar *id,
+                                 const gchar *name,
+                                 const gchar *image_name,
+                                 gint64       created)
+{
+  GyachtContainer *self;
+  GPtrArray *names = NULL;
+  GDateTime *date = NULL;
+
+  g_return_val_if_fail (id != NULL, NULL);
+
+  if (name)
+    {
+      names = g_ptr_array_new_with_free_func (g_free);
+      g_ptr_array_add (names, g_strdup (name));
+    }
+
+  if (created > 0)
+    {
+      g_autoptr(GDateTime) utc = g_date_time_new_from_unix_utc (created);
+      date = g_date_time_to_local (utc);
+    }
+
+  self = gyacht_container_new (id, names, NULL, NULL, NULL, date,
+                               NULL, NULL, NULL);
+  self->image_name = g_strdup (image_name);
+  self->state = CONTAINER_STATE_CREATED;
+
+  return self;
+}
+
 /* --- Public APIs --- */
 GyachtContainer *
 gyacht_container_new (const gchar      *id,
@@ -518,6 +638,21 @@ gyacht_container_get_image_name (GyachtContainer *self)
   return self->image_name;
 }
 
+/**
+ * gyacht_container_get_pod_name:
+ * @self: a #GyachtContainer
+ *
+ * Return value: (nullable): The name of the pod of @self, only known when
+ *   containers are listed by podman's API.
+ */
+const gchar *
+gyacht_container_get_pod_name (GyachtContainer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), NULL);
+
+  return self->pod_name;
+}
+
 const gchar *
 gyacht_container_get_layer (GyachtContainer *self)
 {
@@ -581,3 +716,105 @@ gyacht_container_get_flags (GyachtContainer *self)
 
   return self->flags;
 }
+
+GyachtContainerState
+gyacht_container_get_state (GyachtContainer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), CONTAINER_STATE_UNKNOWN);
+
+  return self->state;
+}
+
+gint
+gyacht_container_get_exit_code (GyachtContainer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), 0);
+
+  return self->exit_code;
+}
+
+gchar *
+gyacht_container_get_status (GyachtContainer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), NULL);
+
+  switch (self->state)
+    {
+    case CONTAINER_STATE_CREATED:
+      return g_strdup (_("Created"));
+
+    case CONTAINER_STATE_RUNNING:
+      return g_strdup (_("Running"));
+
+    case CONTAINER_STATE_EXITED:
+      return g_strdup_printf (_("Exited (%d)"), self->exit_code);
+
+    case CONTAINER_STATE_UNKNOWN:
+    default:
+      return NULL;
+    }
+}
+
+gboolean
+gyacht_container_is_volatile (GyachtContainer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), FALSE);
+
+  return self->is_volatile;
+}
+
+static gboolean
+internal_names_equal (GPtrArray *a,
+                      GPtrArray *b)
+{
+  guint i;
+
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  if (a->len != b->len)
+    return FALSE;
+
+  for (i = 0; i < a->len; i++)
+    if (g_strcmp0 (g_ptr_array_index (a, i), g_ptr_array_index (b, i)) != 0)
+      return FALSE;
+
+  return TRUE;
+}
+
+/**
+ * gyacht_container_equal:
+ * @self: A #GyachtContainer.
+ * @other: Another #GyachtContainer.
+ *
+ * Compares the stored fields of both containers, the runtime state is not
+ * taken into account.
+ *
+ * Return value: %TRUE if both describe the same container record.
+ */
+gboolean
+gyacht_container_equal (GyachtContainer *self,
+                        GyachtContainer *other)
+{
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (self), FALSE);
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (other), FALSE);
+
+  if (self == other)
+    return TRUE;
+
+  if (g_strcmp0 (self->id, other->id) != 0 ||
+      g_strcmp0 (self->image, other->image) != 0 ||
+      g_strcmp0 (self->layer, other->layer) != 0 ||
+      g_strcmp0 (self->metadata, other->metadata) != 0)
+    return FALSE;
+
+  if (self->created == NULL || other->created == NULL)
+    {
+      if (self->created != other->created)
+        return FALSE;
+    }
+  else if (!g_date_time_equal (self->created, other->created))
+    return FALSE;
+
+  return internal_names_equal (self->names, other->names);
+}
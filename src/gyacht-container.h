@@ -28,6 +28,14 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GyachtContainer, gyacht_container, GYACHT, CONTAINER, GObject)
 
+typedef enum {
+  CONTAINER_STATE_UNKNOWN = 0,
+  CONTAINER_STATE_CREATED,
+  CONTAINER_STATE_RUNNING,
+  CONTAINER_STATE_EXITED,
+  N_CONTAINER_STATES
+} GyachtContainerState;
+
 typedef struct
 {
   gint64  container_id;
@@ -57,6 +65,7 @@ const gchar *       gyacht_container_get_name           (GyachtContainer *self);
 const GPtrArray *   gyacht_container_get_names          (GyachtContainer *self);
 const gchar *       gyacht_container_get_image          (GyachtContainer *self);
 const gchar *       gyacht_container_get_image_name     (GyachtContainer *self);
+const gchar *       gyacht_container_get_pod_name       (GyachtContainer *self);
 const gchar *       gyacht_container_get_layer          (GyachtContainer *self);
 const gchar *       gyacht_container_get_metadata       (GyachtContainer *self);
 const GDateTime *   gyacht_container_get_created        (GyachtContainer *self);
@@ -64,5 +73,12 @@ gchar *             gyacht_container_get_calendar_date  (GyachtContainer *self);
 const GPtrArray *   gyacht_container_get_uidmaps        (GyachtContainer *self);
 const GPtrArray *   gyacht_container_get_gidmaps        (GyachtContainer *self);
 const GHashTable *  gyacht_container_get_flags          (GyachtContainer *self);
+GyachtContainerState
+                    gyacht_container_get_state          (GyachtContainer *self);
+gint                gyacht_container_get_exit_code      (GyachtContainer *self);
+gchar *             gyacht_container_get_status         (GyachtContainer *self);
+gboolean            gyacht_container_is_volatile        (GyachtContainer *self);
+gboolean            gyacht_container_equal              (GyachtContainer *self,
+                                                         GyachtContainer *other);
 
 G_END_DECLS
@@ -0,0 +1,415 @@
+/* gyacht-details-cache.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-details-cache.h"
+#include "gyacht-path-manager.h"
+
+#include <json-glib/json-glib.h>
+
+/* The details of a container are read and decoded in a worker thread, and
+ * the last ones are kept in a LRU cache so that going back and forth
+ * between rows never waits for the disk.
+ *
+ * Entries are keyed by id. A container which changes is replaced by a new
+ * object in the model, so the object an entry was loaded for stands for
+ * its generation: details of another generation are loaded again.
+ */
+
+struct _GyachtContainerDetails
+{
+  gint    ref_count;
+
+  gchar   *metadata;  /* Pretty printed */
+  gchar   *config;    /* Pretty printed OCI config.json, NULL if missing */
+};
+
+typedef struct
+{
+  gchar                   *id;
+  GyachtContainer         *container;
+  GyachtContainerDetails  *details;   /* NULL while loading */
+  GList                   *waiting;   /* GTask */
+  GList                   *link;      /* In lru */
+} CacheEntry;
+
+typedef struct
+{
+  GyachtContainer *container;
+  gchar           *metadata;
+  gchar           *config_path;
+} LoadData;
+
+struct _GyachtDetailsCache
+{
+  GObject     parent_instance;
+
+  guint       capacity;
+  GHashTable  *entries;   /* id -> CacheEntry */
+  GQueue      *lru;       /* CacheEntry, the most recently used first */
+  gchar       *containers_dir;
+};
+
+G_DEFINE_TYPE (GyachtDetailsCache, gyacht_details_cache, G_TYPE_OBJECT)
+
+
+static void
+internal_cache_entry_free (gpointer data)
+{
+  CacheEntry *entry = data;
+
+  g_free (entry->id);
+  g_clear_object (&entry->container);
+  g_clear_pointer (&entry->details, gyacht_container_details_unref);
+  g_list_free_full (entry->waiting, g_object_unref);
+  g_free (entry);
+}
+
+static void
+internal_load_data_free (gpointer data)
+{
+  LoadData *load_data = data;
+
+  g_object_unref (load_data->container);
+  g_free (load_data->metadata);
+  g_free (load_data->config_path);
+  g_free (load_data);
+}
+
+static gchar *
+internal_dup_pretty_json (const gchar  *data,
+                          gssize        length,
+                          GError      **error)
+{
+  g_autoptr(JsonParser) parser = json_parser_new ();
+  g_autoptr(JsonGenerator) generator = NULL;
+
+  if (!json_parser_load_from_data (parser, data, length, error))
+    return NULL;
+
+  generator = json_generator_new ();
+  json_generator_set_pretty (generator, TRUE);
+  json_generator_set_root (generator, json_parser_get_root (parser));
+
+  return json_generator_to_data (generator, NULL);
+}
+
+static void
+internal_load_io_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  LoadData *data = task_data;
+  GyachtContainerDetails *details;
+  g_autofree gchar *contents = NULL;
+  g_autoptr(GError) error = NULL;
+  gsize length = 0;
+
+  details = g_new0 (GyachtContainerDetails, 1);
+  details->ref_count = 1;
+
+  if (data->metadata)
+    {
+      details->metadata = internal_dup_pretty_json (data->metadata, -1, NULL);
+      if (details->metadata == NULL)
+        details->metadata = g_strdup (data->metadata);
+    }
+
+  if (g_file_get_contents (data->config_path, &contents, &length, &error))
+    details->config = internal_dup_pretty_json (contents, length, &error);
+
+  if (error && !g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+    gyacht_warn ("Unable to read %s: %s", data->config_path, error->message);
+
+  g_task_return_pointer (task, details, (GDestroyNotify) gyacht_container_details_unref);
+}
+
+static void
+internal_touch (GyachtDetailsCache *self,
+                CacheEntry         *entry)
+{
+  g_queue_unlink (self->lru, entry->link);
+  g_queue_push_head_link (self->lru, entry->link);
+}
+
+/* Entries which are still loading are never evicted */
+static void
+internal_evict (GyachtDetailsCache *self)
+{
+  GList *link = self->lru->tail;
+
+  while (link && g_hash_table_size (self->entries) > self->capacity)
+    {
+      CacheEntry *entry = link->data;
+      GList *prev = link->prev;
+
+      if (entry->details)
+        {
+          g_queue_delete_link (self->lru, link);
+          g_hash_table_remove (self->entries, entry->id);
+        }
+
+      link = prev;
+    }
+}
+
+static void
+internal_load_done_cb (GObject      *source_object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+  GyachtDetailsCache *self = GYACHT_DETAILS_CACHE (source_object);
+  LoadData *data = g_task_get_task_data (G_TASK (res));
+  GyachtContainerDetails *details;
+  CacheEntry *entry;
+  GList *waiting;
+  GList *l;
+
+  details = g_task_propagate_pointer (G_TASK (res), NULL);
+
+  /* Superseded by a newer generation, which is loading on its own */
+  entry = g_hash_table_lookup (self->entries, gyacht_container_get_id (data->container));
+  if (entry == NULL || entry->container != data->container)
+    {
+      gyacht_container_details_unref (details);
+      return;
+    }
+
+  entry->details = details;
+
+  waiting = g_steal_pointer (&entry->waiting);
+  for (l = waiting; l; l = l->next)
+    g_task_return_pointer (l->data,
+                           gyacht_container_details_ref (details),
+                           (GDestroyNotify) gyacht_container_details_unref);
+  g_list_free_full (waiting, g_object_unref);
+
+  internal_evict (self);
+}
+
+static CacheEntry *
+internal_start_load (GyachtDetailsCache *self,
+                     GyachtContainer    *container)
+{
+  const gchar *id = gyacht_container_get_id (container);
+  g_autoptr(GTask) task = NULL;
+  CacheEntry *entry;
+  LoadData *data;
+
+  entry = g_hash_table_lookup (self->entries, id);
+  if (entry == NULL)
+    {
+      entry = g_new0 (CacheEntry, 1);
+      entry->id = g_strdup (id);
+      g_hash_table_insert (self->entries, entry->id, entry);
+
+      g_queue_push_head (self->lru, entry);
+      entry->link = self->lru->head;
+    }
+  else
+    {
+      /* Whoever waits for the previous generation gets this one */
+      g_clear_object (&entry->container);
+      g_clear_pointer (&entry->details, gyacht_container_details_unref);
+      internal_touch (self, entry);
+    }
+
+  entry->container = g_object_ref (container);
+
+  data = g_new0 (LoadData, 1);
+  data->container = g_object_ref (container);
+  data->metadata = g_strdup (gyacht_container_get_metadata (container));
+  data->config_path = g_build_filename (self->containers_dir, id,
+                                        USERDATA_DIR, CONFIG_JSON, NULL);
+
+  task = g_task_new (self, NULL, internal_load_done_cb, NULL);
+  g_task_set_source_tag (task, internal_start_load);
+  g_task_set_task_data (task, data, internal_load_data_free);
+  g_task_run_in_thread (task, internal_load_io_thread);
+
+  return entry;
+}
+
+/* --- GObject --- */
+static void
+gyacht_details_cache_finalize (GObject *object)
+{
+  GyachtDetailsCache *self = GYACHT_DETAILS_CACHE (object);
+
+  g_queue_free (self->lru);
+  g_hash_table_unref (self->entries);
+  g_free (self->containers_dir);
+
+  G_OBJECT_CLASS (gyacht_details_cache_parent_class)->finalize (object);
+}
+
+static void
+gyacht_details_cache_class_init (GyachtDetailsCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_details_cache_finalize;
+}
+
+static void
+gyacht_details_cache_init (GyachtDetailsCache *self)
+{
+  self->capacity = 0;
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL, internal_cache_entry_free);
+  self->lru = g_queue_new ();
+  self->containers_dir = gyacht_dup_user_containers_dir ();
+}
+
+/* --- Public APIs --- */
+GyachtContainerDetails *
+gyacht_container_details_ref (GyachtContainerDetails *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+  return self;
+}
+
+void
+gyacht_container_details_unref (GyachtContainerDetails *self)
+{
+  g_return_if_fail (self != NULL);
+
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_free (self->metadata);
+  g_free (self->config);
+  g_free (self);
+}
+
+const gchar *
+gyacht_container_details_get_metadata (GyachtContainerDetails *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return self->metadata;
+}
+
+const gchar *
+gyacht_container_details_get_config (GyachtContainerDetails *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return self->config;
+}
+
+GyachtDetailsCache *
+gyacht_details_cache_new (guint capacity)
+{
+  GyachtDetailsCache *self;
+
+  self = g_object_new (GYACHT_TYPE_DETAILS_CACHE, NULL);
+  self->capacity = MAX (capacity, 1);
+
+  return self;
+}
+
+/**
+ * gyacht_details_cache_lookup:
+ * @self: a #GyachtDetailsCache
+ * @container: a #GyachtContainer
+ *
+ * Return value: (transfer full) (nullable): The details of @container if
+ *   they are loaded already.
+ */
+GyachtContainerDetails *
+gyacht_details_cache_lookup (GyachtDetailsCache *self,
+                             GyachtContainer    *container)
+{
+  CacheEntry *entry;
+
+  g_return_val_if_fail (GYACHT_IS_DETAILS_CACHE (self), NULL);
+  g_return_val_if_fail (GYACHT_IS_CONTAINER (container), NULL);
+
+  entry = g_hash_table_lookup (self->entries, gyacht_container_get_id (container));
+  if (entry == NULL || entry->container != container || entry->details == NULL)
+    return NULL;
+
+  internal_touch (self, entry);
+  return gyacht_container_details_ref (entry->details);
+}
+
+void
+gyacht_details_cache_load_async (GyachtDetailsCache  *self,
+                                 GyachtContainer     *container,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  CacheEntry *entry;
+
+  g_return_if_fail (GYACHT_IS_DETAILS_CACHE (self));
+  g_return_if_fail (GYACHT_IS_CONTAINER (container));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_details_cache_load_async);
+
+  entry = g_hash_table_lookup (self->entries, gyacht_container_get_id (container));
+  if (entry && entry->container == container && entry->details)
+    {
+      internal_touch (self, entry);
+      g_task_return_pointer (task,
+                             gyacht_container_details_ref (entry->details),
+                             (GDestroyNotify) gyacht_container_details_unref);
+      return;
+    }
+
+  if (entry == NULL || entry->container != container)
+    entry = internal_start_load (self, container);
+
+  entry->waiting = g_list_prepend (entry->waiting, g_steal_pointer (&task));
+}
+
+GyachtContainerDetails *
+gyacht_details_cache_load_finish (GyachtDetailsCache  *self,
+                                  GAsyncResult        *res,
+                                  GError             **error)
+{
+  g_return_val_if_fail (GYACHT_IS_DETAILS_CACHE (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/* Starts loading the details of @container unless they are known */
+void
+gyacht_details_cache_prefetch (GyachtDetailsCache *self,
+                               GyachtContainer    *container)
+{
+  CacheEntry *entry;
+
+  g_return_if_fail (GYACHT_IS_DETAILS_CACHE (self));
+  g_return_if_fail (GYACHT_IS_CONTAINER (container));
+
+  entry = g_hash_table_lookup (self->entries, gyacht_container_get_id (container));
+  if (entry && entry->container == container)
+    return;
+
+  internal_start_load (self, container);
+}
@@ -0,0 +1,57 @@
+/* gyacht-details-cache.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "gyacht-container.h"
+
+G_BEGIN_DECLS
+
+/* What is read from the disk about a container, immutable once loaded */
+typedef struct _GyachtContainerDetails GyachtContainerDetails;
+
+GyachtContainerDetails *  gyacht_container_details_ref          (GyachtContainerDetails *self);
+void                      gyacht_container_details_unref        (GyachtContainerDetails *self);
+const gchar *             gyacht_container_details_get_metadata (GyachtContainerDetails *self);
+const gchar *             gyacht_container_details_get_config   (GyachtContainerDetails *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtContainerDetails, gyacht_container_details_unref)
+
+#define GYACHT_TYPE_DETAILS_CACHE (gyacht_details_cache_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtDetailsCache, gyacht_details_cache, GYACHT, DETAILS_CACHE, GObject)
+
+GyachtDetailsCache *      gyacht_details_cache_new          (guint                 capacity);
+GyachtContainerDetails *  gyacht_details_cache_lookup       (GyachtDetailsCache   *self,
+                                                             GyachtContainer      *container);
+void                      gyacht_details_cache_load_async   (GyachtDetailsCache   *self,
+                                                             GyachtContainer      *container,
+                                                             GCancellable         *cancellable,
+                                                             GAsyncReadyCallback   callback,
+                                                             gpointer              user_data);
+GyachtContainerDetails *  gyacht_details_cache_load_finish  (GyachtDetailsCache   *self,
+                                                             GAsyncResult         *res,
+                                                             GError              **error);
+void                      gyacht_details_cache_prefetch     (GyachtDetailsCache   *self,
+                                                             GyachtContainer      *container);
+
+G_END_DECLS
@@ -0,0 +1,521 @@
+/* gyacht-disk-usage.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-disk-usage.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Sizes directory trees the way du(1) does, on a pool of worker threads
+ * which take one directory each. Files linked more than once are counted
+ * once per scan, by device and inode, and the walk stays on the file
+ * system of the scanned path.
+ *
+ * Every directory keeps what it was found to hold. A directory whose
+ * mtime did not change since the last scan is not read again, only its
+ * subdirectories are visited, so a rescan costs a stat per directory plus
+ * the reading of the changed ones. A file rewritten in place leaves the
+ * mtime of its directory alone, its growth shows once the directory
+ * changes or is forgotten.
+ *
+ * Scans of the same path are coalesced, and the tree of a path belongs to
+ * the workers while it is scanned.
+ */
+
+#define BLOCK_SIZE  512
+
+typedef struct
+{
+  dev_t   dev;
+  ino_t   ino;
+  guint64 size;
+} Link;
+
+typedef struct _DirNode DirNode;
+struct _DirNode
+{
+  gboolean    valid;
+  dev_t       dev;
+  ino_t       ino;
+  gint64      mtime_sec;
+  glong       mtime_nsec;
+
+  guint64     size;       /* The directory and its entries linked once */
+  GArray      *links;     /* Link, entries linked more than once */
+  GHashTable  *children;  /* name -> DirNode */
+};
+
+typedef struct
+{
+  gchar       *path;
+  DirNode     *root;
+  GTask       *task;      /* Owned by the walk until it returns */
+  gint        pending;    /* Directories queued or being read */
+
+  GMutex      lock;       /* For the fields below */
+  GHashTable  *inodes;    /* Link, seen during this scan */
+  guint64     size;
+  GError      *error;
+
+  GList       *waiting;   /* GTask */
+  gboolean    forget;
+} Scan;
+
+typedef struct
+{
+  Scan        *scan;
+  DirNode     *node;
+  gchar       *path;
+} WorkItem;
+
+struct _GyachtDiskUsage
+{
+  GObject       parent_instance;
+
+  GThreadPool   *pool;
+  GHashTable    *roots;   /* path -> DirNode */
+  GHashTable    *scans;   /* path -> Scan, while running */
+};
+
+G_DEFINE_TYPE (GyachtDiskUsage, gyacht_disk_usage, G_TYPE_OBJECT)
+
+
+static DirNode *
+internal_dir_node_new (void)
+{
+  return g_new0 (DirNode, 1);
+}
+
+static void
+internal_dir_node_free (gpointer data)
+{
+  DirNode *node = data;
+
+  if (node->links)
+    g_array_unref (node->links);
+  if (node->children)
+    g_hash_table_unref (node->children);
+  g_free (node);
+}
+
+static guint
+internal_link_hash (gconstpointer v)
+{
+  const Link *link = v;
+
+  return (guint) link->ino ^ (guint) link->dev;
+}
+
+static gboolean
+internal_link_equal (gconstpointer v1,
+                     gconstpointer v2)
+{
+  const Link *link1 = v1;
+  const Link *link2 = v2;
+
+  return link1->ino == link2->ino && link1->dev == link2->dev;
+}
+
+static void
+internal_scan_free (gpointer data)
+{
+  Scan *scan = data;
+
+  g_free (scan->path);
+  g_mutex_clear (&scan->lock);
+  g_hash_table_unref (scan->inodes);
+  g_clear_error (&scan->error);
+  g_list_free_full (scan->waiting, g_object_unref);
+  g_free (scan);
+}
+
+static void
+internal_queue_dir (GyachtDiskUsage *self,
+                    Scan            *scan,
+                    DirNode         *node,
+                    gchar           *path)
+{
+  WorkItem *item;
+
+  item = g_new0 (WorkItem, 1);
+  item->scan = scan;
+  item->node = node;
+  item->path = path;
+
+  g_atomic_int_inc (&scan->pending);
+  g_thread_pool_push (self->pool, item, NULL);
+}
+
+/* Reads the entries of @fd into @node. Subdirectories which are still
+ * there keep their nodes, the others are dropped with their subtrees.
+ */
+static void
+internal_read_dir (DirNode           *node,
+                   gint               fd,
+                   const struct stat *st)
+{
+  g_autoptr(GHashTable) old_children = NULL;
+  struct dirent *entry;
+  DIR *dir;
+
+  dir = fdopendir (fd);
+  if (dir == NULL)
+    {
+      close (fd);
+      node->valid = FALSE;
+      return;
+    }
+
+  old_children = node->children;
+  node->children = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, internal_dir_node_free);
+  if (node->links)
+    g_array_set_size (node->links, 0);
+  node->size = (guint64) st->st_blocks * BLOCK_SIZE;
+
+  while ((entry = readdir (dir)))
+    {
+      struct stat child_st;
+
+      if (g_str_equal (entry->d_name, ".") || g_str_equal (entry->d_name, ".."))
+        continue;
+
+      /* Gone since it was listed */
+      if (fstatat (dirfd (dir), entry->d_name, &child_st, AT_SYMLINK_NOFOLLOW) != 0)
+        continue;
+
+      if (S_ISDIR (child_st.st_mode))
+        {
+          gpointer key = NULL;
+          gpointer child = NULL;
+
+          if (child_st.st_dev != st->st_dev)
+            continue;
+
+          if (old_children &&
+              g_hash_table_lookup_extended (old_children, entry->d_name, &key, &child))
+            {
+              g_hash_table_steal (old_children, key);
+              g_free (key);
+            }
+          else
+            child = internal_dir_node_new ();
+
+          g_hash_table_insert (node->children, g_strdup (entry->d_name), child);
+        }
+      else if (child_st.st_nlink > 1)
+        {
+          Link link = { child_st.st_dev, child_st.st_ino,
+                        (guint64) child_st.st_blocks * BLOCK_SIZE };
+
+          if (node->links == NULL)
+            node->links = g_array_new (FALSE, FALSE, sizeof (Link));
+          g_array_append_val (node->links, link);
+        }
+      else
+        node->size += (guint64) child_st.st_blocks * BLOCK_SIZE;
+    }
+
+  closedir (dir);
+
+  node->valid = TRUE;
+  node->dev = st->st_dev;
+  node->ino = st->st_ino;
+  node->mtime_sec = st->st_mtim.tv_sec;
+  node->mtime_nsec = st->st_mtim.tv_nsec;
+}
+
+static void
+internal_add_node (Scan    *scan,
+                   DirNode *node)
+{
+  guint i;
+
+  g_mutex_lock (&scan->lock);
+
+  scan->size += node->size;
+  for (i = 0; node->links && i < node->links->len; i++)
+    {
+      Link *link = &g_array_index (node->links, Link, i);
+      Link *seen;
+
+      if (g_hash_table_contains (scan->inodes, link))
+        continue;
+
+      seen = g_new (Link, 1);
+      *seen = *link;
+      g_hash_table_add (scan->inodes, seen);
+      scan->size += link->size;
+    }
+
+  g_mutex_unlock (&scan->lock);
+}
+
+static void
+internal_walk_thread (gpointer data,
+                      gpointer user_data)
+{
+  GyachtDiskUsage *self = GYACHT_DISK_USAGE (user_data);
+  WorkItem *item = data;
+  Scan *scan = item->scan;
+  DirNode *node = item->node;
+  struct stat st;
+  gint fd;
+
+  fd = open (item->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0 || fstat (fd, &st) != 0)
+    {
+      gint saved_errno = errno;
+
+      if (fd >= 0)
+        close (fd);
+
+      /* A subdirectory may go away or be unreadable, the scan goes on */
+      if (node == scan->root)
+        {
+          g_mutex_lock (&scan->lock);
+          g_set_error (&scan->error,
+                       G_IO_ERROR,
+                       g_io_error_from_errno (saved_errno),
+                       "Unable to open %s: %s",
+                       item->path,
+                       g_strerror (saved_errno));
+          g_mutex_unlock (&scan->lock);
+        }
+      else
+        gyacht_debug ("Skipped %s: %s", item->path, g_strerror (saved_errno));
+
+      node->valid = FALSE;
+      goto out;
+    }
+
+  if (node->valid &&
+      node->dev == st.st_dev &&
+      node->ino == st.st_ino &&
+      node->mtime_sec == st.st_mtim.tv_sec &&
+      node->mtime_nsec == st.st_mtim.tv_nsec)
+    close (fd);
+  else
+    internal_read_dir (node, fd, &st);
+
+  if (node->valid)
+    {
+      GHashTableIter iter;
+      gpointer key, value;
+
+      internal_add_node (scan, node);
+
+      g_hash_table_iter_init (&iter, node->children);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        internal_queue_dir (self, scan, value,
+                            g_build_filename (item->path, key, NULL));
+    }
+
+out:
+  /* The last directory of the walk hands the scan back */
+  if (g_atomic_int_dec_and_test (&scan->pending))
+    {
+      GTask *task = g_steal_pointer (&scan->task);
+
+      g_task_return_boolean (task, TRUE);
+      g_object_unref (task);
+    }
+
+  g_free (item->path);
+  g_free (item);
+}
+
+static void
+internal_scan_done_cb (GObject      *source_object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+  GyachtDiskUsage *self = GYACHT_DISK_USAGE (source_object);
+  Scan *scan = g_task_get_task_data (G_TASK (res));
+  GList *waiting;
+  GList *l;
+
+  g_hash_table_remove (self->scans, scan->path);
+  if (scan->forget || scan->error)
+    g_hash_table_remove (self->roots, scan->path);
+
+  waiting = g_steal_pointer (&scan->waiting);
+  for (l = waiting; l; l = l->next)
+    {
+      guint64 *size;
+
+      if (scan->error)
+        {
+          g_task_return_error (l->data, g_error_copy (scan->error));
+          continue;
+        }
+
+      size = g_new (guint64, 1);
+      *size = scan->size;
+      g_task_return_pointer (l->data, size, g_free);
+    }
+  g_list_free_full (waiting, g_object_unref);
+}
+
+/* --- GObject --- */
+static void
+gyacht_disk_usage_finalize (GObject *object)
+{
+  GyachtDiskUsage *self = GYACHT_DISK_USAGE (object);
+
+  GYACHT_TRACE_ENTRY;
+
+  /* Every scan holds a reference, none is running */
+  g_thread_pool_free (self->pool, TRUE, TRUE);
+  g_hash_table_unref (self->scans);
+  g_hash_table_unref (self->roots);
+
+  GYACHT_TRACE_EXIT;
+
+  G_OBJECT_CLASS (gyacht_disk_usage_parent_class)->finalize (object);
+}
+
+static void
+gyacht_disk_usage_class_init (GyachtDiskUsageClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_disk_usage_finalize;
+}
+
+static void
+gyacht_disk_usage_init (GyachtDiskUsage *self)
+{
+  self->pool = g_thread_pool_new (internal_walk_thread,
+                                  self,
+                                  g_get_num_processors (),
+                                  FALSE,
+                                  NULL);
+  self->roots = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free, internal_dir_node_free);
+  self->scans = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+/* --- Public APIs --- */
+GyachtDiskUsage *
+gyacht_disk_usage_new (void)
+{
+  return g_object_new (GYACHT_TYPE_DISK_USAGE, NULL);
+}
+
+/**
+ * gyacht_disk_usage_scan_async:
+ * @self: A #GyachtDiskUsage.
+ * @path: The directory to size.
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: Called with the size on the main context.
+ * @user_data: Data for @callback.
+ *
+ * Sizes @path, reading again only the directories which changed since the
+ * last scan of @path. Callers asking while a scan of @path runs share its
+ * result.
+ */
+void
+gyacht_disk_usage_scan_async (GyachtDiskUsage     *self,
+                              const gchar         *path,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  GTask *walk;
+  Scan *scan;
+
+  g_return_if_fail (GYACHT_IS_DISK_USAGE (self));
+  g_return_if_fail (path != NULL);
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_disk_usage_scan_async);
+
+  scan = g_hash_table_lookup (self->scans, path);
+  if (scan)
+    {
+      scan->waiting = g_list_prepend (scan->waiting, g_steal_pointer (&task));
+      return;
+    }
+
+  scan = g_new0 (Scan, 1);
+  scan->path = g_strdup (path);
+  scan->root = g_hash_table_lookup (self->roots, path);
+  if (scan->root == NULL)
+    {
+      scan->root = internal_dir_node_new ();
+      g_hash_table_insert (self->roots, g_strdup (path), scan->root);
+    }
+  g_mutex_init (&scan->lock);
+  scan->inodes = g_hash_table_new_full (internal_link_hash, internal_link_equal,
+                                        g_free, NULL);
+  scan->waiting = g_list_prepend (NULL, g_steal_pointer (&task));
+  g_hash_table_insert (self->scans, scan->path, scan);
+
+  walk = g_task_new (self, NULL, internal_scan_done_cb, NULL);
+  g_task_set_source_tag (walk, internal_scan_done_cb);
+  g_task_set_task_data (walk, scan, internal_scan_free);
+  scan->task = walk;
+
+  internal_queue_dir (self, scan, scan->root, g_strdup (path));
+}
+
+gboolean
+gyacht_disk_usage_scan_finish (GyachtDiskUsage  *self,
+                               GAsyncResult     *res,
+                               guint64          *size,
+                               GError          **error)
+{
+  g_autofree guint64 *result = NULL;
+
+  g_return_val_if_fail (GYACHT_IS_DISK_USAGE (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+
+  result = g_task_propagate_pointer (G_TASK (res), error);
+  if (result == NULL)
+    return FALSE;
+
+  if (size)
+    *size = *result;
+
+  return TRUE;
+}
+
+/* Drops what is known about @path, once its running scan is done */
+void
+gyacht_disk_usage_forget (GyachtDiskUsage *self,
+                          const gchar     *path)
+{
+  Scan *scan;
+
+  g_return_if_fail (GYACHT_IS_DISK_USAGE (self));
+  g_return_if_fail (path != NULL);
+
+  scan = g_hash_table_lookup (self->scans, path);
+  if (scan)
+    scan->forget = TRUE;
+  else
+    g_hash_table_remove (self->roots, path);
+}
@@ -0,0 +1,44 @@
+/* gyacht-disk-usage.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_DISK_USAGE (gyacht_disk_usage_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtDiskUsage, gyacht_disk_usage, GYACHT, DISK_USAGE, GObject)
+
+GyachtDiskUsage * gyacht_disk_usage_new          (void);
+void              gyacht_disk_usage_scan_async   (GyachtDiskUsage      *self,
+                                                  const gchar          *path,
+                                                  GCancellable         *cancellable,
+                                                  GAsyncReadyCallback   callback,
+                                                  gpointer              user_data);
+gboolean          gyacht_disk_usage_scan_finish  (GyachtDiskUsage      *self,
+                                                  GAsyncResult         *res,
+                                                  guint64              *size,
+                                                  GError              **error);
+void              gyacht_disk_usage_forget       (GyachtDiskUsage      *self,
+                                                  const gchar          *path);
+
+G_END_DECLS
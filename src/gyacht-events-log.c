@@ -0,0 +1,557 @@
+/* gyacht-events-log.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-events-log.h"
+#include "gyacht-path-manager.h"
+
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+
+/* podman appends one json object per line to events.log when the
+ * events_logger option in containers.conf is set to "file". We remember how
+ * far the file has been read and only parse what was appended since then.
+ *
+ * Limit a single pass so that a huge log (e.g. the first read after a
+ * rotation) does not keep a worker thread busy for too long.
+ */
+#define EVENTS_LOG_MAX_READ   (4 * 1024 * 1024)
+
+typedef struct
+{
+  GyachtEventStatus  status;
+  gchar             *id;
+  gchar             *name;
+  gchar             *image;
+  gint64             time;
+  gint               exit_code;
+} Event;
+
+typedef struct
+{
+  GFile     *file;
+  goffset   offset;
+  guint64   inode;
+} ReadRequest;
+
+typedef struct
+{
+  GPtrArray *events;
+  goffset   offset;
+  guint64   inode;
+  gboolean  resync;
+  gboolean  more;
+} ReadResult;
+
+struct _GyachtEventsLog
+{
+  GObject       parent_instance;
+
+  GFile         *file;
+  GFileMonitor  *monitor;
+  GCancellable  *cancellable;
+
+  goffset       offset;
+  guint64       inode;
+
+  gboolean      active;
+  gboolean      reading;
+  gboolean      pending;
+};
+
+/* Signals */
+enum {
+  CONTAINER_EVENT,
+  RESYNC_NEEDED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtEventsLog, gyacht_events_log, G_TYPE_OBJECT)
+
+/* Forward declarations */
+static void internal_read_async (GyachtEventsLog *self);
+
+
+static void
+internal_event_free (gpointer data)
+{
+  Event *event = data;
+
+  g_free (event->id);
+  g_free (event->name);
+  g_free (event->image);
+  g_free (event);
+}
+
+static void
+internal_read_request_free (gpointer data)
+{
+  ReadRequest *request = data;
+
+  g_object_unref (request->file);
+  g_free (request);
+}
+
+static void
+internal_read_result_free (gpointer data)
+{
+  ReadResult *result = data;
+
+  g_ptr_array_unref (result->events);
+  g_free (result);
+}
+
+static const gchar *
+internal_get_string_member (JsonObject  *object,
+                            const gchar *member_name)
+{
+  JsonNode *node = json_object_get_member (object, member_name);
+
+  if (node == NULL || json_node_get_value_type (node) != G_TYPE_STRING)
+    return NULL;
+
+  return json_node_get_string (node);
+}
+
+static GyachtEventStatus
+internal_status_from_string (const gchar *status)
+{
+  if (status == NULL)
+    return EVENT_STATUS_NONE;
+
+  if (g_str_equal (status, "create"))
+    return EVENT_STATUS_CREATE;
+  if (g_str_equal (status, "start") ||
+      g_str_equal (status, "restart"))
+    return EVENT_STATUS_START;
+  /* Older podman versions report "exited" instead of "died" */
+  if (g_str_equal (status, "died") ||
+      g_str_equal (status, "exited"))
+    return EVENT_STATUS_DIED;
+  if (g_str_equal (status, "remove"))
+    return EVENT_STATUS_REMOVE;
+
+  return EVENT_STATUS_NONE;
+}
+
+/* Return value: NULL if the line is not a container event we care about,
+ *    @malformed is set if the line could not be parsed at all.
+ */
+static Event *
+internal_parse_event (JsonParser  *parser,
+                      const gchar *line,
+                      gsize        length,
+                      gboolean    *malformed)
+{
+  JsonNode *root;
+  JsonObject *object;
+  GyachtEventStatus status;
+  const gchar *id;
+  const gchar *time;
+  Event *event;
+
+  if (!json_parser_load_from_data (parser, line, length, NULL))
+    {
+      *malformed = TRUE;
+      return NULL;
+    }
+
+  root = json_parser_get_root (parser);
+  if (root == NULL || !JSON_NODE_HOLDS_OBJECT (root))
+    {
+      *malformed = TRUE;
+      return NULL;
+    }
+
+  object = json_node_get_object (root);
+
+  if (g_strcmp0 (internal_get_string_member (object, "Type"), "container") != 0)
+    return NULL;
+
+  status = internal_status_from_string (internal_get_string_member (object, "Status"));
+  id = internal_get_string_member (object, "ID");
+  if (status == EVENT_STATUS_NONE || id == NULL)
+    return NULL;
+
+  event = g_new0 (Event, 1);
+  event->status = status;
+  event->id = g_strdup (id);
+  event->name = g_strdup (internal_get_string_member (object, "Name"));
+  event->image = g_strdup (internal_get_string_member (object, "Image"));
+
+  time = internal_get_string_member (object, "Time");
+  if (time)
+    {
+      g_autoptr(GTimeZone) time_zone = g_time_zone_new_local ();
+      g_autoptr(GDateTime) date = g_date_time_new_from_iso8601 (time, time_zone);
+
+      if (date)
+        event->time = g_date_time_to_unix (date);
+    }
+
+  if (json_object_has_member (object, "ContainerExitCode"))
+    event->exit_code = json_object_get_int_member (object, "ContainerExitCode");
+
+  return event;
+}
+
+static void
+internal_read_io_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  ReadRequest *request = task_data;
+  g_autoptr(GFileInputStream) stream = NULL;
+  g_autoptr(GFileInfo) info = NULL;
+  g_autoptr(JsonParser) parser = NULL;
+  g_autofree gchar *buffer = NULL;
+  ReadResult *result;
+  GError *error = NULL;
+  goffset size;
+  gsize to_read;
+  gsize bytes_read = 0;
+  gsize start = 0;
+  gsize i;
+
+  stream = g_file_read (request->file, cancellable, &error);
+  if (stream == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  info = g_file_input_stream_query_info (stream,
+                                         G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                         G_FILE_ATTRIBUTE_UNIX_INODE,
+                                         cancellable,
+                                         &error);
+  if (info == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  result = g_new0 (ReadResult, 1);
+  result->events = g_ptr_array_new_with_free_func (internal_event_free);
+  result->offset = request->offset;
+  result->inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+
+  size = g_file_info_get_size (info);
+
+  /* podman rotates the log by replacing the file, or it may have been
+   * truncated. Either way events could have been missed in between.
+   */
+  if (result->inode != request->inode || size < request->offset)
+    {
+      gyacht_debug ("events.log has been rotated");
+      result->offset = 0;
+      result->resync = TRUE;
+    }
+
+  if (size == result->offset)
+    goto out;
+
+  if (!g_seekable_seek (G_SEEKABLE (stream), result->offset,
+                        G_SEEK_SET, cancellable, &error))
+    goto out_error;
+
+  to_read = MIN (size - result->offset, EVENTS_LOG_MAX_READ);
+  buffer = g_malloc (to_read);
+
+  if (!g_input_stream_read_all (G_INPUT_STREAM (stream), buffer, to_read,
+                                &bytes_read, cancellable, &error))
+    goto out_error;
+
+  parser = json_parser_new ();
+
+  for (i = 0; i < bytes_read; i++)
+    {
+      gboolean malformed = FALSE;
+      Event *event;
+
+      if (buffer[i] != '\n')
+        continue;
+
+      if (i > start)
+        {
+          event = internal_parse_event (parser, buffer + start, i - start, &malformed);
+          if (event)
+            g_ptr_array_add (result->events, event);
+          else if (malformed)
+            result->resync = TRUE;
+        }
+
+      start = i + 1;
+    }
+
+  /* A line longer than a whole pass can never be completed, skip it */
+  if (start == 0 && bytes_read == EVENTS_LOG_MAX_READ)
+    {
+      start = bytes_read;
+      result->resync = TRUE;
+    }
+
+  /* Keep the trailing partial line for the next pass */
+  result->offset += start;
+  result->more = (result->offset < size && start > 0);
+
+out:
+  g_task_return_pointer (task, result, internal_read_result_free);
+  return;
+
+out_error:
+  internal_read_result_free (result);
+  g_task_return_error (task, error);
+}
+
+static void
+internal_read_callback (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+  GyachtEventsLog *self = GYACHT_EVENTS_LOG (source_object);
+  g_autoptr(GError) error = NULL;
+  ReadResult *result;
+  guint i;
+
+  self->reading = FALSE;
+
+  result = g_task_propagate_pointer (G_TASK (res), &error);
+  if (error)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        gyacht_warn ("Unable to read events: %s", error->message);
+      return;
+    }
+
+  self->offset = result->offset;
+  self->inode = result->inode;
+
+  if (result->resync)
+    g_signal_emit (self, signals[RESYNC_NEEDED], 0);
+
+  for (i = 0; i < result->events->len; i++)
+    {
+      Event *event = g_ptr_array_index (result->events, i);
+
+      g_signal_emit (self, signals[CONTAINER_EVENT], 0,
+                     event->status,
+                     event->id,
+                     event->name,
+                     event->image,
+                     event->time,
+                     event->exit_code);
+    }
+
+  if (result->more || self->pending)
+    {
+      self->pending = FALSE;
+      internal_read_async (self);
+    }
+
+  internal_read_result_free (result);
+}
+
+static void
+internal_read_async (GyachtEventsLog *self)
+{
+  g_autoptr(GTask) task = NULL;
+  ReadRequest *request;
+
+  /* Coalesce the notifications which arrive while a pass is running */
+  if (self->reading)
+    {
+      self->pending = TRUE;
+      return;
+    }
+
+  request = g_new0 (ReadRequest, 1);
+  request->file = g_object_ref (self->file);
+  request->offset = self->offset;
+  request->inode = self->inode;
+
+  self->reading = TRUE;
+
+  task = g_task_new (self, self->cancellable, internal_read_callback, NULL);
+  g_task_set_task_data (task, request, internal_read_request_free);
+  g_task_run_in_thread (task, internal_read_io_thread);
+}
+
+static void
+internal_file_monitor_changed_cb (GFileMonitor      *monitor,
+                                  GFile             *file,
+                                  GFile             *other_file,
+                                  GFileMonitorEvent  event_type,
+                                  gpointer           user_data)
+{
+  GyachtEventsLog *self = GYACHT_EVENTS_LOG (user_data);
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_CHANGED:
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+      self->active = TRUE;
+      internal_read_async (self);
+      break;
+
+    case G_FILE_MONITOR_EVENT_DELETED:
+      self->active = FALSE;
+      break;
+
+    default:
+      break;
+    }
+}
+
+/* --- GObject --- */
+static void
+gyacht_events_log_finalize (GObject *object)
+{
+  GyachtEventsLog *self = GYACHT_EVENTS_LOG (object);
+
+  GYACHT_TRACE_ENTRY;
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  if (self->monitor)
+    g_signal_handlers_disconnect_by_func (self->monitor,
+                                          G_CALLBACK (internal_file_monitor_changed_cb),
+                                          self);
+  g_clear_object (&self->monitor);
+  g_clear_object (&self->file);
+
+  GYACHT_TRACE_EXIT;
+
+  G_OBJECT_CLASS (gyacht_events_log_parent_class)->finalize (object);
+}
+
+static void
+gyacht_events_log_constructed (GObject *object)
+{
+  GyachtEventsLog *self = GYACHT_EVENTS_LOG (object);
+  g_autofree gchar *dir = NULL;
+  g_autofree gchar *path = NULL;
+  g_autoptr(GFileInfo) info = NULL;
+  g_autoptr(GError) error = NULL;
+
+  G_OBJECT_CLASS (gyacht_events_log_parent_class)->constructed (object);
+
+  dir = gyacht_dup_user_events_dir ();
+  path = g_build_filename (dir, EVENTS_LOG, NULL);
+  self->file = g_file_new_for_path (path);
+
+  /* Everything logged so far is already part of the json files */
+  info = g_file_query_info (self->file,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_UNIX_INODE,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL,
+                            NULL);
+  if (info)
+    {
+      self->offset = g_file_info_get_size (info);
+      self->inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+      self->active = TRUE;
+    }
+  else
+    gyacht_info ("%s does not exist, podman may not log events to a file", path);
+
+  self->monitor = g_file_monitor_file (self->file, G_FILE_MONITOR_NONE, NULL, &error);
+  if (error)
+    {
+      gyacht_warn ("Unable to monitor events: %s", error->message);
+      self->active = FALSE;
+      return;
+    }
+
+  g_file_monitor_set_rate_limit (self->monitor, 100);
+  g_signal_connect (self->monitor,
+                    "changed",
+                    G_CALLBACK (internal_file_monitor_changed_cb),
+                    self);
+}
+
+static void
+gyacht_events_log_class_init (GyachtEventsLogClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_events_log_finalize;
+  object_class->constructed = gyacht_events_log_constructed;
+
+  signals [CONTAINER_EVENT] =
+    g_signal_new ("container-event",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 6,
+                  G_TYPE_UINT,      /* GyachtEventStatus */
+                  G_TYPE_STRING,    /* id */
+                  G_TYPE_STRING,    /* name */
+                  G_TYPE_STRING,    /* image */
+                  G_TYPE_INT64,     /* time */
+                  G_TYPE_INT);      /* exit code */
+
+  /* Emitted when events may have been lost, e.g. on rotation */
+  signals [RESYNC_NEEDED] =
+    g_signal_new ("resync-needed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_events_log_init (GyachtEventsLog *self)
+{
+  self->cancellable = g_cancellable_new ();
+  self->offset = 0;
+  self->inode = 0;
+  self->active = FALSE;
+  self->reading = FALSE;
+  self->pending = FALSE;
+}
+
+/* --- Public APIs --- */
+GyachtEventsLog *
+gyacht_events_log_new (void)
+{
+  return g_object_new (GYACHT_TYPE_EVENTS_LOG, NULL);
+}
+
+/**
+ * gyacht_events_log_is_active:
+ * @self: A #GyachtEventsLog.
+ *
+ * Return value: %TRUE if podman is logging events to the file which is
+ *    followed by @self.
+ */
+gboolean
+gyacht_events_log_is_active (GyachtEventsLog *self)
+{
+  g_return_val_if_fail (GYACHT_IS_EVENTS_LOG (self), FALSE);
+
+  return self->active;
+}
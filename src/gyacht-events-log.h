@@ -0,0 +1,43 @@
+/* gyacht-events-log.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  EVENT_STATUS_NONE = 0,
+  EVENT_STATUS_CREATE,
+  EVENT_STATUS_START,
+  EVENT_STATUS_DIED,
+  EVENT_STATUS_REMOVE,
+  N_EVENT_STATUSES
+} GyachtEventStatus;
+
+#define GYACHT_TYPE_EVENTS_LOG (gyacht_events_log_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtEventsLog, gyacht_events_log, GYACHT, EVENTS_LOG, GObject)
+
+GyachtEventsLog * gyacht_events_log_new       (void);
+gboolean          gyacht_events_log_is_active (GyachtEventsLog *self);
+
+G_END_DECLS
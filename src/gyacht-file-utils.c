@@ -20,14 +20,6 @@
 
 #include "gyacht-file-utils.h"
 
-#define GYACHT_FILE_UTILS_ERROR (gyacht_file_utils_error_quark())
-
-static GQuark
-gyacht_file_utils_error_quark (void)
-{
-  return g_quark_from_static_string ("gyacht-container-list-error-quark");
-}
-
 gboolean
 gyacht_file_utils_file_exists (GFile   *file,
                                GError **error)
@@ -38,7 +30,7 @@ gyacht_file_utils_file_exists (GFile   *file,
   if (!g_file_query_exists (file, NULL))
     {
       if (error != NULL)
-        g_set_error (error, GYACHT_FILE_UTILS_ERROR, 0,
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
                      "%s: No such file or directory", g_file_get_path (file));
       return FALSE;
     }
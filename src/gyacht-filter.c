@@ -0,0 +1,451 @@
+/* gyacht-filter.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-filter.h"
+
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Words of the form <field><operator><value> are filter terms, e.g.
+ *
+ *   image=registry.example/foo created>7d names~^ci- state!=exited
+ *
+ * The terms are compiled once: fields are resolved against the table of
+ * the caller, regexes are built and times become unix timestamps. An item
+ * then matches when every term does. Relative times count back from the
+ * compilation, so `created>7d` means "created in the last seven days".
+ *
+ * The other words are left to the free text search.
+ */
+
+#define GYACHT_FILTER_ERROR (gyacht_filter_error_quark())
+
+typedef enum {
+  OP_EQUAL = 0,
+  OP_MATCH,
+  OP_LESS,
+  OP_LESS_EQUAL,
+  OP_GREATER,
+  OP_GREATER_EQUAL
+} FilterOp;
+
+typedef struct
+{
+  const GyachtFilterField *field;
+  FilterOp                op;
+  gboolean                negate;
+
+  gchar                   *string;
+  GRegex                  *regex;
+  gint64                  time;
+} FilterTerm;
+
+struct _GyachtFilter
+{
+  GArray  *terms;   /* FilterTerm */
+  gchar   *source;
+};
+
+static const struct {
+  const gchar *token;
+  FilterOp    op;
+  gboolean    negate;
+} operators[] = {
+  /* Longest first */
+  { "!=", OP_EQUAL,         TRUE  },
+  { "!~", OP_MATCH,         TRUE  },
+  { ">=", OP_GREATER_EQUAL, FALSE },
+  { "<=", OP_LESS_EQUAL,    FALSE },
+  { "=",  OP_EQUAL,         FALSE },
+  { "~",  OP_MATCH,         FALSE },
+  { ">",  OP_GREATER,       FALSE },
+  { "<",  OP_LESS,          FALSE },
+};
+
+
+static GQuark
+gyacht_filter_error_quark (void)
+{
+  return g_quark_from_static_string ("gyacht-filter-error-quark");
+}
+
+static void
+internal_filter_term_clear (gpointer data)
+{
+  FilterTerm *term = data;
+
+  g_free (term->string);
+  g_clear_pointer (&term->regex, g_regex_unref);
+}
+
+static const GyachtFilterField *
+internal_lookup_field (const GyachtFilterField *fields,
+                       const gchar             *name,
+                       gsize                    length)
+{
+  const GyachtFilterField *field;
+
+  for (field = fields; field->name; field++)
+    if (strlen (field->name) == length && strncmp (field->name, name, length) == 0)
+      return field;
+
+  return NULL;
+}
+
+/* Either seconds, minutes, hours, days or weeks ago, or a local date */
+static gboolean
+internal_parse_time (const gchar *value,
+                     gint64      *time)
+{
+  g_autoptr(GDateTime) date = NULL;
+  gchar *end = NULL;
+  guint64 count;
+  gint year, month, day;
+
+  count = g_ascii_strtoull (value, &end, 10);
+  if (end != value && end[0] != '\0' && end[1] == '\0')
+    {
+      gint64 unit;
+
+      switch (end[0])
+        {
+        case 's': unit = 1; break;
+        case 'm': unit = 60; break;
+        case 'h': unit = 60 * 60; break;
+        case 'd': unit = 24 * 60 * 60; break;
+        case 'w': unit = 7 * 24 * 60 * 60; break;
+        default: return FALSE;
+        }
+
+      *time = g_get_real_time () / G_USEC_PER_SEC - (gint64) count * unit;
+      return TRUE;
+    }
+
+  if (sscanf (value, "%4d-%2d-%2d", &year, &month, &day) != 3)
+    return FALSE;
+
+  date = g_date_time_new_local (year, month, day, 0, 0, 0);
+  if (date == NULL)
+    return FALSE;
+
+  *time = g_date_time_to_unix (date);
+  return TRUE;
+}
+
+/* Return value: %FALSE if @word is not a term, or if it is an invalid one
+ * in which case @error is set.
+ */
+static gboolean
+internal_parse_term (const GyachtFilterField  *fields,
+                     const gchar              *word,
+                     FilterTerm               *term,
+                     GError                  **error)
+{
+  const gchar *value;
+  gsize length;
+  guint i;
+
+  length = strspn (word, "abcdefghijklmnopqrstuvwxyz-");
+  if (length == 0)
+    return FALSE;
+
+  term->field = internal_lookup_field (fields, word, length);
+  if (term->field == NULL)
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (operators); i++)
+    if (g_str_has_prefix (word + length, operators[i].token))
+      break;
+
+  if (i == G_N_ELEMENTS (operators))
+    return FALSE;
+
+  term->op = operators[i].op;
+  term->negate = operators[i].negate;
+  value = word + length + strlen (operators[i].token);
+
+  if (*value == '\0')
+    {
+      g_set_error (error, GYACHT_FILTER_ERROR, 0,
+                   _("Missing a value to compare %s with"), term->field->name);
+      return FALSE;
+    }
+
+  if (term->field->type == FILTER_FIELD_TIME)
+    {
+      if (term->op == OP_EQUAL || term->op == OP_MATCH)
+        {
+          g_set_error (error, GYACHT_FILTER_ERROR, 0,
+                       _("%s can only be compared with < and >"), term->field->name);
+          return FALSE;
+        }
+
+      if (!internal_parse_time (value, &term->time))
+        {
+          g_set_error (error, GYACHT_FILTER_ERROR, 0,
+                       _("“%s” is neither a date nor a duration like 7d"), value);
+          return FALSE;
+        }
+
+      return TRUE;
+    }
+
+  switch (term->op)
+    {
+    case OP_EQUAL:
+      term->string = g_strdup (value);
+      return TRUE;
+
+    case OP_MATCH:
+      term->regex = g_regex_new (value, G_REGEX_OPTIMIZE, 0, error);
+      return term->regex != NULL;
+
+    default:
+      g_set_error (error, GYACHT_FILTER_ERROR, 0,
+                   _("%s can only be compared with =, != and ~"), term->field->name);
+      return FALSE;
+    }
+}
+
+static gboolean
+internal_string_matches (const FilterTerm *term,
+                         const gchar      *string)
+{
+  if (string == NULL)
+    return FALSE;
+
+  if (term->op == OP_MATCH)
+    return g_regex_match (term->regex, string, 0, NULL);
+
+  if (term->field->type == FILTER_FIELD_ID)
+    return g_str_has_prefix (string, term->string);
+
+  return strcmp (string, term->string) == 0;
+}
+
+static gboolean
+internal_term_matches (const FilterTerm *term,
+                       gpointer          item)
+{
+  gconstpointer value = term->field->get (item);
+  const GPtrArray *strings;
+  gint64 time;
+  guint i;
+
+  switch (term->field->type)
+    {
+    case FILTER_FIELD_STRING:
+    case FILTER_FIELD_ID:
+      return internal_string_matches (term, value);
+
+    case FILTER_FIELD_STRINGS:
+      strings = value;
+      for (i = 0; strings && i < strings->len; i++)
+        if (internal_string_matches (term, g_ptr_array_index (strings, i)))
+          return TRUE;
+      return FALSE;
+
+    case FILTER_FIELD_TIME:
+      if (value == NULL)
+        return FALSE;
+
+      time = g_date_time_to_unix ((GDateTime *) value);
+      switch (term->op)
+        {
+        case OP_LESS:           return time < term->time;
+        case OP_LESS_EQUAL:     return time <= term->time;
+        case OP_GREATER:        return time > term->time;
+        case OP_GREATER_EQUAL:  return time >= term->time;
+        default:                return FALSE;
+        }
+
+    default:
+      return FALSE;
+    }
+}
+
+/* --- Public APIs --- */
+/**
+ * gyacht_filter_compile:
+ * @fields: the fields items can be filtered on
+ * @text: what the user typed
+ * @rest: (out): the words of @text which are not filter terms
+ * @error: return location for a #GError
+ *
+ * Return value: (transfer full) (nullable): The filter, or %NULL if @text
+ *   has no terms or on an error.
+ */
+GyachtFilter *
+gyacht_filter_compile (const GyachtFilterField  *fields,
+                       const gchar              *text,
+                       gchar                   **rest,
+                       GError                  **error)
+{
+  g_autoptr(GyachtFilter) self = NULL;
+  g_auto(GStrv) words = NULL;
+  g_autoptr(GPtrArray) sources = NULL;
+  g_autoptr(GPtrArray) others = NULL;
+  guint i;
+
+  g_return_val_if_fail (fields != NULL, NULL);
+  g_return_val_if_fail (rest != NULL, NULL);
+
+  self = g_new0 (GyachtFilter, 1);
+  self->terms = g_array_new (FALSE, TRUE, sizeof (FilterTerm));
+  g_array_set_clear_func (self->terms, internal_filter_term_clear);
+
+  sources = g_ptr_array_new ();
+  others = g_ptr_array_new ();
+
+  words = g_strsplit_set (text ? text : "", " \t", -1);
+  for (i = 0; words[i]; i++)
+    {
+      FilterTerm term = { NULL, };
+      GError *local_error = NULL;
+
+      if (*words[i] == '\0')
+        continue;
+
+      if (internal_parse_term (fields, words[i], &term, &local_error))
+        {
+          g_array_append_val (self->terms, term);
+          g_ptr_array_add (sources, words[i]);
+          continue;
+        }
+
+      internal_filter_term_clear (&term);
+      if (local_error)
+        {
+          g_propagate_error (error, local_error);
+          *rest = NULL;
+          return NULL;
+        }
+
+      g_ptr_array_add (others, words[i]);
+    }
+
+  g_ptr_array_add (others, NULL);
+  *rest = g_strjoinv (" ", (gchar **) others->pdata);
+
+  if (self->terms->len == 0)
+    return NULL;
+
+  g_ptr_array_add (sources, NULL);
+  self->source = g_strjoinv (" ", (gchar **) sources->pdata);
+
+  return g_steal_pointer (&self);
+}
+
+void
+gyacht_filter_free (GyachtFilter *self)
+{
+  g_return_if_fail (self != NULL);
+
+  g_array_unref (self->terms);
+  g_free (self->source);
+  g_free (self);
+}
+
+/* The terms of the filter, as they were typed */
+const gchar *
+gyacht_filter_get_source (GyachtFilter *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return self->source;
+}
+
+gboolean
+gyacht_filter_matches (GyachtFilter *self,
+                       gpointer      item)
+{
+  const FilterTerm *terms;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  terms = (const FilterTerm *) self->terms->data;
+  for (i = 0; i < self->terms->len; i++)
+    if (internal_term_matches (&terms[i], item) == terms[i].negate)
+      return FALSE;
+
+  return TRUE;
+}
+
+/**
+ * gyacht_filter_update_from_entry:
+ * @filter: (inout) (nullable): The filter of the view.
+ * @fields: The fields of its items.
+ * @entry: The search entry.
+ * @rows: The rows of the view, as the values of a #GHashTable.
+ * @refilter: Called on every row of @rows once @filter is replaced.
+ * @user_data: User data for @refilter.
+ * @rest: (out): Return location for the words left to the text search.
+ *
+ * Compiles the text of @entry, which is flagged with the error if it is
+ * invalid. Only new filter terms replace @filter and have every row
+ * evaluated again, the free text is left to the caller.
+ *
+ * Return value: %FALSE if the text is invalid, @filter is then kept.
+ */
+gboolean
+gyacht_filter_update_from_entry (GyachtFilter            **filter,
+                                 const GyachtFilterField  *fields,
+                                 GtkEntry                 *entry,
+                                 GHashTable               *rows,
+                                 GFunc                     refilter,
+                                 gpointer                  user_data,
+                                 gchar                   **rest)
+{
+  g_autoptr(GyachtFilter) compiled = NULL;
+  g_autoptr(GError) error = NULL;
+  GtkStyleContext *context;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_return_val_if_fail (filter != NULL, FALSE);
+  g_return_val_if_fail (GTK_IS_ENTRY (entry), FALSE);
+  g_return_val_if_fail (rest != NULL, FALSE);
+
+  compiled = gyacht_filter_compile (fields, gtk_entry_get_text (entry), rest, &error);
+
+  context = gtk_widget_get_style_context (GTK_WIDGET (entry));
+  gtk_widget_set_tooltip_text (GTK_WIDGET (entry), error ? error->message : NULL);
+  if (error)
+    {
+      gtk_style_context_add_class (context, GTK_STYLE_CLASS_ERROR);
+      return FALSE;
+    }
+  gtk_style_context_remove_class (context, GTK_STYLE_CLASS_ERROR);
+
+  if (g_strcmp0 (compiled ? compiled->source : NULL,
+                 *filter ? (*filter)->source : NULL) == 0)
+    return TRUE;
+
+  g_clear_pointer (filter, gyacht_filter_free);
+  *filter = g_steal_pointer (&compiled);
+
+  g_hash_table_iter_init (&iter, rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    refilter (value, user_data);
+
+  return TRUE;
+}
@@ -0,0 +1,68 @@
+/* gyacht-filter.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  FILTER_FIELD_STRING = 0,  /* const gchar *, compared as a whole */
+  FILTER_FIELD_STRINGS,     /* const GPtrArray * of strings, any may match */
+  FILTER_FIELD_ID,          /* const gchar *, short ids match as prefixes */
+  FILTER_FIELD_TIME,        /* const GDateTime * */
+  N_FILTER_FIELDS
+} GyachtFilterFieldType;
+
+typedef gconstpointer (*GyachtFilterGetFunc) (gpointer item);
+
+#define GYACHT_FILTER_GET_FUNC(f) ((GyachtFilterGetFunc) (f))
+
+/* A field which can be filtered on, tables end with a NULL name */
+typedef struct
+{
+  const gchar           *name;
+  GyachtFilterFieldType type;
+  GyachtFilterGetFunc   get;
+} GyachtFilterField;
+
+typedef struct _GyachtFilter GyachtFilter;
+
+GyachtFilter *  gyacht_filter_compile     (const GyachtFilterField  *fields,
+                                           const gchar              *text,
+                                           gchar                   **rest,
+                                           GError                  **error);
+void            gyacht_filter_free        (GyachtFilter             *self);
+const gchar *   gyacht_filter_get_source  (GyachtFilter             *self);
+gboolean        gyacht_filter_matches     (GyachtFilter             *self,
+                                           gpointer                  item);
+gboolean        gyacht_filter_update_from_entry
+                                          (GyachtFilter            **filter,
+                                           const GyachtFilterField  *fields,
+                                           GtkEntry                 *entry,
+                                           GHashTable               *rows,
+                                           GFunc                     refilter,
+                                           gpointer                  user_data,
+                                           gchar                   **rest);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtFilter, gyacht_filter_free)
+
+G_END_DECLS
@@ -0,0 +1,237 @@
+/* gyacht-frame-queue.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-frame-queue.h"
+
+/* Changes of a model are queued here and applied to the view from the
+ * tick callback of its frame clock, for at most FRAME_BUDGET on each
+ * frame, so that a large reload never blocks painting.
+ *
+ * Pending changes of the same key are coalesced into one, and a reset
+ * drops the pending changes of a generation which got superseded.
+ */
+
+#define FRAME_BUDGET  4000  /* microseconds */
+
+typedef struct
+{
+  GyachtFrameOp op;
+  gchar         *key;
+  GObject       *item;
+} PendingOp;
+
+struct _GyachtFrameQueue
+{
+  GObject               parent_instance;
+
+  GtkWidget             *widget;
+  GyachtFrameQueueFunc  func;
+  gpointer              user_data;
+
+  GQueue                *ops;
+  GHashTable            *pending;   /* key -> GList link of ops */
+  guint                 tick_id;
+};
+
+G_DEFINE_TYPE (GyachtFrameQueue, gyacht_frame_queue, G_TYPE_OBJECT)
+
+
+static void
+internal_pending_op_free (gpointer data)
+{
+  PendingOp *op = data;
+
+  g_free (op->key);
+  g_clear_object (&op->item);
+  g_free (op);
+}
+
+static gboolean
+internal_tick_cb (GtkWidget     *widget,
+                  GdkFrameClock *frame_clock,
+                  gpointer       user_data)
+{
+  GyachtFrameQueue *self = GYACHT_FRAME_QUEUE (user_data);
+  gint64 deadline = g_get_monotonic_time () + FRAME_BUDGET;
+
+  /* At least one change goes through on every frame */
+  do
+    {
+      PendingOp *op = g_queue_pop_head (self->ops);
+
+      if (op == NULL)
+        break;
+
+      g_hash_table_remove (self->pending, op->key);
+      self->func (op->op, op->key, op->item, self->user_data);
+      internal_pending_op_free (op);
+    }
+  while (g_get_monotonic_time () < deadline);
+
+  gyacht_trace ("%u changes left", g_queue_get_length (self->ops));
+
+  if (!g_queue_is_empty (self->ops))
+    return G_SOURCE_CONTINUE;
+
+  self->tick_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+/* --- GObject --- */
+static void
+gyacht_frame_queue_finalize (GObject *object)
+{
+  GyachtFrameQueue *self = GYACHT_FRAME_QUEUE (object);
+
+  if (self->tick_id != 0)
+    gtk_widget_remove_tick_callback (self->widget, self->tick_id);
+
+  g_hash_table_unref (self->pending);
+  g_queue_free_full (self->ops, internal_pending_op_free);
+  g_clear_object (&self->widget);
+
+  G_OBJECT_CLASS (gyacht_frame_queue_parent_class)->finalize (object);
+}
+
+static void
+gyacht_frame_queue_class_init (GyachtFrameQueueClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_frame_queue_finalize;
+}
+
+static void
+gyacht_frame_queue_init (GyachtFrameQueue *self)
+{
+  self->ops = g_queue_new ();
+  self->pending = g_hash_table_new (g_str_hash, g_str_equal);
+  self->tick_id = 0;
+}
+
+/* --- Public APIs --- */
+
+/**
+ * gyacht_frame_queue_new:
+ * @widget: The #GtkWidget whose frame clock drives the queue.
+ * @func: Applies a single change to the view.
+ * @user_data: User data for @func.
+ *
+ * Changes are only applied while @widget is realized, so a hidden view
+ * keeps them until it is shown.
+ *
+ * Return value: (transfer full): A new #GyachtFrameQueue.
+ */
+GyachtFrameQueue *
+gyacht_frame_queue_new (GtkWidget            *widget,
+                        GyachtFrameQueueFunc  func,
+                        gpointer              user_data)
+{
+  GyachtFrameQueue *self;
+
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  self = g_object_new (GYACHT_TYPE_FRAME_QUEUE, NULL);
+  self->widget = g_object_ref (widget);
+  self->func = func;
+  self->user_data = user_data;
+
+  return self;
+}
+
+/**
+ * gyacht_frame_queue_push:
+ * @self: A #GyachtFrameQueue.
+ * @op: The #GyachtFrameOp.
+ * @key: The key of the item, e.g. its id.
+ * @item: The item of the model.
+ *
+ * Queues a change of @item. If a change of @key is still pending, they
+ * are merged in place: the latest one wins, except that a change after an
+ * addition is still an addition of the latest @item.
+ */
+void
+gyacht_frame_queue_push (GyachtFrameQueue *self,
+                         GyachtFrameOp     op,
+                         const gchar      *key,
+                         GObject          *item)
+{
+  PendingOp *pending;
+  GList *link;
+
+  g_return_if_fail (GYACHT_IS_FRAME_QUEUE (self));
+  g_return_if_fail (op < N_FRAME_OPS);
+  g_return_if_fail (key != NULL);
+  g_return_if_fail (G_IS_OBJECT (item));
+
+  link = g_hash_table_lookup (self->pending, key);
+  if (link)
+    {
+      pending = link->data;
+
+      if (!(op == FRAME_OP_CHANGE && pending->op == FRAME_OP_ADD))
+        pending->op = op;
+
+      g_set_object (&pending->item, item);
+    }
+  else
+    {
+      pending = g_new0 (PendingOp, 1);
+      pending->op = op;
+      pending->key = g_strdup (key);
+      pending->item = g_object_ref (item);
+
+      g_queue_push_tail (self->ops, pending);
+      g_hash_table_insert (self->pending, pending->key, g_queue_peek_tail_link (self->ops));
+    }
+
+  if (self->tick_id == 0)
+    self->tick_id = gtk_widget_add_tick_callback (self->widget,
+                                                  internal_tick_cb,
+                                                  self,
+                                                  NULL);
+}
+
+/**
+ * gyacht_frame_queue_reset:
+ * @self: A #GyachtFrameQueue.
+ *
+ * Drops every pending change, usually because the view is about to queue
+ * a newer generation of the whole list.
+ */
+void
+gyacht_frame_queue_reset (GyachtFrameQueue *self)
+{
+  g_return_if_fail (GYACHT_IS_FRAME_QUEUE (self));
+
+  g_hash_table_remove_all (self->pending);
+  g_queue_free_full (self->ops, internal_pending_op_free);
+  self->ops = g_queue_new ();
+}
+
+guint
+gyacht_frame_queue_get_length (GyachtFrameQueue *self)
+{
+  g_return_val_if_fail (GYACHT_IS_FRAME_QUEUE (self), 0);
+
+  return g_queue_get_length (self->ops);
+}
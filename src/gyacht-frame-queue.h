@@ -0,0 +1,53 @@
+/* gyacht-frame-queue.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  FRAME_OP_ADD = 0,
+  FRAME_OP_REMOVE,
+  FRAME_OP_CHANGE,
+  N_FRAME_OPS
+} GyachtFrameOp;
+
+typedef void (*GyachtFrameQueueFunc) (GyachtFrameOp  op,
+                                      const gchar   *key,
+                                      GObject       *item,
+                                      gpointer       user_data);
+
+#define GYACHT_TYPE_FRAME_QUEUE (gyacht_frame_queue_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtFrameQueue, gyacht_frame_queue, GYACHT, FRAME_QUEUE, GObject)
+
+GyachtFrameQueue *  gyacht_frame_queue_new        (GtkWidget            *widget,
+                                                   GyachtFrameQueueFunc  func,
+                                                   gpointer              user_data);
+void                gyacht_frame_queue_push       (GyachtFrameQueue     *self,
+                                                   GyachtFrameOp         op,
+                                                   const gchar          *key,
+                                                   GObject              *item);
+void                gyacht_frame_queue_reset      (GyachtFrameQueue     *self);
+guint               gyacht_frame_queue_get_length (GyachtFrameQueue     *self);
+
+G_END_DECLS
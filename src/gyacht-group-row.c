@@ -0,0 +1,254 @@
+/* gyacht-group-row.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-group-row.h"
+
+#include <glib/gi18n.h>
+
+/* The row heading a group of rows. Its counts and total size are kept up
+ * to date by the view as members join, leave, get sized and pass or fail
+ * the search, so it never has to walk the group.
+ */
+
+struct _GyachtGroupRow
+{
+  GtkListBoxRow parent_instance;
+
+  gchar         *key;
+  guint         n_members;
+  guint         n_visible;  /* Members passing the search */
+  guint64       size;
+  gboolean      expanded;
+
+  GtkWidget     *arrow;
+  GtkWidget     *count_label;
+};
+
+G_DEFINE_TYPE (GyachtGroupRow, gyacht_group_row, GTK_TYPE_LIST_BOX_ROW)
+
+
+static void
+internal_update_count_label (GyachtGroupRow *self)
+{
+  g_autofree gchar *count = NULL;
+  g_autofree gchar *size = NULL;
+  g_autofree gchar *text = NULL;
+
+  if (self->n_visible < self->n_members)
+    /* Translators: The members passing the search, then all of them */
+    count = g_strdup_printf (ngettext ("%u of %u container", "%u of %u containers", self->n_members),
+                             self->n_visible, self->n_members);
+  else
+    count = g_strdup_printf (ngettext ("%u container", "%u containers", self->n_members),
+                             self->n_members);
+
+  if (self->size == 0)
+    {
+      gtk_label_set_text (GTK_LABEL (self->count_label), count);
+      return;
+    }
+
+  size = g_format_size (self->size);
+  text = g_strdup_printf ("%s — %s", count, size);
+  gtk_label_set_text (GTK_LABEL (self->count_label), text);
+}
+
+/* --- GObject --- */
+static void
+gyacht_group_row_finalize (GObject *object)
+{
+  GyachtGroupRow *self = GYACHT_GROUP_ROW (object);
+
+  g_free (self->key);
+
+  G_OBJECT_CLASS (gyacht_group_row_parent_class)->finalize (object);
+}
+
+static void
+gyacht_group_row_class_init (GyachtGroupRowClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_group_row_finalize;
+}
+
+static void
+gyacht_group_row_init (GyachtGroupRow *self)
+{
+  self->key = NULL;
+  self->n_members = 0;
+  self->n_visible = 0;
+  self->size = 0;
+  self->expanded = TRUE;
+}
+
+/* --- Public APIs --- */
+GtkWidget *
+gyacht_group_row_new (const gchar *key,
+                      const gchar *title)
+{
+  GyachtGroupRow *self;
+  GtkWidget *box;
+  GtkWidget *widget;
+  PangoAttrList *attrlist;
+
+  self = g_object_new (GYACHT_TYPE_GROUP_ROW, NULL);
+  self->key = g_strdup (key);
+
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_widget_set_margin_start (box, 6);
+  gtk_widget_set_margin_end (box, 6);
+  gtk_widget_set_margin_top (box, 6);
+  gtk_widget_set_margin_bottom (box, 6);
+
+  self->arrow = gtk_image_new_from_icon_name ("pan-down-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_box_pack_start (GTK_BOX (box), self->arrow, FALSE, FALSE, 0);
+
+  widget = gtk_label_new (title);
+  gtk_label_set_ellipsize (GTK_LABEL (widget), PANGO_ELLIPSIZE_END);
+  gtk_label_set_xalign (GTK_LABEL (widget), 0);
+  gtk_widget_set_hexpand (widget, TRUE);
+
+  attrlist = pango_attr_list_new ();
+  pango_attr_list_insert (attrlist, pango_attr_weight_new (PANGO_WEIGHT_BOLD));
+  gtk_label_set_attributes (GTK_LABEL (widget), attrlist);
+  pango_attr_list_unref (attrlist);
+
+  gtk_box_pack_start (GTK_BOX (box), widget, TRUE, TRUE, 0);
+
+  self->count_label = gtk_label_new (NULL);
+  gtk_style_context_add_class (gtk_widget_get_style_context (self->count_label),
+                               GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_box_pack_end (GTK_BOX (box), self->count_label, FALSE, FALSE, 0);
+  internal_update_count_label (self);
+
+  gtk_container_add (GTK_CONTAINER (self), box);
+  gtk_widget_show_all (GTK_WIDGET (self));
+
+  return GTK_WIDGET (self);
+}
+
+const gchar *
+gyacht_group_row_get_key (GyachtGroupRow *self)
+{
+  g_return_val_if_fail (GYACHT_IS_GROUP_ROW (self), NULL);
+
+  return self->key;
+}
+
+/* Return value: The number of members after adding one */
+guint
+gyacht_group_row_add_member (GyachtGroupRow *self,
+                             guint64         size,
+                             gboolean        visible)
+{
+  g_return_val_if_fail (GYACHT_IS_GROUP_ROW (self), 0);
+
+  self->n_members++;
+  if (visible)
+    self->n_visible++;
+  self->size += size;
+  internal_update_count_label (self);
+
+  return self->n_members;
+}
+
+/* Return value: The number of members left */
+guint
+gyacht_group_row_remove_member (GyachtGroupRow *self,
+                                guint64         size,
+                                gboolean        visible)
+{
+  g_return_val_if_fail (GYACHT_IS_GROUP_ROW (self), 0);
+  g_return_val_if_fail (self->n_members > 0, 0);
+
+  self->n_members--;
+  if (visible)
+    self->n_visible--;
+  self->size -= MIN (size, self->size);
+  internal_update_count_label (self);
+
+  return self->n_members;
+}
+
+void
+gyacht_group_row_resize_member (GyachtGroupRow *self,
+                                guint64         old_size,
+                                guint64         size)
+{
+  g_return_if_fail (GYACHT_IS_GROUP_ROW (self));
+
+  self->size -= MIN (old_size, self->size);
+  self->size += size;
+  internal_update_count_label (self);
+}
+
+/**
+ * gyacht_group_row_set_member_visible:
+ * @self: A #GyachtGroupRow.
+ * @visible: Whether a member now passes the search, it did not before.
+ *
+ * Return value: Whether the group has to be filtered again, as it got its
+ *    first visible member or lost its last one.
+ */
+gboolean
+gyacht_group_row_set_member_visible (GyachtGroupRow *self,
+                                     gboolean        visible)
+{
+  g_return_val_if_fail (GYACHT_IS_GROUP_ROW (self), FALSE);
+  g_return_val_if_fail (visible || self->n_visible > 0, FALSE);
+
+  if (visible)
+    self->n_visible++;
+  else
+    self->n_visible--;
+  internal_update_count_label (self);
+
+  return self->n_visible == (visible ? 1 : 0);
+}
+
+/* Return value: Whether a member of the group passes the search */
+gboolean
+gyacht_group_row_has_visible (GyachtGroupRow *self)
+{
+  g_return_val_if_fail (GYACHT_IS_GROUP_ROW (self), FALSE);
+
+  return self->n_visible > 0;
+}
+
+gboolean
+gyacht_group_row_get_expanded (GyachtGroupRow *self)
+{
+  g_return_val_if_fail (GYACHT_IS_GROUP_ROW (self), FALSE);
+
+  return self->expanded;
+}
+
+void
+gyacht_group_row_set_expanded (GyachtGroupRow *self,
+                               gboolean        expanded)
+{
+  g_return_if_fail (GYACHT_IS_GROUP_ROW (self));
+
+  self->expanded = !!expanded;
+  gtk_image_set_from_icon_name (GTK_IMAGE (self->arrow),
+                                expanded ? "pan-down-symbolic" : "pan-end-symbolic",
+                                GTK_ICON_SIZE_BUTTON);
+}
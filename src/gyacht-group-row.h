@@ -0,0 +1,51 @@
+/* gyacht-group-row.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_GROUP_ROW (gyacht_group_row_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtGroupRow, gyacht_group_row, GYACHT, GROUP_ROW, GtkListBoxRow)
+
+GtkWidget *   gyacht_group_row_new            (const gchar    *key,
+                                               const gchar    *title);
+const gchar * gyacht_group_row_get_key        (GyachtGroupRow *self);
+guint         gyacht_group_row_add_member     (GyachtGroupRow *self,
+                                               guint64         size,
+                                               gboolean        visible);
+guint         gyacht_group_row_remove_member  (GyachtGroupRow *self,
+                                               guint64         size,
+                                               gboolean        visible);
+void          gyacht_group_row_resize_member  (GyachtGroupRow *self,
+                                               guint64         old_size,
+                                               guint64         size);
+gboolean      gyacht_group_row_set_member_visible
+                                              (GyachtGroupRow *self,
+                                               gboolean        visible);
+gboolean      gyacht_group_row_has_visible    (GyachtGroupRow *self);
+gboolean      gyacht_group_row_get_expanded   (GyachtGroupRow *self);
+void          gyacht_group_row_set_expanded   (GyachtGroupRow *self,
+                                               gboolean        expanded);
+
+G_END_DECLS
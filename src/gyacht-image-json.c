@@ -48,15 +48,107 @@ internal_names_new (JsonArray *jarray)
   return new_array;
 }
 
+static gint64
+internal_get_big_data_size (JsonObject  *sizes,
+                            const gchar *name)
+{
+  JsonNode *member;
+
+  if (sizes == NULL)
+    return -1;
+
+  member = json_object_get_member (sizes, name);
+  if (member == NULL || json_node_get_value_type (member) != G_TYPE_INT64)
+    return -1;
+
+  return json_node_get_int (member);
+}
+
+static gchar *
+internal_dup_big_data_digest (JsonObject  *digests,
+                              const gchar *name)
+{
+  JsonNode *member;
+
+  if (digests == NULL)
+    return NULL;
+
+  member = json_object_get_member (digests, name);
+  if (member == NULL || json_node_get_value_type (member) != G_TYPE_STRING)
+    return NULL;
+
+  return g_strdup (json_node_get_string (member));
+}
+
+static JsonObject *
+internal_get_object_member (JsonObject  *elem,
+                            const gchar *member_name)
+{
+  JsonNode *member = json_object_get_member (elem, member_name);
+
+  if (member == NULL || !JSON_NODE_HOLDS_OBJECT (member))
+    return NULL;
+
+  return json_node_get_object (member);
+}
+
+/* The sizes and digests are objects keyed by the names */
 static void
-internal_image_json_foreach_cb (JsonArray *array,
-                                guint      index_,
-                                JsonNode  *element_node,
-                                gpointer   user_data)
+internal_parse_big_data (GyachtImage *image,
+                         JsonObject  *elem)
+{
+  JsonNode *member;
+  JsonArray *jarray;
+  JsonObject *sizes;
+  JsonObject *digests;
+  GPtrArray *names;
+  GArray *size_array;
+  GPtrArray *digest_array;
+  guint length;
+  guint i;
+
+  member = json_object_get_member (elem, "big-data-names");
+  if (member == NULL || !JSON_NODE_HOLDS_ARRAY (member))
+    return;
+
+  jarray = json_node_get_array (member);
+  length = json_array_get_length (jarray);
+  sizes = internal_get_object_member (elem, "big-data-sizes");
+  digests = internal_get_object_member (elem, "big-data-digests");
+
+  names = g_ptr_array_new_full (length, g_free);
+  size_array = g_array_sized_new (FALSE, FALSE, sizeof (gint64), length);
+  digest_array = g_ptr_array_new_full (length, g_free);
+
+  for (i = 0; i < length; i++)
+    {
+      const gchar *name = json_array_get_string_element (jarray, i);
+      gint64 size;
+
+      if (name == NULL)
+        continue;
+
+      size = internal_get_big_data_size (sizes, name);
+      g_ptr_array_add (names, g_strdup (name));
+      g_array_append_val (size_array, size);
+      g_ptr_array_add (digest_array, internal_dup_big_data_digest (digests, name));
+    }
+
+  gyacht_image_set_big_data (image, names, size_array, digest_array);
+}
+
+/**
+ * gyacht_image_parse_json_element:
+ * @element_node: An element of the array of images.json.
+ *
+ * It can be called from any thread.
+ *
+ * Return value: (transfer full) (nullable): A new #GyachtImage.
+ */
+GyachtImage *
+gyacht_image_parse_json_element (JsonNode *element_node)
 {
-  GSequence *seq;
   JsonObject *elem;
-  GyachtImage *new_image;
   /* Image data */
   const gchar *id = NULL;
   const gchar *digest = NULL;
@@ -64,14 +156,19 @@ internal_image_json_foreach_cb (JsonArray *array,
   const gchar *layer = NULL;
   const gchar *metadata = NULL;
   GDateTime *created = NULL;
+  GyachtImage *image;
+
+  if (element_node == NULL || !JSON_NODE_HOLDS_OBJECT (element_node))
+    return NULL;
 
-  seq = (GSequence *)user_data;
   elem = json_node_get_object (element_node);
 
   if (json_object_has_member (elem, "id"))
     {
       id = json_object_get_string_member (elem, "id");
     }
+  if (id == NULL)
+    return NULL;
   if (json_object_has_member (elem, "digest"))
     {
       digest = json_object_get_string_member (elem, "digest");
@@ -96,9 +193,25 @@ internal_image_json_foreach_cb (JsonArray *array,
       created = g_date_time_new_from_iso8601 (member, time_zone);
     }
 
-  new_image = gyacht_image_new (id, digest, names,
-                                layer, metadata, created);
-  g_sequence_append (seq, new_image);
+  image = gyacht_image_new (id, digest, names,
+                            layer, metadata, created);
+  internal_parse_big_data (image, elem);
+
+  return image;
+}
+
+static void
+internal_image_json_foreach_cb (JsonArray *array,
+                                guint      index_,
+                                JsonNode  *element_node,
+                                gpointer   user_data)
+{
+  GSequence *seq = (GSequence *)user_data;
+  GyachtImage *new_image;
+
+  new_image = gyacht_image_parse_json_element (element_node);
+  if (new_image)
+    g_sequence_append (seq, new_image);
 }
 
 /**
@@ -140,3 +253,103 @@ gyacht_image_parse_json_contents (JsonParser  *parser,
 
   return seq;
 }
+
+static void
+internal_image_api_foreach_cb (JsonArray *array,
+                               guint      index_,
+                               JsonNode  *element_node,
+                               gpointer   user_data)
+{
+  GSequence *seq;
+  JsonObject *elem;
+  GyachtImage *new_image;
+  /* Image data */
+  const gchar *id = NULL;
+  const gchar *digest = NULL;
+  GPtrArray *names = NULL;
+  GDateTime *created = NULL;
+
+  seq = (GSequence *)user_data;
+  elem = json_node_get_object (element_node);
+
+  if (json_object_has_member (elem, "Id"))
+    {
+      id = json_object_get_string_member (elem, "Id");
+    }
+  if (json_object_has_member (elem, "Digest"))
+    {
+      digest = json_object_get_string_member (elem, "Digest");
+    }
+  if (json_object_has_member (elem, "Names") &&
+      JSON_NODE_HOLDS_ARRAY (json_object_get_member (elem, "Names")))
+    {
+      JsonArray *member = json_object_get_array_member (elem, "Names");
+      names = internal_names_new (member);
+    }
+  else if (json_object_has_member (elem, "RepoTags") &&
+           JSON_NODE_HOLDS_ARRAY (json_object_get_member (elem, "RepoTags")))
+    {
+      JsonArray *member = json_object_get_array_member (elem, "RepoTags");
+      names = internal_names_new (member);
+    }
+  if (json_object_has_member (elem, "Created"))
+    {
+      g_autoptr(GDateTime) utc = NULL;
+
+      utc = g_date_time_new_from_unix_utc (json_object_get_int_member (elem, "Created"));
+      created = g_date_time_to_local (utc);
+    }
+
+  if (id == NULL)
+    {
+      if (names)
+        g_ptr_array_unref (names);
+      if (created)
+        g_date_time_unref (created);
+      return;
+    }
+
+  /* The API does not tell about the top layer nor the metadata */
+  new_image = gyacht_image_new (id, digest, names,
+                                NULL, NULL, created);
+  g_sequence_append (seq, new_image);
+}
+
+/**
+ * gyacht_image_parse_api_contents:
+ * @parser: #JsonParser in which has the response of /images/json.
+ * @error: (nullable): A #GError.
+ *
+ * Return value: (transfer full): Null if it is on failure and error is set,
+ *    otherwise returns #GSequence and error is NULL.
+ */
+GSequence *
+gyacht_image_parse_api_contents (JsonParser  *parser,
+                                 GError     **error)
+{
+  JsonNode *root;
+  GSequence *seq;
+
+  GYACHT_TRACE_ENTRY;
+
+  g_return_val_if_fail (JSON_IS_PARSER (parser), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  root = json_parser_get_root (parser);
+  if (root == NULL || !JSON_NODE_HOLDS_ARRAY (root))
+    {
+      if (error != NULL)
+        g_set_error (error, GYACHT_IMAGE_JSON_ERROR, 0,
+                     "Failed to get an array from the parser");
+      return NULL;
+    }
+
+  seq = g_sequence_new (g_object_unref);
+  json_array_foreach_element (json_node_get_array (root),
+                              internal_image_api_foreach_cb,
+                              seq);
+
+  GYACHT_TRACE_EXIT;
+
+  return seq;
+}
@@ -18,13 +18,28 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include "gyacht-age-clock.h"
+#include "gyacht-application.h"
+#include "gyacht-big-data.h"
+#include "gyacht-compact-row.h"
 #include "gyacht-image-list-view.h"
+#include "gyacht-image-pane.h"
 #include "gyacht-image-private.h"
 #include "gyacht-image-service.h"
+#include "gyacht-layer-browser.h"
 #include "gyacht-debug.h"
+#include "gyacht-filter.h"
+#include "gyacht-frame-queue.h"
 #include "gyacht-macros.h"
+#include "gyacht-reachability.h"
+#include "gyacht-row-sort.h"
+#include "gyacht-search-index.h"
 
 #include <glib/gi18n.h>
+#include <json-glib/json-glib.h>
+
+/* Decoded configurations kept for going back and forth between images */
+#define CONFIG_CACHE_SIZE 64
 
 struct _GyachtImageListView
 {
@@ -32,31 +47,205 @@ struct _GyachtImageListView
 
   /* Widgets */
   GtkListBox          *list_box;
+  GtkWidget           *progress_label;
+  GtkWidget           *reclaim_label;
+  GtkWidget           *selection_label;
+  GtkSearchBar        *search_bar;
+  GtkWidget           *search_entry;
+  GtkWidget           *image_revealer;
+  GtkWidget           *image_pane;
 
   GyachtImageService  *service;
+  GyachtLayerService  *layers;
+  GyachtReachability  *reachability;
+  GyachtReclaimIndex  *reclaim;     /* Shared with the other views */
+  GHashTable          *selection;   /* GtkListBoxRow -> top layer id */
+  GHashTable          *rows;  /* id -> GtkListBoxRow */
+  GyachtFrameQueue    *updates;
+  GyachtAgeClock      *ages;
+  gboolean            compact;
+  GyachtSearchIndex   *index;   /* Follows the rows */
+  GyachtFilter        *filter;
+  GyachtBigDataCache  *big_data;
+  GCancellable        *inspect_cancellable;   /* Of the shown image */
 };
 
 G_DEFINE_TYPE (GyachtImageListView, gyacht_image_list_view, GTK_TYPE_BOX)
 
+static const GyachtFilterField filter_fields[] = {
+  { "id",       FILTER_FIELD_ID,      GYACHT_FILTER_GET_FUNC (gyacht_image_get_id) },
+  { "name",     FILTER_FIELD_STRINGS, GYACHT_FILTER_GET_FUNC (gyacht_image_get_names) },
+  { "names",    FILTER_FIELD_STRINGS, GYACHT_FILTER_GET_FUNC (gyacht_image_get_names) },
+  { "digest",   FILTER_FIELD_ID,      GYACHT_FILTER_GET_FUNC (gyacht_image_get_digest) },
+  { "created",  FILTER_FIELD_TIME,    GYACHT_FILTER_GET_FUNC (gyacht_image_get_created) },
+  { NULL, }
+};
+
+/* The filter is evaluated once per image, when its row is added, and the
+ * verdict is kept on the row for the filter func.
+ */
+static void
+internal_filter_row (GyachtImageListView *self,
+                     GtkWidget           *row)
+{
+  GyachtImage *image = g_object_get_data (G_OBJECT (row), "image");
+  gboolean hidden;
+
+  hidden = self->filter && !gyacht_filter_matches (self->filter, image);
+  g_object_set_data (G_OBJECT (row), "filtered-out", GINT_TO_POINTER (hidden));
+}
 
 static void
-internal_clear_list_box_rows (GyachtImageListView *self)
+internal_set_age (GtkListBoxRow *row,
+                  const gchar   *text,
+                  gpointer       user_data)
 {
-  GList *children, *iter;
+  GtkWidget *label;
 
-  children = gtk_container_get_children (GTK_CONTAINER (self->list_box));
-  for (iter = children; iter != NULL; iter = g_list_next (iter))
-    gtk_widget_destroy (GTK_WIDGET (iter->data));
-  g_list_free (children);
+  if (GYACHT_IS_COMPACT_ROW (row))
+    {
+      gyacht_compact_row_set_text (GYACHT_COMPACT_ROW (row), COMPACT_ROW_DATE, text);
+      return;
+    }
+
+  label = g_object_get_data (G_OBJECT (row), "date-label");
+  if (label)
+    gtk_label_set_text (GTK_LABEL (label), text);
 }
 
 static GtkWidget *
-internal_create_row (GyachtImage *image)
+internal_create_compact_row (GyachtImage *image)
+{
+  GyachtCompactRow *row;
+
+  row = GYACHT_COMPACT_ROW (gyacht_compact_row_new ());
+
+  gyacht_compact_row_set_text (row, COMPACT_ROW_TITLE, gyacht_image_get_name (image));
+  gyacht_compact_row_set_text (row, COMPACT_ROW_SUBTITLE, gyacht_image_get_id (image));
+  gtk_widget_show (GTK_WIDGET (row));
+
+  return GTK_WIDGET (row);
+}
+
+static void
+internal_config_loaded_cb (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  g_autoptr(GyachtImageConfig) config = NULL;
+  g_autoptr(GError) error = NULL;
+  GyachtImageListView *self;
+
+  config = gyacht_big_data_cache_load_config_finish (GYACHT_BIG_DATA_CACHE (source_object),
+                                                     res,
+                                                     &error);
+
+  /* Cancelled if another image got shown or the view is gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = GYACHT_IMAGE_LIST_VIEW (user_data);
+  gyacht_image_pane_set_config (GYACHT_IMAGE_PANE (self->image_pane), config);
+}
+
+static void
+internal_manifest_read_cb (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(JsonParser) parser = NULL;
+  g_autoptr(JsonGenerator) generator = NULL;
+  g_autofree gchar *text = NULL;
+  GyachtImageListView *self;
+  gsize length;
+  const gchar *data;
+
+  bytes = gyacht_big_data_cache_read_finish (GYACHT_BIG_DATA_CACHE (source_object),
+                                             res,
+                                             &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = GYACHT_IMAGE_LIST_VIEW (user_data);
+
+  /* A manifest is a few kilobytes of JSON, it is pretty printed here */
+  if (bytes)
+    {
+      data = g_bytes_get_data (bytes, &length);
+      parser = json_parser_new ();
+      if (json_parser_load_from_data (parser, data, length, NULL))
+        {
+          generator = json_generator_new ();
+          json_generator_set_pretty (generator, TRUE);
+          json_generator_set_root (generator, json_parser_get_root (parser));
+          text = json_generator_to_data (generator, NULL);
+        }
+    }
+
+  gyacht_image_pane_set_manifest (GYACHT_IMAGE_PANE (self->image_pane), text);
+}
+
+/* What the model knows is shown at once. The configuration is decoded
+ * once per digest, the manifest is read again each time.
+ */
+static void
+internal_inspect_image (GyachtImageListView *self,
+                        GyachtImage         *image)
+{
+  g_autoptr(GyachtImageConfig) config = NULL;
+
+  g_cancellable_cancel (self->inspect_cancellable);
+  g_clear_object (&self->inspect_cancellable);
+
+  gyacht_image_pane_set_image (GYACHT_IMAGE_PANE (self->image_pane), image);
+  gtk_revealer_set_reveal_child (GTK_REVEALER (self->image_revealer), TRUE);
+
+  self->inspect_cancellable = g_cancellable_new ();
+
+  if (gyacht_image_has_big_data (image, "manifest"))
+    gyacht_big_data_cache_read_async (self->big_data,
+                                      image,
+                                      "manifest",
+                                      self->inspect_cancellable,
+                                      internal_manifest_read_cb,
+                                      self);
+  else
+    gyacht_image_pane_set_manifest (GYACHT_IMAGE_PANE (self->image_pane), NULL);
+
+  config = gyacht_big_data_cache_lookup_config (self->big_data, image);
+  if (config)
+    {
+      gyacht_image_pane_set_config (GYACHT_IMAGE_PANE (self->image_pane), config);
+      return;
+    }
+
+  gyacht_big_data_cache_load_config_async (self->big_data,
+                                           image,
+                                           self->inspect_cancellable,
+                                           internal_config_loaded_cb,
+                                           self);
+}
+
+static void
+internal_inspect_clicked_cb (GtkButton           *button,
+                             GyachtImageListView *self)
+{
+  GtkWidget *row = g_object_get_data (G_OBJECT (button), "row");
+
+  internal_inspect_image (self, g_object_get_data (G_OBJECT (row), "image"));
+}
+
+static GtkWidget *
+internal_create_row (GyachtImageListView *self,
+                     GyachtImage         *image)
 {
   GtkWidget *row = NULL;
   GtkWidget *grid = NULL;
   GtkWidget *widget = NULL;
   gconstpointer buffer = NULL;
+  g_autofree gchar *date = NULL;
   PangoAttrList *attrlist = NULL;
   PangoAttribute *attr = NULL;
 
@@ -106,26 +295,36 @@ internal_create_row (GyachtImage *image)
 
   gtk_grid_attach (GTK_GRID (grid), widget, 0, 2, 1, 1);
 
-  /* Created */
-  buffer = gyacht_image_get_calendar_date (image);
-  widget = gtk_label_new (buffer);
+  /* Created, the age clock sets its text */
+  date = gyacht_image_get_calendar_date (image);
+  widget = gtk_label_new ("");
   gtk_label_set_xalign (GTK_LABEL (widget), 0);
+  gtk_widget_set_tooltip_text (widget, date);
+  g_object_set_data (G_OBJECT (row), "date-label", widget);
 
   gtk_grid_attach (GTK_GRID (grid), widget, 0, 3, 1, 1);
 
+  /* Size, set once the layers are known */
+  widget = gtk_label_new ("");
+  gtk_label_set_xalign (GTK_LABEL (widget), 0);
+  gtk_widget_set_sensitive (widget, FALSE);
+  g_object_set_data (G_OBJECT (row), "size-label", widget);
+
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 4, 1, 1);
+
   /* Separator */
   widget = gtk_separator_new (GTK_ORIENTATION_VERTICAL);
-  gtk_grid_attach (GTK_GRID (grid), widget, 1, 0, 1, 4);
+  gtk_grid_attach (GTK_GRID (grid), widget, 1, 0, 1, 5);
 
   /* Button */
   widget = gtk_button_new_from_icon_name ("preferences-other", GTK_ICON_SIZE_BUTTON);
   gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
   g_object_set_data (G_OBJECT (widget), "row", row);
   gtk_widget_set_tooltip_text (widget, _("Open the information dialog on the image"));
-  /*g_signal_connect (G_OBJECT (widget), "clicked", NULL, self);*/
+  g_signal_connect (G_OBJECT (widget), "clicked", G_CALLBACK (internal_inspect_clicked_cb), self);
   gtk_button_set_relief (GTK_BUTTON (widget), GTK_RELIEF_NONE);
 
-  gtk_grid_attach (GTK_GRID (grid), widget, 2, 0, 1, 4);
+  gtk_grid_attach (GTK_GRID (grid), widget, 2, 0, 1, 5);
 
   gtk_container_add (GTK_CONTAINER (row), grid);
   gtk_widget_show_all (row);
@@ -134,30 +333,309 @@ internal_create_row (GyachtImage *image)
 }
 
 static void
-internal_set_rows_foreach_cb (gpointer data,
-                              gpointer user_data)
+internal_update_size (GyachtImageListView *self,
+                      GtkWidget           *row)
 {
-  GyachtImageListView *self = GYACHT_IMAGE_LIST_VIEW (user_data);
-  GyachtImage *image = GYACHT_IMAGE (data);
+  GyachtImage *image = g_object_get_data (G_OBJECT (row), "image");
+  GyachtReachabilityReport *report;
+  g_autofree gchar *text = NULL;
+  const gchar *status = NULL;
+  guint64 unique_size;
+  guint64 shared_size;
+
+  if (gyacht_layer_service_get_image_usage (self->layers, image, &unique_size, &shared_size))
+    {
+      g_autofree gchar *size = g_format_size (unique_size + shared_size);
+
+      gyacht_row_sort_set_size (GTK_LIST_BOX_ROW (row), unique_size + shared_size);
+
+      if (shared_size > 0)
+        {
+          g_autofree gchar *unique = g_format_size (unique_size);
+
+          /* Translators: The size of an image, then what only it uses */
+          text = g_strdup_printf (_("%s (%s unique)"), size, unique);
+        }
+      else
+        text = g_steal_pointer (&size);
+    }
+
+  report = gyacht_reachability_get_report (self->reachability);
+  if (report && gyacht_reachability_report_is_dangling (report, image, NULL))
+    status = _("Dangling");
+
+  if (GYACHT_IS_COMPACT_ROW (row))
+    {
+      gyacht_compact_row_set_text (GYACHT_COMPACT_ROW (row), COMPACT_ROW_DETAIL, text);
+      gyacht_compact_row_set_text (GYACHT_COMPACT_ROW (row), COMPACT_ROW_STATUS, status);
+      return;
+    }
+
+  if (status)
+    {
+      g_autofree gchar *size = g_steal_pointer (&text);
+
+      text = size ? g_strdup_printf ("%s — %s", size, status) : g_strdup (status);
+    }
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "size-label"), text ? text : "");
+}
+
+static void
+internal_usage_changed_cb (GyachtImageListView *self)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, self->rows);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    internal_update_size (self, value);
+}
+
+static void
+internal_report_changed_cb (GyachtImageListView *self)
+{
+  GyachtReachabilityReport *report = gyacht_reachability_get_report (self->reachability);
+  g_autofree gchar *dangling = NULL;
+  g_autofree gchar *unreferenced = NULL;
+  g_autofree gchar *size = NULL;
+  g_autofree gchar *text = NULL;
+  guint n_dangling;
+  guint n_unreferenced;
+
+  /* Rows show whether they are dangling */
+  internal_usage_changed_cb (self);
+
+  n_dangling = gyacht_reachability_report_get_n_dangling (report);
+  n_unreferenced = gyacht_reachability_report_get_n_unreferenced (report);
+  if (n_dangling == 0 && n_unreferenced == 0)
+    {
+      gtk_widget_hide (self->reclaim_label);
+      return;
+    }
+
+  dangling = g_strdup_printf (ngettext ("%u dangling image", "%u dangling images", n_dangling),
+                              n_dangling);
+  unreferenced = g_strdup_printf (ngettext ("%u unreferenced layer", "%u unreferenced layers",
+                                            n_unreferenced),
+                                  n_unreferenced);
+  size = g_format_size (gyacht_reachability_report_get_reclaimable (report));
+
+  /* Translators: e.g. "2 dangling images and 5 unreferenced layers, 1.2 GB can be reclaimed" */
+  text = g_strdup_printf (_("%s and %s, %s can be reclaimed"), dangling, unreferenced, size);
+  gtk_label_set_text (GTK_LABEL (self->reclaim_label), text);
+  gtk_widget_show (self->reclaim_label);
+}
+
+/* Short ids are prefixes of the ids, they need no texts of their own */
+static void
+internal_index_image (GyachtImageListView *self,
+                      GyachtImage         *image)
+{
+  g_autoptr(GPtrArray) texts = NULL;
+  const GPtrArray *names;
+  guint i;
+
+  texts = g_ptr_array_new ();
+
+  names = gyacht_image_get_names (image);
+  for (i = 0; names && i < names->len; i++)
+    g_ptr_array_add (texts, g_ptr_array_index (names, i));
+
+  g_ptr_array_add (texts, (gpointer) gyacht_image_get_id (image));
+  g_ptr_array_add (texts, NULL);
+
+  gyacht_search_index_add (self->index,
+                           gyacht_image_get_id (image),
+                           (const gchar *const *) texts->pdata);
+}
+
+static void
+internal_add_row (GyachtImageListView *self,
+                  GyachtImage         *image)
+{
+  const gchar *id = gyacht_image_get_id (image);
   GtkWidget *row = NULL;
+  GtkWidget *old_row;
+  gint position = -1;
+
+  if (self->compact)
+    row = internal_create_compact_row (image);
+  else
+    row = internal_create_row (self, image);
+  g_object_set_data_full (G_OBJECT (row), "image", g_object_ref (image), g_object_unref);
+  internal_filter_row (self, row);
+
+  /* Before inserting, the list box filters the row right away */
+  internal_index_image (self, image);
+
+  /* A replaced image keeps its place */
+  old_row = g_hash_table_lookup (self->rows, id);
+  gyacht_row_sort_set_keys (GTK_LIST_BOX_ROW (row),
+                            old_row ? GTK_LIST_BOX_ROW (old_row) : NULL,
+                            gyacht_image_get_name (image),
+                            gyacht_image_get_name (image),
+                            gyacht_image_get_created (image));
+  internal_update_size (self, row);
+  if (old_row)
+    {
+      position = gtk_list_box_row_get_index (GTK_LIST_BOX_ROW (old_row));
+      gtk_widget_destroy (old_row);
+    }
 
-  row = internal_create_row (image);
+  g_hash_table_insert (self->rows, g_strdup (id), row);
+  gtk_list_box_insert (GTK_LIST_BOX (self->list_box), row, position);
+  gyacht_age_clock_add_row (self->ages, GTK_LIST_BOX_ROW (row),
+                            gyacht_image_get_created (image));
+}
 
-  gtk_list_box_insert (GTK_LIST_BOX (self->list_box), row, -1);
+static void
+internal_apply_update (GyachtFrameOp  op,
+                       const gchar   *key,
+                       GObject       *item,
+                       gpointer       user_data)
+{
+  GyachtImageListView *self = GYACHT_IMAGE_LIST_VIEW (user_data);
+  GtkWidget *row;
+
+  switch (op)
+    {
+    case FRAME_OP_ADD:
+    case FRAME_OP_CHANGE:
+      internal_add_row (self, GYACHT_IMAGE (item));
+      break;
+
+    case FRAME_OP_REMOVE:
+      row = g_hash_table_lookup (self->rows, key);
+      if (row)
+        {
+          gyacht_search_index_remove (self->index, key);
+          g_hash_table_remove (self->rows, key);
+          gtk_widget_destroy (row);
+        }
+      break;
+
+    default:
+      break;
+    }
 }
 
+/* Whether @row still shows @image as it is */
+static gboolean
+internal_row_is_current (GyachtImageListView *self,
+                         GtkWidget           *row,
+                         GyachtImage         *image)
+{
+  GyachtImage *shown = g_object_get_data (G_OBJECT (row), "image");
+
+  return GYACHT_IS_COMPACT_ROW (row) == self->compact &&
+         g_strcmp0 (gyacht_image_get_name (shown), gyacht_image_get_name (image)) == 0 &&
+         g_strcmp0 (gyacht_image_get_digest (shown), gyacht_image_get_digest (image)) == 0;
+}
+
+/* The service replaces the list, or a single image of it, and signals the
+ * whole list. Only the images which differ from the rows are queued.
+ */
 static void
 internal_image_list_set_rows (GyachtImageListView *self)
 {
-  GSequence *containers = NULL;
+  g_autoptr(GHashTable) fresh = NULL;
+  GSequence *images = NULL;
+  GSequenceIter *iter;
+  GHashTableIter rows_iter;
+  gpointer key, value;
+
+  gyacht_frame_queue_reset (self->updates);
+
+  fresh = g_hash_table_new (g_str_hash, g_str_equal);
+
+  images = gyacht_image_service_get_images (self->service);
+  if (images)
+    {
+      for (iter = g_sequence_get_begin_iter (images);
+           !g_sequence_iter_is_end (iter);
+           iter = g_sequence_iter_next (iter))
+        {
+          GyachtImage *image = g_sequence_get (iter);
+          const gchar *id = gyacht_image_get_id (image);
+          GtkWidget *row;
+
+          g_hash_table_add (fresh, (gpointer) id);
+
+          row = g_hash_table_lookup (self->rows, id);
+          if (row && internal_row_is_current (self, row, image))
+            continue;
+
+          gyacht_frame_queue_push (self->updates, FRAME_OP_ADD, id, G_OBJECT (image));
+        }
+    }
+
+  g_hash_table_iter_init (&rows_iter, self->rows);
+  while (g_hash_table_iter_next (&rows_iter, &key, &value))
+    if (!g_hash_table_contains (fresh, key))
+      gyacht_frame_queue_push (self->updates, FRAME_OP_REMOVE, key, G_OBJECT (value));
+}
+
+static void
+internal_reclaim_changed_cb (GyachtImageListView *self)
+{
+  g_autofree gchar *size = NULL;
+  g_autofree gchar *text = NULL;
+  guint n_items = gyacht_reclaim_index_get_n_items (self->reclaim);
+
+  if (n_items == 0)
+    {
+      gtk_widget_hide (self->selection_label);
+      return;
+    }
+
+  size = g_format_size (gyacht_reclaim_index_get_size (self->reclaim));
+  text = g_strdup_printf (ngettext ("Removing %u selected item frees %s",
+                                    "Removing %u selected items frees %s",
+                                    n_items),
+                          n_items, size);
+  gtk_label_set_text (GTK_LABEL (self->selection_label), text);
+  gtk_widget_show (self->selection_label);
+}
+
+/* Only the rows which joined or left the selection walk their chains */
+static void
+internal_selected_rows_changed_cb (GtkListBox          *list_box,
+                                   GyachtImageListView *self)
+{
+  g_autoptr(GHashTable) fresh = NULL;
+  GList *rows, *l;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  fresh = g_hash_table_new (NULL, NULL);
+
+  rows = gtk_list_box_get_selected_rows (list_box);
+  for (l = rows; l; l = l->next)
+    {
+      GyachtImage *item = g_object_get_data (G_OBJECT (l->data), "image");
+      const gchar *top;
+
+      if (item == NULL)
+        continue;
 
-  internal_clear_list_box_rows (self);
+      g_hash_table_add (fresh, l->data);
+      if (g_hash_table_contains (self->selection, l->data))
+        continue;
 
-  containers = gyacht_image_service_get_images (self->service);
-  if (containers)
+      top = gyacht_image_get_layer (item);
+      g_hash_table_insert (self->selection, l->data, g_strdup (top));
+      gyacht_reclaim_index_add (self->reclaim, top);
+    }
+  g_list_free (rows);
+
+  g_hash_table_iter_init (&iter, self->selection);
+  while (g_hash_table_iter_next (&iter, &key, &value))
     {
-      g_sequence_foreach (containers, internal_set_rows_foreach_cb, self);
-      gtk_list_box_unselect_all (GTK_LIST_BOX (self->list_box));
+      if (g_hash_table_contains (fresh, key))
+        continue;
+
+      gyacht_reclaim_index_remove (self->reclaim, value);
+      g_hash_table_iter_remove (&iter);
     }
 }
 
@@ -168,7 +646,13 @@ internal_box_header_func (GtkListBoxRow *row,
 {
   GtkWidget *cur;
 
-  if (!before)
+  /* @before is the previous visible row, whatever the filter */
+
+  /* Compact rows draw their separator themselves */
+  if (GYACHT_IS_COMPACT_ROW (row))
+    gyacht_compact_row_set_separator (GYACHT_COMPACT_ROW (row), before != NULL);
+
+  if (!before || GYACHT_IS_COMPACT_ROW (row))
     {
       gtk_list_box_row_set_header (row, NULL);
       return;
@@ -183,19 +667,193 @@ internal_box_header_func (GtkListBoxRow *row,
     }
 }
 
+static gboolean
+internal_box_filter_func (GtkListBoxRow *row,
+                          gpointer       user_data)
+{
+  GyachtImageListView *self = GYACHT_IMAGE_LIST_VIEW (user_data);
+  GyachtImage *image = g_object_get_data (G_OBJECT (row), "image");
+
+  if (g_object_get_data (G_OBJECT (row), "filtered-out"))
+    return FALSE;
+
+  return gyacht_search_index_matches (self->index, gyacht_image_get_id (image));
+}
+
+static void
+internal_refilter_row_cb (gpointer data,
+                          gpointer user_data)
+{
+  internal_filter_row (GYACHT_IMAGE_LIST_VIEW (user_data), GTK_WIDGET (data));
+}
+
+static void
+internal_search_changed_cb (GtkSearchEntry      *entry,
+                            GyachtImageListView *self)
+{
+  g_autofree gchar *text = NULL;
+
+  if (!gyacht_filter_update_from_entry (&self->filter,
+                                        filter_fields,
+                                        GTK_ENTRY (entry),
+                                        self->rows,
+                                        internal_refilter_row_cb,
+                                        self,
+                                        &text))
+    return;
+
+  gyacht_search_index_set_query (self->index, text);
+  gtk_list_box_invalidate_filter (self->list_box);
+}
+
+static void
+internal_sort_by_changed_cb (GActionGroup        *action_group,
+                             const gchar         *action_name,
+                             GVariant            *value,
+                             GyachtImageListView *self)
+{
+  gyacht_row_sort_apply (self->list_box,
+                         gyacht_sort_column_from_string (g_variant_get_string (value, NULL)));
+}
+
+static void
+internal_compact_rows_changed_cb (GActionGroup        *action_group,
+                                  const gchar         *action_name,
+                                  GVariant            *value,
+                                  GyachtImageListView *self)
+{
+  gboolean compact = g_variant_get_boolean (value);
+
+  if (self->compact == compact)
+    return;
+
+  self->compact = compact;
+  internal_image_list_set_rows (self);
+}
+
+static void
+internal_image_added_cb (GyachtImageListView *self,
+                         GyachtImage         *image)
+{
+  gyacht_frame_queue_push (self->updates, FRAME_OP_ADD,
+                           gyacht_image_get_id (image),
+                           G_OBJECT (image));
+}
+
+static void
+internal_row_activated_cb (GtkListBox          *list_box,
+                           GtkListBoxRow       *row,
+                           GyachtImageListView *self)
+{
+  internal_inspect_image (self, g_object_get_data (G_OBJECT (row), "image"));
+}
+
+static void
+internal_inspect_close_cb (GyachtImagePane     *pane,
+                           GyachtImageListView *self)
+{
+  gtk_revealer_set_reveal_child (GTK_REVEALER (self->image_revealer), FALSE);
+}
+
+static void
+internal_browse_layer_cb (GyachtImagePane     *pane,
+                          const gchar         *layer_id,
+                          GyachtImageListView *self)
+{
+  GyachtLayer *layer = gyacht_layer_service_lookup (self->layers, layer_id);
+  GtkWidget *browser;
+
+  if (layer == NULL)
+    return;
+
+  browser = gyacht_layer_browser_new (self->layers, layer);
+  gtk_window_set_transient_for (GTK_WINDOW (browser),
+                                GTK_WINDOW (gtk_widget_get_toplevel (GTK_WIDGET (self))));
+  gtk_window_set_destroy_with_parent (GTK_WINDOW (browser), TRUE);
+  gtk_window_present (GTK_WINDOW (browser));
+}
+
+static void
+internal_load_progress_cb (GyachtImageListView *self,
+                           guint                n_items,
+                           gboolean             done)
+{
+  g_autofree gchar *text = NULL;
+
+  if (done)
+    {
+      gtk_widget_hide (self->progress_label);
+      return;
+    }
+
+  text = g_strdup_printf (ngettext ("Loading… %u image",
+                                    "Loading… %u images",
+                                    n_items),
+                          n_items);
+  gtk_label_set_text (GTK_LABEL (self->progress_label), text);
+  gtk_widget_show (self->progress_label);
+}
+
 /* --- GObject --- */
 static void
 gyacht_image_list_view_finalize (GObject *object)
 {
   GyachtImageListView *self = GYACHT_IMAGE_LIST_VIEW (object);
+  GHashTableIter selection_iter;
+  gpointer value;
 
   GYACHT_TRACE_ENTRY;
 
+  g_signal_handlers_disconnect_by_func (g_application_get_default (),
+                                        internal_compact_rows_changed_cb,
+                                        self);
+  g_signal_handlers_disconnect_by_func (g_application_get_default (),
+                                        internal_sort_by_changed_cb,
+                                        self);
+
   if (self->service)
-    g_signal_handlers_disconnect_by_func (self->service,
-                                          internal_image_list_set_rows,
-                                          self);
+    {
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_image_list_set_rows,
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_image_added_cb,
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->service,
+                                            internal_load_progress_cb,
+                                            self);
+    }
   g_clear_object (&self->service);
+  if (self->layers)
+    g_signal_handlers_disconnect_by_func (self->layers,
+                                          internal_usage_changed_cb,
+                                          self);
+  g_clear_object (&self->layers);
+  if (self->reachability)
+    g_signal_handlers_disconnect_by_func (self->reachability,
+                                          internal_report_changed_cb,
+                                          self);
+  g_clear_object (&self->reachability);
+  g_clear_object (&self->updates);
+
+  /* Its rows leave the selection */
+  g_signal_handlers_disconnect_by_func (self->reclaim,
+                                        G_CALLBACK (internal_reclaim_changed_cb),
+                                        self);
+  g_hash_table_iter_init (&selection_iter, self->selection);
+  while (g_hash_table_iter_next (&selection_iter, NULL, &value))
+    gyacht_reclaim_index_remove (self->reclaim, value);
+  g_hash_table_unref (self->selection);
+  g_clear_object (&self->reclaim);
+
+  g_cancellable_cancel (self->inspect_cancellable);
+  g_clear_object (&self->inspect_cancellable);
+  g_clear_object (&self->big_data);
+
+  g_clear_object (&self->ages);
+  g_clear_object (&self->index);
+  g_clear_pointer (&self->filter, gyacht_filter_free);
+  g_hash_table_unref (self->rows);
 
   GYACHT_TRACE_EXIT;
 
@@ -213,20 +871,141 @@ gyacht_image_list_view_class_init (GyachtImageListViewClass *klass)
   gtk_widget_class_set_template_from_resource (widget_class,
                                                GYACHT_UI_PREFIX "gyacht-image-list-view.ui");
   gtk_widget_class_bind_template_child (widget_class, GyachtImageListView, list_box);
+  gtk_widget_class_bind_template_child (widget_class, GyachtImageListView, progress_label);
+  gtk_widget_class_bind_template_child (widget_class, GyachtImageListView, selection_label);
+  gtk_widget_class_bind_template_child (widget_class, GyachtImageListView, reclaim_label);
+  gtk_widget_class_bind_template_child (widget_class, GyachtImageListView, search_bar);
+  gtk_widget_class_bind_template_child (widget_class, GyachtImageListView, search_entry);
 }
 
 static void
 gyacht_image_list_view_init (GyachtImageListView *self)
 {
+  GyachtApplication *app;
+  g_autoptr(GVariant) compact = NULL;
+  g_autoptr(GVariant) sort_by = NULL;
+  g_autoptr(GyachtContainerService) containers = NULL;
+
   gtk_widget_init_template (GTK_WIDGET (self));
 
   gtk_list_box_set_header_func (GTK_LIST_BOX (self->list_box),
                                 internal_box_header_func,
                                 NULL, NULL);
-
-  self->service = gyacht_image_service_new (RUN_LEVEL_USER);
+  gtk_list_box_set_filter_func (GTK_LIST_BOX (self->list_box),
+                                internal_box_filter_func,
+                                self, NULL);
+
+  self->index = gyacht_search_index_new ();
+  g_signal_connect (self->search_entry,
+                    "search-changed",
+                    G_CALLBACK (internal_search_changed_cb),
+                    self);
+
+  self->rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->updates = gyacht_frame_queue_new (GTK_WIDGET (self->list_box),
+                                          internal_apply_update,
+                                          self);
+  self->ages = gyacht_age_clock_new (self->list_box, internal_set_age, NULL);
+
+  g_signal_connect (self->list_box,
+                    "row-activated",
+                    G_CALLBACK (internal_row_activated_cb),
+                    self);
+
+  self->big_data = gyacht_big_data_cache_new (CONFIG_CACHE_SIZE);
+  self->image_pane = gyacht_image_pane_new ();
+  self->image_revealer = gtk_revealer_new ();
+  gtk_revealer_set_transition_type (GTK_REVEALER (self->image_revealer),
+                                    GTK_REVEALER_TRANSITION_TYPE_SLIDE_UP);
+  gtk_container_add (GTK_CONTAINER (self->image_revealer), self->image_pane);
+  gtk_widget_show (self->image_revealer);
+  gtk_box_pack_end (GTK_BOX (self), self->image_revealer, FALSE, TRUE, 0);
+  g_signal_connect (self->image_pane,
+                    "close",
+                    G_CALLBACK (internal_inspect_close_cb),
+                    self);
+  g_signal_connect (self->image_pane,
+                    "browse-layer",
+                    G_CALLBACK (internal_browse_layer_cb),
+                    self);
+
+  app = GYACHT_APPLICATION (g_application_get_default ());
+
+  self->reclaim = gyacht_application_dup_reclaim_index (app);
+  self->selection = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  g_signal_connect_swapped (self->reclaim,
+                            "changed",
+                            G_CALLBACK (internal_reclaim_changed_cb),
+                            self);
+  internal_reclaim_changed_cb (self);
+  g_signal_connect (self->list_box,
+                    "selected-rows-changed",
+                    G_CALLBACK (internal_selected_rows_changed_cb),
+                    self);
+
+  compact = g_action_group_get_action_state (G_ACTION_GROUP (app), "compact-rows");
+  self->compact = compact ? g_variant_get_boolean (compact) : FALSE;
+  g_signal_connect (app,
+                    "action-state-changed::compact-rows",
+                    G_CALLBACK (internal_compact_rows_changed_cb),
+                    self);
+
+  sort_by = g_action_group_get_action_state (G_ACTION_GROUP (app), "sort-by");
+  gyacht_row_sort_apply (self->list_box,
+                         gyacht_sort_column_from_string (sort_by ? g_variant_get_string (sort_by, NULL) : NULL));
+  g_signal_connect (app,
+                    "action-state-changed::sort-by",
+                    G_CALLBACK (internal_sort_by_changed_cb),
+                    self);
+
+  /* The service is shared with the other views, it may be loaded already */
+  self->service = gyacht_application_dup_image_service (app);
+  self->layers = gyacht_application_dup_layer_service (app);
+  g_signal_connect_swapped (self->layers,
+                            "usage-changed",
+                            G_CALLBACK (internal_usage_changed_cb),
+                            self);
+  containers = gyacht_application_dup_container_service (app);
+  self->reachability = gyacht_reachability_new (containers,
+                                                self->service,
+                                                self->layers);
+  g_signal_connect_swapped (self->reachability,
+                            "report-changed",
+                            G_CALLBACK (internal_report_changed_cb),
+                            self);
+  internal_image_list_set_rows (self);
   g_signal_connect_swapped (self->service,
                             "list-updated",
                             G_CALLBACK (internal_image_list_set_rows),
                             self);
+
+  /* Images come in batches while the first load is running */
+  g_signal_connect_swapped (self->service,
+                            "item-added",
+                            G_CALLBACK (internal_image_added_cb),
+                            self);
+  internal_load_progress_cb (self, 0, gyacht_service_is_loaded (GYACHT_SERVICE (self->service)));
+  g_signal_connect_swapped (self->service,
+                            "load-progress",
+                            G_CALLBACK (internal_load_progress_cb),
+                            self);
+}
+
+/* --- Public APIs --- */
+/**
+ * gyacht_image_list_view_handle_event:
+ * @self: a #GyachtImageListView
+ * @event: a key press event of the toplevel
+ *
+ * Starts searching when @event types some text.
+ *
+ * Returns: %GDK_EVENT_STOP if the search bar handled @event
+ */
+gboolean
+gyacht_image_list_view_handle_event (GyachtImageListView *self,
+                                     GdkEvent            *event)
+{
+  g_return_val_if_fail (GYACHT_IS_IMAGE_LIST_VIEW (self), GDK_EVENT_PROPAGATE);
+
+  return gtk_search_bar_handle_event (self->search_bar, event);
 }
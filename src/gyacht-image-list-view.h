@@ -28,4 +28,7 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GyachtImageListView, gyacht_image_list_view, GYACHT, IMAGE_LIST_VIEW, GtkBox)
 
+gboolean  gyacht_image_list_view_handle_event (GyachtImageListView *self,
+                                               GdkEvent            *event);
+
 G_END_DECLS
@@ -0,0 +1,433 @@
+/* gyacht-image-pane.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-image-pane.h"
+
+#include <glib/gi18n.h>
+
+/* Shows an image at once from what the model knows, then what is decoded
+ * from its configuration and its manifest once they are read.
+ */
+
+/* What Dockerfile instructions which make no layer are prefixed with */
+#define NOP_PREFIX "/bin/sh -c #(nop) "
+
+enum {
+  FIELD_NAMES = 0,
+  FIELD_ID,
+  FIELD_DIGEST,
+  FIELD_LAYER,
+  FIELD_BIG_DATA,
+  FIELD_ARCHITECTURE,
+  FIELD_OS,
+  FIELD_ENTRYPOINT,
+  FIELD_CMD,
+  N_FIELDS
+};
+
+enum {
+  CLOSE,
+  BROWSE_LAYER,
+  N_SIGNALS
+};
+
+struct _GyachtImagePane
+{
+  GtkBox          parent_instance;
+
+  GyachtImage     *image;
+
+  GtkWidget       *title_label;
+  GtkWidget       *field_labels [N_FIELDS];
+  GtkTextBuffer   *history_buffer;
+  GtkTextBuffer   *manifest_buffer;
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtImagePane, gyacht_image_pane, GTK_TYPE_BOX)
+
+
+static gchar *
+internal_dup_names (const GPtrArray *names)
+{
+  g_autoptr(GPtrArray) strv = NULL;
+  guint i;
+
+  if (names == NULL || names->len == 0)
+    return g_strdup ("—");
+
+  strv = g_ptr_array_new ();
+  for (i = 0; i < names->len; i++)
+    g_ptr_array_add (strv, g_ptr_array_index ((GPtrArray *) names, i));
+  g_ptr_array_add (strv, NULL);
+
+  return g_strjoinv ("\n", (gchar **) strv->pdata);
+}
+
+static gchar *
+internal_dup_big_data (GyachtImage *image)
+{
+  const GPtrArray *names = gyacht_image_get_big_data_names (image);
+  GString *string;
+  guint i;
+
+  if (names == NULL || names->len == 0)
+    return g_strdup ("—");
+
+  string = g_string_new (NULL);
+  for (i = 0; i < names->len; i++)
+    {
+      const gchar *name = g_ptr_array_index ((GPtrArray *) names, i);
+      gint64 size = gyacht_image_get_big_data_size (image, name);
+
+      g_string_append_printf (string, "%s%s", i > 0 ? "\n" : "", name);
+      if (size >= 0)
+        {
+          g_autofree gchar *text = g_format_size (size);
+
+          g_string_append_printf (string, " (%s)", text);
+        }
+    }
+
+  return g_string_free (string, FALSE);
+}
+
+static gchar *
+internal_dup_history (GyachtImageConfig *config)
+{
+  GString *string;
+  guint n_history = gyacht_image_config_get_n_history (config);
+  guint i;
+
+  if (n_history == 0)
+    return g_strdup (_("No build history"));
+
+  string = g_string_new (NULL);
+  for (i = 0; i < n_history; i++)
+    {
+      const GyachtImageHistory *step = gyacht_image_config_get_history (config, i);
+      const gchar *created_by = step->created_by ? step->created_by : step->comment;
+
+      if (created_by && g_str_has_prefix (created_by, NOP_PREFIX))
+        created_by = created_by + strlen (NOP_PREFIX);
+
+      g_string_append_printf (string, "%s%s%s\n    %s",
+                              i > 0 ? "\n" : "",
+                              step->created ? step->created : "—",
+                              step->empty_layer ? _(", no layer") : "",
+                              created_by ? created_by : "—");
+    }
+
+  return g_string_free (string, FALSE);
+}
+
+static void
+internal_set_field (GyachtImagePane *self,
+                    guint            field,
+                    const gchar     *text)
+{
+  gtk_label_set_text (GTK_LABEL (self->field_labels[field]),
+                      text && *text ? text : "—");
+}
+
+static void
+internal_set_strv_field (GyachtImagePane     *self,
+                         guint                field,
+                         const gchar * const *strv)
+{
+  g_autofree gchar *text = NULL;
+
+  if (strv)
+    text = g_strjoinv (" ", (gchar **) strv);
+  internal_set_field (self, field, text);
+}
+
+static GtkWidget *
+internal_create_text_view (GtkTextBuffer **buffer)
+{
+  GtkWidget *view;
+
+  view = gtk_text_view_new ();
+  gtk_text_view_set_editable (GTK_TEXT_VIEW (view), FALSE);
+  gtk_text_view_set_cursor_visible (GTK_TEXT_VIEW (view), FALSE);
+  gtk_text_view_set_monospace (GTK_TEXT_VIEW (view), TRUE);
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), GTK_WRAP_CHAR);
+  *buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
+  return view;
+}
+
+static GtkWidget *
+internal_create_heading (const gchar *text)
+{
+  GtkWidget *label;
+
+  label = gtk_label_new (text);
+  gtk_label_set_xalign (GTK_LABEL (label), 0);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label),
+                               GTK_STYLE_CLASS_DIM_LABEL);
+
+  return label;
+}
+
+static void
+internal_close_clicked_cb (GtkButton       *button,
+                           GyachtImagePane *self)
+{
+  g_signal_emit (self, signals [CLOSE], 0);
+}
+
+static void
+internal_browse_clicked_cb (GtkButton       *button,
+                            GyachtImagePane *self)
+{
+  if (self->image)
+    g_signal_emit (self, signals [BROWSE_LAYER], 0, gyacht_image_get_layer (self->image));
+}
+
+/* --- GObject --- */
+static void
+gyacht_image_pane_finalize (GObject *object)
+{
+  GyachtImagePane *self = GYACHT_IMAGE_PANE (object);
+
+  g_clear_object (&self->image);
+
+  G_OBJECT_CLASS (gyacht_image_pane_parent_class)->finalize (object);
+}
+
+static void
+gyacht_image_pane_class_init (GyachtImagePaneClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_image_pane_finalize;
+
+  signals [CLOSE] =
+    g_signal_new ("close",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+
+  signals [BROWSE_LAYER] =
+    g_signal_new ("browse-layer",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 1, G_TYPE_STRING);
+}
+
+static void
+gyacht_image_pane_init (GyachtImagePane *self)
+{
+  static const gchar *field_names[N_FIELDS] = {
+    N_("Names"),
+    N_("ID"),
+    N_("Digest"),
+    N_("Layer"),
+    N_("Big data"),
+    N_("Architecture"),
+    N_("OS"),
+    N_("Entrypoint"),
+    N_("Command"),
+  };
+  GtkWidget *header;
+  GtkWidget *scrolled;
+  GtkWidget *content;
+  GtkWidget *grid;
+  GtkWidget *widget;
+  PangoAttrList *attrlist;
+  guint i;
+
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (self), GTK_ORIENTATION_VERTICAL);
+
+  /* Header */
+  header = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_widget_set_margin_start (header, 6);
+  gtk_widget_set_margin_end (header, 6);
+  gtk_widget_set_margin_top (header, 6);
+
+  self->title_label = gtk_label_new (NULL);
+  gtk_label_set_ellipsize (GTK_LABEL (self->title_label), PANGO_ELLIPSIZE_END);
+  gtk_label_set_xalign (GTK_LABEL (self->title_label), 0);
+
+  attrlist = pango_attr_list_new ();
+  pango_attr_list_insert (attrlist, pango_attr_weight_new (PANGO_WEIGHT_SEMIBOLD));
+  gtk_label_set_attributes (GTK_LABEL (self->title_label), attrlist);
+  pango_attr_list_unref (attrlist);
+
+  gtk_box_pack_start (GTK_BOX (header), self->title_label, TRUE, TRUE, 0);
+
+  widget = gtk_button_new_from_icon_name ("window-close-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_button_set_relief (GTK_BUTTON (widget), GTK_RELIEF_NONE);
+  gtk_widget_set_tooltip_text (widget, _("Close the information"));
+  g_signal_connect (widget, "clicked", G_CALLBACK (internal_close_clicked_cb), self);
+  gtk_box_pack_end (GTK_BOX (header), widget, FALSE, FALSE, 0);
+
+  widget = gtk_button_new_from_icon_name ("folder-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_button_set_relief (GTK_BUTTON (widget), GTK_RELIEF_NONE);
+  gtk_widget_set_tooltip_text (widget, _("Browse the files of the top layer"));
+  g_signal_connect (widget, "clicked", G_CALLBACK (internal_browse_clicked_cb), self);
+  gtk_box_pack_end (GTK_BOX (header), widget, FALSE, FALSE, 0);
+
+  gtk_box_pack_start (GTK_BOX (self), header, FALSE, TRUE, 0);
+
+  /* Contents */
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_min_content_height (GTK_SCROLLED_WINDOW (scrolled), 240);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+
+  content = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
+  gtk_widget_set_margin_start (content, 6);
+  gtk_widget_set_margin_end (content, 6);
+  gtk_widget_set_margin_bottom (content, 6);
+
+  grid = gtk_grid_new ();
+  gtk_grid_set_column_spacing (GTK_GRID (grid), 12);
+  gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
+
+  for (i = 0; i < N_FIELDS; i++)
+    {
+      widget = internal_create_heading (_(field_names[i]));
+      gtk_widget_set_valign (widget, GTK_ALIGN_START);
+      gtk_grid_attach (GTK_GRID (grid), widget, 0, i, 1, 1);
+
+      widget = gtk_label_new (NULL);
+      gtk_label_set_xalign (GTK_LABEL (widget), 0);
+      gtk_label_set_selectable (GTK_LABEL (widget), TRUE);
+      gtk_label_set_line_wrap (GTK_LABEL (widget), TRUE);
+      gtk_label_set_line_wrap_mode (GTK_LABEL (widget), PANGO_WRAP_CHAR);
+      gtk_widget_set_hexpand (widget, TRUE);
+      gtk_grid_attach (GTK_GRID (grid), widget, 1, i, 1, 1);
+      self->field_labels[i] = widget;
+    }
+
+  gtk_box_pack_start (GTK_BOX (content), grid, FALSE, TRUE, 0);
+
+  gtk_box_pack_start (GTK_BOX (content), internal_create_heading (_("History")),
+                      FALSE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (content), internal_create_text_view (&self->history_buffer),
+                      FALSE, TRUE, 0);
+
+  gtk_box_pack_start (GTK_BOX (content), internal_create_heading (_("Manifest")),
+                      FALSE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (content), internal_create_text_view (&self->manifest_buffer),
+                      FALSE, TRUE, 0);
+
+  gtk_container_add (GTK_CONTAINER (scrolled), content);
+  gtk_box_pack_start (GTK_BOX (self), scrolled, TRUE, TRUE, 0);
+
+  gtk_widget_show_all (GTK_WIDGET (self));
+}
+
+/* --- Public APIs --- */
+GtkWidget *
+gyacht_image_pane_new (void)
+{
+  return g_object_new (GYACHT_TYPE_IMAGE_PANE, NULL);
+}
+
+/* Shows what the model knows about @image, its configuration and its
+ * manifest are shown as loading until they are set.
+ */
+void
+gyacht_image_pane_set_image (GyachtImagePane *self,
+                             GyachtImage     *image)
+{
+  g_autofree gchar *names = NULL;
+  g_autofree gchar *big_data = NULL;
+
+  g_return_if_fail (GYACHT_IS_IMAGE_PANE (self));
+  g_return_if_fail (GYACHT_IS_IMAGE (image));
+
+  g_set_object (&self->image, image);
+
+  names = internal_dup_names (gyacht_image_get_names (image));
+  big_data = internal_dup_big_data (image);
+
+  gtk_label_set_text (GTK_LABEL (self->title_label), gyacht_image_get_name (image));
+  internal_set_field (self, FIELD_NAMES, names);
+  internal_set_field (self, FIELD_ID, gyacht_image_get_id (image));
+  internal_set_field (self, FIELD_DIGEST, gyacht_image_get_digest (image));
+  internal_set_field (self, FIELD_LAYER, gyacht_image_get_layer (image));
+  internal_set_field (self, FIELD_BIG_DATA, big_data);
+  internal_set_field (self, FIELD_ARCHITECTURE, _("Loading…"));
+  internal_set_field (self, FIELD_OS, _("Loading…"));
+  internal_set_field (self, FIELD_ENTRYPOINT, _("Loading…"));
+  internal_set_field (self, FIELD_CMD, _("Loading…"));
+
+  gtk_text_buffer_set_text (self->history_buffer, _("Loading…"), -1);
+  gtk_text_buffer_set_text (self->manifest_buffer, _("Loading…"), -1);
+}
+
+GyachtImage *
+gyacht_image_pane_get_image (GyachtImagePane *self)
+{
+  g_return_val_if_fail (GYACHT_IS_IMAGE_PANE (self), NULL);
+
+  return self->image;
+}
+
+/* @config is %NULL if the image has none or it cannot be read */
+void
+gyacht_image_pane_set_config (GyachtImagePane   *self,
+                              GyachtImageConfig *config)
+{
+  g_autofree gchar *history = NULL;
+
+  g_return_if_fail (GYACHT_IS_IMAGE_PANE (self));
+
+  if (config == NULL)
+    {
+      internal_set_field (self, FIELD_ARCHITECTURE, NULL);
+      internal_set_field (self, FIELD_OS, NULL);
+      internal_set_field (self, FIELD_ENTRYPOINT, NULL);
+      internal_set_field (self, FIELD_CMD, NULL);
+      gtk_text_buffer_set_text (self->history_buffer,
+                                _("No configuration is stored with the image"),
+                                -1);
+      return;
+    }
+
+  history = internal_dup_history (config);
+
+  internal_set_field (self, FIELD_ARCHITECTURE, gyacht_image_config_get_architecture (config));
+  internal_set_field (self, FIELD_OS, gyacht_image_config_get_os (config));
+  internal_set_strv_field (self, FIELD_ENTRYPOINT, gyacht_image_config_get_entrypoint (config));
+  internal_set_strv_field (self, FIELD_CMD, gyacht_image_config_get_cmd (config));
+  gtk_text_buffer_set_text (self->history_buffer, history, -1);
+}
+
+/* @manifest is %NULL if the image has none or it cannot be read */
+void
+gyacht_image_pane_set_manifest (GyachtImagePane *self,
+                                const gchar     *manifest)
+{
+  g_return_if_fail (GYACHT_IS_IMAGE_PANE (self));
+
+  gtk_text_buffer_set_text (self->manifest_buffer,
+                            manifest ? manifest : _("No manifest is stored with the image"),
+                            -1);
+}
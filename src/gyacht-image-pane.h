@@ -0,0 +1,43 @@
+/* gyacht-image-pane.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "gyacht-big-data.h"
+#include "gyacht-image.h"
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_IMAGE_PANE (gyacht_image_pane_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtImagePane, gyacht_image_pane, GYACHT, IMAGE_PANE, GtkBox)
+
+GtkWidget *     gyacht_image_pane_new           (void);
+void            gyacht_image_pane_set_image     (GyachtImagePane   *self,
+                                                 GyachtImage       *image);
+GyachtImage *   gyacht_image_pane_get_image     (GyachtImagePane   *self);
+void            gyacht_image_pane_set_config    (GyachtImagePane   *self,
+                                                 GyachtImageConfig *config);
+void            gyacht_image_pane_set_manifest  (GyachtImagePane   *self,
+                                                 const gchar       *manifest);
+
+G_END_DECLS
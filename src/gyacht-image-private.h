@@ -29,5 +29,13 @@ G_BEGIN_DECLS
 
 GSequence * gyacht_image_parse_json_contents      (JsonParser  *parser,
                                                    GError     **error);
+GyachtImage *
+            gyacht_image_parse_json_element       (JsonNode    *element_node);
+GSequence * gyacht_image_parse_api_contents       (JsonParser  *parser,
+                                                   GError     **error);
+void        gyacht_image_set_big_data             (GyachtImage *self,
+                                                   GPtrArray   *names,
+                                                   GArray      *sizes,
+                                                   GPtrArray   *digests);
 
 G_END_DECLS
@@ -23,16 +23,25 @@
 #include "gyacht-image-private.h"
 #include "gyacht-image-service.h"
 #include "gyacht-path-manager.h"
+#include "gyacht-podman-client.h"
 
 #include <gio/gio.h>
 #include <json-glib/json-glib.h>
 
+#define API_IMAGES_PATH           PODMAN_API_PREFIX "/images/json"
+
 struct _GyachtImageService
 {
   GyachtService   parent_instance;
 
   GSequence       *images;
+  GSequence       *loading;     /* The next list while a reload runs */
+  gboolean        progressive;  /* Whether the load fills images directly */
   GQueue          *jobs;
+
+  /* Only with SOURCE_PODMAN_API */
+  GyachtPodmanClient *client;
+  GHashTable      *refreshing;  /* id -> whether it is stale */
 };
 
 enum {
@@ -46,6 +55,14 @@ G_DEFINE_TYPE (GyachtImageService, gyacht_image_service, GYACHT_TYPE_SERVICE)
 static void internal_load_json_callback (GObject      *source_object,
                                          GAsyncResult *res,
                                          gpointer      user_data);
+static void internal_load_api_callback  (GObject      *source_object,
+                                         GAsyncResult *res,
+                                         gpointer      user_data);
+static void internal_load_batch_cb      (GyachtService *service,
+                                         GSequence     *batch,
+                                         gpointer       user_data);
+static void internal_refresh_image      (GyachtImageService *self,
+                                         const gchar        *id);
 
 
 static GFile *
@@ -74,6 +91,12 @@ internal_get_json_path (GyachtService *service)
   return g_file_new_for_path (json_path);
 }
 
+static const gchar *
+internal_get_api_path (GyachtService *service)
+{
+  return API_IMAGES_PATH;
+}
+
 static void
 internal_clear_image_list (GyachtService *service)
 {
@@ -86,22 +109,122 @@ internal_clear_image_list (GyachtService *service)
   self->images = NULL;
 }
 
+static GObject *
+internal_parse_element (JsonNode *node)
+{
+  return (GObject *) gyacht_image_parse_json_element (node);
+}
+
+/* The first list is shown while it loads. The next ones are collected
+ * aside and replace it once complete, the views then diff them.
+ */
+static void
+internal_run_job (GyachtImageService *self)
+{
+  GyachtService *service = GYACHT_SERVICE (self);
+  g_autoptr(GFile) location = NULL;
+
+  self->progressive = (self->images == NULL);
+  if (self->progressive)
+    self->images = g_sequence_new (g_object_unref);
+  else
+    self->loading = g_sequence_new (g_object_unref);
+
+  if (gyacht_service_get_source (service) == SOURCE_PODMAN_API)
+    {
+      gyacht_service_load_api_async (service,
+                                     NULL,
+                                     NULL,
+                                     internal_load_api_callback,
+                                     NULL);
+      return;
+    }
+
+  location = internal_get_json_path (service);
+  gyacht_service_stream_json_file_async (service,
+                                         location,
+                                         internal_parse_element,
+                                         internal_load_batch_cb,
+                                         NULL,
+                                         internal_load_json_callback,
+                                         NULL);
+}
+
 static void
 internal_execute_next_job (GyachtImageService *self)
 {
   g_queue_pop_head (self->jobs);
 
   if (!g_queue_is_empty (self->jobs))
-    gyacht_service_load_json_async (GYACHT_SERVICE (self),
-                                    NULL,
-                                    internal_load_json_callback,
-                                    NULL);
+    internal_run_job (self);
+  else
+    gyacht_service_report_progress (GYACHT_SERVICE (self),
+                                    g_sequence_get_length (self->images),
+                                    TRUE);
+}
+
+static void
+internal_load_batch_cb (GyachtService *service,
+                        GSequence     *batch,
+                        gpointer       user_data)
+{
+  GyachtImageService *self = GYACHT_IMAGE_SERVICE (service);
+  GSequence *target = self->progressive ? self->images : self->loading;
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (batch);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GyachtImage *image = g_sequence_get (iter);
+
+      g_sequence_append (target, g_object_ref (image));
+      if (self->progressive)
+        g_signal_emit_by_name (self, "item-added", image);
+    }
+
+  gyacht_service_report_progress (service, g_sequence_get_length (target), FALSE);
+}
+
+static void
+internal_finish_load (GyachtImageService *self,
+                      gboolean            success)
+{
+  if (!self->progressive)
+    {
+      if (success)
+        {
+          g_sequence_free (self->images);
+          self->images = g_steal_pointer (&self->loading);
+        }
+      g_clear_pointer (&self->loading, g_sequence_free);
+    }
+
+  if (success)
+    g_signal_emit_by_name (self, "list-updated", 0);
+
+  internal_execute_next_job (self);
 }
 
 static void
 internal_load_json_callback (GObject      *source_object,
                              GAsyncResult *res,
                              gpointer      user_data)
+{
+  GyachtImageService *self = GYACHT_IMAGE_SERVICE (source_object);
+  g_autoptr(GError) error = NULL;
+
+  if (!gyacht_service_stream_json_finish (GYACHT_SERVICE (self), res, &error))
+    gyacht_warn ("Unable to load json contents from file: %s",
+                 error->message);
+
+  internal_finish_load (self, error == NULL);
+}
+
+static void
+internal_load_api_callback (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
 {
   GyachtImageService *self = GYACHT_IMAGE_SERVICE (source_object);
   g_autoptr(JsonParser) parser = NULL;
@@ -111,26 +234,21 @@ internal_load_json_callback (GObject      *source_object,
   parser = gyacht_service_load_json_finish (GYACHT_SERVICE (self),
                                             res,
                                             &error);
-  if (error)
-    {
-      gyacht_warn ("Unable to load json contents from file: %s",
-                   error->message);
-      goto do_next_job;
-    }
+  if (parser)
+    new_images = gyacht_image_parse_api_contents (parser, &error);
 
-  new_images = gyacht_image_parse_json_contents (parser, &error);
   if (error)
     {
-      gyacht_warn ("Unable to parse json contents: %s",
+      gyacht_warn ("Unable to load images from podman: %s",
                    error->message);
-      goto do_next_job;
+      internal_finish_load (self, FALSE);
+      return;
     }
 
-  self->images = new_images;
-  g_signal_emit_by_name (self, "list-updated", 0);
+  internal_load_batch_cb (GYACHT_SERVICE (self), new_images, NULL);
+  g_sequence_free (new_images);
 
-do_next_job:
-  internal_execute_next_job (self);
+  internal_finish_load (self, TRUE);
 }
 
 static void
@@ -138,18 +256,164 @@ internal_load_contents (GyachtImageService *self)
 {
   GYACHT_TRACE_ENTRY;
 
+  /* A load is already waiting behind the running one */
+  if (g_queue_get_length (self->jobs) > 1)
+    {
+      GYACHT_TRACE_EXIT;
+      return;
+    }
+
   g_queue_push_tail (self->jobs, GINT_TO_POINTER (ASYNC_JOB_LOAD));
 
   /* Run if it has only one job in which is just pushed */
   if (g_queue_get_length (self->jobs) == 1)
-    gyacht_service_load_json_async (GYACHT_SERVICE (self),
-                                    NULL,
-                                    internal_load_json_callback,
-                                    NULL);
+    internal_run_job (self);
 
   GYACHT_TRACE_EXIT;
 }
 
+static GSequenceIter *
+internal_lookup_image (GyachtImageService *self,
+                       const gchar        *id)
+{
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (self->images);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    if (g_strcmp0 (gyacht_image_get_id (g_sequence_get (iter)), id) == 0)
+      return iter;
+
+  return NULL;
+}
+
+/* Replaces the image @id with the one @found holds, or removes it if there
+ * is none. The views diff the list against their rows, so only that image
+ * is updated.
+ */
+static void
+internal_merge_image (GyachtImageService *self,
+                      const gchar        *id,
+                      GSequence          *found)
+{
+  GyachtImage *image = NULL;
+  GSequenceIter *iter;
+
+  if (self->images == NULL)
+    return;
+
+  if (found && g_sequence_get_length (found) > 0)
+    image = g_object_ref (g_sequence_get (g_sequence_get_begin_iter (found)));
+
+  iter = internal_lookup_image (self, id);
+  if (iter && image)
+    g_sequence_set (iter, image);
+  else if (iter)
+    g_sequence_remove (iter);
+  else if (image)
+    g_sequence_append (self->images, image);
+  else
+    return;
+
+  g_signal_emit_by_name (self, "list-updated", 0);
+}
+
+static void
+internal_refresh_callback (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  GyachtImageService *self = GYACHT_IMAGE_SERVICE (source_object);
+  g_autofree gchar *id = user_data;
+  g_autoptr(JsonParser) parser = NULL;
+  g_autoptr(GError) error = NULL;
+  GSequence *found = NULL;
+
+  parser = gyacht_service_load_json_finish (GYACHT_SERVICE (self),
+                                            res,
+                                            &error);
+  if (parser)
+    found = gyacht_image_parse_api_contents (parser, &error);
+
+  if (error)
+    gyacht_warn ("Unable to refresh image %s: %s", id, error->message);
+  else
+    internal_merge_image (self, id, found);
+
+  g_clear_pointer (&found, g_sequence_free);
+
+  /* More events came in while it was requested */
+  if (GPOINTER_TO_INT (g_hash_table_lookup (self->refreshing, id)))
+    {
+      g_hash_table_insert (self->refreshing, g_strdup (id), GINT_TO_POINTER (FALSE));
+      internal_refresh_image (self, id);
+    }
+  else
+    g_hash_table_remove (self->refreshing, id);
+}
+
+static void
+internal_refresh_image (GyachtImageService *self,
+                        const gchar        *id)
+{
+  g_autofree gchar *filters = NULL;
+  g_autofree gchar *escaped = NULL;
+  g_autofree gchar *path = NULL;
+
+  /* Coalesce with the request on the fly, it is repeated when done */
+  if (g_hash_table_contains (self->refreshing, id))
+    {
+      g_hash_table_insert (self->refreshing, g_strdup (id), GINT_TO_POINTER (TRUE));
+      return;
+    }
+
+  g_hash_table_insert (self->refreshing, g_strdup (id), GINT_TO_POINTER (FALSE));
+
+  filters = g_strdup_printf ("{\"id\":[\"%s\"]}", id);
+  escaped = g_uri_escape_string (filters, NULL, FALSE);
+  path = g_strdup_printf ("%s?filters=%s", API_IMAGES_PATH, escaped);
+
+  gyacht_service_load_api_async (GYACHT_SERVICE (self),
+                                 path,
+                                 NULL,
+                                 internal_refresh_callback,
+                                 g_strdup (id));
+}
+
+static void
+internal_api_event_cb (GyachtPodmanClient *client,
+                       const gchar        *type,
+                       const gchar        *action,
+                       const gchar        *id,
+                       const gchar        *name,
+                       const gchar        *image,
+                       gint                exit_code,
+                       gpointer            user_data)
+{
+  GyachtImageService *self = GYACHT_IMAGE_SERVICE (user_data);
+
+  if (g_strcmp0 (type, "image") != 0)
+    return;
+
+  gyacht_trace ("%s: %s", id, action);
+
+  /* A load is running or waiting, the list it brings has the change */
+  if (!g_queue_is_empty (self->jobs))
+    {
+      internal_load_contents (self);
+      return;
+    }
+
+  if (g_str_equal (action, "remove"))
+    {
+      internal_merge_image (self, id, NULL);
+      return;
+    }
+
+  /* Only the image the event is about is requested again */
+  internal_refresh_image (self, id);
+}
+
 /* --- GObject --- */
 static void
 gyacht_image_service_finalize (GObject *object)
@@ -159,12 +423,25 @@ gyacht_image_service_finalize (GObject *object)
   GYACHT_TRACE_ENTRY;
 
   internal_clear_image_list (GYACHT_SERVICE (self));
+  g_clear_pointer (&self->loading, g_sequence_free);
 
   g_signal_handlers_disconnect_by_func (self,
                                         G_CALLBACK (internal_load_contents),
                                         NULL);
 
   g_queue_free (self->jobs);
+  g_hash_table_unref (self->refreshing);
+
+  if (self->client)
+    {
+      g_signal_handlers_disconnect_by_func (self->client,
+                                            G_CALLBACK (internal_api_event_cb),
+                                            self);
+      g_signal_handlers_disconnect_by_func (self->client,
+                                            G_CALLBACK (internal_load_contents),
+                                            self);
+      gyacht_podman_client_unwatch_events (self->client);
+    }
 
   GYACHT_TRACE_EXIT;
 
@@ -179,7 +456,22 @@ gyacht_image_service_constructed (GObject *object)
 
   G_OBJECT_CLASS (gyacht_image_service_parent_class)->constructed (object);
 
-  if (!gyacht_service_error_occur (service))
+  if (gyacht_service_get_source (service) == SOURCE_PODMAN_API)
+    {
+      self->client = gyacht_podman_client_get_default ();
+      g_signal_connect (self->client,
+                        "event",
+                        G_CALLBACK (internal_api_event_cb),
+                        self);
+      g_signal_connect_swapped (self->client,
+                                "resync-needed",
+                                G_CALLBACK (internal_load_contents),
+                                self);
+      gyacht_podman_client_watch_events (self->client);
+
+      internal_load_contents (self);
+    }
+  else if (!gyacht_service_error_occur (service))
     {
       g_signal_connect (self,
                         "monitor-event-triggered",
@@ -188,6 +480,8 @@ gyacht_image_service_constructed (GObject *object)
 
       internal_load_contents (self);
     }
+  else
+    gyacht_service_report_progress (service, 0, TRUE);
 }
 
 static void
@@ -199,15 +493,18 @@ gyacht_image_service_class_init (GyachtImageServiceClass *klass)
   object_class->finalize = gyacht_image_service_finalize;
   object_class->constructed = gyacht_image_service_constructed;
 
-  service_class->clear_list = internal_clear_image_list;
   service_class->get_json_path = internal_get_json_path;
+  service_class->get_api_path = internal_get_api_path;
 }
 
 static void
 gyacht_image_service_init (GyachtImageService *self)
 {
   self->images = NULL;
+  self->loading = NULL;
+  self->progressive = FALSE;
   self->jobs = g_queue_new ();
+  self->refreshing = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 /* --- Public APIs --- */
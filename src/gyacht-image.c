@@ -20,6 +20,7 @@
 
 #include "gyacht-debug.h"
 #include "gyacht-image.h"
+#include "gyacht-image-private.h"
 #include "gyacht-macros.h"
 
 #include <glib/gi18n.h>
@@ -37,12 +38,12 @@ struct _GyachtImage
   gchar       *metadata;
   GDateTime   *created;
 
-#if 0
-  /* Should we implement the following data? */
-  gpointer    big_data_names;
-  gpointer    big_data_sizes;
-  gpointer    big_data_digests;
-#endif
+  /* Manifests, signatures and the configuration stored aside. The sizes
+   * and digests go with the names, -1 and %NULL when unknown.
+   */
+  GPtrArray   *big_data_names;
+  GArray      *big_data_sizes;
+  GPtrArray   *big_data_digests;
 };
 
 G_DEFINE_TYPE (GyachtImage, gyacht_image, G_TYPE_OBJECT)
@@ -88,6 +89,9 @@ gyacht_image_finalize (GObject *object)
   g_free (self->metadata);
   if (self->created)
     g_date_time_unref (self->created);
+  g_clear_pointer (&self->big_data_names, g_ptr_array_unref);
+  g_clear_pointer (&self->big_data_sizes, g_array_unref);
+  g_clear_pointer (&self->big_data_digests, g_ptr_array_unref);
 
   G_OBJECT_CLASS (gyacht_image_parent_class)->finalize (object);
 }
@@ -320,6 +324,47 @@ gyacht_image_set_created (GyachtImage *self,
     }
 }
 
+static gint
+internal_find_big_data (GyachtImage *self,
+                        const gchar *name)
+{
+  guint i;
+
+  for (i = 0; self->big_data_names && i < self->big_data_names->len; i++)
+    if (g_strcmp0 (g_ptr_array_index (self->big_data_names, i), name) == 0)
+      return i;
+
+  return -1;
+}
+
+/**
+ * gyacht_image_set_big_data:
+ * @self: A #GyachtImage.
+ * @names: (transfer full): The names of the big data items.
+ * @sizes: (transfer full): A #gint64 per name, -1 if unknown.
+ * @digests: (transfer full): A digest per name, %NULL if unknown.
+ *
+ * Only called while the image is parsed, it never changes afterwards.
+ */
+void
+gyacht_image_set_big_data (GyachtImage *self,
+                           GPtrArray   *names,
+                           GArray      *sizes,
+                           GPtrArray   *digests)
+{
+  g_return_if_fail (GYACHT_IS_IMAGE (self));
+  g_return_if_fail (names != NULL && sizes != NULL && digests != NULL);
+  g_return_if_fail (names->len == sizes->len && names->len == digests->len);
+
+  g_clear_pointer (&self->big_data_names, g_ptr_array_unref);
+  g_clear_pointer (&self->big_data_sizes, g_array_unref);
+  g_clear_pointer (&self->big_data_digests, g_ptr_array_unref);
+
+  self->big_data_names = names;
+  self->big_data_sizes = sizes;
+  self->big_data_digests = digests;
+}
+
 /* --- Public APIs --- */
 GyachtImage *
 gyacht_image_new (const gchar     *id,
@@ -421,3 +466,51 @@ gyacht_image_get_calendar_date (GyachtImage *self)
 
   return formatted_date;
 }
+
+const GPtrArray *
+gyacht_image_get_big_data_names (GyachtImage *self)
+{
+  g_return_val_if_fail (GYACHT_IS_IMAGE (self), NULL);
+
+  return self->big_data_names;
+}
+
+gboolean
+gyacht_image_has_big_data (GyachtImage *self,
+                           const gchar *name)
+{
+  g_return_val_if_fail (GYACHT_IS_IMAGE (self), FALSE);
+
+  return internal_find_big_data (self, name) >= 0;
+}
+
+/* Return value: The size of @name as recorded, -1 if unknown */
+gint64
+gyacht_image_get_big_data_size (GyachtImage *self,
+                                const gchar *name)
+{
+  gint i;
+
+  g_return_val_if_fail (GYACHT_IS_IMAGE (self), -1);
+
+  i = internal_find_big_data (self, name);
+  if (i < 0)
+    return -1;
+
+  return g_array_index (self->big_data_sizes, gint64, i);
+}
+
+const gchar *
+gyacht_image_get_big_data_digest (GyachtImage *self,
+                                  const gchar *name)
+{
+  gint i;
+
+  g_return_val_if_fail (GYACHT_IS_IMAGE (self), NULL);
+
+  i = internal_find_big_data (self, name);
+  if (i < 0)
+    return NULL;
+
+  return g_ptr_array_index (self->big_data_digests, i);
+}
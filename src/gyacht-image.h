@@ -28,20 +28,27 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (GyachtImage, gyacht_image, GYACHT, IMAGE, GObject)
 
-GyachtImage *     gyacht_image_new                (const gchar     *id,
-                                                   const gchar     *digest,
-                                                   const GPtrArray *names,
-                                                   const gchar     *layer,
-                                                   const gchar     *metadata,
-                                                   const GDateTime *created);
-const gchar *     gyacht_image_get_id             (GyachtImage *self);
-const gchar *     gyacht_image_get_short_id       (GyachtImage *self);
-const gchar *     gyacht_image_get_digest         (GyachtImage *self);
-const gchar *     gyacht_image_get_name           (GyachtImage *self);
-const GPtrArray * gyacht_image_get_names          (GyachtImage *self);
-const gchar *     gyacht_image_get_layer          (GyachtImage *self);
-const gchar *     gyacht_image_get_metadata       (GyachtImage *self);
-const GDateTime * gyacht_image_get_created        (GyachtImage *self);
-gchar *           gyacht_image_get_calendar_date  (GyachtImage *self);
+GyachtImage *     gyacht_image_new                  (const gchar     *id,
+                                                     const gchar     *digest,
+                                                     const GPtrArray *names,
+                                                     const gchar     *layer,
+                                                     const gchar     *metadata,
+                                                     const GDateTime *created);
+const gchar *     gyacht_image_get_id               (GyachtImage *self);
+const gchar *     gyacht_image_get_short_id         (GyachtImage *self);
+const gchar *     gyacht_image_get_digest           (GyachtImage *self);
+const gchar *     gyacht_image_get_name             (GyachtImage *self);
+const GPtrArray * gyacht_image_get_names            (GyachtImage *self);
+const gchar *     gyacht_image_get_layer            (GyachtImage *self);
+const gchar *     gyacht_image_get_metadata         (GyachtImage *self);
+const GDateTime * gyacht_image_get_created          (GyachtImage *self);
+gchar *           gyacht_image_get_calendar_date    (GyachtImage *self);
+const GPtrArray * gyacht_image_get_big_data_names   (GyachtImage *self);
+gboolean          gyacht_image_has_big_data         (GyachtImage *self,
+                                                     const gchar *name);
+gint64            gyacht_image_get_big_data_size    (GyachtImage *self,
+                                                     const gchar *name);
+const gchar *     gyacht_image_get_big_data_digest  (GyachtImage *self,
+                                                     const gchar *name);
 
 G_END_DECLS
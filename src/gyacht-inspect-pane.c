@@ -0,0 +1,355 @@
+/* gyacht-inspect-pane.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-inspect-pane.h"
+
+#include <glib/gi18n.h>
+
+/* Shows a container at once from what the model knows, then what is read
+ * from the disk about it once its details are loaded.
+ */
+
+enum {
+  FIELD_NAMES = 0,
+  FIELD_ID,
+  FIELD_IMAGE,
+  FIELD_LAYER,
+  FIELD_UIDMAP,
+  FIELD_GIDMAP,
+  FIELD_FLAGS,
+  N_FIELDS
+};
+
+enum {
+  CLOSE,
+  N_SIGNALS
+};
+
+struct _GyachtInspectPane
+{
+  GtkBox          parent_instance;
+
+  GyachtContainer *container;
+
+  GtkWidget       *title_label;
+  GtkWidget       *field_labels [N_FIELDS];
+  GtkTextBuffer   *metadata_buffer;
+  GtkTextBuffer   *config_buffer;
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtInspectPane, gyacht_inspect_pane, GTK_TYPE_BOX)
+
+
+static gchar *
+internal_dup_idmaps (const GPtrArray *maps)
+{
+  GString *string;
+  guint i;
+
+  if (maps == NULL || maps->len == 0)
+    return g_strdup ("—");
+
+  string = g_string_new (NULL);
+  for (i = 0; i < maps->len; i++)
+    {
+      /* Uidmap and Gidmap are the same */
+      const Uidmap *map = g_ptr_array_index ((GPtrArray *) maps, i);
+
+      g_string_append_printf (string, "%s%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+                              i > 0 ? "\n" : "",
+                              map->container_id, map->host_id, map->size);
+    }
+
+  return g_string_free (string, FALSE);
+}
+
+static gchar *
+internal_dup_flags (const GHashTable *flags)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GString *string;
+
+  if (flags == NULL || g_hash_table_size ((GHashTable *) flags) == 0)
+    return g_strdup ("—");
+
+  string = g_string_new (NULL);
+  g_hash_table_iter_init (&iter, (GHashTable *) flags);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_string_append_printf (string, "%s%s=%s",
+                            string->len > 0 ? "\n" : "",
+                            (const gchar *) key,
+                            value ? (const gchar *) value : "");
+
+  return g_string_free (string, FALSE);
+}
+
+static gchar *
+internal_dup_names (const GPtrArray *names)
+{
+  g_autoptr(GPtrArray) strv = NULL;
+  guint i;
+
+  if (names == NULL || names->len == 0)
+    return g_strdup ("—");
+
+  strv = g_ptr_array_new ();
+  for (i = 0; i < names->len; i++)
+    g_ptr_array_add (strv, g_ptr_array_index ((GPtrArray *) names, i));
+  g_ptr_array_add (strv, NULL);
+
+  return g_strjoinv ("\n", (gchar **) strv->pdata);
+}
+
+static void
+internal_set_field (GyachtInspectPane *self,
+                    guint              field,
+                    const gchar       *text)
+{
+  gtk_label_set_text (GTK_LABEL (self->field_labels[field]), text ? text : "—");
+}
+
+static GtkWidget *
+internal_create_text_view (GtkTextBuffer **buffer)
+{
+  GtkWidget *view;
+
+  view = gtk_text_view_new ();
+  gtk_text_view_set_editable (GTK_TEXT_VIEW (view), FALSE);
+  gtk_text_view_set_cursor_visible (GTK_TEXT_VIEW (view), FALSE);
+  gtk_text_view_set_monospace (GTK_TEXT_VIEW (view), TRUE);
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), GTK_WRAP_CHAR);
+  *buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+
+  return view;
+}
+
+static GtkWidget *
+internal_create_heading (const gchar *text)
+{
+  GtkWidget *label;
+
+  label = gtk_label_new (text);
+  gtk_label_set_xalign (GTK_LABEL (label), 0);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label),
+                               GTK_STYLE_CLASS_DIM_LABEL);
+
+  return label;
+}
+
+static void
+internal_close_clicked_cb (GtkButton         *button,
+                           GyachtInspectPane *self)
+{
+  g_signal_emit (self, signals [CLOSE], 0);
+}
+
+/* --- GObject --- */
+static void
+gyacht_inspect_pane_finalize (GObject *object)
+{
+  GyachtInspectPane *self = GYACHT_INSPECT_PANE (object);
+
+  g_clear_object (&self->container);
+
+  G_OBJECT_CLASS (gyacht_inspect_pane_parent_class)->finalize (object);
+}
+
+static void
+gyacht_inspect_pane_class_init (GyachtInspectPaneClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_inspect_pane_finalize;
+
+  signals [CLOSE] =
+    g_signal_new ("close",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_inspect_pane_init (GyachtInspectPane *self)
+{
+  static const gchar *field_names[N_FIELDS] = {
+    N_("Names"),
+    N_("ID"),
+    N_("Image"),
+    N_("Layer"),
+    N_("UID map"),
+    N_("GID map"),
+    N_("Flags"),
+  };
+  GtkWidget *header;
+  GtkWidget *scrolled;
+  GtkWidget *content;
+  GtkWidget *grid;
+  GtkWidget *widget;
+  PangoAttrList *attrlist;
+  guint i;
+
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (self), GTK_ORIENTATION_VERTICAL);
+
+  /* Header */
+  header = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_widget_set_margin_start (header, 6);
+  gtk_widget_set_margin_end (header, 6);
+  gtk_widget_set_margin_top (header, 6);
+
+  self->title_label = gtk_label_new (NULL);
+  gtk_label_set_ellipsize (GTK_LABEL (self->title_label), PANGO_ELLIPSIZE_END);
+  gtk_label_set_xalign (GTK_LABEL (self->title_label), 0);
+
+  attrlist = pango_attr_list_new ();
+  pango_attr_list_insert (attrlist, pango_attr_weight_new (PANGO_WEIGHT_SEMIBOLD));
+  gtk_label_set_attributes (GTK_LABEL (self->title_label), attrlist);
+  pango_attr_list_unref (attrlist);
+
+  gtk_box_pack_start (GTK_BOX (header), self->title_label, TRUE, TRUE, 0);
+
+  widget = gtk_button_new_from_icon_name ("window-close-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_button_set_relief (GTK_BUTTON (widget), GTK_RELIEF_NONE);
+  gtk_widget_set_tooltip_text (widget, _("Close the information"));
+  g_signal_connect (widget, "clicked", G_CALLBACK (internal_close_clicked_cb), self);
+  gtk_box_pack_end (GTK_BOX (header), widget, FALSE, FALSE, 0);
+
+  gtk_box_pack_start (GTK_BOX (self), header, FALSE, TRUE, 0);
+
+  /* Contents */
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_min_content_height (GTK_SCROLLED_WINDOW (scrolled), 240);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+
+  content = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
+  gtk_widget_set_margin_start (content, 6);
+  gtk_widget_set_margin_end (content, 6);
+  gtk_widget_set_margin_bottom (content, 6);
+
+  grid = gtk_grid_new ();
+  gtk_grid_set_column_spacing (GTK_GRID (grid), 12);
+  gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
+
+  for (i = 0; i < N_FIELDS; i++)
+    {
+      widget = internal_create_heading (_(field_names[i]));
+      gtk_widget_set_valign (widget, GTK_ALIGN_START);
+      gtk_grid_attach (GTK_GRID (grid), widget, 0, i, 1, 1);
+
+      widget = gtk_label_new (NULL);
+      gtk_label_set_xalign (GTK_LABEL (widget), 0);
+      gtk_label_set_selectable (GTK_LABEL (widget), TRUE);
+      gtk_label_set_line_wrap (GTK_LABEL (widget), TRUE);
+      gtk_label_set_line_wrap_mode (GTK_LABEL (widget), PANGO_WRAP_CHAR);
+      gtk_widget_set_hexpand (widget, TRUE);
+      gtk_grid_attach (GTK_GRID (grid), widget, 1, i, 1, 1);
+      self->field_labels[i] = widget;
+    }
+
+  gtk_box_pack_start (GTK_BOX (content), grid, FALSE, TRUE, 0);
+
+  gtk_box_pack_start (GTK_BOX (content), internal_create_heading (_("Metadata")),
+                      FALSE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (content), internal_create_text_view (&self->metadata_buffer),
+                      FALSE, TRUE, 0);
+
+  gtk_box_pack_start (GTK_BOX (content), internal_create_heading (_("OCI configuration")),
+                      FALSE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (content), internal_create_text_view (&self->config_buffer),
+                      FALSE, TRUE, 0);
+
+  gtk_container_add (GTK_CONTAINER (scrolled), content);
+  gtk_box_pack_start (GTK_BOX (self), scrolled, TRUE, TRUE, 0);
+
+  gtk_widget_show_all (GTK_WIDGET (self));
+}
+
+/* --- Public APIs --- */
+GtkWidget *
+gyacht_inspect_pane_new (void)
+{
+  return g_object_new (GYACHT_TYPE_INSPECT_PANE, NULL);
+}
+
+/* Shows what the model knows about @container, its details are shown as
+ * loading until gyacht_inspect_pane_set_details() is called.
+ */
+void
+gyacht_inspect_pane_set_container (GyachtInspectPane *self,
+                                   GyachtContainer   *container)
+{
+  g_autofree gchar *names = NULL;
+  g_autofree gchar *uidmap = NULL;
+  g_autofree gchar *gidmap = NULL;
+  g_autofree gchar *flags = NULL;
+
+  g_return_if_fail (GYACHT_IS_INSPECT_PANE (self));
+  g_return_if_fail (GYACHT_IS_CONTAINER (container));
+
+  g_set_object (&self->container, container);
+
+  names = internal_dup_names (gyacht_container_get_names (container));
+  uidmap = internal_dup_idmaps (gyacht_container_get_uidmaps (container));
+  gidmap = internal_dup_idmaps (gyacht_container_get_gidmaps (container));
+  flags = internal_dup_flags (gyacht_container_get_flags (container));
+
+  gtk_label_set_text (GTK_LABEL (self->title_label), gyacht_container_get_name (container));
+  internal_set_field (self, FIELD_NAMES, names);
+  internal_set_field (self, FIELD_ID, gyacht_container_get_id (container));
+  internal_set_field (self, FIELD_IMAGE, gyacht_container_get_image_name (container));
+  internal_set_field (self, FIELD_LAYER, gyacht_container_get_layer (container));
+  internal_set_field (self, FIELD_UIDMAP, uidmap);
+  internal_set_field (self, FIELD_GIDMAP, gidmap);
+  internal_set_field (self, FIELD_FLAGS, flags);
+
+  gtk_text_buffer_set_text (self->metadata_buffer, _("Loading…"), -1);
+  gtk_text_buffer_set_text (self->config_buffer, _("Loading…"), -1);
+}
+
+GyachtContainer *
+gyacht_inspect_pane_get_container (GyachtInspectPane *self)
+{
+  g_return_val_if_fail (GYACHT_IS_INSPECT_PANE (self), NULL);
+
+  return self->container;
+}
+
+void
+gyacht_inspect_pane_set_details (GyachtInspectPane      *self,
+                                 GyachtContainerDetails *details)
+{
+  const gchar *text;
+
+  g_return_if_fail (GYACHT_IS_INSPECT_PANE (self));
+  g_return_if_fail (details != NULL);
+
+  text = gyacht_container_details_get_metadata (details);
+  gtk_text_buffer_set_text (self->metadata_buffer, text ? text : "—", -1);
+
+  text = gyacht_container_details_get_config (details);
+  gtk_text_buffer_set_text (self->config_buffer,
+                            text ? text : _("No config.json in the userdata directory"),
+                            -1);
+}
@@ -0,0 +1,380 @@
+/* gyacht-layer-browser.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-layer-browser.h"
+#include "gyacht-layer-index.h"
+
+#include <glib/gi18n.h>
+#include <sys/stat.h>
+
+/* Lists the files a layer adds from its index. Directories are filled in
+ * when first expanded, so opening a layer of any size costs its root.
+ */
+
+#define SHORT_ID_LENGTH 12
+
+enum {
+  COLUMN_ICON = 0,
+  COLUMN_NAME,
+  COLUMN_PATH,    /* NULL for the placeholder of a directory not expanded yet */
+  COLUMN_SIZE,
+  COLUMN_MODE,
+  N_COLUMNS
+};
+
+struct _GyachtLayerBrowser
+{
+  GtkWindow           parent_instance;
+
+  GyachtLayerService  *layers;
+  GyachtLayer         *layer;
+  GyachtLayerIndex    *index;
+  GCancellable        *cancellable;   /* Of the index being loaded */
+
+  GtkWidget           *header_bar;
+  GtkWidget           *parent_button;
+  GtkWidget           *status_label;
+  GtkTreeStore        *store;
+};
+
+G_DEFINE_TYPE (GyachtLayerBrowser, gyacht_layer_browser, GTK_TYPE_WINDOW)
+
+
+static gchar *
+internal_dup_mode_string (guint32 mode)
+{
+  gchar text[11];
+  gchar type;
+
+  if (mode == 0)
+    return g_strdup ("—");
+
+  if (S_ISDIR (mode))
+    type = 'd';
+  else if (S_ISLNK (mode))
+    type = 'l';
+  else if (S_ISCHR (mode))
+    type = 'c';
+  else if (S_ISBLK (mode))
+    type = 'b';
+  else if (S_ISFIFO (mode))
+    type = 'p';
+  else
+    type = '-';
+
+  text[0] = type;
+  text[1] = (mode & S_IRUSR) ? 'r' : '-';
+  text[2] = (mode & S_IWUSR) ? 'w' : '-';
+  text[3] = (mode & S_ISUID) ? ((mode & S_IXUSR) ? 's' : 'S') : ((mode & S_IXUSR) ? 'x' : '-');
+  text[4] = (mode & S_IRGRP) ? 'r' : '-';
+  text[5] = (mode & S_IWGRP) ? 'w' : '-';
+  text[6] = (mode & S_ISGID) ? ((mode & S_IXGRP) ? 's' : 'S') : ((mode & S_IXGRP) ? 'x' : '-');
+  text[7] = (mode & S_IROTH) ? 'r' : '-';
+  text[8] = (mode & S_IWOTH) ? 'w' : '-';
+  text[9] = (mode & S_ISVTX) ? ((mode & S_IXOTH) ? 't' : 'T') : ((mode & S_IXOTH) ? 'x' : '-');
+  text[10] = '\0';
+
+  return g_strdup (text);
+}
+
+static void
+internal_fill_dir (GyachtLayerBrowser *self,
+                   GtkTreeIter        *parent,
+                   const gchar        *dir)
+{
+  g_autoptr(GArray) children = NULL;
+  guint i;
+
+  children = gyacht_layer_index_dup_children (self->index, dir);
+
+  for (i = 0; i < children->len; i++)
+    {
+      GyachtLayerIndexChild *child = &g_array_index (children, GyachtLayerIndexChild, i);
+      g_autofree gchar *path = NULL;
+      g_autofree gchar *size = NULL;
+      g_autofree gchar *mode = NULL;
+      GtkTreeIter iter;
+
+      path = *dir ? g_strconcat (dir, "/", child->name, NULL) : g_strdup (child->name);
+      if (child->entry >= 0)
+        {
+          guint32 st_mode = gyacht_layer_index_get_mode (self->index, child->entry);
+
+          mode = internal_dup_mode_string (st_mode);
+          if (!child->is_dir && !S_ISLNK (st_mode))
+            size = g_format_size (gyacht_layer_index_get_size (self->index, child->entry));
+        }
+
+      gtk_tree_store_insert_with_values (self->store, &iter, parent, -1,
+                                         COLUMN_ICON, child->is_dir ? "folder-symbolic"
+                                                                    : "text-x-generic-symbolic",
+                                         COLUMN_NAME, child->name,
+                                         COLUMN_PATH, path,
+                                         COLUMN_SIZE, size,
+                                         COLUMN_MODE, mode,
+                                         -1);
+
+      if (child->has_children)
+        gtk_tree_store_insert_with_values (self->store, NULL, &iter, -1,
+                                           COLUMN_PATH, NULL,
+                                           -1);
+    }
+}
+
+static gboolean
+internal_test_expand_row_cb (GtkTreeView        *tree_view,
+                             GtkTreeIter        *iter,
+                             GtkTreePath        *tree_path,
+                             GyachtLayerBrowser *self)
+{
+  g_autofree gchar *placeholder = NULL;
+  g_autofree gchar *path = NULL;
+  GtkTreeIter child;
+
+  if (!gtk_tree_model_iter_children (GTK_TREE_MODEL (self->store), &child, iter))
+    return FALSE;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (self->store), &child, COLUMN_PATH, &placeholder, -1);
+  if (placeholder != NULL)
+    return FALSE;
+
+  gtk_tree_store_remove (self->store, &child);
+
+  gtk_tree_model_get (GTK_TREE_MODEL (self->store), iter, COLUMN_PATH, &path, -1);
+  internal_fill_dir (self, iter, path);
+
+  return FALSE;
+}
+
+static void
+internal_index_loaded_cb (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+  g_autoptr(GyachtLayerIndex) index = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *text = NULL;
+  GyachtLayerBrowser *self;
+  guint n_entries;
+
+  index = gyacht_layer_index_load_finish (res, &error);
+
+  /* Cancelled if another layer got shown or the window is gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = GYACHT_LAYER_BROWSER (user_data);
+  g_clear_object (&self->cancellable);
+
+  if (index == NULL)
+    {
+      gyacht_debug ("Unable to index the layer %s: %s",
+                    gyacht_layer_get_id (self->layer), error->message);
+      gtk_label_set_text (GTK_LABEL (self->status_label),
+                          _("The files of this layer are not listed in its metadata"));
+      return;
+    }
+
+  self->index = g_steal_pointer (&index);
+  internal_fill_dir (self, NULL, "");
+
+  n_entries = gyacht_layer_index_get_n_entries (self->index);
+  text = g_strdup_printf (ngettext ("%u path", "%u paths", n_entries), n_entries);
+  gtk_label_set_text (GTK_LABEL (self->status_label), text);
+}
+
+static void
+internal_parent_clicked_cb (GtkButton          *button,
+                            GyachtLayerBrowser *self)
+{
+  GyachtLayer *parent;
+
+  parent = gyacht_layer_service_lookup (self->layers, gyacht_layer_get_parent (self->layer));
+  if (parent)
+    gyacht_layer_browser_set_layer (self, parent);
+}
+
+static GtkTreeViewColumn *
+internal_create_text_column (const gchar *title,
+                             gint         column,
+                             gfloat       xalign)
+{
+  GtkCellRenderer *renderer;
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "xalign", xalign, NULL);
+
+  return gtk_tree_view_column_new_with_attributes (title, renderer,
+                                                   "text", column,
+                                                   NULL);
+}
+
+/* --- GObject --- */
+static void
+gyacht_layer_browser_finalize (GObject *object)
+{
+  GyachtLayerBrowser *self = GYACHT_LAYER_BROWSER (object);
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+  g_clear_pointer (&self->index, gyacht_layer_index_unref);
+  g_clear_object (&self->layer);
+  g_clear_object (&self->layers);
+  g_clear_object (&self->store);
+
+  G_OBJECT_CLASS (gyacht_layer_browser_parent_class)->finalize (object);
+}
+
+static void
+gyacht_layer_browser_class_init (GyachtLayerBrowserClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_layer_browser_finalize;
+}
+
+static void
+gyacht_layer_browser_init (GyachtLayerBrowser *self)
+{
+  GtkTreeViewColumn *tree_column;
+  GtkCellRenderer *renderer;
+  GtkWidget *tree_view;
+  GtkWidget *scrolled;
+  GtkWidget *box;
+
+  gtk_window_set_default_size (GTK_WINDOW (self), 600, 500);
+
+  self->header_bar = gtk_header_bar_new ();
+  gtk_header_bar_set_show_close_button (GTK_HEADER_BAR (self->header_bar), TRUE);
+  gtk_header_bar_set_title (GTK_HEADER_BAR (self->header_bar), _("Layer Files"));
+
+  self->parent_button = gtk_button_new_with_label (_("Parent Layer"));
+  gtk_widget_set_tooltip_text (self->parent_button, _("Show the files of the layer below"));
+  g_signal_connect (self->parent_button,
+                    "clicked",
+                    G_CALLBACK (internal_parent_clicked_cb),
+                    self);
+  gtk_header_bar_pack_start (GTK_HEADER_BAR (self->header_bar), self->parent_button);
+
+  gtk_window_set_titlebar (GTK_WINDOW (self), self->header_bar);
+
+  self->store = gtk_tree_store_new (N_COLUMNS,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (self->store));
+  gtk_tree_view_set_enable_search (GTK_TREE_VIEW (tree_view), TRUE);
+  gtk_tree_view_set_search_column (GTK_TREE_VIEW (tree_view), COLUMN_NAME);
+  g_signal_connect (tree_view,
+                    "test-expand-row",
+                    G_CALLBACK (internal_test_expand_row_cb),
+                    self);
+
+  /* Name with its icon */
+  tree_column = gtk_tree_view_column_new ();
+  gtk_tree_view_column_set_title (tree_column, _("Name"));
+  gtk_tree_view_column_set_expand (tree_column, TRUE);
+  renderer = gtk_cell_renderer_pixbuf_new ();
+  gtk_tree_view_column_pack_start (tree_column, renderer, FALSE);
+  gtk_tree_view_column_add_attribute (tree_column, renderer, "icon-name", COLUMN_ICON);
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "ellipsize", PANGO_ELLIPSIZE_MIDDLE, NULL);
+  gtk_tree_view_column_pack_start (tree_column, renderer, TRUE);
+  gtk_tree_view_column_add_attribute (tree_column, renderer, "text", COLUMN_NAME);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), tree_column);
+
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view),
+                               internal_create_text_column (_("Size"), COLUMN_SIZE, 1.0));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view),
+                               internal_create_text_column (_("Mode"), COLUMN_MODE, 0.0));
+
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_vexpand (scrolled, TRUE);
+  gtk_container_add (GTK_CONTAINER (scrolled), tree_view);
+
+  self->status_label = gtk_label_new (NULL);
+  gtk_widget_set_margin_top (self->status_label, 6);
+  gtk_widget_set_margin_bottom (self->status_label, 6);
+  gtk_style_context_add_class (gtk_widget_get_style_context (self->status_label),
+                               GTK_STYLE_CLASS_DIM_LABEL);
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_box_pack_start (GTK_BOX (box), scrolled, TRUE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (box), self->status_label, FALSE, TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (self), box);
+
+  gtk_widget_show_all (box);
+  gtk_widget_show (self->header_bar);
+}
+
+/* --- Public APIs --- */
+GtkWidget *
+gyacht_layer_browser_new (GyachtLayerService *layers,
+                          GyachtLayer        *layer)
+{
+  GyachtLayerBrowser *self;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (layers), NULL);
+  g_return_val_if_fail (GYACHT_IS_LAYER (layer), NULL);
+
+  self = g_object_new (GYACHT_TYPE_LAYER_BROWSER, NULL);
+  self->layers = g_object_ref (layers);
+  gyacht_layer_browser_set_layer (self, layer);
+
+  return GTK_WIDGET (self);
+}
+
+/* The index is built on the first time only, then mapped from the cache */
+void
+gyacht_layer_browser_set_layer (GyachtLayerBrowser *self,
+                                GyachtLayer        *layer)
+{
+  g_autofree gchar *short_id = NULL;
+  const gchar *parent;
+
+  g_return_if_fail (GYACHT_IS_LAYER_BROWSER (self));
+  g_return_if_fail (GYACHT_IS_LAYER (layer));
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+  g_clear_pointer (&self->index, gyacht_layer_index_unref);
+  gtk_tree_store_clear (self->store);
+
+  g_set_object (&self->layer, layer);
+
+  short_id = g_strndup (gyacht_layer_get_id (layer), SHORT_ID_LENGTH);
+  gtk_header_bar_set_subtitle (GTK_HEADER_BAR (self->header_bar), short_id);
+
+  parent = gyacht_layer_get_parent (layer);
+  gtk_widget_set_sensitive (self->parent_button,
+                            parent && gyacht_layer_service_lookup (self->layers, parent));
+
+  gtk_label_set_text (GTK_LABEL (self->status_label), _("Indexing…"));
+
+  self->cancellable = g_cancellable_new ();
+  gyacht_layer_index_load_async (layer,
+                                 self->cancellable,
+                                 internal_index_loaded_cb,
+                                 self);
+}
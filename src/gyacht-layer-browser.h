@@ -0,0 +1,39 @@
+/* gyacht-layer-browser.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include "gyacht-layer.h"
+#include "gyacht-layer-service.h"
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_LAYER_BROWSER (gyacht_layer_browser_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtLayerBrowser, gyacht_layer_browser, GYACHT, LAYER_BROWSER, GtkWindow)
+
+GtkWidget *     gyacht_layer_browser_new        (GyachtLayerService *layers,
+                                                 GyachtLayer        *layer);
+void            gyacht_layer_browser_set_layer  (GyachtLayerBrowser *self,
+                                                 GyachtLayer        *layer);
+
+G_END_DECLS
@@ -0,0 +1,674 @@
+/* gyacht-layer-index.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-layer-index.h"
+#include "gyacht-path-manager.h"
+#include "gyacht-tar-split.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* The files a layer adds are listed from its tar-split metadata, which
+ * podman keeps to rebuild the tar stream: a gzipped line of JSON per tar
+ * header segment and per file. Nothing of the diff directory is read.
+ *
+ * The sorted listing is written once to the cache directory, keyed by the
+ * diff digest of the layer, and mapped from there afterwards. A record is
+ * a little endian size and mode, the length of the path and the path with
+ * its terminating nul, so paths are used in place.
+ */
+
+#define INDEX_MAGIC         "GYLIDX1"
+#define INDEX_HEADER_SIZE   12    /* Magic with its nul, number of records */
+#define RECORD_HEADER_SIZE  16    /* Size, mode, path length */
+#define TAR_BLOCK_SIZE      512
+
+struct _GyachtLayerIndex
+{
+  gint    ref_count;
+
+  GBytes  *data;
+  guint32 *offsets;     /* Of each record, in the order of the paths */
+  guint   n_entries;
+};
+
+typedef struct
+{
+  gchar   *path;
+  guint64 size;
+  guint32 mode;
+  guint   seq;          /* A path may be archived twice, the last wins */
+} BuildEntry;
+
+
+static void
+internal_build_entry_clear (gpointer data)
+{
+  BuildEntry *entry = data;
+
+  g_free (entry->path);
+}
+
+static gint
+internal_build_entry_compare (gconstpointer a,
+                              gconstpointer b)
+{
+  const BuildEntry *entry_a = a;
+  const BuildEntry *entry_b = b;
+  gint result = strcmp (entry_a->path, entry_b->path);
+
+  if (result != 0)
+    return result;
+
+  return entry_a->seq < entry_b->seq ? -1 : (entry_a->seq > entry_b->seq);
+}
+
+static const guchar *
+internal_get_record (GyachtLayerIndex *self,
+                     guint             index_)
+{
+  return (const guchar *) g_bytes_get_data (self->data, NULL) + self->offsets[index_];
+}
+
+static guint32
+internal_read_uint32 (const guchar *p)
+{
+  guint32 value;
+
+  memcpy (&value, p, sizeof (value));
+  return GUINT32_FROM_LE (value);
+}
+
+static guint64
+internal_read_uint64 (const guchar *p)
+{
+  guint64 value;
+
+  memcpy (&value, p, sizeof (value));
+  return GUINT64_FROM_LE (value);
+}
+
+/* Takes @data, whether it is a valid index or not */
+static GyachtLayerIndex *
+internal_index_new_from_bytes (GBytes  *data,
+                               GError **error)
+{
+  g_autoptr(GyachtLayerIndex) self = NULL;
+  const guchar *base;
+  gsize length;
+  gsize offset;
+  guint i;
+
+  self = g_new0 (GyachtLayerIndex, 1);
+  self->ref_count = 1;
+  self->data = data;
+
+  base = g_bytes_get_data (data, &length);
+  if (length < INDEX_HEADER_SIZE || memcmp (base, INDEX_MAGIC, sizeof (INDEX_MAGIC)) != 0)
+    goto invalid;
+
+  self->n_entries = internal_read_uint32 (base + sizeof (INDEX_MAGIC));
+  if (self->n_entries > (length - INDEX_HEADER_SIZE) / RECORD_HEADER_SIZE)
+    goto invalid;
+
+  self->offsets = g_new (guint32, self->n_entries);
+  offset = INDEX_HEADER_SIZE;
+  for (i = 0; i < self->n_entries; i++)
+    {
+      guint32 path_length;
+
+      if (length - offset < RECORD_HEADER_SIZE)
+        goto invalid;
+
+      path_length = internal_read_uint32 (base + offset + 12);
+      if (length - offset - RECORD_HEADER_SIZE <= path_length ||
+          base[offset + RECORD_HEADER_SIZE + path_length] != '\0')
+        goto invalid;
+
+      self->offsets[i] = offset;
+      offset += RECORD_HEADER_SIZE + path_length + 1;
+    }
+
+  return g_steal_pointer (&self);
+
+invalid:
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                       "The layer index is corrupted");
+  return NULL;
+}
+
+static guint64
+internal_parse_octal (const guchar *field,
+                      gsize         length)
+{
+  guint64 value = 0;
+  gsize i;
+
+  for (i = 0; i < length && field[i] == ' '; i++);
+  for (; i < length && field[i] >= '0' && field[i] <= '7'; i++)
+    value = value * 8 + (field[i] - '0');
+
+  return value;
+}
+
+/* The header of a file ends the segment before it */
+static guint32
+internal_parse_mode (const guchar *header)
+{
+  guint32 mode = internal_parse_octal (header + 100, 8) & 07777;
+
+  switch (header[156])
+    {
+    case '2':
+      return mode | S_IFLNK;
+    case '3':
+      return mode | S_IFCHR;
+    case '4':
+      return mode | S_IFBLK;
+    case '5':
+      return mode | S_IFDIR;
+    case '6':
+      return mode | S_IFIFO;
+    default:
+      return mode | S_IFREG;
+    }
+}
+
+typedef struct
+{
+  GArray    *entries;               /* BuildEntry, in the order of tar-split */
+  guchar    header[TAR_BLOCK_SIZE]; /* Of the last segment */
+  gboolean  have_header;
+} ReadData;
+
+static gboolean
+internal_read_entry_cb (const GyachtTarSplitEntry  *entry,
+                        gpointer                    user_data,
+                        GError                    **error)
+{
+  ReadData *data = user_data;
+  BuildEntry build_entry;
+
+  if (entry->type == TAR_SPLIT_SEGMENT)
+    {
+      data->have_header = entry->payload_length >= TAR_BLOCK_SIZE;
+      if (data->have_header)
+        memcpy (data->header,
+                entry->payload + entry->payload_length - TAR_BLOCK_SIZE,
+                TAR_BLOCK_SIZE);
+      return TRUE;
+    }
+
+  build_entry.path = entry->name ? gyacht_layer_index_dup_normalized_path (entry->name) : NULL;
+  if (build_entry.path)
+    {
+      build_entry.size = MAX (0, entry->size);
+      build_entry.mode = data->have_header ? internal_parse_mode (data->header) : 0;
+      build_entry.seq = data->entries->len;
+      g_array_append_val (data->entries, build_entry);
+    }
+
+  data->have_header = FALSE;
+  return TRUE;
+}
+
+static GArray *
+internal_read_tar_split (const gchar   *path,
+                         GCancellable  *cancellable,
+                         GError       **error)
+{
+  g_autoptr(GArray) entries = NULL;
+  ReadData data = { 0, };
+
+  entries = g_array_new (FALSE, FALSE, sizeof (BuildEntry));
+  g_array_set_clear_func (entries, internal_build_entry_clear);
+  data.entries = entries;
+
+  /* A line which does not parse only leaves a path out of the listing */
+  if (!gyacht_tar_split_foreach (path, FALSE, internal_read_entry_cb, &data,
+                                 cancellable, error))
+    return NULL;
+
+  return g_steal_pointer (&entries);
+}
+
+static GBytes *
+internal_serialize (GArray *entries)
+{
+  GByteArray *buffer;
+  guint32 n_records = 0;
+  guint32 value32;
+  guint i;
+
+  buffer = g_byte_array_new ();
+  g_byte_array_append (buffer, (const guint8 *) INDEX_MAGIC, sizeof (INDEX_MAGIC));
+  g_byte_array_append (buffer, (const guint8 *) &n_records, sizeof (n_records));
+
+  for (i = 0; i < entries->len; i++)
+    {
+      BuildEntry *entry = &g_array_index (entries, BuildEntry, i);
+      guint64 value64;
+
+      /* Only the last of the same paths is kept */
+      if (i + 1 < entries->len &&
+          strcmp (entry->path, g_array_index (entries, BuildEntry, i + 1).path) == 0)
+        continue;
+
+      value64 = GUINT64_TO_LE (entry->size);
+      g_byte_array_append (buffer, (const guint8 *) &value64, sizeof (value64));
+      value32 = GUINT32_TO_LE (entry->mode);
+      g_byte_array_append (buffer, (const guint8 *) &value32, sizeof (value32));
+      value32 = GUINT32_TO_LE (strlen (entry->path));
+      g_byte_array_append (buffer, (const guint8 *) &value32, sizeof (value32));
+      g_byte_array_append (buffer, (const guint8 *) entry->path, strlen (entry->path) + 1);
+      n_records++;
+    }
+
+  value32 = GUINT32_TO_LE (n_records);
+  memcpy (buffer->data + sizeof (INDEX_MAGIC), &value32, sizeof (value32));
+
+  return g_byte_array_free_to_bytes (buffer);
+}
+
+/* Return value: (nullable): Where the index of @layer is cached, none
+ *   without a digest to name it after.
+ */
+static gchar *
+internal_dup_cache_path (GyachtLayer *layer)
+{
+  g_autofree gchar *cache_dir = NULL;
+  g_autofree gchar *name = NULL;
+  const gchar *digest = gyacht_layer_get_diff_digest (layer);
+
+  if (digest == NULL)
+    return NULL;
+
+  name = g_strdup_printf ("%s.idx", digest);
+  g_strcanon (name, "abcdefghijklmnopqrstuvwxyz0123456789.", '-');
+
+  cache_dir = gyacht_dup_user_cache_dir ();
+  return g_build_filename (cache_dir, LAYER_INDEX_DIR, name, NULL);
+}
+
+static void
+internal_save (const gchar *cache_path,
+               GBytes      *data)
+{
+  g_autofree gchar *dir = g_path_get_dirname (cache_path);
+  g_autoptr(GError) error = NULL;
+  gconstpointer contents;
+  gsize length;
+
+  if (g_mkdir_with_parents (dir, 0700) != 0)
+    {
+      gyacht_warn ("Unable to create %s: %s", dir, g_strerror (errno));
+      return;
+    }
+
+  contents = g_bytes_get_data (data, &length);
+  if (!g_file_set_contents (cache_path, contents, length, &error))
+    gyacht_warn ("Unable to save the layer index: %s", error->message);
+}
+
+static void
+internal_load_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  GyachtLayer *layer = task_data;
+  GyachtLayerIndex *index;
+  GError *error = NULL;
+
+  index = gyacht_layer_index_load (layer, cancellable, &error);
+  if (index == NULL)
+    g_task_return_error (task, error);
+  else
+    g_task_return_pointer (task, index, (GDestroyNotify) gyacht_layer_index_unref);
+}
+
+/* Return value: The first index whose path is not before @key */
+static guint
+internal_lower_bound (GyachtLayerIndex *self,
+                      const gchar      *key)
+{
+  guint low = 0;
+  guint high = self->n_entries;
+
+  while (low < high)
+    {
+      guint middle = low + (high - low) / 2;
+
+      if (strcmp (gyacht_layer_index_get_path (self, middle), key) < 0)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+
+  return low;
+}
+
+static gboolean
+internal_has_entries_under (GyachtLayerIndex *self,
+                            const gchar      *prefix)
+{
+  guint i = internal_lower_bound (self, prefix);
+
+  return i < self->n_entries &&
+         g_str_has_prefix (gyacht_layer_index_get_path (self, i), prefix);
+}
+
+static void
+internal_child_clear (gpointer data)
+{
+  GyachtLayerIndexChild *child = data;
+
+  g_free (child->name);
+}
+
+/* Directories first */
+static gint
+internal_child_compare (gconstpointer a,
+                        gconstpointer b)
+{
+  const GyachtLayerIndexChild *child_a = a;
+  const GyachtLayerIndexChild *child_b = b;
+
+  if (child_a->is_dir != child_b->is_dir)
+    return child_a->is_dir ? -1 : 1;
+
+  return strcmp (child_a->name, child_b->name);
+}
+
+/* --- Public APIs --- */
+/**
+ * gyacht_layer_index_dup_normalized_path:
+ * @path: an archived name, or a path within a layer
+ *
+ * Archived names are relative, possibly with a leading "./", and those of
+ * directories end with a slash. Paths looked up are usually absolute.
+ *
+ * Return value: (transfer full) (nullable): @path relative to the root of
+ *   the layer, %NULL for the root itself.
+ */
+gchar *
+gyacht_layer_index_dup_normalized_path (const gchar *path)
+{
+  gsize length;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  while (g_str_has_prefix (path, "./") || *path == '/')
+    path += (*path == '/') ? 1 : 2;
+
+  length = strlen (path);
+  while (length > 0 && path[length - 1] == '/')
+    length--;
+
+  if (length == 0 || (length == 1 && path[0] == '.'))
+    return NULL;
+
+  return g_strndup (path, length);
+}
+
+GyachtLayerIndex *
+gyacht_layer_index_ref (GyachtLayerIndex *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+  return self;
+}
+
+void
+gyacht_layer_index_unref (GyachtLayerIndex *self)
+{
+  g_return_if_fail (self != NULL);
+
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_bytes_unref (self->data);
+  g_free (self->offsets);
+  g_free (self);
+}
+
+guint
+gyacht_layer_index_get_n_entries (GyachtLayerIndex *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->n_entries;
+}
+
+const gchar *
+gyacht_layer_index_get_path (GyachtLayerIndex *self,
+                             guint             index_)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (index_ < self->n_entries, NULL);
+
+  return (const gchar *) internal_get_record (self, index_) + RECORD_HEADER_SIZE;
+}
+
+guint64
+gyacht_layer_index_get_size (GyachtLayerIndex *self,
+                             guint             index_)
+{
+  g_return_val_if_fail (self != NULL, 0);
+  g_return_val_if_fail (index_ < self->n_entries, 0);
+
+  return internal_read_uint64 (internal_get_record (self, index_));
+}
+
+/* Return value: A st_mode, 0 if the header of the entry was not found */
+guint32
+gyacht_layer_index_get_mode (GyachtLayerIndex *self,
+                             guint             index_)
+{
+  g_return_val_if_fail (self != NULL, 0);
+  g_return_val_if_fail (index_ < self->n_entries, 0);
+
+  return internal_read_uint32 (internal_get_record (self, index_) + 8);
+}
+
+/* Return value: The index of @path, -1 if the layer does not add it */
+gint
+gyacht_layer_index_lookup (GyachtLayerIndex *self,
+                           const gchar      *path)
+{
+  guint i;
+
+  g_return_val_if_fail (self != NULL, -1);
+  g_return_val_if_fail (path != NULL, -1);
+
+  i = internal_lower_bound (self, path);
+  if (i < self->n_entries && strcmp (gyacht_layer_index_get_path (self, i), path) == 0)
+    return i;
+
+  return -1;
+}
+
+/**
+ * gyacht_layer_index_dup_children:
+ * @self: a #GyachtLayerIndex
+ * @dir: a path of the layer, "" for its root
+ *
+ * Lists the entries right under @dir, which need not be archived itself.
+ * The paths under @dir are a range of the index, only its children are
+ * visited: a whole subtree is skipped with a lookup.
+ *
+ * Return value: (transfer full) (element-type GyachtLayerIndexChild): The
+ *   children of @dir, directories first.
+ */
+GArray *
+gyacht_layer_index_dup_children (GyachtLayerIndex *self,
+                                 const gchar      *dir)
+{
+  g_autofree gchar *prefix = NULL;
+  GArray *children;
+  gsize prefix_length;
+  guint i;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (dir != NULL, NULL);
+
+  children = g_array_new (FALSE, FALSE, sizeof (GyachtLayerIndexChild));
+  g_array_set_clear_func (children, internal_child_clear);
+
+  prefix = *dir ? g_strconcat (dir, "/", NULL) : g_strdup ("");
+  prefix_length = strlen (prefix);
+
+  i = internal_lower_bound (self, prefix);
+  while (i < self->n_entries)
+    {
+      const gchar *path = gyacht_layer_index_get_path (self, i);
+      GyachtLayerIndexChild child;
+      const gchar *slash;
+
+      if (strncmp (path, prefix, prefix_length) != 0)
+        break;
+
+      slash = strchr (path + prefix_length, '/');
+      if (slash == NULL)
+        {
+          g_autofree gchar *under = g_strconcat (path, "/", NULL);
+
+          child.name = g_strdup (path + prefix_length);
+          child.entry = i;
+          child.is_dir = S_ISDIR (gyacht_layer_index_get_mode (self, i));
+          child.has_children = internal_has_entries_under (self, under);
+          g_array_append_val (children, child);
+          i++;
+        }
+      else
+        {
+          g_autofree gchar *name = g_strndup (path + prefix_length,
+                                              slash - path - prefix_length);
+          g_autofree gchar *implied = g_strconcat (prefix, name, NULL);
+          g_autofree gchar *after = g_strconcat (implied, "0", NULL);
+
+          /* An archived directory comes before what is under it */
+          if (gyacht_layer_index_lookup (self, implied) < 0)
+            {
+              child.name = g_steal_pointer (&name);
+              child.entry = -1;
+              child.is_dir = TRUE;
+              child.has_children = TRUE;
+              g_array_append_val (children, child);
+            }
+
+          /* '0' follows '/', nothing under @implied is before @after */
+          i = internal_lower_bound (self, after);
+        }
+    }
+
+  g_array_sort (children, internal_child_compare);
+
+  return children;
+}
+
+/**
+ * gyacht_layer_index_load:
+ * @layer: a #GyachtLayer
+ * @cancellable: (nullable): a #GCancellable
+ * @error: return location for a #GError
+ *
+ * Maps the cached index of @layer, or builds it from the tar-split
+ * metadata and caches it. It blocks, it can be called from any thread.
+ *
+ * Return value: (transfer full) (nullable): The index of @layer.
+ */
+GyachtLayerIndex *
+gyacht_layer_index_load (GyachtLayer   *layer,
+                         GCancellable  *cancellable,
+                         GError       **error)
+{
+  g_autofree gchar *cache_path = NULL;
+  g_autofree gchar *layers_dir = NULL;
+  g_autofree gchar *tar_split = NULL;
+  g_autofree gchar *file_name = NULL;
+  g_autoptr(GArray) entries = NULL;
+  GyachtLayerIndex *index;
+  GBytes *data;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER (layer), NULL);
+
+  cache_path = internal_dup_cache_path (layer);
+  if (cache_path)
+    {
+      g_autoptr(GMappedFile) mapped = NULL;
+      g_autoptr(GError) local_error = NULL;
+
+      mapped = g_mapped_file_new (cache_path, FALSE, NULL);
+      if (mapped)
+        {
+          index = internal_index_new_from_bytes (g_mapped_file_get_bytes (mapped),
+                                                 &local_error);
+          if (index)
+            return index;
+
+          gyacht_debug ("Rebuilding %s: %s", cache_path, local_error->message);
+        }
+    }
+
+  layers_dir = gyacht_dup_user_layers_dir ();
+  file_name = g_strconcat (gyacht_layer_get_id (layer), TAR_SPLIT_SUFFIX, NULL);
+  tar_split = g_build_filename (layers_dir, file_name, NULL);
+
+  entries = internal_read_tar_split (tar_split, cancellable, error);
+  if (entries == NULL)
+    return NULL;
+
+  g_array_sort (entries, internal_build_entry_compare);
+  data = internal_serialize (entries);
+
+  if (cache_path)
+    internal_save (cache_path, data);
+
+  return internal_index_new_from_bytes (data, error);
+}
+
+void
+gyacht_layer_index_load_async (GyachtLayer         *layer,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (GYACHT_IS_LAYER (layer));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_layer_index_load_async);
+  g_task_set_task_data (task, g_object_ref (layer), g_object_unref);
+  g_task_run_in_thread (task, internal_load_thread);
+}
+
+GyachtLayerIndex *
+gyacht_layer_index_load_finish (GAsyncResult  *res,
+                                GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (res, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
@@ -0,0 +1,69 @@
+/* gyacht-layer-index.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "gyacht-layer.h"
+
+G_BEGIN_DECLS
+
+/* An entry of a directory of a layer index */
+typedef struct
+{
+  gchar     *name;
+  gint      entry;          /* -1 for a directory only implied by deeper paths */
+  gboolean  is_dir;
+  gboolean  has_children;
+} GyachtLayerIndexChild;
+
+/* The paths a layer adds, sorted, immutable once loaded */
+typedef struct _GyachtLayerIndex GyachtLayerIndex;
+
+gchar *             gyacht_layer_index_dup_normalized_path
+                                                        (const gchar      *path);
+GyachtLayerIndex *  gyacht_layer_index_ref              (GyachtLayerIndex *self);
+void                gyacht_layer_index_unref            (GyachtLayerIndex *self);
+guint               gyacht_layer_index_get_n_entries    (GyachtLayerIndex *self);
+const gchar *       gyacht_layer_index_get_path         (GyachtLayerIndex *self,
+                                                         guint             index_);
+guint64             gyacht_layer_index_get_size         (GyachtLayerIndex *self,
+                                                         guint             index_);
+guint32             gyacht_layer_index_get_mode         (GyachtLayerIndex *self,
+                                                         guint             index_);
+gint                gyacht_layer_index_lookup           (GyachtLayerIndex *self,
+                                                         const gchar      *path);
+GArray *            gyacht_layer_index_dup_children     (GyachtLayerIndex *self,
+                                                         const gchar      *dir);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtLayerIndex, gyacht_layer_index_unref)
+
+GyachtLayerIndex *  gyacht_layer_index_load             (GyachtLayer          *layer,
+                                                         GCancellable         *cancellable,
+                                                         GError              **error);
+void                gyacht_layer_index_load_async       (GyachtLayer          *layer,
+                                                         GCancellable         *cancellable,
+                                                         GAsyncReadyCallback   callback,
+                                                         gpointer              user_data);
+GyachtLayerIndex *  gyacht_layer_index_load_finish      (GAsyncResult         *res,
+                                                         GError              **error);
+
+G_END_DECLS
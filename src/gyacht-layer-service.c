@@ -0,0 +1,877 @@
+/* gyacht-layer-service.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-layer-service.h"
+#include "gyacht-path-manager.h"
+
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+
+/* Layers form a forest through their parents. Every node counts the
+ * images whose chain goes through it, which is the number of images with
+ * their top layer in its subtree, and memoizes the size of its chain. The
+ * containers are counted apart the same way, through their own layer.
+ *
+ * Because a parent is in every chain its children are in, the layers of
+ * an image used by no other image are the top of its chain, up to the
+ * first shared layer. Its unique size is then the difference of two
+ * chain sizes.
+ *
+ * Images and layers come and go independently, a layer may even be listed
+ * before its parent. Children waiting for their parent are kept aside in
+ * orphans, images waiting for their top layer in pending_tops.
+ */
+
+typedef enum {
+  USERS_IMAGES = 0,
+  USERS_CONTAINERS,
+  N_USERS
+} Users;
+
+typedef struct _LayerNode LayerNode;
+
+struct _LayerNode
+{
+  GyachtLayer *layer;
+  LayerNode   *parent;
+  GPtrArray   *children;    /* LayerNode */
+  guint       n_tops [N_USERS];   /* Users whose top layer it is */
+  guint       n_users [N_USERS];  /* Users whose chain it is in */
+  gint64      chain_size;   /* Memoized, -1 until known */
+};
+
+struct _GyachtLayerService
+{
+  GyachtService   parent_instance;
+
+  GHashTable      *nodes;         /* id -> LayerNode */
+  GHashTable      *orphans;       /* parent id -> GPtrArray of LayerNode */
+  GHashTable      *pending_tops [N_USERS];  /* layer id -> number of users */
+  GHashTable      *image_tops;      /* image id -> top layer id */
+  GHashTable      *container_tops;  /* container id -> layer id */
+  GHashTable      *loading;       /* id -> GyachtLayer, while a load runs */
+  GQueue          *jobs;
+  guint           usage_idle_id;
+
+  GyachtImageService     *images;
+  GyachtContainerService *containers;
+};
+
+enum {
+  ASYNC_JOB_ERROR = 0,
+  ASYNC_JOB_LOAD
+};
+
+/* Signals */
+enum {
+  USAGE_CHANGED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtLayerService, gyacht_layer_service, GYACHT_TYPE_SERVICE)
+
+/* Forward declarations */
+static void internal_load_json_callback (GObject      *source_object,
+                                         GAsyncResult *res,
+                                         gpointer      user_data);
+static void internal_load_batch_cb      (GyachtService *service,
+                                         GSequence     *batch,
+                                         gpointer       user_data);
+
+
+static void
+internal_layer_node_free (gpointer data)
+{
+  LayerNode *node = data;
+
+  g_object_unref (node->layer);
+  g_ptr_array_unref (node->children);
+  g_free (node);
+}
+
+static void
+internal_add_users (LayerNode *node,
+                    Users      users,
+                    gint       delta)
+{
+  for (; node; node = node->parent)
+    node->n_users[users] += delta;
+}
+
+/* A valid chain size implies a valid one for the parent, so it stops at
+ * the first invalid node.
+ */
+static void
+internal_invalidate (LayerNode *node)
+{
+  guint i;
+
+  if (node->chain_size < 0)
+    return;
+
+  node->chain_size = -1;
+  for (i = 0; i < node->children->len; i++)
+    internal_invalidate (g_ptr_array_index (node->children, i));
+}
+
+static gint64
+internal_get_chain_size (LayerNode *node)
+{
+  if (node->chain_size < 0)
+    node->chain_size = gyacht_layer_get_diff_size (node->layer) +
+                       (node->parent ? internal_get_chain_size (node->parent) : 0);
+
+  return node->chain_size;
+}
+
+static void
+internal_add_orphan (GyachtLayerService *self,
+                     LayerNode          *node)
+{
+  const gchar *parent_id = gyacht_layer_get_parent (node->layer);
+  GPtrArray *waiting;
+
+  waiting = g_hash_table_lookup (self->orphans, parent_id);
+  if (waiting == NULL)
+    {
+      waiting = g_ptr_array_new ();
+      g_hash_table_insert (self->orphans, g_strdup (parent_id), waiting);
+    }
+
+  g_ptr_array_add (waiting, node);
+}
+
+static GPtrArray *
+internal_steal_orphans (GyachtLayerService *self,
+                        const gchar        *parent_id)
+{
+  gpointer key, value;
+
+  if (!g_hash_table_lookup_extended (self->orphans, parent_id, &key, &value))
+    return NULL;
+
+  g_hash_table_steal (self->orphans, parent_id);
+  g_free (key);
+
+  return value;
+}
+
+static void
+internal_link_layer (GyachtLayerService *self,
+                     GyachtLayer        *layer)
+{
+  const gchar *id = gyacht_layer_get_id (layer);
+  const gchar *parent_id = gyacht_layer_get_parent (layer);
+  g_autoptr(GPtrArray) waiting = NULL;
+  LayerNode *node;
+  guint i, k;
+
+  node = g_new0 (LayerNode, 1);
+  node->layer = g_object_ref (layer);
+  node->children = g_ptr_array_new ();
+  node->chain_size = -1;
+
+  for (k = 0; k < N_USERS; k++)
+    {
+      node->n_tops[k] = GPOINTER_TO_UINT (g_hash_table_lookup (self->pending_tops[k], id));
+      node->n_users[k] = node->n_tops[k];
+      g_hash_table_remove (self->pending_tops[k], id);
+    }
+
+  /* Children listed before their parent */
+  waiting = internal_steal_orphans (self, id);
+  if (waiting)
+    {
+      for (i = 0; i < waiting->len; i++)
+        {
+          LayerNode *child = g_ptr_array_index (waiting, i);
+
+          child->parent = node;
+          g_ptr_array_add (node->children, child);
+          for (k = 0; k < N_USERS; k++)
+            node->n_users[k] += child->n_users[k];
+          internal_invalidate (child);
+        }
+    }
+
+  if (parent_id)
+    {
+      node->parent = g_hash_table_lookup (self->nodes, parent_id);
+      if (node->parent)
+        {
+          g_ptr_array_add (node->parent->children, node);
+          for (k = 0; k < N_USERS; k++)
+            internal_add_users (node->parent, k, node->n_users[k]);
+        }
+      else
+        internal_add_orphan (self, node);
+    }
+
+  g_hash_table_insert (self->nodes, (gpointer) id, node);
+}
+
+static void
+internal_unlink_layer (GyachtLayerService *self,
+                       const gchar        *id)
+{
+  const gchar *parent_id;
+  LayerNode *node;
+  guint i, k;
+
+  node = g_hash_table_lookup (self->nodes, id);
+  if (node == NULL)
+    return;
+
+  parent_id = gyacht_layer_get_parent (node->layer);
+
+  if (node->parent)
+    {
+      g_ptr_array_remove_fast (node->parent->children, node);
+      for (k = 0; k < N_USERS; k++)
+        internal_add_users (node->parent, k, -(gint) node->n_users[k]);
+    }
+  else if (parent_id)
+    {
+      GPtrArray *waiting = g_hash_table_lookup (self->orphans, parent_id);
+
+      g_ptr_array_remove_fast (waiting, node);
+      if (waiting->len == 0)
+        g_hash_table_remove (self->orphans, parent_id);
+    }
+
+  /* Its children wait for it to come back */
+  for (i = 0; i < node->children->len; i++)
+    {
+      LayerNode *child = g_ptr_array_index (node->children, i);
+
+      child->parent = NULL;
+      internal_invalidate (child);
+      internal_add_orphan (self, child);
+    }
+
+  for (k = 0; k < N_USERS; k++)
+    if (node->n_tops[k] > 0)
+      g_hash_table_insert (self->pending_tops[k], g_strdup (id),
+                           GUINT_TO_POINTER (node->n_tops[k]));
+
+  g_hash_table_remove (self->nodes, id);
+}
+
+static gboolean
+internal_usage_idle_cb (gpointer user_data)
+{
+  GyachtLayerService *self = GYACHT_LAYER_SERVICE (user_data);
+
+  self->usage_idle_id = 0;
+  g_signal_emit (self, signals[USAGE_CHANGED], 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Images arrive one at a time while they load, the views hear about all
+ * of them at once.
+ */
+static void
+internal_queue_usage_changed (GyachtLayerService *self)
+{
+  if (self->usage_idle_id == 0)
+    self->usage_idle_id = g_idle_add (internal_usage_idle_cb, self);
+}
+
+static void
+internal_add_top (GyachtLayerService *self,
+                  Users               users,
+                  const gchar        *top,
+                  gint                delta)
+{
+  LayerNode *node = g_hash_table_lookup (self->nodes, top);
+  guint n_tops;
+
+  if (node)
+    {
+      node->n_tops[users] += delta;
+      internal_add_users (node, users, delta);
+      return;
+    }
+
+  n_tops = GPOINTER_TO_UINT (g_hash_table_lookup (self->pending_tops[users], top)) + delta;
+  if (n_tops > 0)
+    g_hash_table_insert (self->pending_tops[users], g_strdup (top), GUINT_TO_POINTER (n_tops));
+  else
+    g_hash_table_remove (self->pending_tops[users], top);
+}
+
+static gboolean
+internal_set_image_top (GyachtLayerService *self,
+                        GyachtImage        *image)
+{
+  const gchar *id = gyacht_image_get_id (image);
+  const gchar *top = gyacht_image_get_layer (image);
+  const gchar *old_top;
+
+  old_top = g_hash_table_lookup (self->image_tops, id);
+  if (g_strcmp0 (old_top, top) == 0)
+    return FALSE;
+
+  if (old_top)
+    internal_add_top (self, USERS_IMAGES, old_top, -1);
+  if (top)
+    {
+      internal_add_top (self, USERS_IMAGES, top, 1);
+      g_hash_table_insert (self->image_tops, g_strdup (id), g_strdup (top));
+    }
+  else
+    g_hash_table_remove (self->image_tops, id);
+
+  return TRUE;
+}
+
+static void
+internal_image_added_cb (GyachtLayerService *self,
+                         GyachtImage        *image)
+{
+  if (internal_set_image_top (self, image))
+    internal_queue_usage_changed (self);
+}
+
+/* Follows the images through their top layers only, so a reload of
+ * images.json costs a lookup per image and a walk up the chains of those
+ * which came or went.
+ */
+static void
+internal_sync_images (GyachtLayerService *self)
+{
+  g_autoptr(GHashTable) fresh = NULL;
+  GSequence *images;
+  GSequenceIter *iter;
+  GHashTableIter tops_iter;
+  gpointer key, value;
+  gboolean changed = FALSE;
+
+  fresh = g_hash_table_new (g_str_hash, g_str_equal);
+
+  images = gyacht_image_service_get_images (self->images);
+  for (iter = images ? g_sequence_get_begin_iter (images) : NULL;
+       iter && !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GyachtImage *image = g_sequence_get (iter);
+
+      g_hash_table_add (fresh, (gpointer) gyacht_image_get_id (image));
+      changed |= internal_set_image_top (self, image);
+    }
+
+  g_hash_table_iter_init (&tops_iter, self->image_tops);
+  while (g_hash_table_iter_next (&tops_iter, &key, &value))
+    {
+      if (g_hash_table_contains (fresh, key))
+        continue;
+
+      internal_add_top (self, USERS_IMAGES, value, -1);
+      g_hash_table_iter_remove (&tops_iter);
+      changed = TRUE;
+    }
+
+  if (changed)
+    internal_queue_usage_changed (self);
+}
+
+/* A container is counted through its own layer, whose parent is the top
+ * layer of its image. Containers never change their layer, the service
+ * replaces them instead.
+ */
+static void
+internal_container_added_cb (GyachtLayerService *self,
+                             GyachtContainer    *container)
+{
+  const gchar *layer = gyacht_container_get_layer (container);
+
+  if (layer == NULL)
+    return;
+
+  internal_add_top (self, USERS_CONTAINERS, layer, 1);
+  g_hash_table_insert (self->container_tops,
+                       g_strdup (gyacht_container_get_id (container)),
+                       g_strdup (layer));
+  internal_queue_usage_changed (self);
+}
+
+static void
+internal_container_removed_cb (GyachtLayerService *self,
+                               GyachtContainer    *container)
+{
+  const gchar *id = gyacht_container_get_id (container);
+  const gchar *layer;
+
+  layer = g_hash_table_lookup (self->container_tops, id);
+  if (layer == NULL)
+    return;
+
+  internal_add_top (self, USERS_CONTAINERS, layer, -1);
+  g_hash_table_remove (self->container_tops, id);
+  internal_queue_usage_changed (self);
+}
+
+static GFile *
+internal_get_json_path (GyachtService *service)
+{
+  g_autofree gchar *json_path = NULL;
+  g_autofree gchar *file_dir = NULL;
+
+  /* TODO System level layer dir */
+  file_dir = gyacht_dup_user_layers_dir ();
+
+  json_path = g_build_filename (file_dir, LAYERS_JSON, NULL);
+  return g_file_new_for_path (json_path);
+}
+
+static GObject *
+internal_parse_element (JsonNode *node)
+{
+  return (GObject *) gyacht_layer_parse_json_element (node);
+}
+
+static void
+internal_run_job (GyachtLayerService *self)
+{
+  g_autoptr(GFile) location = NULL;
+
+  self->loading = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+
+  location = internal_get_json_path (GYACHT_SERVICE (self));
+  gyacht_service_stream_json_file_async (GYACHT_SERVICE (self),
+                                         location,
+                                         internal_parse_element,
+                                         internal_load_batch_cb,
+                                         NULL,
+                                         internal_load_json_callback,
+                                         NULL);
+}
+
+static void
+internal_execute_next_job (GyachtLayerService *self)
+{
+  g_queue_pop_head (self->jobs);
+
+  if (!g_queue_is_empty (self->jobs))
+    internal_run_job (self);
+  else
+    gyacht_service_report_progress (GYACHT_SERVICE (self),
+                                    g_hash_table_size (self->nodes),
+                                    TRUE);
+}
+
+static void
+internal_load_batch_cb (GyachtService *service,
+                        GSequence     *batch,
+                        gpointer       user_data)
+{
+  GyachtLayerService *self = GYACHT_LAYER_SERVICE (service);
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (batch);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GyachtLayer *layer = g_sequence_get (iter);
+
+      g_hash_table_insert (self->loading,
+                           (gpointer) gyacht_layer_get_id (layer),
+                           g_object_ref (layer));
+    }
+
+  gyacht_service_report_progress (service, g_hash_table_size (self->loading), FALSE);
+}
+
+/* Only the layers which differ from the graph are unlinked and linked
+ * again, so are the memoized sizes above them.
+ */
+static void
+internal_apply_loaded (GyachtLayerService *self)
+{
+  g_autoptr(GPtrArray) removed = NULL;
+  g_autoptr(GHashTable) replaced = NULL;
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i;
+
+  removed = g_ptr_array_new_with_free_func (g_object_unref);
+  replaced = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  g_hash_table_iter_init (&iter, self->nodes);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      LayerNode *node = value;
+      GyachtLayer *fresh = g_hash_table_lookup (self->loading, key);
+
+      if (fresh && gyacht_layer_equal (node->layer, fresh))
+        {
+          g_hash_table_remove (self->loading, key);
+          continue;
+        }
+
+      g_ptr_array_add (removed, g_object_ref (node->layer));
+    }
+
+  for (i = 0; i < removed->len; i++)
+    {
+      GyachtLayer *layer = g_ptr_array_index (removed, i);
+      const gchar *id = gyacht_layer_get_id (layer);
+
+      internal_unlink_layer (self, id);
+      if (g_hash_table_contains (self->loading, id))
+        g_hash_table_add (replaced, g_strdup (id));
+      else
+        g_signal_emit_by_name (self, "item-removed", layer);
+    }
+
+  g_hash_table_iter_init (&iter, self->loading);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      internal_link_layer (self, value);
+      g_signal_emit_by_name (self,
+                             g_hash_table_contains (replaced, key) ? "item-changed" : "item-added",
+                             value);
+    }
+
+  gyacht_debug ("%u layers, %u removed or changed, %u added or changed",
+                g_hash_table_size (self->nodes),
+                removed->len,
+                g_hash_table_size (self->loading));
+
+  if (removed->len > 0 || g_hash_table_size (self->loading) > 0)
+    internal_queue_usage_changed (self);
+}
+
+static void
+internal_load_json_callback (GObject      *source_object,
+                             GAsyncResult *res,
+                             gpointer      user_data)
+{
+  GyachtLayerService *self = GYACHT_LAYER_SERVICE (source_object);
+  g_autoptr(GError) error = NULL;
+
+  if (!gyacht_service_stream_json_finish (GYACHT_SERVICE (self), res, &error))
+    gyacht_warn ("Unable to load json contents from file: %s",
+                 error->message);
+  else
+    {
+      internal_apply_loaded (self);
+      g_signal_emit_by_name (self, "list-updated", 0);
+    }
+
+  g_clear_pointer (&self->loading, g_hash_table_unref);
+  internal_execute_next_job (self);
+}
+
+static void
+internal_load_contents (GyachtLayerService *self)
+{
+  GYACHT_TRACE_ENTRY;
+
+  /* A load is already waiting behind the running one */
+  if (g_queue_get_length (self->jobs) > 1)
+    {
+      GYACHT_TRACE_EXIT;
+      return;
+    }
+
+  g_queue_push_tail (self->jobs, GINT_TO_POINTER (ASYNC_JOB_LOAD));
+
+  /* Run if it has only one job in which is just pushed */
+  if (g_queue_get_length (self->jobs) == 1)
+    internal_run_job (self);
+
+  GYACHT_TRACE_EXIT;
+}
+
+/* --- GObject --- */
+static void
+gyacht_layer_service_finalize (GObject *object)
+{
+  GyachtLayerService *self = GYACHT_LAYER_SERVICE (object);
+
+  GYACHT_TRACE_ENTRY;
+
+  if (self->usage_idle_id)
+    g_source_remove (self->usage_idle_id);
+
+  g_signal_handlers_disconnect_by_func (self,
+                                        G_CALLBACK (internal_load_contents),
+                                        NULL);
+  g_signal_handlers_disconnect_by_func (self->images,
+                                        G_CALLBACK (internal_sync_images),
+                                        self);
+  g_signal_handlers_disconnect_by_func (self->images,
+                                        G_CALLBACK (internal_image_added_cb),
+                                        self);
+  g_clear_object (&self->images);
+  g_signal_handlers_disconnect_by_func (self->containers,
+                                        G_CALLBACK (internal_container_added_cb),
+                                        self);
+  g_signal_handlers_disconnect_by_func (self->containers,
+                                        G_CALLBACK (internal_container_removed_cb),
+                                        self);
+  g_clear_object (&self->containers);
+
+  g_clear_pointer (&self->loading, g_hash_table_unref);
+  g_hash_table_unref (self->orphans);
+  g_hash_table_unref (self->nodes);
+  g_hash_table_unref (self->pending_tops[USERS_IMAGES]);
+  g_hash_table_unref (self->pending_tops[USERS_CONTAINERS]);
+  g_hash_table_unref (self->image_tops);
+  g_hash_table_unref (self->container_tops);
+  g_queue_free (self->jobs);
+
+  GYACHT_TRACE_EXIT;
+
+  G_OBJECT_CLASS (gyacht_layer_service_parent_class)->finalize (object);
+}
+
+static void
+gyacht_layer_service_constructed (GObject *object)
+{
+  GyachtLayerService *self = GYACHT_LAYER_SERVICE (object);
+  GyachtService *service = GYACHT_SERVICE (object);
+
+  G_OBJECT_CLASS (gyacht_layer_service_parent_class)->constructed (object);
+
+  /* podman has no endpoint for layers, only the storage knows them */
+  if (gyacht_service_get_source (service) == SOURCE_PODMAN_API ||
+      gyacht_service_error_occur (service))
+    {
+      gyacht_service_report_progress (service, 0, TRUE);
+      return;
+    }
+
+  g_signal_connect (self,
+                    "monitor-event-triggered",
+                    G_CALLBACK (internal_load_contents),
+                    NULL);
+
+  internal_load_contents (self);
+}
+
+static void
+gyacht_layer_service_class_init (GyachtLayerServiceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GyachtServiceClass *service_class = GYACHT_SERVICE_CLASS (klass);
+
+  object_class->finalize = gyacht_layer_service_finalize;
+  object_class->constructed = gyacht_layer_service_constructed;
+
+  service_class->get_json_path = internal_get_json_path;
+
+  /* Emitted when the sizes of images may have changed, since layers or
+   * images came or went.
+   */
+  signals [USAGE_CHANGED] =
+    g_signal_new ("usage-changed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_layer_service_init (GyachtLayerService *self)
+{
+  /* Orphans go first, nodes own what they point to */
+  self->nodes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       NULL, internal_layer_node_free);
+  self->orphans = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, (GDestroyNotify) g_ptr_array_unref);
+  self->pending_tops[USERS_IMAGES] = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                            g_free, NULL);
+  self->pending_tops[USERS_CONTAINERS] = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                                g_free, NULL);
+  self->image_tops = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  self->container_tops = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  self->loading = NULL;
+  self->jobs = g_queue_new ();
+  self->usage_idle_id = 0;
+}
+
+/* --- Public APIs --- */
+/**
+ * gyacht_layer_service_new:
+ * @level: A #GyachtRunLevel.
+ * @images: The #GyachtImageService whose images are accounted.
+ * @containers: The #GyachtContainerService whose containers are accounted.
+ *
+ * Return value: (transfer full): A new #GyachtLayerService.
+ */
+GyachtLayerService *
+gyacht_layer_service_new (GyachtRunLevel          level,
+                          GyachtImageService     *images,
+                          GyachtContainerService *containers)
+{
+  GyachtLayerService *self;
+  GSequence *list;
+  GSequenceIter *iter;
+
+  g_return_val_if_fail (GYACHT_IS_IMAGE_SERVICE (images), NULL);
+  g_return_val_if_fail (GYACHT_IS_CONTAINER_SERVICE (containers), NULL);
+
+  self = g_object_new (GYACHT_TYPE_LAYER_SERVICE,
+                       "run-level", level,
+                       NULL);
+
+  self->images = g_object_ref (images);
+  g_signal_connect_swapped (images,
+                            "list-updated",
+                            G_CALLBACK (internal_sync_images),
+                            self);
+  g_signal_connect_swapped (images,
+                            "item-added",
+                            G_CALLBACK (internal_image_added_cb),
+                            self);
+  internal_sync_images (self);
+
+  self->containers = g_object_ref (containers);
+  g_signal_connect_swapped (containers,
+                            "item-added",
+                            G_CALLBACK (internal_container_added_cb),
+                            self);
+  g_signal_connect_swapped (containers,
+                            "item-removed",
+                            G_CALLBACK (internal_container_removed_cb),
+                            self);
+
+  list = gyacht_container_service_get_containers (containers);
+  for (iter = list ? g_sequence_get_begin_iter (list) : NULL;
+       iter && !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    internal_container_added_cb (self, g_sequence_get (iter));
+
+  return self;
+}
+
+/**
+ * gyacht_layer_service_get_n_users:
+ * @self: A #GyachtLayerService.
+ * @id: The id of a layer.
+ *
+ * Return value: The number of images and containers which need the layer.
+ */
+guint
+gyacht_layer_service_get_n_users (GyachtLayerService *self,
+                                  const gchar        *id)
+{
+  LayerNode *node;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (self), 0);
+
+  node = id ? g_hash_table_lookup (self->nodes, id) : NULL;
+  if (node == NULL)
+    return 0;
+
+  return node->n_users[USERS_IMAGES] + node->n_users[USERS_CONTAINERS];
+}
+
+GyachtLayer *
+gyacht_layer_service_lookup (GyachtLayerService *self,
+                             const gchar        *id)
+{
+  LayerNode *node;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (self), NULL);
+
+  node = id ? g_hash_table_lookup (self->nodes, id) : NULL;
+
+  return node ? node->layer : NULL;
+}
+
+/**
+ * gyacht_layer_service_dup_layers:
+ * @self: A #GyachtLayerService.
+ *
+ * Layers never change, so the array can be read from any thread.
+ *
+ * Return value: (transfer full) (element-type GyachtLayer): Every layer.
+ */
+GPtrArray *
+gyacht_layer_service_dup_layers (GyachtLayerService *self)
+{
+  GHashTableIter iter;
+  GPtrArray *layers;
+  gpointer value;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (self), NULL);
+
+  layers = g_ptr_array_new_full (g_hash_table_size (self->nodes), g_object_unref);
+
+  g_hash_table_iter_init (&iter, self->nodes);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_ptr_array_add (layers, g_object_ref (((LayerNode *) value)->layer));
+
+  return layers;
+}
+
+/**
+ * gyacht_layer_service_get_image_usage:
+ * @self: A #GyachtLayerService.
+ * @image: A #GyachtImage.
+ * @unique_size: (out) (optional): Bytes of the layers no other image uses.
+ * @shared_size: (out) (optional): Bytes of the layers other images use too.
+ *
+ * The sizes are those of the layers unpacked on disk. A chain whose base
+ * is not loaded counts from the first missing layer.
+ *
+ * Return value: Whether the top layer of @image is known.
+ */
+gboolean
+gyacht_layer_service_get_image_usage (GyachtLayerService *self,
+                                      GyachtImage        *image,
+                                      guint64            *unique_size,
+                                      guint64            *shared_size)
+{
+  LayerNode *top;
+  LayerNode *node;
+  gint64 total;
+  gint64 shared;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (self), FALSE);
+  g_return_val_if_fail (GYACHT_IS_IMAGE (image), FALSE);
+
+  if (gyacht_image_get_layer (image) == NULL)
+    return FALSE;
+
+  top = g_hash_table_lookup (self->nodes, gyacht_image_get_layer (image));
+  if (top == NULL)
+    return FALSE;
+
+  for (node = top; node && node->n_users[USERS_IMAGES] <= 1; node = node->parent)
+    ;
+
+  total = internal_get_chain_size (top);
+  shared = node ? internal_get_chain_size (node) : 0;
+
+  if (unique_size)
+    *unique_size = total - shared;
+  if (shared_size)
+    *shared_size = shared;
+
+  return TRUE;
+}
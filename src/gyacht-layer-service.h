@@ -0,0 +1,52 @@
+/* gyacht-layer-service.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "gyacht-container.h"
+#include "gyacht-container-service.h"
+#include "gyacht-image.h"
+#include "gyacht-image-service.h"
+#include "gyacht-layer.h"
+#include "gyacht-macros.h"
+#include "gyacht-service-private.h"
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_LAYER_SERVICE (gyacht_layer_service_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtLayerService, gyacht_layer_service, GYACHT, LAYER_SERVICE, GyachtService)
+
+GyachtLayerService *  gyacht_layer_service_new              (GyachtRunLevel          level,
+                                                             GyachtImageService     *images,
+                                                             GyachtContainerService *containers);
+GyachtLayer *         gyacht_layer_service_lookup           (GyachtLayerService *self,
+                                                             const gchar        *id);
+GPtrArray *           gyacht_layer_service_dup_layers       (GyachtLayerService *self);
+guint                 gyacht_layer_service_get_n_users      (GyachtLayerService *self,
+                                                             const gchar        *id);
+gboolean              gyacht_layer_service_get_image_usage  (GyachtLayerService *self,
+                                                             GyachtImage        *image,
+                                                             guint64            *unique_size,
+                                                             guint64            *shared_size);
+
+G_END_DECLS
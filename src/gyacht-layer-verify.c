@@ -0,0 +1,614 @@
+/* gyacht-layer-verify.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-layer-verify.h"
+#include "gyacht-path-manager.h"
+#include "gyacht-tar-split.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Tells whether the diff directory of each layer still holds what it was
+ * committed with. The tar stream the diff digest was computed over is
+ * rebuilt from the tar-split metadata, whose segments are the headers and
+ * paddings of the archive, with the content of each file read from the
+ * diff directory in between.
+ *
+ * The layers are hashed on a pool of dedicated threads, one per core,
+ * which take the next layer of a shared queue when done with one. The
+ * largest layers are queued first, so that no long layer is left alone
+ * at the end. Those threads read at the lowest best-effort I/O priority
+ * and drop the large files they read from the page cache.
+ */
+
+#define DIGEST_PREFIX         "sha256:"
+#define READ_BUFFER_SIZE      (1024 * 1024)
+#define LARGE_FILE_SIZE       (8 * 1024 * 1024)
+
+/* From linux/ioprio.h, which is not installed everywhere */
+#define IOPRIO_WHO_PROCESS    1
+#define IOPRIO_CLASS_BE       2
+#define IOPRIO_CLASS_SHIFT    13
+#define IOPRIO_LOWEST_LEVEL   7
+
+typedef struct
+{
+  gchar     *id;
+  gchar     *reason;
+} Failure;
+
+struct _GyachtVerifyReport
+{
+  gint        ref_count;
+
+  GArray      *failures;    /* Failure, by id */
+  guint       n_verified;
+  guint       n_skipped;    /* Without a digest to compare with */
+  guint64     hashed_size;
+};
+
+typedef struct
+{
+  GyachtLayerService  *layers;
+  GyachtVerifyReport  *report;
+  GThreadPool         *pool;
+  guint               pending;    /* Layers being hashed */
+  gboolean            waiting;    /* For the service to load */
+  gint64              started;
+} VerifyData;
+
+typedef struct
+{
+  GyachtLayer *layer;
+  gchar       *diff_dir;
+  gchar       *tar_split;
+  guint64     hashed_size;  /* Of the files, written by the worker */
+} LayerJob;
+
+
+static void
+internal_failure_clear (gpointer data)
+{
+  Failure *failure = data;
+
+  g_free (failure->id);
+  g_free (failure->reason);
+}
+
+static gint
+internal_compare_failures (gconstpointer a,
+                           gconstpointer b)
+{
+  const Failure *failure1 = a;
+  const Failure *failure2 = b;
+
+  return g_strcmp0 (failure1->id, failure2->id);
+}
+
+static void
+internal_layer_job_free (gpointer data)
+{
+  LayerJob *job = data;
+
+  g_object_unref (job->layer);
+  g_free (job->diff_dir);
+  g_free (job->tar_split);
+  g_free (job);
+}
+
+static void
+internal_verify_data_free (gpointer data)
+{
+  VerifyData *verify = data;
+
+  if (verify->pool)
+    g_thread_pool_free (verify->pool, TRUE, FALSE);
+  g_clear_object (&verify->layers);
+  g_clear_pointer (&verify->report, gyacht_verify_report_unref);
+  g_free (verify);
+}
+
+/* The priority is of the calling thread only */
+static void
+internal_lower_io_priority (void)
+{
+#ifdef SYS_ioprio_set
+  if (syscall (SYS_ioprio_set,
+               IOPRIO_WHO_PROCESS,
+               0,
+               (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | IOPRIO_LOWEST_LEVEL) != 0)
+    gyacht_debug ("Unable to lower the I/O priority: %s", g_strerror (errno));
+#endif
+}
+
+static gboolean
+internal_hash_file (GChecksum     *checksum,
+                    const gchar   *path,
+                    guint64        size,
+                    guchar        *buffer,
+                    GCancellable  *cancellable,
+                    GError       **error)
+{
+  struct stat st;
+  guint64 left = size;
+  gint fd;
+
+  fd = open (path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0)
+    {
+      gint saved_errno = errno;
+
+      g_set_error (error,
+                   G_IO_ERROR,
+                   g_io_error_from_errno (saved_errno),
+                   "Unable to open %s: %s",
+                   path,
+                   g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || (guint64) st.st_size != size)
+    {
+      close (fd);
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_INVALID_DATA,
+                   "%s is not the file which was archived",
+                   path);
+      return FALSE;
+    }
+
+  if (size >= LARGE_FILE_SIZE)
+    posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  while (left > 0)
+    {
+      gssize n_read;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        break;
+
+      n_read = read (fd, buffer, MIN (left, READ_BUFFER_SIZE));
+      if (n_read < 0 && errno == EINTR)
+        continue;
+
+      if (n_read <= 0)
+        {
+          gint saved_errno = n_read < 0 ? errno : 0;
+
+          g_set_error (error,
+                       G_IO_ERROR,
+                       n_read < 0 ? g_io_error_from_errno (saved_errno) : G_IO_ERROR_INVALID_DATA,
+                       "Unable to read %s: %s",
+                       path,
+                       n_read < 0 ? g_strerror (saved_errno) : "truncated");
+          break;
+        }
+
+      g_checksum_update (checksum, buffer, n_read);
+      left -= n_read;
+    }
+
+  /* A verification reads everything once, let the rest keep the cache */
+  if (size >= LARGE_FILE_SIZE)
+    posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+
+  close (fd);
+
+  return left == 0;
+}
+
+typedef struct
+{
+  LayerJob      *job;
+  GChecksum     *checksum;
+  guchar        *buffer;
+  GCancellable  *cancellable;
+} HashData;
+
+static gboolean
+internal_hash_entry_cb (const GyachtTarSplitEntry  *entry,
+                        gpointer                    user_data,
+                        GError                    **error)
+{
+  HashData *data = user_data;
+  g_autofree gchar *path = NULL;
+
+  if (entry->type == TAR_SPLIT_SEGMENT)
+    {
+      g_checksum_update (data->checksum, entry->payload, entry->payload_length);
+      return TRUE;
+    }
+
+  if (entry->size <= 0)
+    return TRUE;
+
+  if (entry->name == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           "A file of the tar-split metadata has no name");
+      return FALSE;
+    }
+
+  path = g_build_filename (data->job->diff_dir, entry->name, NULL);
+  if (!internal_hash_file (data->checksum, path, entry->size, data->buffer,
+                           data->cancellable, error))
+    return FALSE;
+
+  data->job->hashed_size += entry->size;
+  return TRUE;
+}
+
+/* Return value: (transfer full): The digest of the rebuilt tar stream */
+static gchar *
+internal_dup_layer_digest (LayerJob      *job,
+                           GCancellable  *cancellable,
+                           GError       **error)
+{
+  g_autoptr(GChecksum) checksum = NULL;
+  g_autofree guchar *buffer = NULL;
+  HashData data;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  buffer = g_malloc (READ_BUFFER_SIZE);
+
+  data.job = job;
+  data.checksum = checksum;
+  data.buffer = buffer;
+  data.cancellable = cancellable;
+
+  /* Unlike for listing, a line skipped would only be a mismatch */
+  if (!gyacht_tar_split_foreach (job->tar_split, TRUE, internal_hash_entry_cb, &data,
+                                 cancellable, error))
+    return NULL;
+
+  return g_strconcat (DIGEST_PREFIX, g_checksum_get_string (checksum), NULL);
+}
+
+static void
+internal_verify_thread (gpointer data,
+                        gpointer user_data)
+{
+  g_autoptr(GTask) task = data;
+  LayerJob *job = g_task_get_task_data (task);
+  g_autofree gchar *digest = NULL;
+  GError *error = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  internal_lower_io_priority ();
+
+  digest = internal_dup_layer_digest (job, g_task_get_cancellable (task), &error);
+  if (digest == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  if (g_strcmp0 (digest, gyacht_layer_get_diff_digest (job->layer)) != 0)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_DATA,
+                               "The content hashes to %s",
+                               digest);
+      return;
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+internal_layer_verified_cb (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  VerifyData *verify = g_task_get_task_data (task);
+  GyachtVerifyReport *report = verify->report;
+  LayerJob *job = g_task_get_task_data (G_TASK (res));
+  g_autoptr(GError) error = NULL;
+
+  report->hashed_size += job->hashed_size;
+
+  if (g_task_propagate_boolean (G_TASK (res), &error))
+    report->n_verified++;
+  else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      Failure failure;
+
+      failure.id = g_strdup (gyacht_layer_get_id (job->layer));
+      failure.reason = g_strdup (error->message);
+      g_array_append_val (report->failures, failure);
+      report->n_verified++;
+
+      gyacht_debug ("Layer %s does not verify: %s", failure.id, failure.reason);
+    }
+
+  if (--verify->pending > 0)
+    return;
+
+  /* The queue is empty, the threads only have to exit */
+  g_thread_pool_free (g_steal_pointer (&verify->pool), FALSE, FALSE);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  gyacht_debug ("%u layers verified in %.1f s",
+                report->n_verified,
+                (g_get_monotonic_time () - verify->started) / (gdouble) G_USEC_PER_SEC);
+
+  g_array_sort (report->failures, internal_compare_failures);
+  g_task_return_pointer (task,
+                         g_steal_pointer (&verify->report),
+                         (GDestroyNotify) gyacht_verify_report_unref);
+}
+
+static gint
+internal_compare_layers (gconstpointer a,
+                         gconstpointer b)
+{
+  gint64 size1 = gyacht_layer_get_diff_size (*(GyachtLayer **) a);
+  gint64 size2 = gyacht_layer_get_diff_size (*(GyachtLayer **) b);
+
+  if (size1 != size2)
+    return size1 > size2 ? -1 : 1;
+
+  return 0;
+}
+
+static void
+internal_start_verify (GTask *task)
+{
+  VerifyData *verify = g_task_get_task_data (task);
+  g_autoptr(GPtrArray) layers = NULL;
+  g_autofree gchar *overlay_dir = NULL;
+  g_autofree gchar *layers_dir = NULL;
+  guint i;
+
+  GYACHT_TRACE_ENTRY;
+
+  verify->report = g_new0 (GyachtVerifyReport, 1);
+  verify->report->ref_count = 1;
+  verify->report->failures = g_array_new (FALSE, FALSE, sizeof (Failure));
+  g_array_set_clear_func (verify->report->failures, internal_failure_clear);
+
+  verify->started = g_get_monotonic_time ();
+  verify->pool = g_thread_pool_new (internal_verify_thread,
+                                    NULL,
+                                    g_get_num_processors (),
+                                    TRUE,
+                                    NULL);
+
+  overlay_dir = gyacht_dup_user_overlay_dir ();
+  layers_dir = gyacht_dup_user_layers_dir ();
+
+  /* The largest first, the threads pick them in this order */
+  layers = gyacht_layer_service_dup_layers (verify->layers);
+  g_ptr_array_sort (layers, internal_compare_layers);
+
+  for (i = 0; i < layers->len; i++)
+    {
+      GyachtLayer *layer = g_ptr_array_index (layers, i);
+      const gchar *id = gyacht_layer_get_id (layer);
+      const gchar *digest = gyacht_layer_get_diff_digest (layer);
+      g_autofree gchar *file_name = NULL;
+      LayerJob *job;
+      GTask *layer_task;
+
+      /* Those of containers are written to, and have none */
+      if (digest == NULL || !g_str_has_prefix (digest, DIGEST_PREFIX))
+        {
+          verify->report->n_skipped++;
+          continue;
+        }
+
+      file_name = g_strconcat (id, TAR_SPLIT_SUFFIX, NULL);
+
+      job = g_new0 (LayerJob, 1);
+      job->layer = g_object_ref (layer);
+      job->diff_dir = g_build_filename (overlay_dir, id, OVERLAY_DIFF, NULL);
+      job->tar_split = g_build_filename (layers_dir, file_name, NULL);
+
+      layer_task = g_task_new (NULL,
+                               g_task_get_cancellable (task),
+                               internal_layer_verified_cb,
+                               g_object_ref (task));
+      g_task_set_source_tag (layer_task, internal_start_verify);
+      g_task_set_task_data (layer_task, job, internal_layer_job_free);
+
+      verify->pending++;
+      g_thread_pool_push (verify->pool, layer_task, NULL);
+    }
+
+  if (verify->pending == 0)
+    {
+      g_thread_pool_free (g_steal_pointer (&verify->pool), FALSE, FALSE);
+      g_task_return_pointer (task,
+                             g_steal_pointer (&verify->report),
+                             (GDestroyNotify) gyacht_verify_report_unref);
+    }
+
+  GYACHT_TRACE_EXIT;
+}
+
+static void
+internal_load_progress_cb (GyachtService *service,
+                           guint          n_items,
+                           gboolean       done,
+                           GTask         *task)
+{
+  VerifyData *verify = g_task_get_task_data (task);
+
+  if (!verify->waiting || !gyacht_service_is_loaded (service))
+    return;
+
+  verify->waiting = FALSE;
+  g_signal_handlers_disconnect_by_func (verify->layers,
+                                        G_CALLBACK (internal_load_progress_cb),
+                                        task);
+
+  internal_start_verify (task);
+  g_object_unref (task);
+}
+
+/* --- Public APIs --- */
+GyachtVerifyReport *
+gyacht_verify_report_ref (GyachtVerifyReport *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+
+  return self;
+}
+
+void
+gyacht_verify_report_unref (GyachtVerifyReport *self)
+{
+  g_return_if_fail (self != NULL);
+
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_array_unref (self->failures);
+  g_free (self);
+}
+
+guint
+gyacht_verify_report_get_n_verified (GyachtVerifyReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->n_verified;
+}
+
+guint
+gyacht_verify_report_get_n_skipped (GyachtVerifyReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->n_skipped;
+}
+
+guint64
+gyacht_verify_report_get_hashed_size (GyachtVerifyReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->hashed_size;
+}
+
+guint
+gyacht_verify_report_get_n_failures (GyachtVerifyReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->failures->len;
+}
+
+const gchar *
+gyacht_verify_report_get_failure_id (GyachtVerifyReport *self,
+                                     guint               index_)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (index_ < self->failures->len, NULL);
+
+  return g_array_index (self->failures, Failure, index_).id;
+}
+
+const gchar *
+gyacht_verify_report_get_failure_reason (GyachtVerifyReport *self,
+                                         guint               index_)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (index_ < self->failures->len, NULL);
+
+  return g_array_index (self->failures, Failure, index_).reason;
+}
+
+/**
+ * gyacht_layer_verify_async:
+ * @layers: A #GyachtLayerService.
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: Called with the report.
+ * @user_data: Data for @callback.
+ *
+ * Hashes the content of every layer which has a diff digest and reports
+ * those which differ from it. The verification waits for the service to
+ * be loaded.
+ */
+void
+gyacht_layer_verify_async (GyachtLayerService  *layers,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  VerifyData *verify;
+
+  g_return_if_fail (GYACHT_IS_LAYER_SERVICE (layers));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_layer_verify_async);
+
+  /* The layers are not known then */
+  if (gyacht_service_get_source (GYACHT_SERVICE (layers)) == SOURCE_PODMAN_API)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_SUPPORTED,
+                               "Layers are verified only when the storage is read directly");
+      return;
+    }
+
+  verify = g_new0 (VerifyData, 1);
+  verify->layers = g_object_ref (layers);
+  g_task_set_task_data (task, verify, internal_verify_data_free);
+
+  if (gyacht_service_is_loaded (GYACHT_SERVICE (layers)))
+    {
+      internal_start_verify (task);
+      return;
+    }
+
+  /* The reference goes with the wait */
+  verify->waiting = TRUE;
+  g_signal_connect (layers,
+                    "load-progress",
+                    G_CALLBACK (internal_load_progress_cb),
+                    task);
+  g_steal_pointer (&task);
+}
+
+GyachtVerifyReport *
+gyacht_layer_verify_finish (GAsyncResult  *res,
+                            GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (res, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
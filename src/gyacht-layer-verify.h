@@ -0,0 +1,54 @@
+/* gyacht-layer-verify.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "gyacht-layer-service.h"
+
+G_BEGIN_DECLS
+
+/* Layers whose content no longer matches their digest, immutable once
+ * verified.
+ */
+typedef struct _GyachtVerifyReport GyachtVerifyReport;
+
+GyachtVerifyReport *  gyacht_verify_report_ref                (GyachtVerifyReport *self);
+void                  gyacht_verify_report_unref              (GyachtVerifyReport *self);
+guint                 gyacht_verify_report_get_n_verified     (GyachtVerifyReport *self);
+guint                 gyacht_verify_report_get_n_skipped      (GyachtVerifyReport *self);
+guint64               gyacht_verify_report_get_hashed_size    (GyachtVerifyReport *self);
+guint                 gyacht_verify_report_get_n_failures     (GyachtVerifyReport *self);
+const gchar *         gyacht_verify_report_get_failure_id     (GyachtVerifyReport *self,
+                                                               guint               index_);
+const gchar *         gyacht_verify_report_get_failure_reason (GyachtVerifyReport *self,
+                                                               guint               index_);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtVerifyReport, gyacht_verify_report_unref)
+
+void                  gyacht_layer_verify_async               (GyachtLayerService  *layers,
+                                                               GCancellable        *cancellable,
+                                                               GAsyncReadyCallback  callback,
+                                                               gpointer             user_data);
+GyachtVerifyReport *  gyacht_layer_verify_finish              (GAsyncResult        *res,
+                                                               GError             **error);
+
+G_END_DECLS
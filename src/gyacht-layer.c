@@ -0,0 +1,192 @@
+/* gyacht-layer.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-layer.h"
+
+/* A record of overlay-layers/layers.json. It never changes once created,
+ * a layer which changed on disk is replaced by a new object.
+ */
+
+struct _GyachtLayer
+{
+  GObject     parent_instance;
+
+  gchar       *id;
+  gchar       *parent;
+  gchar       *diff_digest;     /* Of the uncompressed tar stream */
+  gint64      diff_size;        /* Uncompressed, as unpacked on disk */
+  gint64      compressed_size;  /* As pulled, 0 for local layers */
+};
+
+G_DEFINE_TYPE (GyachtLayer, gyacht_layer, G_TYPE_OBJECT)
+
+
+static gint64
+internal_get_size_member (JsonObject  *elem,
+                          const gchar *member_name)
+{
+  JsonNode *member = json_object_get_member (elem, member_name);
+
+  if (member == NULL || json_node_get_value_type (member) != G_TYPE_INT64)
+    return 0;
+
+  return MAX (0, json_node_get_int (member));
+}
+
+/* --- GObject --- */
+static void
+gyacht_layer_finalize (GObject *object)
+{
+  GyachtLayer *self = GYACHT_LAYER (object);
+
+  g_free (self->id);
+  g_free (self->parent);
+  g_free (self->diff_digest);
+
+  G_OBJECT_CLASS (gyacht_layer_parent_class)->finalize (object);
+}
+
+static void
+gyacht_layer_class_init (GyachtLayerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_layer_finalize;
+}
+
+static void
+gyacht_layer_init (GyachtLayer *self)
+{
+  self->diff_size = 0;
+  self->compressed_size = 0;
+}
+
+/* --- Public APIs --- */
+GyachtLayer *
+gyacht_layer_new (const gchar *id,
+                  const gchar *parent,
+                  const gchar *diff_digest,
+                  gint64       diff_size,
+                  gint64       compressed_size)
+{
+  GyachtLayer *self;
+
+  g_return_val_if_fail (id != NULL, NULL);
+
+  self = g_object_new (GYACHT_TYPE_LAYER, NULL);
+  self->id = g_strdup (id);
+  self->parent = (parent && *parent) ? g_strdup (parent) : NULL;
+  self->diff_digest = (diff_digest && *diff_digest) ? g_strdup (diff_digest) : NULL;
+  self->diff_size = diff_size;
+  self->compressed_size = compressed_size;
+
+  return self;
+}
+
+/**
+ * gyacht_layer_parse_json_element:
+ * @element_node: An element of the array of layers.json.
+ *
+ * It can be called from any thread.
+ *
+ * Return value: (transfer full) (nullable): A new #GyachtLayer.
+ */
+GyachtLayer *
+gyacht_layer_parse_json_element (JsonNode *element_node)
+{
+  JsonObject *elem;
+  const gchar *id = NULL;
+  const gchar *parent = NULL;
+  const gchar *diff_digest = NULL;
+
+  if (element_node == NULL || !JSON_NODE_HOLDS_OBJECT (element_node))
+    return NULL;
+
+  elem = json_node_get_object (element_node);
+
+  if (json_object_has_member (elem, "id"))
+    id = json_object_get_string_member (elem, "id");
+  if (id == NULL)
+    return NULL;
+  if (json_object_has_member (elem, "parent"))
+    parent = json_object_get_string_member (elem, "parent");
+  if (json_object_has_member (elem, "diff-digest"))
+    diff_digest = json_object_get_string_member (elem, "diff-digest");
+
+  return gyacht_layer_new (id, parent, diff_digest,
+                           internal_get_size_member (elem, "diff-size"),
+                           internal_get_size_member (elem, "compressed-size"));
+}
+
+gboolean
+gyacht_layer_equal (GyachtLayer *self,
+                    GyachtLayer *other)
+{
+  g_return_val_if_fail (GYACHT_IS_LAYER (self), FALSE);
+  g_return_val_if_fail (GYACHT_IS_LAYER (other), FALSE);
+
+  return g_strcmp0 (self->id, other->id) == 0 &&
+         g_strcmp0 (self->parent, other->parent) == 0 &&
+         g_strcmp0 (self->diff_digest, other->diff_digest) == 0 &&
+         self->diff_size == other->diff_size &&
+         self->compressed_size == other->compressed_size;
+}
+
+/* --- Getters --- */
+const gchar *
+gyacht_layer_get_id (GyachtLayer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_LAYER (self), NULL);
+
+  return self->id;
+}
+
+const gchar *
+gyacht_layer_get_parent (GyachtLayer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_LAYER (self), NULL);
+
+  return self->parent;
+}
+
+/* Return value: (nullable): The digest of the uncompressed layer */
+const gchar *
+gyacht_layer_get_diff_digest (GyachtLayer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_LAYER (self), NULL);
+
+  return self->diff_digest;
+}
+
+gint64
+gyacht_layer_get_diff_size (GyachtLayer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_LAYER (self), 0);
+
+  return self->diff_size;
+}
+
+gint64
+gyacht_layer_get_compressed_size (GyachtLayer *self)
+{
+  g_return_val_if_fail (GYACHT_IS_LAYER (self), 0);
+
+  return self->compressed_size;
+}
@@ -0,0 +1,46 @@
+/* gyacht-layer.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_LAYER (gyacht_layer_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtLayer, gyacht_layer, GYACHT, LAYER, GObject)
+
+GyachtLayer *   gyacht_layer_new                  (const gchar *id,
+                                                   const gchar *parent,
+                                                   const gchar *diff_digest,
+                                                   gint64       diff_size,
+                                                   gint64       compressed_size);
+GyachtLayer *   gyacht_layer_parse_json_element   (JsonNode    *element_node);
+gboolean        gyacht_layer_equal                (GyachtLayer *self,
+                                                   GyachtLayer *other);
+const gchar *   gyacht_layer_get_id               (GyachtLayer *self);
+const gchar *   gyacht_layer_get_parent           (GyachtLayer *self);
+const gchar *   gyacht_layer_get_diff_digest      (GyachtLayer *self);
+gint64          gyacht_layer_get_diff_size        (GyachtLayer *self);
+gint64          gyacht_layer_get_compressed_size  (GyachtLayer *self);
+
+G_END_DECLS
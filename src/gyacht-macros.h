@@ -27,5 +27,11 @@ typedef enum {
   N_RUN_LEVELS
 } GyachtRunLevel;
 
+typedef enum {
+  SOURCE_STORAGE = 0,   /* Read the json files of containers/storage */
+  SOURCE_PODMAN_API,    /* Ask `podman system service` over its socket */
+  N_SOURCES
+} GyachtSource;
+
 #define   GYACHT_UI_PREFIX        "/com/github/yisooan/gyacht/"
 #define   GYACHT_APPLICATION_ID   "com.github.yisooan.gyacht"
@@ -0,0 +1,327 @@
+/* gyacht-mount-service.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-mount-service.h"
+#include "gyacht-path-manager.h"
+
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+
+/* The mount state of the layers, as containers/storage records it in
+ * overlay-layers/mountpoints.json. The file is loaded and watched like the
+ * other stores. Every load is compared with the last one, and only the
+ * entries whose state differs are signaled: item-added, item-removed or
+ * item-changed with the new #GyachtMount.
+ */
+
+struct _GyachtMountService
+{
+  GyachtService   parent_instance;
+
+  GHashTable      *mounts;    /* layer id -> GyachtMount */
+  GHashTable      *loading;   /* layer id -> GyachtMount, while a load runs */
+  GQueue          *jobs;
+};
+
+enum {
+  ASYNC_JOB_ERROR = 0,
+  ASYNC_JOB_LOAD
+};
+
+G_DEFINE_TYPE (GyachtMountService, gyacht_mount_service, GYACHT_TYPE_SERVICE)
+
+/* Forward declarations */
+static void internal_load_json_callback (GObject      *source_object,
+                                         GAsyncResult *res,
+                                         gpointer      user_data);
+static void internal_load_batch_cb      (GyachtService *service,
+                                         GSequence     *batch,
+                                         gpointer       user_data);
+
+
+static GFile *
+internal_get_json_path (GyachtService *service)
+{
+  g_autofree gchar *json_path = NULL;
+  g_autofree gchar *file_dir = NULL;
+
+  /* TODO System level layer dir */
+  file_dir = gyacht_dup_user_layers_dir ();
+
+  json_path = g_build_filename (file_dir, MOUNTPOINTS_JSON, NULL);
+  return g_file_new_for_path (json_path);
+}
+
+static GObject *
+internal_parse_element (JsonNode *node)
+{
+  return (GObject *) gyacht_mount_parse_json_element (node);
+}
+
+static void
+internal_run_job (GyachtMountService *self)
+{
+  g_autoptr(GFile) location = NULL;
+
+  self->loading = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+
+  location = internal_get_json_path (GYACHT_SERVICE (self));
+  gyacht_service_stream_json_file_async (GYACHT_SERVICE (self),
+                                         location,
+                                         internal_parse_element,
+                                         internal_load_batch_cb,
+                                         NULL,
+                                         internal_load_json_callback,
+                                         NULL);
+}
+
+static void
+internal_execute_next_job (GyachtMountService *self)
+{
+  g_queue_pop_head (self->jobs);
+
+  if (!g_queue_is_empty (self->jobs))
+    internal_run_job (self);
+  else
+    gyacht_service_report_progress (GYACHT_SERVICE (self),
+                                    g_hash_table_size (self->mounts),
+                                    TRUE);
+}
+
+static void
+internal_load_batch_cb (GyachtService *service,
+                        GSequence     *batch,
+                        gpointer       user_data)
+{
+  GyachtMountService *self = GYACHT_MOUNT_SERVICE (service);
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (batch);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GyachtMount *mount = g_sequence_get (iter);
+
+      g_hash_table_insert (self->loading,
+                           (gpointer) gyacht_mount_get_id (mount),
+                           g_object_ref (mount));
+    }
+}
+
+static void
+internal_apply_loaded (GyachtMountService *self)
+{
+  g_autoptr(GPtrArray) removed = NULL;
+  g_autoptr(GPtrArray) changed = NULL;
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i;
+
+  removed = g_ptr_array_new_with_free_func (g_object_unref);
+  changed = g_ptr_array_new_with_free_func (g_object_unref);
+
+  g_hash_table_iter_init (&iter, self->mounts);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GyachtMount *fresh = g_hash_table_lookup (self->loading, key);
+
+      if (fresh == NULL)
+        {
+          g_ptr_array_add (removed, g_object_ref (value));
+          g_hash_table_iter_remove (&iter);
+          continue;
+        }
+
+      if (!gyacht_mount_equal (value, fresh))
+        g_ptr_array_add (changed, g_object_ref (fresh));
+
+      g_hash_table_remove (self->loading, key);
+    }
+
+  for (i = 0; i < removed->len; i++)
+    g_signal_emit_by_name (self, "item-removed", g_ptr_array_index (removed, i));
+
+  /* The keys belong to the mounts, they are replaced along */
+  for (i = 0; i < changed->len; i++)
+    {
+      GyachtMount *mount = g_ptr_array_index (changed, i);
+
+      g_hash_table_replace (self->mounts,
+                            (gpointer) gyacht_mount_get_id (mount),
+                            g_object_ref (mount));
+      g_signal_emit_by_name (self, "item-changed", mount);
+    }
+
+  g_hash_table_iter_init (&iter, self->loading);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      g_hash_table_insert (self->mounts, key, g_object_ref (value));
+      g_signal_emit_by_name (self, "item-added", value);
+    }
+
+  gyacht_debug ("%u mounts, %u removed, %u changed, %u added",
+                g_hash_table_size (self->mounts),
+                removed->len,
+                changed->len,
+                g_hash_table_size (self->loading));
+}
+
+static void
+internal_load_json_callback (GObject      *source_object,
+                             GAsyncResult *res,
+                             gpointer      user_data)
+{
+  GyachtMountService *self = GYACHT_MOUNT_SERVICE (source_object);
+  g_autoptr(GError) error = NULL;
+
+  /* No layer was mounted yet, or the last one was unmounted and removed */
+  if (!gyacht_service_stream_json_finish (GYACHT_SERVICE (self), res, &error) &&
+      !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+    gyacht_warn ("Unable to load json contents from file: %s",
+                 error->message);
+  else
+    {
+      internal_apply_loaded (self);
+      g_signal_emit_by_name (self, "list-updated", 0);
+    }
+
+  g_clear_pointer (&self->loading, g_hash_table_unref);
+  internal_execute_next_job (self);
+}
+
+static void
+internal_load_contents (GyachtMountService *self)
+{
+  GYACHT_TRACE_ENTRY;
+
+  /* A load is already waiting behind the running one */
+  if (g_queue_get_length (self->jobs) > 1)
+    {
+      GYACHT_TRACE_EXIT;
+      return;
+    }
+
+  g_queue_push_tail (self->jobs, GINT_TO_POINTER (ASYNC_JOB_LOAD));
+
+  /* Run if it has only one job in which is just pushed */
+  if (g_queue_get_length (self->jobs) == 1)
+    internal_run_job (self);
+
+  GYACHT_TRACE_EXIT;
+}
+
+/* --- GObject --- */
+static void
+gyacht_mount_service_finalize (GObject *object)
+{
+  GyachtMountService *self = GYACHT_MOUNT_SERVICE (object);
+
+  GYACHT_TRACE_ENTRY;
+
+  g_signal_handlers_disconnect_by_func (self,
+                                        G_CALLBACK (internal_load_contents),
+                                        NULL);
+
+  g_clear_pointer (&self->loading, g_hash_table_unref);
+  g_hash_table_unref (self->mounts);
+  g_queue_free (self->jobs);
+
+  GYACHT_TRACE_EXIT;
+
+  G_OBJECT_CLASS (gyacht_mount_service_parent_class)->finalize (object);
+}
+
+static void
+gyacht_mount_service_constructed (GObject *object)
+{
+  GyachtMountService *self = GYACHT_MOUNT_SERVICE (object);
+  GyachtService *service = GYACHT_SERVICE (object);
+
+  G_OBJECT_CLASS (gyacht_mount_service_parent_class)->constructed (object);
+
+  /* Like the layers, only the storage knows the mounts */
+  if (gyacht_service_get_source (service) == SOURCE_PODMAN_API ||
+      gyacht_service_error_occur (service))
+    {
+      gyacht_service_report_progress (service, 0, TRUE);
+      return;
+    }
+
+  g_signal_connect (self,
+                    "monitor-event-triggered",
+                    G_CALLBACK (internal_load_contents),
+                    NULL);
+
+  internal_load_contents (self);
+}
+
+static void
+gyacht_mount_service_class_init (GyachtMountServiceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GyachtServiceClass *service_class = GYACHT_SERVICE_CLASS (klass);
+
+  object_class->finalize = gyacht_mount_service_finalize;
+  object_class->constructed = gyacht_mount_service_constructed;
+
+  service_class->get_json_path = internal_get_json_path;
+
+  /* It is missing until a layer is first mounted */
+  service_class->json_optional = TRUE;
+}
+
+static void
+gyacht_mount_service_init (GyachtMountService *self)
+{
+  /* Keys are owned by the mounts */
+  self->mounts = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+  self->loading = NULL;
+  self->jobs = g_queue_new ();
+}
+
+/* --- Public APIs --- */
+GyachtMountService *
+gyacht_mount_service_new (GyachtRunLevel level)
+{
+  return g_object_new (GYACHT_TYPE_MOUNT_SERVICE,
+                       "run-level", level,
+                       NULL);
+}
+
+/**
+ * gyacht_mount_service_lookup:
+ * @self: A #GyachtMountService.
+ * @id: The id of a layer.
+ *
+ * Return value: (transfer none) (nullable): The mount state of the layer,
+ *   %NULL if it was never mounted.
+ */
+GyachtMount *
+gyacht_mount_service_lookup (GyachtMountService *self,
+                             const gchar        *id)
+{
+  g_return_val_if_fail (GYACHT_IS_MOUNT_SERVICE (self), NULL);
+
+  if (id == NULL)
+    return NULL;
+
+  return g_hash_table_lookup (self->mounts, id);
+}
@@ -0,0 +1,154 @@
+/* gyacht-mount.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-mount.h"
+
+/* A record of overlay-layers/mountpoints.json, the mount state of a
+ * layer. It never changes once created, like a #GyachtLayer.
+ */
+
+struct _GyachtMount
+{
+  GObject     parent_instance;
+
+  gchar       *id;          /* Of the layer */
+  gchar       *mountpoint;
+  guint       count;        /* Unmounted at 0 */
+};
+
+G_DEFINE_TYPE (GyachtMount, gyacht_mount, G_TYPE_OBJECT)
+
+
+/* --- GObject --- */
+static void
+gyacht_mount_finalize (GObject *object)
+{
+  GyachtMount *self = GYACHT_MOUNT (object);
+
+  g_free (self->id);
+  g_free (self->mountpoint);
+
+  G_OBJECT_CLASS (gyacht_mount_parent_class)->finalize (object);
+}
+
+static void
+gyacht_mount_class_init (GyachtMountClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_mount_finalize;
+}
+
+static void
+gyacht_mount_init (GyachtMount *self)
+{
+  self->count = 0;
+}
+
+/* --- Public APIs --- */
+GyachtMount *
+gyacht_mount_new (const gchar *id,
+                  const gchar *mountpoint,
+                  guint        count)
+{
+  GyachtMount *self;
+
+  g_return_val_if_fail (id != NULL, NULL);
+
+  self = g_object_new (GYACHT_TYPE_MOUNT, NULL);
+  self->id = g_strdup (id);
+  self->mountpoint = (mountpoint && *mountpoint) ? g_strdup (mountpoint) : NULL;
+  self->count = count;
+
+  return self;
+}
+
+/**
+ * gyacht_mount_parse_json_element:
+ * @element_node: An element of the array of mountpoints.json.
+ *
+ * It can be called from any thread.
+ *
+ * Return value: (transfer full) (nullable): A new #GyachtMount.
+ */
+GyachtMount *
+gyacht_mount_parse_json_element (JsonNode *element_node)
+{
+  JsonObject *elem;
+  JsonNode *member;
+  const gchar *id = NULL;
+  const gchar *mountpoint = NULL;
+  gint64 count = 0;
+
+  if (element_node == NULL || !JSON_NODE_HOLDS_OBJECT (element_node))
+    return NULL;
+
+  elem = json_node_get_object (element_node);
+
+  if (json_object_has_member (elem, "id"))
+    id = json_object_get_string_member (elem, "id");
+  if (id == NULL)
+    return NULL;
+  if (json_object_has_member (elem, "mountpoint"))
+    mountpoint = json_object_get_string_member (elem, "mountpoint");
+
+  member = json_object_get_member (elem, "mount-count");
+  if (member && json_node_get_value_type (member) == G_TYPE_INT64)
+    count = CLAMP (json_node_get_int (member), 0, G_MAXUINT);
+
+  return gyacht_mount_new (id, mountpoint, (guint) count);
+}
+
+gboolean
+gyacht_mount_equal (GyachtMount *self,
+                    GyachtMount *other)
+{
+  g_return_val_if_fail (GYACHT_IS_MOUNT (self), FALSE);
+  g_return_val_if_fail (GYACHT_IS_MOUNT (other), FALSE);
+
+  return g_strcmp0 (self->id, other->id) == 0 &&
+         g_strcmp0 (self->mountpoint, other->mountpoint) == 0 &&
+         self->count == other->count;
+}
+
+/* --- Getters --- */
+const gchar *
+gyacht_mount_get_id (GyachtMount *self)
+{
+  g_return_val_if_fail (GYACHT_IS_MOUNT (self), NULL);
+
+  return self->id;
+}
+
+const gchar *
+gyacht_mount_get_mountpoint (GyachtMount *self)
+{
+  g_return_val_if_fail (GYACHT_IS_MOUNT (self), NULL);
+
+  return self->mountpoint;
+}
+
+guint
+gyacht_mount_get_count (GyachtMount *self)
+{
+  g_return_val_if_fail (GYACHT_IS_MOUNT (self), 0);
+
+  return self->count;
+}
@@ -0,0 +1,42 @@
+/* gyacht-mount.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_MOUNT (gyacht_mount_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtMount, gyacht_mount, GYACHT, MOUNT, GObject)
+
+GyachtMount *   gyacht_mount_new                  (const gchar *id,
+                                                   const gchar *mountpoint,
+                                                   guint        count);
+GyachtMount *   gyacht_mount_parse_json_element   (JsonNode    *element_node);
+gboolean        gyacht_mount_equal                (GyachtMount *self,
+                                                   GyachtMount *other);
+const gchar *   gyacht_mount_get_id               (GyachtMount *self);
+const gchar *   gyacht_mount_get_mountpoint       (GyachtMount *self);
+guint           gyacht_mount_get_count            (GyachtMount *self);
+
+G_END_DECLS
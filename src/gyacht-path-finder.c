@@ -0,0 +1,281 @@
+/* gyacht-path-finder.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-path-finder.h"
+
+#include <glib/gi18n.h>
+#include <sys/stat.h>
+
+/* Looks a path up in every image. The query waits for the layers still
+ * being indexed, which the status tells meanwhile.
+ */
+
+#define SHORT_ID_LENGTH 12
+
+enum {
+  COLUMN_IMAGE = 0,
+  COLUMN_IMAGE_ID,
+  COLUMN_LAYER_ID,
+  COLUMN_SIZE,
+  N_COLUMNS
+};
+
+struct _GyachtPathFinder
+{
+  GtkWindow         parent_instance;
+
+  GyachtPathIndex   *index;
+  GCancellable      *cancellable;   /* Of the running query */
+
+  GtkWidget         *entry;
+  GtkWidget         *status_label;
+  GtkListStore      *store;
+};
+
+G_DEFINE_TYPE (GyachtPathFinder, gyacht_path_finder, GTK_TYPE_WINDOW)
+
+
+static void
+internal_update_progress (GyachtPathFinder *self)
+{
+  g_autofree gchar *text = NULL;
+  guint n_indexed;
+  guint n_layers;
+
+  if (self->cancellable == NULL)
+    return;
+
+  gyacht_path_index_get_progress (self->index, &n_indexed, &n_layers);
+  text = g_strdup_printf (_("Indexing layers… %u of %u"), n_indexed, n_layers);
+  gtk_label_set_text (GTK_LABEL (self->status_label), text);
+}
+
+static void
+internal_query_cb (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  g_autoptr(GPtrArray) matches = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *text = NULL;
+  GyachtPathFinder *self;
+  guint i;
+
+  matches = gyacht_path_index_query_finish (GYACHT_PATH_INDEX (source_object), res, &error);
+
+  /* Another path got looked up or the window is gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = GYACHT_PATH_FINDER (user_data);
+  g_clear_object (&self->cancellable);
+
+  if (matches == NULL)
+    {
+      gtk_label_set_text (GTK_LABEL (self->status_label), error->message);
+      return;
+    }
+
+  for (i = 0; i < matches->len; i++)
+    {
+      GyachtPathMatch *match = g_ptr_array_index (matches, i);
+      g_autofree gchar *layer_id = NULL;
+      g_autofree gchar *size = NULL;
+      const gchar *name;
+
+      name = gyacht_image_get_name (match->image);
+      layer_id = g_strndup (gyacht_layer_get_id (match->layer), SHORT_ID_LENGTH);
+      if (!S_ISDIR (match->mode) && !S_ISLNK (match->mode))
+        size = g_format_size (match->size);
+
+      gtk_list_store_insert_with_values (self->store, NULL, -1,
+                                         COLUMN_IMAGE, name ? name : _("<none>"),
+                                         COLUMN_IMAGE_ID, gyacht_image_get_short_id (match->image),
+                                         COLUMN_LAYER_ID, layer_id,
+                                         COLUMN_SIZE, size,
+                                         -1);
+    }
+
+  if (matches->len == 0)
+    text = g_strdup (_("No image contains this path"));
+  else
+    text = g_strdup_printf (ngettext ("Found in %u image", "Found in %u images", matches->len),
+                            matches->len);
+  gtk_label_set_text (GTK_LABEL (self->status_label), text);
+}
+
+static void
+internal_entry_activate_cb (GtkEntry         *entry,
+                            GyachtPathFinder *self)
+{
+  const gchar *path = gtk_entry_get_text (entry);
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+  gtk_list_store_clear (self->store);
+
+  if (*path == '\0')
+    {
+      gtk_label_set_text (GTK_LABEL (self->status_label), NULL);
+      return;
+    }
+
+  self->cancellable = g_cancellable_new ();
+  if (gyacht_path_index_is_complete (self->index))
+    gtk_label_set_text (GTK_LABEL (self->status_label), _("Searching…"));
+  else
+    internal_update_progress (self);
+
+  gyacht_path_index_query_async (self->index,
+                                 path,
+                                 self->cancellable,
+                                 internal_query_cb,
+                                 self);
+}
+
+static GtkTreeViewColumn *
+internal_create_text_column (const gchar *title,
+                             gint         column,
+                             gfloat       xalign,
+                             gboolean     expand)
+{
+  GtkTreeViewColumn *tree_column;
+  GtkCellRenderer *renderer;
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer,
+                "xalign", xalign,
+                "ellipsize", expand ? PANGO_ELLIPSIZE_END : PANGO_ELLIPSIZE_NONE,
+                NULL);
+
+  tree_column = gtk_tree_view_column_new_with_attributes (title, renderer,
+                                                          "text", column,
+                                                          NULL);
+  gtk_tree_view_column_set_expand (tree_column, expand);
+  gtk_tree_view_column_set_sort_column_id (tree_column, column);
+
+  return tree_column;
+}
+
+/* --- GObject --- */
+static void
+gyacht_path_finder_finalize (GObject *object)
+{
+  GyachtPathFinder *self = GYACHT_PATH_FINDER (object);
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+  g_clear_object (&self->index);
+  g_clear_object (&self->store);
+
+  G_OBJECT_CLASS (gyacht_path_finder_parent_class)->finalize (object);
+}
+
+static void
+gyacht_path_finder_class_init (GyachtPathFinderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_path_finder_finalize;
+}
+
+static void
+gyacht_path_finder_init (GyachtPathFinder *self)
+{
+  GtkWidget *header_bar;
+  GtkWidget *tree_view;
+  GtkWidget *scrolled;
+  GtkWidget *box;
+
+  gtk_window_set_default_size (GTK_WINDOW (self), 600, 400);
+
+  header_bar = gtk_header_bar_new ();
+  gtk_header_bar_set_show_close_button (GTK_HEADER_BAR (header_bar), TRUE);
+  gtk_header_bar_set_title (GTK_HEADER_BAR (header_bar), _("Find Path"));
+  gtk_window_set_titlebar (GTK_WINDOW (self), header_bar);
+
+  self->entry = gtk_search_entry_new ();
+  gtk_entry_set_placeholder_text (GTK_ENTRY (self->entry), _("Path within the images"));
+  gtk_widget_set_margin_start (self->entry, 6);
+  gtk_widget_set_margin_end (self->entry, 6);
+  gtk_widget_set_margin_top (self->entry, 6);
+  gtk_widget_set_margin_bottom (self->entry, 6);
+  g_signal_connect (self->entry,
+                    "activate",
+                    G_CALLBACK (internal_entry_activate_cb),
+                    self);
+
+  self->store = gtk_list_store_new (N_COLUMNS,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING,
+                                    G_TYPE_STRING);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (self->store));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view),
+                               internal_create_text_column (_("Image"), COLUMN_IMAGE, 0.0, TRUE));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view),
+                               internal_create_text_column (_("ID"), COLUMN_IMAGE_ID, 0.0, FALSE));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view),
+                               internal_create_text_column (_("Layer"), COLUMN_LAYER_ID, 0.0, FALSE));
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view),
+                               internal_create_text_column (_("Size"), COLUMN_SIZE, 1.0, FALSE));
+
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_vexpand (scrolled, TRUE);
+  gtk_container_add (GTK_CONTAINER (scrolled), tree_view);
+
+  self->status_label = gtk_label_new (NULL);
+  gtk_label_set_selectable (GTK_LABEL (self->status_label), TRUE);
+  gtk_widget_set_margin_top (self->status_label, 6);
+  gtk_widget_set_margin_bottom (self->status_label, 6);
+  gtk_style_context_add_class (gtk_widget_get_style_context (self->status_label),
+                               GTK_STYLE_CLASS_DIM_LABEL);
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_box_pack_start (GTK_BOX (box), self->entry, FALSE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (box), scrolled, TRUE, TRUE, 0);
+  gtk_box_pack_start (GTK_BOX (box), self->status_label, FALSE, TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (self), box);
+
+  gtk_widget_show_all (box);
+  gtk_widget_show (header_bar);
+}
+
+/* --- Public APIs --- */
+GtkWidget *
+gyacht_path_finder_new (GyachtPathIndex *index)
+{
+  GyachtPathFinder *self;
+
+  g_return_val_if_fail (GYACHT_IS_PATH_INDEX (index), NULL);
+
+  self = g_object_new (GYACHT_TYPE_PATH_FINDER, NULL);
+  self->index = g_object_ref (index);
+
+  g_signal_connect_object (index,
+                           "progress",
+                           G_CALLBACK (internal_update_progress),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  return GTK_WIDGET (self);
+}
@@ -0,0 +1,594 @@
+/* gyacht-path-index.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-layer-index.h"
+#include "gyacht-path-index.h"
+
+#include <string.h>
+
+/* Answers which images contain a path. This is not an inverted index but
+ * a forward one per layer: the sorted listings which
+ * gyacht_layer_index_load() caches on the disk and maps. A query walks the
+ * layer chain of every image down to the first layer which adds or hides
+ * the path, which costs a binary search of the path and of each of its
+ * hiders in every layer visited; the first query after a start maps every
+ * cached listing.
+ *
+ * Layers are indexed on a pool as they come, and dropped as they go. A
+ * layer without a diff digest, the one of a container or of a pull which
+ * is not complete, has no listing: it is kept as such until it gets a
+ * digest. A listing which fails to load is retried on the next sync.
+ */
+
+#define WHITEOUT_PREFIX   ".wh."
+#define OPAQUE_WHITEOUT   ".wh..wh..opq"
+
+typedef enum
+{
+  PATH_STATE_NONE = 0,
+  PATH_STATE_ADDED,
+  PATH_STATE_REMOVED
+} PathState;
+
+typedef struct
+{
+  PathState         state;
+  GyachtLayerIndex  *index;   /* Where the path is added */
+  gint              entry;
+} LayerState;
+
+enum {
+  PROGRESS,
+  N_SIGNALS
+};
+
+struct _GyachtPathIndex
+{
+  GObject             parent_instance;
+
+  GyachtLayerService  *layers;
+  GyachtImageService  *images;
+
+  GHashTable          *indexes;   /* layer id -> GyachtLayerIndex, NULL if not listed */
+  GHashTable          *pending;   /* layer id -> GyachtLayer being indexed */
+  GThreadPool         *pool;
+  GCancellable        *cancellable;
+  GList               *waiting;   /* GTask of queries, until the index is complete */
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtPathIndex, gyacht_path_index, G_TYPE_OBJECT)
+
+
+static void
+internal_layer_index_unref (gpointer data)
+{
+  if (data)
+    gyacht_layer_index_unref (data);
+}
+
+static void
+internal_path_match_free (gpointer data)
+{
+  GyachtPathMatch *match = data;
+
+  g_object_unref (match->image);
+  g_object_unref (match->layer);
+  g_free (match);
+}
+
+/* What hides @path in a layer: a whiteout of it or of any directory above
+ * it, or an opaque directory above it.
+ */
+static GPtrArray *
+internal_dup_hiders (const gchar *path)
+{
+  GPtrArray *hiders = g_ptr_array_new_with_free_func (g_free);
+  const gchar *start = path;
+  const gchar *slash;
+
+  for (;;)
+    {
+      g_autofree gchar *dir = g_strndup (path, start - path);
+
+      slash = strchr (start, '/');
+      if (slash == NULL)
+        {
+          g_ptr_array_add (hiders, g_strconcat (dir, WHITEOUT_PREFIX, start, NULL));
+          break;
+        }
+
+      g_ptr_array_add (hiders, g_strdup_printf ("%s" WHITEOUT_PREFIX "%.*s",
+                                                dir, (gint) (slash - start), start));
+      g_ptr_array_add (hiders, g_strdup_printf ("%.*s/" OPAQUE_WHITEOUT,
+                                                (gint) (slash - path), path));
+      start = slash + 1;
+    }
+
+  return hiders;
+}
+
+/* Entries of the layer itself take precedence over its whiteouts */
+static LayerState *
+internal_get_layer_state (GyachtPathIndex *self,
+                          GHashTable      *states,
+                          const gchar     *layer_id,
+                          const gchar     *path,
+                          GPtrArray       *hiders)
+{
+  GyachtLayerIndex *index;
+  LayerState *state;
+  guint i;
+
+  state = g_hash_table_lookup (states, layer_id);
+  if (state)
+    return state;
+
+  state = g_new0 (LayerState, 1);
+  g_hash_table_insert (states, (gpointer) layer_id, state);
+
+  index = g_hash_table_lookup (self->indexes, layer_id);
+  if (index == NULL)
+    return state;
+
+  state->entry = gyacht_layer_index_lookup (index, path);
+  if (state->entry >= 0)
+    {
+      state->state = PATH_STATE_ADDED;
+      state->index = index;
+      return state;
+    }
+
+  for (i = 0; i < hiders->len; i++)
+    if (gyacht_layer_index_lookup (index, g_ptr_array_index (hiders, i)) >= 0)
+      {
+        state->state = PATH_STATE_REMOVED;
+        break;
+      }
+
+  return state;
+}
+
+static GPtrArray *
+internal_query (GyachtPathIndex *self,
+                const gchar     *path)
+{
+  g_autoptr(GPtrArray) hiders = NULL;
+  g_autoptr(GHashTable) states = NULL;
+  GPtrArray *matches;
+  GSequence *images;
+  GSequenceIter *iter;
+
+  matches = g_ptr_array_new_with_free_func (internal_path_match_free);
+
+  images = gyacht_image_service_get_images (self->images);
+  if (images == NULL)
+    return matches;
+
+  hiders = internal_dup_hiders (path);
+  states = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+
+  for (iter = g_sequence_get_begin_iter (images);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GyachtImage *image = g_sequence_get (iter);
+      GyachtLayer *layer;
+
+      /* The topmost layer mentioning the path tells */
+      layer = gyacht_layer_service_lookup (self->layers, gyacht_image_get_layer (image));
+      while (layer)
+        {
+          LayerState *state = internal_get_layer_state (self, states,
+                                                        gyacht_layer_get_id (layer),
+                                                        path, hiders);
+
+          if (state->state == PATH_STATE_ADDED)
+            {
+              GyachtPathMatch *match = g_new0 (GyachtPathMatch, 1);
+
+              match->image = g_object_ref (image);
+              match->layer = g_object_ref (layer);
+              match->size = gyacht_layer_index_get_size (state->index, state->entry);
+              match->mode = gyacht_layer_index_get_mode (state->index, state->entry);
+              g_ptr_array_add (matches, match);
+              break;
+            }
+
+          if (state->state == PATH_STATE_REMOVED)
+            break;
+
+          layer = gyacht_layer_service_lookup (self->layers, gyacht_layer_get_parent (layer));
+        }
+    }
+
+  return matches;
+}
+
+static void
+internal_return_waiting (GyachtPathIndex *self)
+{
+  GList *waiting = g_steal_pointer (&self->waiting);
+  GList *l;
+
+  for (l = waiting; l; l = l->next)
+    {
+      const gchar *path = g_task_get_task_data (l->data);
+
+      g_task_return_pointer (l->data,
+                             internal_query (self, path),
+                             (GDestroyNotify) g_ptr_array_unref);
+    }
+  g_list_free_full (waiting, g_object_unref);
+}
+
+static void
+internal_progress (GyachtPathIndex *self)
+{
+  g_signal_emit (self, signals [PROGRESS], 0);
+
+  if (self->waiting && gyacht_path_index_is_complete (self))
+    internal_return_waiting (self);
+}
+
+static void
+internal_index_thread (gpointer data,
+                       gpointer user_data)
+{
+  GTask *task = data;
+  GyachtLayer *layer = g_task_get_task_data (task);
+  GyachtLayerIndex *index;
+  GError *error = NULL;
+
+  if (!g_task_return_error_if_cancelled (task))
+    {
+      index = gyacht_layer_index_load (layer, g_task_get_cancellable (task), &error);
+      if (index)
+        g_task_return_pointer (task, index, (GDestroyNotify) gyacht_layer_index_unref);
+      else
+        g_task_return_error (task, error);
+    }
+
+  g_object_unref (task);
+}
+
+static void
+internal_layer_indexed_cb (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+  GyachtLayer *layer = g_task_get_task_data (G_TASK (res));
+  const gchar *id = gyacht_layer_get_id (layer);
+  g_autoptr(GyachtLayerIndex) index = NULL;
+  g_autoptr(GError) error = NULL;
+  GyachtPathIndex *self;
+
+  index = g_task_propagate_pointer (G_TASK (res), &error);
+
+  /* The index is gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = GYACHT_PATH_INDEX (user_data);
+
+  /* Removed meanwhile */
+  if (!g_hash_table_contains (self->pending, id))
+    return;
+
+  if (index == NULL)
+    {
+      gyacht_debug ("Layer %s is not indexed: %s", id, error->message);
+
+      /* Not written completely yet, or not readable for now */
+      if (gyacht_layer_get_diff_digest (layer) != NULL)
+        {
+          g_hash_table_remove (self->pending, id);
+          internal_progress (self);
+          return;
+        }
+    }
+
+  g_hash_table_insert (self->indexes, g_strdup (id), g_steal_pointer (&index));
+  g_hash_table_remove (self->pending, id);
+
+  internal_progress (self);
+}
+
+static void
+internal_queue_layer (GyachtPathIndex *self,
+                      GyachtLayer     *layer)
+{
+  GTask *task;
+
+  g_hash_table_insert (self->pending,
+                       (gpointer) gyacht_layer_get_id (layer),
+                       g_object_ref (layer));
+
+  task = g_task_new (NULL, self->cancellable, internal_layer_indexed_cb, self);
+  g_task_set_source_tag (task, internal_queue_layer);
+  g_task_set_task_data (task, g_object_ref (layer), g_object_unref);
+  g_thread_pool_push (self->pool, task, NULL);
+}
+
+/* Only the layers which came or went are indexed or dropped */
+static void
+internal_sync_layers (GyachtPathIndex *self)
+{
+  g_autoptr(GPtrArray) layers = NULL;
+  g_autoptr(GHashTable) current = NULL;
+  GHashTableIter iter;
+  gpointer key;
+  guint i;
+
+  layers = gyacht_layer_service_dup_layers (self->layers);
+  current = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < layers->len; i++)
+    {
+      GyachtLayer *layer = g_ptr_array_index (layers, i);
+      const gchar *id = gyacht_layer_get_id (layer);
+      gpointer index;
+
+      g_hash_table_add (current, (gpointer) id);
+
+      /* A layer without a listing gets one with its diff digest */
+      if (g_hash_table_lookup_extended (self->indexes, id, NULL, &index))
+        {
+          if (index || gyacht_layer_get_diff_digest (layer) == NULL)
+            continue;
+          g_hash_table_remove (self->indexes, id);
+        }
+
+      if (!g_hash_table_contains (self->pending, id))
+        internal_queue_layer (self, layer);
+    }
+
+  g_hash_table_iter_init (&iter, self->indexes);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    if (!g_hash_table_contains (current, key))
+      g_hash_table_iter_remove (&iter);
+
+  g_hash_table_iter_init (&iter, self->pending);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    if (!g_hash_table_contains (current, key))
+      g_hash_table_iter_remove (&iter);
+
+  gyacht_debug ("%u layers indexed, %u pending",
+                g_hash_table_size (self->indexes),
+                g_hash_table_size (self->pending));
+
+  internal_progress (self);
+}
+
+static void
+internal_load_progress_cb (GyachtPathIndex *self,
+                           guint            n_items,
+                           gboolean         done)
+{
+  if (done)
+    internal_progress (self);
+}
+
+/* --- GObject --- */
+static void
+gyacht_path_index_finalize (GObject *object)
+{
+  GyachtPathIndex *self = GYACHT_PATH_INDEX (object);
+
+  g_signal_handlers_disconnect_by_func (self->layers,
+                                        G_CALLBACK (internal_sync_layers),
+                                        self);
+  g_signal_handlers_disconnect_by_func (self->layers,
+                                        G_CALLBACK (internal_load_progress_cb),
+                                        self);
+  g_signal_handlers_disconnect_by_func (self->images,
+                                        G_CALLBACK (internal_load_progress_cb),
+                                        self);
+
+  /* Queued layers return at once, their callbacks see the cancellation */
+  g_cancellable_cancel (self->cancellable);
+  g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_object_unref (self->cancellable);
+
+  g_hash_table_unref (self->indexes);
+  g_hash_table_unref (self->pending);
+  g_object_unref (self->layers);
+  g_object_unref (self->images);
+
+  G_OBJECT_CLASS (gyacht_path_index_parent_class)->finalize (object);
+}
+
+static void
+gyacht_path_index_class_init (GyachtPathIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_path_index_finalize;
+
+  signals [PROGRESS] =
+    g_signal_new ("progress",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_path_index_init (GyachtPathIndex *self)
+{
+  self->indexes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free, internal_layer_index_unref);
+  self->pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL, g_object_unref);
+  self->cancellable = g_cancellable_new ();
+
+  /* Mapping a cached listing is cheap, building one is bound by the CPU */
+  self->pool = g_thread_pool_new (internal_index_thread,
+                                  self,
+                                  g_get_num_processors (),
+                                  FALSE,
+                                  NULL);
+}
+
+/* --- Public APIs --- */
+GyachtPathIndex *
+gyacht_path_index_new (GyachtLayerService *layers,
+                       GyachtImageService *images)
+{
+  GyachtPathIndex *self;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (layers), NULL);
+  g_return_val_if_fail (GYACHT_IS_IMAGE_SERVICE (images), NULL);
+
+  self = g_object_new (GYACHT_TYPE_PATH_INDEX, NULL);
+  self->layers = g_object_ref (layers);
+  self->images = g_object_ref (images);
+
+  g_signal_connect_swapped (layers,
+                            "list-updated",
+                            G_CALLBACK (internal_sync_layers),
+                            self);
+  g_signal_connect_swapped (layers,
+                            "load-progress",
+                            G_CALLBACK (internal_load_progress_cb),
+                            self);
+  g_signal_connect_swapped (images,
+                            "load-progress",
+                            G_CALLBACK (internal_load_progress_cb),
+                            self);
+
+  if (gyacht_service_is_loaded (GYACHT_SERVICE (layers)))
+    internal_sync_layers (self);
+
+  return self;
+}
+
+/* Whether every known layer and image is accounted */
+gboolean
+gyacht_path_index_is_complete (GyachtPathIndex *self)
+{
+  g_return_val_if_fail (GYACHT_IS_PATH_INDEX (self), FALSE);
+
+  return gyacht_service_is_loaded (GYACHT_SERVICE (self->layers)) &&
+         gyacht_service_is_loaded (GYACHT_SERVICE (self->images)) &&
+         g_hash_table_size (self->pending) == 0;
+}
+
+void
+gyacht_path_index_get_progress (GyachtPathIndex *self,
+                                guint           *n_indexed,
+                                guint           *n_layers)
+{
+  g_return_if_fail (GYACHT_IS_PATH_INDEX (self));
+
+  if (n_indexed)
+    *n_indexed = g_hash_table_size (self->indexes);
+  if (n_layers)
+    *n_layers = g_hash_table_size (self->indexes) + g_hash_table_size (self->pending);
+}
+
+/**
+ * gyacht_path_index_query:
+ * @self: a #GyachtPathIndex
+ * @path: an absolute path within the images
+ *
+ * Answers from the layers indexed so far, see
+ * gyacht_path_index_query_async() to wait for all of them.
+ *
+ * Return value: (transfer full) (element-type GyachtPathMatch): The
+ *   images containing @path, in the order of the image service.
+ */
+GPtrArray *
+gyacht_path_index_query (GyachtPathIndex *self,
+                         const gchar     *path)
+{
+  g_autofree gchar *normalized = NULL;
+
+  g_return_val_if_fail (GYACHT_IS_PATH_INDEX (self), NULL);
+  g_return_val_if_fail (path != NULL, NULL);
+
+  normalized = gyacht_layer_index_dup_normalized_path (path);
+  if (normalized == NULL)
+    return g_ptr_array_new_with_free_func (internal_path_match_free);
+
+  return internal_query (self, normalized);
+}
+
+void
+gyacht_path_index_query_async (GyachtPathIndex     *self,
+                               const gchar         *path,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  gchar *normalized;
+
+  g_return_if_fail (GYACHT_IS_PATH_INDEX (self));
+  g_return_if_fail (path != NULL);
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_path_index_query_async);
+
+  /* The layers are not known then */
+  if (gyacht_service_get_source (GYACHT_SERVICE (self->layers)) == SOURCE_PODMAN_API)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_SUPPORTED,
+                               "Paths are looked up only when the storage is read directly");
+      return;
+    }
+
+  normalized = gyacht_layer_index_dup_normalized_path (path);
+  if (normalized == NULL)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_ARGUMENT,
+                               "No path to look up");
+      return;
+    }
+  g_task_set_task_data (task, normalized, g_free);
+
+  if (gyacht_path_index_is_complete (self))
+    {
+      g_task_return_pointer (task,
+                             internal_query (self, normalized),
+                             (GDestroyNotify) g_ptr_array_unref);
+      return;
+    }
+
+  self->waiting = g_list_append (self->waiting, g_steal_pointer (&task));
+}
+
+GPtrArray *
+gyacht_path_index_query_finish (GyachtPathIndex  *self,
+                                GAsyncResult     *res,
+                                GError          **error)
+{
+  g_return_val_if_fail (GYACHT_IS_PATH_INDEX (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
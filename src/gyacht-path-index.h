@@ -0,0 +1,60 @@
+/* gyacht-path-index.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "gyacht-image-service.h"
+#include "gyacht-layer-service.h"
+
+G_BEGIN_DECLS
+
+/* An image containing a path, and the layer of it which adds the path */
+typedef struct
+{
+  GyachtImage *image;
+  GyachtLayer *layer;
+  guint64     size;
+  guint32     mode;
+} GyachtPathMatch;
+
+#define GYACHT_TYPE_PATH_INDEX (gyacht_path_index_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtPathIndex, gyacht_path_index, GYACHT, PATH_INDEX, GObject)
+
+GyachtPathIndex * gyacht_path_index_new           (GyachtLayerService   *layers,
+                                                   GyachtImageService   *images);
+gboolean          gyacht_path_index_is_complete   (GyachtPathIndex      *self);
+void              gyacht_path_index_get_progress  (GyachtPathIndex      *self,
+                                                   guint                *n_indexed,
+                                                   guint                *n_layers);
+GPtrArray *       gyacht_path_index_query         (GyachtPathIndex      *self,
+                                                   const gchar          *path);
+void              gyacht_path_index_query_async   (GyachtPathIndex      *self,
+                                                   const gchar          *path,
+                                                   GCancellable         *cancellable,
+                                                   GAsyncReadyCallback   callback,
+                                                   gpointer              user_data);
+GPtrArray *       gyacht_path_index_query_finish  (GyachtPathIndex      *self,
+                                                   GAsyncResult         *res,
+                                                   GError              **error);
+
+G_END_DECLS
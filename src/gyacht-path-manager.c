@@ -21,8 +21,16 @@
 #include "gyacht-debug.h"
 #include "gyacht-path-manager.h"
 
+#define USER_OVERLAY              "containers/storage/overlay"
 #define USER_OVERLAY_CONTAINERS   "containers/storage/overlay-containers"
 #define USER_OVERLAY_IMAGES       "containers/storage/overlay-images"
+#define USER_OVERLAY_LAYERS       "containers/storage/overlay-layers"
+/* Both are relative to $XDG_RUNTIME_DIR */
+#define USER_RUN_CONTAINERS       "containers/overlay-containers"
+#define USER_LIBPOD_EXITS         "libpod/tmp/exits"
+#define USER_LIBPOD_EVENTS        "libpod/tmp/events"
+/* Relative to $XDG_CACHE_HOME */
+#define USER_CACHE                "gyacht"
 
 static gchar *
 internal_build_container_filename (void)
@@ -44,6 +52,58 @@ internal_build_image_filename (void)
                            NULL);
 }
 
+static gchar *
+internal_build_layer_filename (void)
+{
+  return g_build_filename (g_get_home_dir (),
+                           ".local",
+                           "share",
+                           USER_OVERLAY_LAYERS,
+                           NULL);
+}
+
+static gchar *
+internal_build_overlay_filename (void)
+{
+  return g_build_filename (g_get_home_dir (),
+                           ".local",
+                           "share",
+                           USER_OVERLAY,
+                           NULL);
+}
+
+static gchar *
+internal_build_run_container_filename (void)
+{
+  return g_build_filename (g_get_user_runtime_dir (),
+                           USER_RUN_CONTAINERS,
+                           NULL);
+}
+
+static gchar *
+internal_build_exits_filename (void)
+{
+  return g_build_filename (g_get_user_runtime_dir (),
+                           USER_LIBPOD_EXITS,
+                           NULL);
+}
+
+static gchar *
+internal_build_events_filename (void)
+{
+  return g_build_filename (g_get_user_runtime_dir (),
+                           USER_LIBPOD_EVENTS,
+                           NULL);
+}
+
+static gchar *
+internal_build_cache_filename (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           USER_CACHE,
+                           NULL);
+}
+
 /* --- Public APIs --- */
 gchar *
 gyacht_dup_user_containers_dir (void)
@@ -56,3 +116,39 @@ gyacht_dup_user_images_dir (void)
 {
   return internal_build_image_filename ();
 }
+
+gchar *
+gyacht_dup_user_layers_dir (void)
+{
+  return internal_build_layer_filename ();
+}
+
+gchar *
+gyacht_dup_user_overlay_dir (void)
+{
+  return internal_build_overlay_filename ();
+}
+
+gchar *
+gyacht_dup_user_run_containers_dir (void)
+{
+  return internal_build_run_container_filename ();
+}
+
+gchar *
+gyacht_dup_user_exits_dir (void)
+{
+  return internal_build_exits_filename ();
+}
+
+gchar *
+gyacht_dup_user_events_dir (void)
+{
+  return internal_build_events_filename ();
+}
+
+gchar *
+gyacht_dup_user_cache_dir (void)
+{
+  return internal_build_cache_filename ();
+}
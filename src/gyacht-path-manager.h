@@ -26,8 +26,23 @@ G_BEGIN_DECLS
 
 #define CONTAINERS_JSON           "containers.json"
 #define IMAGES_JSON               "images.json"
+#define LAYERS_JSON               "layers.json"
+#define MOUNTPOINTS_JSON          "mountpoints.json"
+#define USERDATA_DIR              "userdata"
+#define CONFIG_JSON               "config.json"
+#define PIDFILE                   "pidfile"
+#define EVENTS_LOG                "events.log"
+#define OVERLAY_DIFF              "diff"
+#define TAR_SPLIT_SUFFIX          ".tar-split.gz"
+#define LAYER_INDEX_DIR           "layer-index"
 
-gchar * gyacht_dup_user_containers_dir  (void);
-gchar * gyacht_dup_user_images_dir      (void);
+gchar * gyacht_dup_user_containers_dir      (void);
+gchar * gyacht_dup_user_images_dir          (void);
+gchar * gyacht_dup_user_layers_dir          (void);
+gchar * gyacht_dup_user_overlay_dir         (void);
+gchar * gyacht_dup_user_run_containers_dir  (void);
+gchar * gyacht_dup_user_exits_dir           (void);
+gchar * gyacht_dup_user_events_dir          (void);
+gchar * gyacht_dup_user_cache_dir           (void);
 
 G_END_DECLS
@@ -0,0 +1,848 @@
+/* gyacht-podman-client.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-podman-client.h"
+
+#include <gio/gunixsocketaddress.h>
+#include <string.h>
+
+/* A minimal HTTP/1.1 client for the libpod REST API which is served on a
+ * unix socket by `podman system service`. It only knows about GET requests,
+ * which is all we need to read containers and images.
+ *
+ * Requests share one kept-alive connection and are meant to be issued from
+ * worker threads. Events are streamed on a connection of their own by a
+ * dedicated thread, and emitted on the main context.
+ *
+ * To exercise it, run `podman system service --time=0` and start the
+ * application with --podman-api; `podman run`, `podman stop` and
+ * `podman rm` then show up as events and single-container requests.
+ */
+
+#define PODMAN_SOCKET       "podman/podman.sock"
+#define EVENTS_RETRY_DELAY  5   /* seconds */
+
+#define GYACHT_PODMAN_CLIENT_ERROR (gyacht_podman_client_error_quark())
+
+typedef struct
+{
+  guint     status;
+  gboolean  chunked;
+  gint64    length;
+  gboolean  close;
+} Response;
+
+typedef struct
+{
+  GyachtPodmanClient  *client;
+  gchar               *type;
+  gchar               *action;
+  gchar               *id;
+  gchar               *name;
+  gchar               *image;
+  gint                exit_code;
+} ApiEvent;
+
+struct _GyachtPodmanClient
+{
+  GObject           parent_instance;
+
+  GSocketAddress    *address;
+  GSocketClient     *socket_client;
+
+  /* The kept-alive connection for requests, guarded by lock */
+  GMutex            lock;
+  GSocketConnection *connection;
+  GDataInputStream  *input;
+
+  /* The events stream */
+  GMainContext      *context;
+  GThread           *events_thread;
+  GCancellable      *events_cancellable;
+  guint             n_watchers;
+};
+
+/* Signals */
+enum {
+  EVENT,
+  RESYNC_NEEDED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+static GyachtPodmanClient *default_client = NULL;
+
+G_DEFINE_TYPE (GyachtPodmanClient, gyacht_podman_client, G_TYPE_OBJECT)
+
+
+static GQuark
+gyacht_podman_client_error_quark (void)
+{
+  return g_quark_from_static_string ("gyacht-podman-client-error-quark");
+}
+
+/* --- HTTP --- */
+static gboolean
+internal_open (GyachtPodmanClient  *self,
+               GSocketConnection  **connection,
+               GDataInputStream   **input,
+               GCancellable        *cancellable,
+               GError             **error)
+{
+  GInputStream *base;
+
+  *connection = g_socket_client_connect (self->socket_client,
+                                         G_SOCKET_CONNECTABLE (self->address),
+                                         cancellable,
+                                         error);
+  if (*connection == NULL)
+    return FALSE;
+
+  base = g_io_stream_get_input_stream (G_IO_STREAM (*connection));
+  *input = g_data_input_stream_new (base);
+  g_data_input_stream_set_newline_type (*input, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+  g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (*input), FALSE);
+
+  return TRUE;
+}
+
+static void
+internal_close (GSocketConnection **connection,
+                GDataInputStream  **input)
+{
+  g_clear_object (input);
+
+  if (*connection)
+    g_io_stream_close (G_IO_STREAM (*connection), NULL, NULL);
+  g_clear_object (connection);
+}
+
+static gboolean
+internal_send_request (GSocketConnection  *connection,
+                       const gchar        *path,
+                       GCancellable       *cancellable,
+                       GError            **error)
+{
+  g_autofree gchar *request = NULL;
+  GOutputStream *output;
+
+  request = g_strdup_printf ("GET %s HTTP/1.1\r\n"
+                             "Host: d\r\n"
+                             "Accept: application/json\r\n"
+                             "\r\n",
+                             path);
+
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  return g_output_stream_write_all (output, request, strlen (request),
+                                    NULL, cancellable, error);
+}
+
+static gchar *
+internal_read_line (GDataInputStream  *input,
+                    GCancellable      *cancellable,
+                    GError           **error)
+{
+  GError *local_error = NULL;
+  gchar *line;
+
+  line = g_data_input_stream_read_line (input, NULL, cancellable, &local_error);
+  if (line == NULL && local_error == NULL)
+    local_error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED,
+                                       "Connection closed by podman");
+  if (local_error)
+    g_propagate_error (error, local_error);
+
+  return line;
+}
+
+static gboolean
+internal_read_exactly (GDataInputStream  *input,
+                       guint8            *buffer,
+                       gsize              count,
+                       GCancellable      *cancellable,
+                       GError           **error)
+{
+  gsize bytes_read = 0;
+
+  if (!g_input_stream_read_all (G_INPUT_STREAM (input), buffer, count,
+                                &bytes_read, cancellable, error))
+    return FALSE;
+
+  if (bytes_read != count)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED,
+                           "Connection closed by podman");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+internal_read_head (GDataInputStream  *input,
+                    Response          *response,
+                    GCancellable      *cancellable,
+                    GError           **error)
+{
+  g_autofree gchar *status_line = NULL;
+
+  response->status = 0;
+  response->chunked = FALSE;
+  response->length = -1;
+  response->close = FALSE;
+
+  status_line = internal_read_line (input, cancellable, error);
+  if (status_line == NULL)
+    return FALSE;
+
+  if (!g_str_has_prefix (status_line, "HTTP/1.") || strlen (status_line) < 12)
+    {
+      g_set_error (error, GYACHT_PODMAN_CLIENT_ERROR, 0,
+                   "Malformed status line: %s", status_line);
+      return FALSE;
+    }
+
+  response->status = (guint) g_ascii_strtoull (status_line + 9, NULL, 10);
+
+  for (;;)
+    {
+      g_autofree gchar *line = NULL;
+      gchar *value;
+
+      line = internal_read_line (input, cancellable, error);
+      if (line == NULL)
+        return FALSE;
+
+      /* End of the header */
+      if (*line == '\0')
+        break;
+
+      value = strchr (line, ':');
+      if (value == NULL)
+        continue;
+
+      *value++ = '\0';
+      g_strstrip (value);
+
+      if (g_ascii_strcasecmp (line, "Content-Length") == 0)
+        response->length = g_ascii_strtoll (value, NULL, 10);
+      else if (g_ascii_strcasecmp (line, "Transfer-Encoding") == 0)
+        response->chunked = (strstr (value, "chunked") != NULL);
+      else if (g_ascii_strcasecmp (line, "Connection") == 0)
+        response->close = (g_ascii_strcasecmp (value, "close") == 0);
+    }
+
+  return TRUE;
+}
+
+/* Return value: the size of the next chunk, or -1 on failure */
+static gint64
+internal_read_chunk_size (GDataInputStream  *input,
+                          GCancellable      *cancellable,
+                          GError           **error)
+{
+  g_autofree gchar *line = NULL;
+
+  line = internal_read_line (input, cancellable, error);
+  if (line == NULL)
+    return -1;
+
+  /* Chunk extensions after ';' are ignored by strtoull */
+  return (gint64) g_ascii_strtoull (line, NULL, 16);
+}
+
+static GBytes *
+internal_read_body (GDataInputStream  *input,
+                    Response          *response,
+                    GCancellable      *cancellable,
+                    GError           **error)
+{
+  g_autoptr(GByteArray) body = g_byte_array_new ();
+
+  if (response->chunked)
+    {
+      for (;;)
+        {
+          g_autofree gchar *crlf = NULL;
+          gint64 size;
+          guint old_len;
+
+          size = internal_read_chunk_size (input, cancellable, error);
+          if (size < 0)
+            return NULL;
+
+          if (size == 0)
+            {
+              /* Skip the trailer */
+              for (;;)
+                {
+                  g_autofree gchar *line = internal_read_line (input, cancellable, error);
+
+                  if (line == NULL)
+                    return NULL;
+                  if (*line == '\0')
+                    break;
+                }
+              break;
+            }
+
+          old_len = body->len;
+          g_byte_array_set_size (body, old_len + size);
+          if (!internal_read_exactly (input, body->data + old_len, size,
+                                      cancellable, error))
+            return NULL;
+
+          crlf = internal_read_line (input, cancellable, error);
+          if (crlf == NULL)
+            return NULL;
+        }
+    }
+  else if (response->length >= 0)
+    {
+      g_byte_array_set_size (body, response->length);
+      if (!internal_read_exactly (input, body->data, response->length,
+                                  cancellable, error))
+        return NULL;
+    }
+  else
+    {
+      /* Neither a length nor chunks, the body ends with the connection */
+      guint8 buffer[4096];
+      gssize n;
+
+      while ((n = g_input_stream_read (G_INPUT_STREAM (input), buffer, sizeof buffer,
+                                       cancellable, error)) > 0)
+        g_byte_array_append (body, buffer, n);
+
+      if (n < 0)
+        return NULL;
+
+      response->close = TRUE;
+    }
+
+  return g_byte_array_free_to_bytes (g_steal_pointer (&body));
+}
+
+static GBytes *
+internal_request (GyachtPodmanClient  *self,
+                  const gchar         *path,
+                  guint               *status,
+                  GCancellable        *cancellable,
+                  GError             **error)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->lock);
+  guint attempt;
+
+  for (attempt = 0; attempt < 2; attempt++)
+    {
+      GError *local_error = NULL;
+      Response response;
+      gboolean reused;
+      GBytes *body;
+
+      reused = (self->connection != NULL);
+      if (!reused &&
+          !internal_open (self, &self->connection, &self->input, cancellable, error))
+        return NULL;
+
+      if (!internal_send_request (self->connection, path, cancellable, &local_error) ||
+          !internal_read_head (self->input, &response, cancellable, &local_error))
+        goto failed;
+
+      body = internal_read_body (self->input, &response, cancellable, &local_error);
+      if (body == NULL)
+        goto failed;
+
+      if (response.close)
+        internal_close (&self->connection, &self->input);
+
+      *status = response.status;
+      return body;
+
+failed:
+      internal_close (&self->connection, &self->input);
+
+      /* podman may have closed the idle connection meanwhile, retry once */
+      if (reused && !g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          gyacht_debug ("Reconnecting: %s", local_error->message);
+          g_clear_error (&local_error);
+          continue;
+        }
+
+      g_propagate_error (error, local_error);
+      return NULL;
+    }
+
+  g_set_error (error, GYACHT_PODMAN_CLIENT_ERROR, 0,
+               "Unable to request %s", path);
+  return NULL;
+}
+
+/* --- Events --- */
+static void
+internal_api_event_free (gpointer data)
+{
+  ApiEvent *event = data;
+
+  g_object_unref (event->client);
+  g_free (event->type);
+  g_free (event->action);
+  g_free (event->id);
+  g_free (event->name);
+  g_free (event->image);
+  g_free (event);
+}
+
+static gboolean
+internal_emit_event_cb (gpointer data)
+{
+  ApiEvent *event = data;
+
+  g_signal_emit (event->client, signals[EVENT], 0,
+                 event->type,
+                 event->action,
+                 event->id,
+                 event->name,
+                 event->image,
+                 event->exit_code);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+internal_emit_resync_cb (gpointer data)
+{
+  g_signal_emit (GYACHT_PODMAN_CLIENT (data), signals[RESYNC_NEEDED], 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+static const gchar *
+internal_get_string_member (JsonObject  *object,
+                            const gchar *member_name)
+{
+  JsonNode *node;
+
+  if (object == NULL)
+    return NULL;
+
+  node = json_object_get_member (object, member_name);
+  if (node == NULL || json_node_get_value_type (node) != G_TYPE_STRING)
+    return NULL;
+
+  return json_node_get_string (node);
+}
+
+static JsonObject *
+internal_get_object_member (JsonObject  *object,
+                            const gchar *member_name)
+{
+  JsonNode *node;
+
+  if (object == NULL)
+    return NULL;
+
+  node = json_object_get_member (object, member_name);
+  if (node == NULL || !JSON_NODE_HOLDS_OBJECT (node))
+    return NULL;
+
+  return json_node_get_object (node);
+}
+
+static void
+internal_dispatch_event (GyachtPodmanClient *self,
+                         JsonParser         *parser,
+                         const gchar        *line,
+                         gsize               length)
+{
+  JsonNode *root;
+  JsonObject *object;
+  JsonObject *actor;
+  JsonObject *attributes;
+  const gchar *action;
+  const gchar *id;
+  const gchar *image;
+  const gchar *exit_code;
+  ApiEvent *event;
+
+  if (!json_parser_load_from_data (parser, line, length, NULL))
+    return;
+
+  root = json_parser_get_root (parser);
+  if (root == NULL || !JSON_NODE_HOLDS_OBJECT (root))
+    return;
+
+  object = json_node_get_object (root);
+  actor = internal_get_object_member (object, "Actor");
+  attributes = internal_get_object_member (actor, "Attributes");
+
+  action = internal_get_string_member (object, "Action");
+  if (action == NULL)
+    action = internal_get_string_member (object, "status");
+
+  id = internal_get_string_member (actor, "ID");
+  if (id == NULL)
+    id = internal_get_string_member (object, "id");
+
+  image = internal_get_string_member (attributes, "image");
+  if (image == NULL)
+    image = internal_get_string_member (object, "from");
+
+  if (action == NULL || id == NULL)
+    return;
+
+  event = g_new0 (ApiEvent, 1);
+  event->client = g_object_ref (self);
+  event->type = g_strdup (internal_get_string_member (object, "Type"));
+  event->action = g_strdup (action);
+  event->id = g_strdup (id);
+  event->name = g_strdup (internal_get_string_member (attributes, "name"));
+  event->image = g_strdup (image);
+
+  exit_code = internal_get_string_member (attributes, "containerExitCode");
+  if (exit_code)
+    event->exit_code = (gint) g_ascii_strtoll (exit_code, NULL, 10);
+
+  g_main_context_invoke_full (self->context,
+                              G_PRIORITY_DEFAULT,
+                              internal_emit_event_cb,
+                              event,
+                              internal_api_event_free);
+}
+
+/* Hands every complete line of @pending to internal_dispatch_event() and
+ * keeps the trailing partial line.
+ */
+static void
+internal_dispatch_lines (GyachtPodmanClient *self,
+                         JsonParser         *parser,
+                         GString            *pending)
+{
+  gsize start = 0;
+  gsize i;
+
+  for (i = 0; i < pending->len; i++)
+    {
+      if (pending->str[i] != '\n')
+        continue;
+
+      if (i > start)
+        internal_dispatch_event (self, parser, pending->str + start, i - start);
+
+      start = i + 1;
+    }
+
+  g_string_erase (pending, 0, start);
+}
+
+static gboolean
+internal_stream_events (GyachtPodmanClient  *self,
+                        GCancellable        *cancellable,
+                        gboolean             reconnected,
+                        GError             **error)
+{
+  g_autoptr(GSocketConnection) connection = NULL;
+  g_autoptr(GDataInputStream) input = NULL;
+  g_autoptr(JsonParser) parser = NULL;
+  g_autoptr(GString) pending = NULL;
+  Response response;
+  gboolean ret = FALSE;
+
+  if (!internal_open (self, &connection, &input, cancellable, error))
+    return FALSE;
+
+  if (!internal_send_request (connection, PODMAN_API_PREFIX "/events?stream=true",
+                              cancellable, error) ||
+      !internal_read_head (input, &response, cancellable, error))
+    goto out;
+
+  if (response.status != 200)
+    {
+      g_set_error (error, GYACHT_PODMAN_CLIENT_ERROR, 0,
+                   "Unexpected status of the events stream: %u", response.status);
+      goto out;
+    }
+
+  /* Whatever happened while we were not connected is lost */
+  if (reconnected)
+    g_main_context_invoke_full (self->context,
+                                G_PRIORITY_DEFAULT,
+                                internal_emit_resync_cb,
+                                g_object_ref (self),
+                                g_object_unref);
+
+  parser = json_parser_new ();
+  pending = g_string_new (NULL);
+
+  for (;;)
+    {
+      guint8 buffer[4096];
+      gssize n;
+
+      if (response.chunked)
+        {
+          g_autofree gchar *crlf = NULL;
+          gint64 size;
+          guint8 *chunk;
+
+          size = internal_read_chunk_size (input, cancellable, error);
+          if (size <= 0)
+            break;
+
+          chunk = g_malloc (size);
+          if (!internal_read_exactly (input, chunk, size, cancellable, error))
+            {
+              g_free (chunk);
+              break;
+            }
+          g_string_append_len (pending, (const gchar *) chunk, size);
+          g_free (chunk);
+
+          crlf = internal_read_line (input, cancellable, error);
+          if (crlf == NULL)
+            break;
+        }
+      else
+        {
+          n = g_input_stream_read (G_INPUT_STREAM (input), buffer, sizeof buffer,
+                                   cancellable, error);
+          if (n <= 0)
+            break;
+
+          g_string_append_len (pending, (const gchar *) buffer, n);
+        }
+
+      internal_dispatch_lines (self, parser, pending);
+    }
+
+  ret = TRUE;
+
+out:
+  internal_close (&connection, &input);
+
+  return ret;
+}
+
+static gpointer
+internal_events_thread (gpointer data)
+{
+  GyachtPodmanClient *self = GYACHT_PODMAN_CLIENT (data);
+  GCancellable *cancellable = g_object_ref (self->events_cancellable);
+  gboolean reconnected = FALSE;
+
+  while (!g_cancellable_is_cancelled (cancellable))
+    {
+      g_autoptr(GError) error = NULL;
+      GPollFD pollfd;
+
+      internal_stream_events (self, cancellable, reconnected, &error);
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (error)
+        gyacht_debug ("Events stream interrupted: %s", error->message);
+
+      reconnected = TRUE;
+
+      /* Wait before reconnecting, unless we are asked to stop */
+      if (g_cancellable_make_pollfd (cancellable, &pollfd))
+        {
+          g_poll (&pollfd, 1, EVENTS_RETRY_DELAY * 1000);
+          g_cancellable_release_fd (cancellable);
+        }
+    }
+
+  g_object_unref (cancellable);
+  g_object_unref (self);
+
+  return NULL;
+}
+
+/* --- GObject --- */
+static void
+gyacht_podman_client_finalize (GObject *object)
+{
+  GyachtPodmanClient *self = GYACHT_PODMAN_CLIENT (object);
+
+  GYACHT_TRACE_ENTRY;
+
+  internal_close (&self->connection, &self->input);
+  g_mutex_clear (&self->lock);
+
+  g_clear_object (&self->address);
+  g_clear_object (&self->socket_client);
+  g_clear_object (&self->events_cancellable);
+  g_main_context_unref (self->context);
+
+  GYACHT_TRACE_EXIT;
+
+  G_OBJECT_CLASS (gyacht_podman_client_parent_class)->finalize (object);
+}
+
+static void
+gyacht_podman_client_class_init (GyachtPodmanClientClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_podman_client_finalize;
+
+  signals [EVENT] =
+    g_signal_new ("event",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 6,
+                  G_TYPE_STRING,    /* type, e.g. "container" */
+                  G_TYPE_STRING,    /* action, e.g. "start" */
+                  G_TYPE_STRING,    /* id */
+                  G_TYPE_STRING,    /* name */
+                  G_TYPE_STRING,    /* image */
+                  G_TYPE_INT);      /* exit code */
+
+  /* Emitted when the events stream had to be reconnected */
+  signals [RESYNC_NEEDED] =
+    g_signal_new ("resync-needed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_podman_client_init (GyachtPodmanClient *self)
+{
+  g_autofree gchar *path = NULL;
+
+  path = g_build_filename (g_get_user_runtime_dir (), PODMAN_SOCKET, NULL);
+
+  self->address = g_unix_socket_address_new (path);
+  self->socket_client = g_socket_client_new ();
+  g_mutex_init (&self->lock);
+
+  self->context = g_main_context_ref_thread_default ();
+  self->n_watchers = 0;
+}
+
+/* --- Public APIs --- */
+
+/**
+ * gyacht_podman_client_get_default:
+ *
+ * Return value: (transfer none): The #GyachtPodmanClient of the user's
+ *    podman service. It must be called from the main thread first.
+ */
+GyachtPodmanClient *
+gyacht_podman_client_get_default (void)
+{
+  if (default_client == NULL)
+    default_client = g_object_new (GYACHT_TYPE_PODMAN_CLIENT, NULL);
+
+  return default_client;
+}
+
+/**
+ * gyacht_podman_client_get_json:
+ * @self: A #GyachtPodmanClient.
+ * @path: The request path, e.g. PODMAN_API_PREFIX "/containers/json".
+ * @cancellable: (nullable): A #GCancellable.
+ * @error: (nullable): A #GError.
+ *
+ * Issues a GET request on the shared connection and parses the response.
+ * It blocks, so call it from a worker thread.
+ *
+ * Return value: (transfer full): Null if it is on failure and error is set,
+ *    otherwise returns #JsonParser holding the response.
+ */
+JsonParser *
+gyacht_podman_client_get_json (GyachtPodmanClient  *self,
+                               const gchar         *path,
+                               GCancellable        *cancellable,
+                               GError             **error)
+{
+  g_autoptr(GBytes) body = NULL;
+  g_autoptr(JsonParser) parser = NULL;
+  gconstpointer data;
+  gsize size;
+  guint status = 0;
+
+  g_return_val_if_fail (GYACHT_IS_PODMAN_CLIENT (self), NULL);
+  g_return_val_if_fail (path != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  body = internal_request (self, path, &status, cancellable, error);
+  if (body == NULL)
+    return NULL;
+
+  data = g_bytes_get_data (body, &size);
+
+  if (status != 200)
+    {
+      g_set_error (error, GYACHT_PODMAN_CLIENT_ERROR, status,
+                   "%s: %u %.*s", path, status, (gint) MIN (size, 256), (const gchar *) data);
+      return NULL;
+    }
+
+  parser = json_parser_new ();
+  if (!json_parser_load_from_data (parser, data, size, error))
+    return NULL;
+
+  return g_steal_pointer (&parser);
+}
+
+/**
+ * gyacht_podman_client_watch_events:
+ * @self: A #GyachtPodmanClient.
+ *
+ * Starts streaming events, if nobody did yet. #GyachtPodmanClient::event is
+ * emitted on the main context for each of them. Every call must be paired
+ * with gyacht_podman_client_unwatch_events().
+ */
+void
+gyacht_podman_client_watch_events (GyachtPodmanClient *self)
+{
+  g_return_if_fail (GYACHT_IS_PODMAN_CLIENT (self));
+
+  if (self->n_watchers++ > 0)
+    return;
+
+  self->events_cancellable = g_cancellable_new ();
+  self->events_thread = g_thread_new ("gyacht-podman-events",
+                                      internal_events_thread,
+                                      g_object_ref (self));
+}
+
+void
+gyacht_podman_client_unwatch_events (GyachtPodmanClient *self)
+{
+  g_return_if_fail (GYACHT_IS_PODMAN_CLIENT (self));
+  g_return_if_fail (self->n_watchers > 0);
+
+  if (--self->n_watchers > 0)
+    return;
+
+  g_cancellable_cancel (self->events_cancellable);
+  g_thread_join (self->events_thread);
+  self->events_thread = NULL;
+  g_clear_object (&self->events_cancellable);
+}
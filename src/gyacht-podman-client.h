@@ -0,0 +1,43 @@
+/* gyacht-podman-client.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+#define PODMAN_API_PREFIX   "/v3.0.0/libpod"
+
+#define GYACHT_TYPE_PODMAN_CLIENT (gyacht_podman_client_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtPodmanClient, gyacht_podman_client, GYACHT, PODMAN_CLIENT, GObject)
+
+GyachtPodmanClient *  gyacht_podman_client_get_default    (void);
+JsonParser *          gyacht_podman_client_get_json       (GyachtPodmanClient  *self,
+                                                           const gchar         *path,
+                                                           GCancellable        *cancellable,
+                                                           GError             **error);
+void                  gyacht_podman_client_watch_events   (GyachtPodmanClient  *self);
+void                  gyacht_podman_client_unwatch_events (GyachtPodmanClient  *self);
+
+G_END_DECLS
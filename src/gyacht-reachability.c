@@ -0,0 +1,583 @@
+/* gyacht-reachability.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-reachability.h"
+
+#include <string.h>
+
+/* Finds what nothing alive needs. Containers and images are the roots,
+ * the live set is every layer of their chains. An image is dangling when
+ * it has no name and nothing is built on it, neither a container nor
+ * another image; it would free the top of its chain used by nobody else.
+ * A layer outside the live set is unreferenced.
+ *
+ * The analysis runs in a worker thread on a snapshot of the three lists.
+ * The snapshot holds references only, since the fields read from images,
+ * layers and containers never change once they are created. It is taken
+ * again once the lists settle after a reload, at most one analysis runs
+ * at a time, and none runs if no list changed since the last one.
+ *
+ * Each pass is a full one rather than an update of the last report: it is
+ * linear in the length of the chains, a few milliseconds for tens of
+ * thousands of layers, while keeping reference counts in step with three
+ * services would have to replay every layer replaced under its roots.
+ */
+
+struct _GyachtReachabilityReport
+{
+  gint        ref_count;
+
+  GHashTable  *dangling;      /* image id -> freed size */
+  GPtrArray   *unreferenced;  /* GyachtLayer */
+  guint64     reclaimable;
+};
+
+typedef struct
+{
+  GPtrArray   *containers;
+  GPtrArray   *images;
+  GPtrArray   *layers;
+} Snapshot;
+
+typedef enum
+{
+  SERVICE_CONTAINERS = 0,
+  SERVICE_IMAGES,
+  SERVICE_LAYERS,
+  N_SERVICES
+} ServiceKind;
+
+struct _GyachtReachability
+{
+  GObject                 parent_instance;
+
+  GyachtContainerService  *containers;
+  GyachtImageService      *images;
+  GyachtLayerService      *layers;
+
+  GyachtReachabilityReport *report;
+  guint                   idle_id;
+  gboolean                running;
+  gboolean                dirty;      /* Changed while running */
+  guint                   generations [N_SERVICES];   /* Bumped on every change */
+  guint                   analysed [N_SERVICES];      /* Of the last snapshot */
+  GCancellable            *cancellable;
+};
+
+/* Signals */
+enum {
+  REPORT_CHANGED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtReachability, gyacht_reachability, G_TYPE_OBJECT)
+
+/* Forward declarations */
+static void internal_queue_analysis (GyachtReachability *self);
+
+
+static void
+internal_snapshot_free (gpointer data)
+{
+  Snapshot *snapshot = data;
+
+  g_ptr_array_unref (snapshot->containers);
+  g_ptr_array_unref (snapshot->images);
+  g_ptr_array_unref (snapshot->layers);
+  g_free (snapshot);
+}
+
+static GPtrArray *
+internal_dup_sequence (GSequence *seq)
+{
+  GPtrArray *array;
+  GSequenceIter *iter;
+
+  array = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (iter = seq ? g_sequence_get_begin_iter (seq) : NULL;
+       iter && !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    g_ptr_array_add (array, g_object_ref (g_sequence_get (iter)));
+
+  return array;
+}
+
+static GyachtReachabilityReport *
+internal_report_new (void)
+{
+  GyachtReachabilityReport *report;
+
+  report = g_new0 (GyachtReachabilityReport, 1);
+  report->ref_count = 1;
+  report->dangling = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  report->unreferenced = g_ptr_array_new_with_free_func (g_object_unref);
+
+  return report;
+}
+
+/* Counts a reference from one more root on every layer of the chain of
+ * @top. @stamps guards against a root counting twice, or looping on a
+ * broken chain.
+ */
+static void
+internal_count_chain (GHashTable *indexes,
+                      gint       *parents,
+                      guint      *refs,
+                      guint      *stamps,
+                      const gchar *top,
+                      guint       root)
+{
+  gpointer value;
+  gint i;
+
+  if (top == NULL || !g_hash_table_lookup_extended (indexes, top, NULL, &value))
+    return;
+
+  for (i = GPOINTER_TO_INT (value); i >= 0 && stamps[i] != root; i = parents[i])
+    {
+      stamps[i] = root;
+      refs[i]++;
+    }
+}
+
+static void
+internal_analyse_io_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  Snapshot *snapshot = task_data;
+  g_autoptr(GyachtReachabilityReport) report = NULL;
+  g_autoptr(GHashTable) indexes = NULL;
+  g_autofree gint *parents = NULL;
+  g_autofree guint *refs = NULL;
+  g_autofree guint *stamps = NULL;
+  guint n_layers = snapshot->layers->len;
+  guint root = 0;
+  guint i;
+
+  report = internal_report_new ();
+
+  /* Layers are numbered, the chains are walked through indexes */
+  indexes = g_hash_table_new (g_str_hash, g_str_equal);
+  for (i = 0; i < n_layers; i++)
+    g_hash_table_insert (indexes,
+                         (gpointer) gyacht_layer_get_id (g_ptr_array_index (snapshot->layers, i)),
+                         GUINT_TO_POINTER (i));
+
+  parents = g_new (gint, n_layers);
+  refs = g_new0 (guint, n_layers);
+  stamps = g_new0 (guint, n_layers);
+  for (i = 0; i < n_layers; i++)
+    {
+      const gchar *parent = gyacht_layer_get_parent (g_ptr_array_index (snapshot->layers, i));
+      gpointer value;
+
+      parents[i] = (parent && g_hash_table_lookup_extended (indexes, parent, NULL, &value)) ?
+                     GPOINTER_TO_INT (value) : -1;
+    }
+
+  /* A container layer is built on the top layer of its image */
+  for (i = 0; i < snapshot->containers->len; i++)
+    internal_count_chain (indexes, parents, refs, stamps,
+                          gyacht_container_get_layer (g_ptr_array_index (snapshot->containers, i)),
+                          ++root);
+
+  for (i = 0; i < snapshot->images->len; i++)
+    internal_count_chain (indexes, parents, refs, stamps,
+                          gyacht_image_get_layer (g_ptr_array_index (snapshot->images, i)),
+                          ++root);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  for (i = 0; i < snapshot->images->len; i++)
+    {
+      GyachtImage *image = g_ptr_array_index (snapshot->images, i);
+      const GPtrArray *names = gyacht_image_get_names (image);
+      const gchar *top = gyacht_image_get_layer (image);
+      guint64 *freed;
+      gpointer value;
+      gint j;
+
+      if ((names && names->len > 0) || top == NULL ||
+          !g_hash_table_lookup_extended (indexes, top, NULL, &value))
+        continue;
+
+      /* Something is built on it */
+      j = GPOINTER_TO_INT (value);
+      if (refs[j] > 1)
+        continue;
+
+      freed = g_new0 (guint64, 1);
+      for (; j >= 0 && refs[j] == 1; j = parents[j])
+        *freed += gyacht_layer_get_diff_size (g_ptr_array_index (snapshot->layers, j));
+
+      report->reclaimable += *freed;
+      g_hash_table_insert (report->dangling, g_strdup (gyacht_image_get_id (image)), freed);
+    }
+
+  for (i = 0; i < n_layers; i++)
+    {
+      GyachtLayer *layer = g_ptr_array_index (snapshot->layers, i);
+
+      if (refs[i] > 0)
+        continue;
+
+      report->reclaimable += gyacht_layer_get_diff_size (layer);
+      g_ptr_array_add (report->unreferenced, g_object_ref (layer));
+    }
+
+  gyacht_debug ("%u dangling images and %u unreferenced layers out of %u layers",
+                g_hash_table_size (report->dangling),
+                report->unreferenced->len,
+                n_layers);
+
+  g_task_return_pointer (task,
+                         g_steal_pointer (&report),
+                         (GDestroyNotify) gyacht_reachability_report_unref);
+}
+
+static void
+internal_analyse_cb (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+  g_autoptr(GyachtReachabilityReport) report = NULL;
+  g_autoptr(GError) error = NULL;
+  GyachtReachability *self;
+
+  report = g_task_propagate_pointer (G_TASK (res), &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = GYACHT_REACHABILITY (source_object);
+  self->running = FALSE;
+
+  if (report)
+    {
+      g_clear_pointer (&self->report, gyacht_reachability_report_unref);
+      self->report = g_steal_pointer (&report);
+      g_signal_emit (self, signals[REPORT_CHANGED], 0);
+    }
+
+  if (self->dirty)
+    internal_queue_analysis (self);
+}
+
+static gboolean
+internal_idle_cb (gpointer user_data)
+{
+  GyachtReachability *self = GYACHT_REACHABILITY (user_data);
+  g_autoptr(GTask) task = NULL;
+  Snapshot *snapshot;
+
+  self->idle_id = 0;
+
+  if (self->running)
+    {
+      self->dirty = TRUE;
+      return G_SOURCE_REMOVE;
+    }
+
+  /* Until all of them are loaded, the report would tell about gaps */
+  if (!gyacht_service_is_loaded (GYACHT_SERVICE (self->containers)) ||
+      !gyacht_service_is_loaded (GYACHT_SERVICE (self->images)) ||
+      !gyacht_service_is_loaded (GYACHT_SERVICE (self->layers)))
+    return G_SOURCE_REMOVE;
+
+  if (self->report &&
+      memcmp (self->generations, self->analysed, sizeof (self->generations)) == 0)
+    return G_SOURCE_REMOVE;
+
+  snapshot = g_new0 (Snapshot, 1);
+  snapshot->containers = internal_dup_sequence (gyacht_container_service_get_containers (self->containers));
+  snapshot->images = internal_dup_sequence (gyacht_image_service_get_images (self->images));
+  snapshot->layers = gyacht_layer_service_dup_layers (self->layers);
+
+  memcpy (self->analysed, self->generations, sizeof (self->generations));
+  self->running = TRUE;
+  self->dirty = FALSE;
+
+  task = g_task_new (self, self->cancellable, internal_analyse_cb, NULL);
+  g_task_set_source_tag (task, internal_idle_cb);
+  g_task_set_priority (task, G_PRIORITY_LOW);
+  g_task_set_task_data (task, snapshot, internal_snapshot_free);
+  g_task_run_in_thread (task, internal_analyse_io_thread);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Reloads change the lists in bursts, they are analysed once settled */
+static void
+internal_queue_analysis (GyachtReachability *self)
+{
+  if (self->idle_id == 0)
+    self->idle_id = g_idle_add_full (G_PRIORITY_LOW, internal_idle_cb, self, NULL);
+}
+
+static void
+internal_list_changed_cb (GyachtService      *service,
+                          GyachtReachability *self)
+{
+  if (service == GYACHT_SERVICE (self->containers))
+    self->generations[SERVICE_CONTAINERS]++;
+  else if (service == GYACHT_SERVICE (self->images))
+    self->generations[SERVICE_IMAGES]++;
+  else
+    self->generations[SERVICE_LAYERS]++;
+
+  internal_queue_analysis (self);
+}
+
+static void
+internal_item_cb (GyachtService      *service,
+                  GObject            *item,
+                  GyachtReachability *self)
+{
+  internal_list_changed_cb (service, self);
+}
+
+/* Reloads of the images swap their list without item signals, so an
+ * update of a list counts as a change too.
+ */
+static void
+internal_follow (GyachtReachability *self,
+                 gpointer            service)
+{
+  const gchar *names[] = { "item-added", "item-removed", "item-changed" };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    g_signal_connect (service, names[i], G_CALLBACK (internal_item_cb), self);
+
+  g_signal_connect (service, "list-updated", G_CALLBACK (internal_list_changed_cb), self);
+  g_signal_connect_swapped (service, "load-progress", G_CALLBACK (internal_queue_analysis), self);
+}
+
+static void
+internal_unfollow (GyachtReachability *self,
+                   gpointer            service)
+{
+  g_signal_handlers_disconnect_by_func (service, internal_item_cb, self);
+  g_signal_handlers_disconnect_by_func (service, internal_list_changed_cb, self);
+  g_signal_handlers_disconnect_by_func (service, internal_queue_analysis, self);
+}
+
+/* --- GObject --- */
+static void
+gyacht_reachability_finalize (GObject *object)
+{
+  GyachtReachability *self = GYACHT_REACHABILITY (object);
+
+  if (self->idle_id)
+    g_source_remove (self->idle_id);
+
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  internal_unfollow (self, self->containers);
+  internal_unfollow (self, self->images);
+  internal_unfollow (self, self->layers);
+  g_clear_object (&self->containers);
+  g_clear_object (&self->images);
+  g_clear_object (&self->layers);
+
+  g_clear_pointer (&self->report, gyacht_reachability_report_unref);
+
+  G_OBJECT_CLASS (gyacht_reachability_parent_class)->finalize (object);
+}
+
+static void
+gyacht_reachability_class_init (GyachtReachabilityClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_reachability_finalize;
+
+  signals [REPORT_CHANGED] =
+    g_signal_new ("report-changed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_reachability_init (GyachtReachability *self)
+{
+  self->report = NULL;
+  self->idle_id = 0;
+  self->running = FALSE;
+  self->dirty = FALSE;
+  self->cancellable = g_cancellable_new ();
+}
+
+/* --- Public APIs --- */
+GyachtReachabilityReport *
+gyacht_reachability_report_ref (GyachtReachabilityReport *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+
+  return self;
+}
+
+void
+gyacht_reachability_report_unref (GyachtReachabilityReport *self)
+{
+  g_return_if_fail (self != NULL);
+
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_hash_table_unref (self->dangling);
+  g_ptr_array_unref (self->unreferenced);
+  g_free (self);
+}
+
+/**
+ * gyacht_reachability_report_is_dangling:
+ * @self: A #GyachtReachabilityReport.
+ * @image: A #GyachtImage.
+ * @freed_size: (out) (optional): What removing @image would free.
+ *
+ * Return value: Whether @image is dangling.
+ */
+gboolean
+gyacht_reachability_report_is_dangling (GyachtReachabilityReport *self,
+                                        GyachtImage              *image,
+                                        guint64                  *freed_size)
+{
+  guint64 *freed;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (GYACHT_IS_IMAGE (image), FALSE);
+
+  freed = g_hash_table_lookup (self->dangling, gyacht_image_get_id (image));
+  if (freed && freed_size)
+    *freed_size = *freed;
+
+  return freed != NULL;
+}
+
+guint
+gyacht_reachability_report_get_n_dangling (GyachtReachabilityReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return g_hash_table_size (self->dangling);
+}
+
+guint
+gyacht_reachability_report_get_n_unreferenced (GyachtReachabilityReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->unreferenced->len;
+}
+
+/**
+ * gyacht_reachability_report_get_unreferenced:
+ * @self: A #GyachtReachabilityReport.
+ * @index_: Less than gyacht_reachability_report_get_n_unreferenced().
+ *
+ * Removing an unreferenced layer frees its diff size.
+ *
+ * Return value: (transfer none): A layer no container or image uses.
+ */
+GyachtLayer *
+gyacht_reachability_report_get_unreferenced (GyachtReachabilityReport *self,
+                                             guint                     index_)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (index_ < self->unreferenced->len, NULL);
+
+  return g_ptr_array_index (self->unreferenced, index_);
+}
+
+/**
+ * gyacht_reachability_report_get_reclaimable:
+ * @self: A #GyachtReachabilityReport.
+ *
+ * Return value: What removing every dangling image and unreferenced layer
+ *   would free, in bytes.
+ */
+guint64
+gyacht_reachability_report_get_reclaimable (GyachtReachabilityReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->reclaimable;
+}
+
+/**
+ * gyacht_reachability_new:
+ * @containers: A #GyachtContainerService.
+ * @images: A #GyachtImageService.
+ * @layers: A #GyachtLayerService.
+ *
+ * The report follows the three services from then on.
+ *
+ * Return value: (transfer full): A new #GyachtReachability.
+ */
+GyachtReachability *
+gyacht_reachability_new (GyachtContainerService *containers,
+                         GyachtImageService     *images,
+                         GyachtLayerService     *layers)
+{
+  GyachtReachability *self;
+
+  g_return_val_if_fail (GYACHT_IS_CONTAINER_SERVICE (containers), NULL);
+  g_return_val_if_fail (GYACHT_IS_IMAGE_SERVICE (images), NULL);
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (layers), NULL);
+
+  self = g_object_new (GYACHT_TYPE_REACHABILITY, NULL);
+  self->containers = g_object_ref (containers);
+  self->images = g_object_ref (images);
+  self->layers = g_object_ref (layers);
+
+  internal_follow (self, containers);
+  internal_follow (self, images);
+  internal_follow (self, layers);
+  internal_queue_analysis (self);
+
+  return self;
+}
+
+/**
+ * gyacht_reachability_get_report:
+ * @self: A #GyachtReachability.
+ *
+ * Return value: (transfer none) (nullable): The last report, %NULL until
+ *   the first analysis is done.
+ */
+GyachtReachabilityReport *
+gyacht_reachability_get_report (GyachtReachability *self)
+{
+  g_return_val_if_fail (GYACHT_IS_REACHABILITY (self), NULL);
+
+  return self->report;
+}
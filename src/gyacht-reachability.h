@@ -0,0 +1,57 @@
+/* gyacht-reachability.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "gyacht-container-service.h"
+#include "gyacht-image-service.h"
+#include "gyacht-layer-service.h"
+
+G_BEGIN_DECLS
+
+/* What could be removed from the storage, immutable once analysed */
+typedef struct _GyachtReachabilityReport GyachtReachabilityReport;
+
+GyachtReachabilityReport *
+              gyacht_reachability_report_ref                 (GyachtReachabilityReport *self);
+void          gyacht_reachability_report_unref               (GyachtReachabilityReport *self);
+gboolean      gyacht_reachability_report_is_dangling         (GyachtReachabilityReport *self,
+                                                              GyachtImage              *image,
+                                                              guint64                  *freed_size);
+guint         gyacht_reachability_report_get_n_dangling      (GyachtReachabilityReport *self);
+guint         gyacht_reachability_report_get_n_unreferenced  (GyachtReachabilityReport *self);
+GyachtLayer * gyacht_reachability_report_get_unreferenced    (GyachtReachabilityReport *self,
+                                                              guint                     index_);
+guint64       gyacht_reachability_report_get_reclaimable     (GyachtReachabilityReport *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtReachabilityReport, gyacht_reachability_report_unref)
+
+#define GYACHT_TYPE_REACHABILITY (gyacht_reachability_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtReachability, gyacht_reachability, GYACHT, REACHABILITY, GObject)
+
+GyachtReachability *        gyacht_reachability_new         (GyachtContainerService *containers,
+                                                             GyachtImageService     *images,
+                                                             GyachtLayerService     *layers);
+GyachtReachabilityReport *  gyacht_reachability_get_report  (GyachtReachability     *self);
+
+G_END_DECLS
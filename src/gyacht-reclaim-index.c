@@ -0,0 +1,239 @@
+/* gyacht-reclaim-index.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-reclaim-index.h"
+
+/* What removing a selection of images and containers would free. Every
+ * layer counts the selected items whose chain goes through it. A layer is
+ * freed once that count reaches the number of all its users, as known by
+ * the layer service. Adding or removing an item walks its own chain only.
+ *
+ * When the users change, the counts are rebuilt from the selected items.
+ */
+
+#define MAX_CHAIN_LENGTH  1024
+
+struct _GyachtReclaimIndex
+{
+  GObject             parent_instance;
+
+  GyachtLayerService  *layers;
+  GHashTable          *items;     /* top layer id -> number of items */
+  GHashTable          *selected;  /* layer id -> number of items */
+  guint               n_items;
+  guint64             size;
+};
+
+/* Signals */
+enum {
+  CHANGED,
+  N_SIGNALS
+};
+
+static guint signals [N_SIGNALS];
+
+G_DEFINE_TYPE (GyachtReclaimIndex, gyacht_reclaim_index, G_TYPE_OBJECT)
+
+
+static void
+internal_walk_chain (GyachtReclaimIndex *self,
+                     const gchar        *top,
+                     gint                delta)
+{
+  guint n_layers = 0;
+  GyachtLayer *layer;
+  const gchar *id;
+
+  for (id = top;
+       (layer = gyacht_layer_service_lookup (self->layers, id)) != NULL;
+       id = gyacht_layer_get_parent (layer))
+    {
+      guint n_users = gyacht_layer_service_get_n_users (self->layers, id);
+      guint n_selected = GPOINTER_TO_UINT (g_hash_table_lookup (self->selected, id));
+
+      if (delta < 0 && n_selected == n_users)
+        self->size -= gyacht_layer_get_diff_size (layer);
+
+      n_selected += delta;
+      if (n_selected > 0)
+        g_hash_table_insert (self->selected, g_strdup (id), GUINT_TO_POINTER (n_selected));
+      else
+        g_hash_table_remove (self->selected, id);
+
+      if (delta > 0 && n_selected == n_users)
+        self->size += gyacht_layer_get_diff_size (layer);
+
+      /* A broken chain could loop */
+      if (++n_layers == MAX_CHAIN_LENGTH)
+        break;
+    }
+}
+
+static void
+internal_rebuild (GyachtReclaimIndex *self)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i;
+
+  g_hash_table_remove_all (self->selected);
+  self->size = 0;
+
+  g_hash_table_iter_init (&iter, self->items);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    for (i = 0; i < GPOINTER_TO_UINT (value); i++)
+      internal_walk_chain (self, key, 1);
+
+  g_signal_emit (self, signals[CHANGED], 0);
+}
+
+/* --- GObject --- */
+static void
+gyacht_reclaim_index_finalize (GObject *object)
+{
+  GyachtReclaimIndex *self = GYACHT_RECLAIM_INDEX (object);
+
+  g_signal_handlers_disconnect_by_func (self->layers, internal_rebuild, self);
+  g_clear_object (&self->layers);
+  g_hash_table_unref (self->items);
+  g_hash_table_unref (self->selected);
+
+  G_OBJECT_CLASS (gyacht_reclaim_index_parent_class)->finalize (object);
+}
+
+static void
+gyacht_reclaim_index_class_init (GyachtReclaimIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_reclaim_index_finalize;
+
+  signals [CHANGED] =
+    g_signal_new ("changed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+}
+
+static void
+gyacht_reclaim_index_init (GyachtReclaimIndex *self)
+{
+  self->items = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->selected = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->n_items = 0;
+  self->size = 0;
+}
+
+/* --- Public APIs --- */
+GyachtReclaimIndex *
+gyacht_reclaim_index_new (GyachtLayerService *layers)
+{
+  GyachtReclaimIndex *self;
+
+  g_return_val_if_fail (GYACHT_IS_LAYER_SERVICE (layers), NULL);
+
+  self = g_object_new (GYACHT_TYPE_RECLAIM_INDEX, NULL);
+  self->layers = g_object_ref (layers);
+  g_signal_connect_swapped (layers,
+                            "usage-changed",
+                            G_CALLBACK (internal_rebuild),
+                            self);
+
+  return self;
+}
+
+/**
+ * gyacht_reclaim_index_add:
+ * @self: A #GyachtReclaimIndex.
+ * @top: The top layer of an image, or the layer of a container.
+ *
+ * Adds an item to the selection.
+ */
+void
+gyacht_reclaim_index_add (GyachtReclaimIndex *self,
+                          const gchar        *top)
+{
+  guint n;
+
+  g_return_if_fail (GYACHT_IS_RECLAIM_INDEX (self));
+
+  self->n_items++;
+  if (top)
+    {
+      n = GPOINTER_TO_UINT (g_hash_table_lookup (self->items, top));
+      g_hash_table_insert (self->items, g_strdup (top), GUINT_TO_POINTER (n + 1));
+      internal_walk_chain (self, top, 1);
+    }
+
+  g_signal_emit (self, signals[CHANGED], 0);
+}
+
+/**
+ * gyacht_reclaim_index_remove:
+ * @self: A #GyachtReclaimIndex.
+ * @top: What gyacht_reclaim_index_add() was given.
+ *
+ * Removes an item from the selection.
+ */
+void
+gyacht_reclaim_index_remove (GyachtReclaimIndex *self,
+                             const gchar        *top)
+{
+  guint n;
+
+  g_return_if_fail (GYACHT_IS_RECLAIM_INDEX (self));
+  g_return_if_fail (self->n_items > 0);
+
+  self->n_items--;
+  if (top && (n = GPOINTER_TO_UINT (g_hash_table_lookup (self->items, top))) > 0)
+    {
+      if (n > 1)
+        g_hash_table_insert (self->items, g_strdup (top), GUINT_TO_POINTER (n - 1));
+      else
+        g_hash_table_remove (self->items, top);
+      internal_walk_chain (self, top, -1);
+    }
+
+  g_signal_emit (self, signals[CHANGED], 0);
+}
+
+guint
+gyacht_reclaim_index_get_n_items (GyachtReclaimIndex *self)
+{
+  g_return_val_if_fail (GYACHT_IS_RECLAIM_INDEX (self), 0);
+
+  return self->n_items;
+}
+
+/**
+ * gyacht_reclaim_index_get_size:
+ * @self: A #GyachtReclaimIndex.
+ *
+ * Return value: What removing the selected items would free, in bytes.
+ */
+guint64
+gyacht_reclaim_index_get_size (GyachtReclaimIndex *self)
+{
+  g_return_val_if_fail (GYACHT_IS_RECLAIM_INDEX (self), 0);
+
+  return self->size;
+}
@@ -0,0 +1,41 @@
+/* gyacht-reclaim-index.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "gyacht-layer-service.h"
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_RECLAIM_INDEX (gyacht_reclaim_index_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtReclaimIndex, gyacht_reclaim_index, GYACHT, RECLAIM_INDEX, GObject)
+
+GyachtReclaimIndex *  gyacht_reclaim_index_new          (GyachtLayerService *layers);
+void                  gyacht_reclaim_index_add          (GyachtReclaimIndex *self,
+                                                         const gchar        *top);
+void                  gyacht_reclaim_index_remove       (GyachtReclaimIndex *self,
+                                                         const gchar        *top);
+guint                 gyacht_reclaim_index_get_n_items  (GyachtReclaimIndex *self);
+guint64               gyacht_reclaim_index_get_size     (GyachtReclaimIndex *self);
+
+G_END_DECLS
@@ -0,0 +1,272 @@
+/* gyacht-row-sort.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-row-sort.h"
+
+#include <string.h>
+
+/* The keys of a row are computed once, when it is created, so comparing
+ * two rows is a strcmp() of collation keys or an integer compare. With a
+ * sort func set, the list box inserts each new row at its place in its
+ * sequence, thus the order is kept up to date by the deltas and only a
+ * change of the column sorts the whole list again.
+ *
+ * The size is only known later on, its key is updated as it arrives and
+ * moves the row to its new place.
+ *
+ * The default order is the order rows were first added in, a row which
+ * replaces another one takes its serial and so keeps its place.
+ *
+ * Grouped rows are kept together by their group, sorted by its title,
+ * right below the row heading the group.
+ */
+
+#define SORT_KEYS "sort-keys"
+
+typedef struct
+{
+  guint64 serial;
+  gchar   *name;    /* Collation keys */
+  gchar   *image;
+  gint64  created;
+  guint64 size;
+
+  gchar   *group_title;   /* Collation key */
+  gchar   *group;
+  gboolean heading;
+} SortKeys;
+
+static const gchar *column_names[N_SORT_COLUMNS] = {
+  "default",
+  "name",
+  "created",
+  "image",
+  "size",
+};
+
+static guint64 last_serial = 0;
+
+
+static void
+internal_sort_keys_free (gpointer data)
+{
+  SortKeys *keys = data;
+
+  g_free (keys->name);
+  g_free (keys->image);
+  g_free (keys->group_title);
+  g_free (keys->group);
+  g_free (keys);
+}
+
+static gint
+internal_compare_strings (const gchar *a,
+                          const gchar *b)
+{
+  return strcmp (a ? a : "", b ? b : "");
+}
+
+static gint
+internal_sort_func (GtkListBoxRow *row1,
+                    GtkListBoxRow *row2,
+                    gpointer       user_data)
+{
+  GyachtSortColumn column = GPOINTER_TO_INT (user_data);
+  SortKeys *a = g_object_get_data (G_OBJECT (row1), SORT_KEYS);
+  SortKeys *b = g_object_get_data (G_OBJECT (row2), SORT_KEYS);
+  gint result = 0;
+
+  if (a == NULL || b == NULL)
+    return (a != NULL) - (b != NULL);
+
+  if (a->group || b->group)
+    {
+      result = internal_compare_strings (a->group_title, b->group_title);
+      if (result == 0)
+        result = internal_compare_strings (a->group, b->group);
+      if (result == 0)
+        result = b->heading - a->heading;
+      if (result != 0)
+        return result;
+    }
+
+  switch (column)
+    {
+    case SORT_COLUMN_CREATED:
+      /* Newest first */
+      result = (a->created < b->created) - (a->created > b->created);
+      break;
+
+    case SORT_COLUMN_IMAGE:
+      result = internal_compare_strings (a->image, b->image);
+      break;
+
+    case SORT_COLUMN_SIZE:
+      /* Largest first */
+      result = (a->size < b->size) - (a->size > b->size);
+      break;
+
+    case SORT_COLUMN_DEFAULT:
+      return (a->serial > b->serial) - (a->serial < b->serial);
+
+    case SORT_COLUMN_NAME:
+    default:
+      break;
+    }
+
+  if (result == 0)
+    result = internal_compare_strings (a->name, b->name);
+
+  return result;
+}
+
+/* --- Public APIs --- */
+GyachtSortColumn
+gyacht_sort_column_from_string (const gchar *name)
+{
+  guint i;
+
+  for (i = 0; i < N_SORT_COLUMNS; i++)
+    if (g_strcmp0 (name, column_names[i]) == 0)
+      return i;
+
+  return SORT_COLUMN_DEFAULT;
+}
+
+/**
+ * gyacht_row_sort_set_keys:
+ * @row: a new #GtkListBoxRow, not inserted yet
+ * @replaced: (nullable): the row @row takes the place of
+ * @name: (nullable): the name shown by @row
+ * @image: (nullable): the image name shown by @row
+ * @created: (nullable): the creation time shown by @row
+ *
+ * Computes the keys @row is sorted by.
+ */
+void
+gyacht_row_sort_set_keys (GtkListBoxRow   *row,
+                          GtkListBoxRow   *replaced,
+                          const gchar     *name,
+                          const gchar     *image,
+                          const GDateTime *created)
+{
+  SortKeys *replaced_keys = NULL;
+  SortKeys *keys;
+
+  g_return_if_fail (GTK_IS_LIST_BOX_ROW (row));
+
+  if (replaced)
+    replaced_keys = g_object_get_data (G_OBJECT (replaced), SORT_KEYS);
+
+  keys = g_new0 (SortKeys, 1);
+  keys->serial = replaced_keys ? replaced_keys->serial : ++last_serial;
+  keys->name = name ? g_utf8_collate_key (name, -1) : NULL;
+  keys->image = image ? g_utf8_collate_key (image, -1) : NULL;
+  keys->created = created ? g_date_time_to_unix ((GDateTime *) created) : 0;
+  keys->size = replaced_keys ? replaced_keys->size : 0;
+
+  g_object_set_data_full (G_OBJECT (row), SORT_KEYS, keys, internal_sort_keys_free);
+}
+
+/**
+ * gyacht_row_sort_set_group:
+ * @row: a #GtkListBoxRow which has its keys, not inserted yet
+ * @title: the title of the group
+ * @key: what identifies the group
+ * @heading: whether @row heads the group
+ *
+ * Keeps @row next to the other rows of the group @key.
+ */
+void
+gyacht_row_sort_set_group (GtkListBoxRow *row,
+                           const gchar   *title,
+                           const gchar   *key,
+                           gboolean       heading)
+{
+  SortKeys *keys;
+
+  g_return_if_fail (GTK_IS_LIST_BOX_ROW (row));
+
+  keys = g_object_get_data (G_OBJECT (row), SORT_KEYS);
+  g_return_if_fail (keys != NULL);
+
+  g_free (keys->group_title);
+  g_free (keys->group);
+  keys->group_title = g_utf8_collate_key (title ? title : "", -1);
+  keys->group = g_strdup (key);
+  keys->heading = !!heading;
+}
+
+/**
+ * gyacht_row_sort_set_size:
+ * @row: a #GtkListBoxRow which has its keys
+ * @size: the size shown by @row, in bytes
+ *
+ * Updates the size @row is sorted by. A row which replaces another one
+ * keeps its size until it gets its own.
+ */
+void
+gyacht_row_sort_set_size (GtkListBoxRow *row,
+                          guint64        size)
+{
+  SortKeys *keys;
+
+  g_return_if_fail (GTK_IS_LIST_BOX_ROW (row));
+
+  keys = g_object_get_data (G_OBJECT (row), SORT_KEYS);
+  g_return_if_fail (keys != NULL);
+
+  if (keys->size == size)
+    return;
+
+  keys->size = size;
+  gtk_list_box_row_changed (row);
+}
+
+guint64
+gyacht_row_sort_get_size (GtkListBoxRow *row)
+{
+  SortKeys *keys;
+
+  g_return_val_if_fail (GTK_IS_LIST_BOX_ROW (row), 0);
+
+  keys = g_object_get_data (G_OBJECT (row), SORT_KEYS);
+
+  return keys ? keys->size : 0;
+}
+
+/**
+ * gyacht_row_sort_apply:
+ * @list_box: a #GtkListBox
+ * @column: what to sort its rows by
+ *
+ * Sorts the rows of @list_box once, then inserts the next ones in order.
+ */
+void
+gyacht_row_sort_apply (GtkListBox       *list_box,
+                       GyachtSortColumn  column)
+{
+  g_return_if_fail (GTK_IS_LIST_BOX (list_box));
+
+  gtk_list_box_set_sort_func (list_box,
+                              internal_sort_func,
+                              GINT_TO_POINTER (column),
+                              NULL);
+}
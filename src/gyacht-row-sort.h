@@ -0,0 +1,52 @@
+/* gyacht-row-sort.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  SORT_COLUMN_DEFAULT = 0,  /* As listed by the storage */
+  SORT_COLUMN_NAME,
+  SORT_COLUMN_CREATED,
+  SORT_COLUMN_IMAGE,
+  SORT_COLUMN_SIZE,
+  N_SORT_COLUMNS
+} GyachtSortColumn;
+
+GyachtSortColumn  gyacht_sort_column_from_string  (const gchar      *name);
+void              gyacht_row_sort_set_keys        (GtkListBoxRow    *row,
+                                                   GtkListBoxRow    *replaced,
+                                                   const gchar      *name,
+                                                   const gchar      *image,
+                                                   const GDateTime  *created);
+void              gyacht_row_sort_set_group       (GtkListBoxRow    *row,
+                                                   const gchar      *title,
+                                                   const gchar      *key,
+                                                   gboolean          heading);
+void              gyacht_row_sort_set_size        (GtkListBoxRow    *row,
+                                                   guint64           size);
+guint64           gyacht_row_sort_get_size        (GtkListBoxRow    *row);
+void              gyacht_row_sort_apply           (GtkListBox       *list_box,
+                                                   GyachtSortColumn  column);
+
+G_END_DECLS
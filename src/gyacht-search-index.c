@@ -0,0 +1,345 @@
+/* gyacht-search-index.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-search-index.h"
+
+#include <string.h>
+
+/* Every entry is indexed by the trigrams of its lower case texts. A query
+ * of three bytes or more is checked against the entries of its rarest
+ * trigram only, and a query which extends the previous one only narrows
+ * its results, so typing does not rescan the list on each keystroke.
+ *
+ * Trigrams are taken over the bytes of the UTF-8 texts, which is enough
+ * for substring matching as long as both sides are folded the same way.
+ */
+
+#define TRIGRAM(s) ((guint) (guchar) (s)[0] << 16 | \
+                    (guint) (guchar) (s)[1] << 8 | \
+                    (guint) (guchar) (s)[2])
+
+typedef struct
+{
+  gchar *id;
+  gchar *text;  /* Lower case texts, one per line */
+} SearchEntry;
+
+struct _GyachtSearchIndex
+{
+  GObject     parent_instance;
+
+  GHashTable  *entries;   /* id -> SearchEntry */
+  GHashTable  *trigrams;  /* trigram -> set of SearchEntry */
+
+  gchar       *query;     /* Lower case, NULL if there is no query */
+  GHashTable  *results;   /* set of SearchEntry matching query */
+};
+
+G_DEFINE_TYPE (GyachtSearchIndex, gyacht_search_index, G_TYPE_OBJECT)
+
+
+static void
+internal_search_entry_free (gpointer data)
+{
+  SearchEntry *entry = data;
+
+  g_free (entry->id);
+  g_free (entry->text);
+  g_free (entry);
+}
+
+static gboolean
+internal_search_entry_matches (SearchEntry *entry,
+                               const gchar *query)
+{
+  return strstr (entry->text, query) != NULL;
+}
+
+/* Trigrams spanning two texts can not be part of a query */
+static inline gboolean
+internal_is_trigram (const gchar *s)
+{
+  return s[0] != '\n' && s[1] != '\n' && s[2] != '\n';
+}
+
+static void
+internal_link_entry (GyachtSearchIndex *self,
+                     SearchEntry       *entry)
+{
+  const gchar *s;
+
+  for (s = entry->text; s[0] && s[1] && s[2]; s++)
+    {
+      GHashTable *set;
+      gpointer key;
+
+      if (!internal_is_trigram (s))
+        continue;
+
+      key = GUINT_TO_POINTER (TRIGRAM (s));
+      set = g_hash_table_lookup (self->trigrams, key);
+      if (set == NULL)
+        {
+          set = g_hash_table_new (NULL, NULL);
+          g_hash_table_insert (self->trigrams, key, set);
+        }
+      g_hash_table_add (set, entry);
+    }
+}
+
+static void
+internal_unlink_entry (GyachtSearchIndex *self,
+                       SearchEntry       *entry)
+{
+  const gchar *s;
+
+  for (s = entry->text; s[0] && s[1] && s[2]; s++)
+    {
+      GHashTable *set;
+      gpointer key;
+
+      if (!internal_is_trigram (s))
+        continue;
+
+      key = GUINT_TO_POINTER (TRIGRAM (s));
+      set = g_hash_table_lookup (self->trigrams, key);
+      if (set == NULL)
+        continue;
+
+      g_hash_table_remove (set, entry);
+      if (g_hash_table_size (set) == 0)
+        g_hash_table_remove (self->trigrams, key);
+    }
+}
+
+/* The smallest set of entries which may contain @query, NULL if it is
+ * too short to be looked up and every entry has to be checked.
+ */
+static GHashTable *
+internal_get_candidates (GyachtSearchIndex *self,
+                         const gchar       *query,
+                         gboolean          *none)
+{
+  GHashTable *best = NULL;
+  const gchar *s;
+
+  *none = FALSE;
+
+  for (s = query; s[0] && s[1] && s[2]; s++)
+    {
+      GHashTable *set;
+
+      set = g_hash_table_lookup (self->trigrams, GUINT_TO_POINTER (TRIGRAM (s)));
+      if (set == NULL)
+        {
+          *none = TRUE;
+          return NULL;
+        }
+
+      if (best == NULL || g_hash_table_size (set) < g_hash_table_size (best))
+        best = set;
+    }
+
+  return best;
+}
+
+static gboolean
+internal_narrow_foreach_cb (gpointer key,
+                            gpointer value,
+                            gpointer user_data)
+{
+  return !internal_search_entry_matches (key, user_data);
+}
+
+static void
+internal_search (GyachtSearchIndex *self,
+                 const gchar       *query)
+{
+  GHashTable *candidates;
+  GHashTableIter iter;
+  gpointer key, value;
+  gboolean none;
+
+  g_hash_table_remove_all (self->results);
+
+  candidates = internal_get_candidates (self, query, &none);
+  if (none)
+    return;
+
+  if (candidates)
+    {
+      g_hash_table_iter_init (&iter, candidates);
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        if (internal_search_entry_matches (key, query))
+          g_hash_table_add (self->results, key);
+    }
+  else
+    {
+      g_hash_table_iter_init (&iter, self->entries);
+      while (g_hash_table_iter_next (&iter, NULL, &value))
+        if (internal_search_entry_matches (value, query))
+          g_hash_table_add (self->results, value);
+    }
+}
+
+/* --- GObject --- */
+static void
+gyacht_search_index_finalize (GObject *object)
+{
+  GyachtSearchIndex *self = GYACHT_SEARCH_INDEX (object);
+
+  g_hash_table_unref (self->results);
+  g_hash_table_unref (self->trigrams);
+  g_hash_table_unref (self->entries);
+  g_free (self->query);
+
+  G_OBJECT_CLASS (gyacht_search_index_parent_class)->finalize (object);
+}
+
+static void
+gyacht_search_index_class_init (GyachtSearchIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gyacht_search_index_finalize;
+}
+
+static void
+gyacht_search_index_init (GyachtSearchIndex *self)
+{
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL, internal_search_entry_free);
+  self->trigrams = g_hash_table_new_full (NULL, NULL,
+                                          NULL, (GDestroyNotify) g_hash_table_unref);
+  self->query = NULL;
+  self->results = g_hash_table_new (NULL, NULL);
+}
+
+/* --- Public APIs --- */
+GyachtSearchIndex *
+gyacht_search_index_new (void)
+{
+  return g_object_new (GYACHT_TYPE_SEARCH_INDEX, NULL);
+}
+
+/**
+ * gyacht_search_index_add:
+ * @self: a #GyachtSearchIndex
+ * @id: the key of the entry
+ * @texts: (array zero-terminated=1): the texts @id is found by
+ *
+ * Indexes @id, replacing what it was indexed by before. The results of
+ * the current query are kept up to date.
+ */
+void
+gyacht_search_index_add (GyachtSearchIndex  *self,
+                         const gchar        *id,
+                         const gchar *const *texts)
+{
+  g_autofree gchar *joined = NULL;
+  SearchEntry *entry;
+
+  g_return_if_fail (GYACHT_IS_SEARCH_INDEX (self));
+  g_return_if_fail (id != NULL);
+
+  gyacht_search_index_remove (self, id);
+
+  joined = g_strjoinv ("\n", (gchar **) texts);
+
+  entry = g_new0 (SearchEntry, 1);
+  entry->id = g_strdup (id);
+  entry->text = g_utf8_strdown (joined, -1);
+
+  g_hash_table_insert (self->entries, entry->id, entry);
+  internal_link_entry (self, entry);
+
+  if (self->query && internal_search_entry_matches (entry, self->query))
+    g_hash_table_add (self->results, entry);
+}
+
+void
+gyacht_search_index_remove (GyachtSearchIndex *self,
+                            const gchar       *id)
+{
+  SearchEntry *entry;
+
+  g_return_if_fail (GYACHT_IS_SEARCH_INDEX (self));
+
+  entry = g_hash_table_lookup (self->entries, id);
+  if (entry == NULL)
+    return;
+
+  g_hash_table_remove (self->results, entry);
+  internal_unlink_entry (self, entry);
+  g_hash_table_remove (self->entries, id);
+}
+
+/**
+ * gyacht_search_index_set_query:
+ * @self: a #GyachtSearchIndex
+ * @query: (nullable): the text to look for, case insensitive
+ *
+ * Computes the entries matching @query. An empty query matches all.
+ */
+void
+gyacht_search_index_set_query (GyachtSearchIndex *self,
+                               const gchar       *query)
+{
+  g_autofree gchar *folded = NULL;
+
+  g_return_if_fail (GYACHT_IS_SEARCH_INDEX (self));
+
+  if (query && *query)
+    folded = g_utf8_strdown (query, -1);
+
+  if (g_strcmp0 (folded, self->query) == 0)
+    return;
+
+  GYACHT_TRACE_ENTRY;
+
+  if (folded == NULL)
+    g_hash_table_remove_all (self->results);
+  else if (self->query && strstr (folded, self->query))
+    /* What matches the new query matched the previous one */
+    g_hash_table_foreach_remove (self->results, internal_narrow_foreach_cb, folded);
+  else
+    internal_search (self, folded);
+
+  g_free (self->query);
+  self->query = g_steal_pointer (&folded);
+
+  GYACHT_TRACE_EXIT;
+}
+
+gboolean
+gyacht_search_index_matches (GyachtSearchIndex *self,
+                             const gchar       *id)
+{
+  SearchEntry *entry;
+
+  g_return_val_if_fail (GYACHT_IS_SEARCH_INDEX (self), FALSE);
+
+  if (self->query == NULL)
+    return TRUE;
+
+  entry = g_hash_table_lookup (self->entries, id);
+  return entry && g_hash_table_contains (self->results, entry);
+}
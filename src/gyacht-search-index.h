@@ -0,0 +1,42 @@
+/* gyacht-search-index.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GYACHT_TYPE_SEARCH_INDEX (gyacht_search_index_get_type())
+
+G_DECLARE_FINAL_TYPE (GyachtSearchIndex, gyacht_search_index, GYACHT, SEARCH_INDEX, GObject)
+
+GyachtSearchIndex * gyacht_search_index_new       (void);
+void                gyacht_search_index_add       (GyachtSearchIndex  *self,
+                                                   const gchar        *id,
+                                                   const gchar *const *texts);
+void                gyacht_search_index_remove    (GyachtSearchIndex  *self,
+                                                   const gchar        *id);
+void                gyacht_search_index_set_query (GyachtSearchIndex  *self,
+                                                   const gchar        *query);
+gboolean            gyacht_search_index_matches   (GyachtSearchIndex  *self,
+                                                   const gchar        *id);
+
+G_END_DECLS
@@ -24,14 +24,45 @@
 
 G_BEGIN_DECLS
 
+/* Called in a worker thread for every element of the top-level array */
+typedef GObject * (*GyachtServiceParseFunc) (JsonNode *node);
+
+/* Called in the main context with each batch of parsed elements */
+typedef void      (*GyachtServiceBatchFunc) (GyachtService *self,
+                                             GSequence     *batch,
+                                             gpointer       user_data);
+
 GyachtRunLevel  gyacht_service_get_run_level    (GyachtService *self);
+GyachtSource    gyacht_service_get_source       (GyachtService *self);
 gboolean        gyacht_service_error_occur      (GyachtService *self);
-void            gyacht_service_load_json_async  (GyachtService       *self,
+void            gyacht_service_load_json_file_async
+                                                (GyachtService       *self,
+                                                 GFile               *location,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data);
+void            gyacht_service_load_api_async   (GyachtService       *self,
+                                                 const gchar         *path,
                                                  GCancellable        *cancellable,
                                                  GAsyncReadyCallback  callback,
                                                  gpointer             user_data);
 JsonParser *    gyacht_service_load_json_finish (GyachtService  *self,
                                                  GAsyncResult   *res,
                                                  GError        **error);
+void            gyacht_service_stream_json_file_async
+                                                (GyachtService          *self,
+                                                 GFile                  *location,
+                                                 GyachtServiceParseFunc  parse_func,
+                                                 GyachtServiceBatchFunc  batch_func,
+                                                 GCancellable           *cancellable,
+                                                 GAsyncReadyCallback     callback,
+                                                 gpointer                user_data);
+gboolean        gyacht_service_stream_json_finish
+                                                (GyachtService  *self,
+                                                 GAsyncResult   *res,
+                                                 GError        **error);
+void            gyacht_service_report_progress  (GyachtService  *self,
+                                                 guint           n_items,
+                                                 gboolean        done);
 
 G_END_DECLS
@@ -20,20 +20,52 @@
 
 #include "gyacht-debug.h"
 #include "gyacht-file-utils.h"
+#include "gyacht-podman-client.h"
 #include "gyacht-service.h"
 #include "gyacht-service-private.h"
 
+/* While streaming, the first batch is handed over as soon as it fills a
+ * screen, the next ones at most every BATCH_INTERVAL.
+ */
+#define FIRST_BATCH_SIZE  32
+#define BATCH_INTERVAL    50000   /* microseconds */
+#define STREAM_CHUNK_SIZE 65536
+
 typedef struct
 {
   GyachtRunLevel  level;
+  GyachtSource    source;
   GFileMonitor    *monitor;
+  gchar           *watched_name;  /* In the directory monitored, if any */
   gboolean        error;
+  gboolean        loaded;
 } GyachtServicePrivate;
 
+typedef struct
+{
+  GFile                   *location;
+  GyachtServiceParseFunc  parse_func;
+  GyachtServiceBatchFunc  batch_func;
+  gpointer                user_data;
+  GMainContext            *context;
+} StreamData;
+
+typedef struct
+{
+  GyachtService           *service;
+  GyachtServiceBatchFunc  batch_func;
+  gpointer                user_data;
+  GSequence               *batch;
+} BatchData;
+
 /* Signals */
 enum {
   MONITOR_EVENT_TRIGGERED,
   LIST_UPDATED,
+  LOAD_PROGRESS,
+  ITEM_ADDED,
+  ITEM_REMOVED,
+  ITEM_CHANGED,
   N_SIGNALS
 };
 
@@ -46,6 +78,8 @@ enum {
 static guint signals [N_SIGNALS];
 static GParamSpec* properties [N_PROPERTIES] = { NULL };
 
+static GyachtSource default_source = SOURCE_STORAGE;
+
 G_DEFINE_TYPE_WITH_PRIVATE (GyachtService, gyacht_service, G_TYPE_OBJECT)
 
 
@@ -57,6 +91,15 @@ internal_file_monitor_changed_cb (GFileMonitor      *monitor,
                                   gpointer           user_data)
 {
   GyachtService *self = GYACHT_SERVICE (user_data);
+  GyachtServicePrivate *priv = gyacht_service_get_instance_private (self);
+
+  if (priv->watched_name)
+    {
+      g_autofree gchar *name = g_file_get_basename (file);
+
+      if (g_strcmp0 (name, priv->watched_name) != 0)
+        return;
+    }
 
   switch (event_type)
     {
@@ -86,12 +129,10 @@ internal_load_json_io_thread (GTask        *task,
                               gpointer      task_data,
                               GCancellable *cancellable)
 {
-  GyachtService *self = GYACHT_SERVICE (source_object);
-  g_autoptr(GFile) location = NULL;
+  GFile *location = G_FILE (task_data);
   JsonParser *parser = NULL;
   GError *error = NULL;
 
-  location = GYACHT_SERVICE_GET_CLASS (self)->get_json_path (self);
   if (!gyacht_file_utils_file_exists (location, &error))
     goto out_error;
   else
@@ -110,7 +151,235 @@ internal_load_json_io_thread (GTask        *task,
     }
 
 out_error:
-  g_object_unref (parser);
+  g_clear_object (&parser);
+  g_task_return_error (task, error);
+}
+
+static void
+internal_load_api_io_thread (GTask        *task,
+                             gpointer      source_object,
+                             gpointer      task_data,
+                             GCancellable *cancellable)
+{
+  GyachtService *self = GYACHT_SERVICE (source_object);
+  GyachtPodmanClient *client = gyacht_podman_client_get_default ();
+  const gchar *path = task_data;
+  JsonParser *parser = NULL;
+  GError *error = NULL;
+
+  if (path == NULL)
+    path = GYACHT_SERVICE_GET_CLASS (self)->get_api_path (self);
+
+  parser = gyacht_podman_client_get_json (client, path, cancellable, &error);
+  if (error)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_pointer (task, parser, g_object_unref);
+}
+
+static void
+internal_stream_data_free (gpointer data)
+{
+  StreamData *stream_data = data;
+
+  g_object_unref (stream_data->location);
+  g_main_context_unref (stream_data->context);
+  g_free (stream_data);
+}
+
+static void
+internal_batch_data_free (gpointer data)
+{
+  BatchData *batch_data = data;
+
+  g_object_unref (batch_data->service);
+  g_sequence_free (batch_data->batch);
+  g_free (batch_data);
+}
+
+static gboolean
+internal_dispatch_batch_cb (gpointer data)
+{
+  BatchData *batch_data = data;
+
+  batch_data->batch_func (batch_data->service,
+                          batch_data->batch,
+                          batch_data->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Hands @batch over to the main context and replaces it with a new one.
+ * Batches are dispatched before the task returns, in order.
+ */
+static void
+internal_flush_batch (GyachtService  *self,
+                      StreamData     *stream_data,
+                      GSequence     **batch)
+{
+  BatchData *batch_data;
+
+  if (g_sequence_is_empty (*batch))
+    return;
+
+  batch_data = g_new0 (BatchData, 1);
+  batch_data->service = g_object_ref (self);
+  batch_data->batch_func = stream_data->batch_func;
+  batch_data->user_data = stream_data->user_data;
+  batch_data->batch = *batch;
+
+  g_main_context_invoke_full (stream_data->context,
+                              G_PRIORITY_DEFAULT,
+                              internal_dispatch_batch_cb,
+                              batch_data,
+                              internal_batch_data_free);
+
+  *batch = g_sequence_new (g_object_unref);
+}
+
+/* Reads a json file whose root is an array and parses its elements one by
+ * one as they come in, instead of loading the whole tree first. Only the
+ * nesting of brackets outside of strings is tracked to find the elements.
+ */
+static void
+internal_stream_json_io_thread (GTask        *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  GyachtService *self = GYACHT_SERVICE (source_object);
+  StreamData *stream_data = task_data;
+  g_autoptr(GFileInputStream) stream = NULL;
+  g_autoptr(JsonParser) parser = NULL;
+  g_autoptr(GString) buffer = NULL;
+  GSequence *batch = NULL;
+  guint batch_size = FIRST_BATCH_SIZE;
+  gint64 last_flush;
+  gboolean in_string = FALSE;
+  gboolean escaped = FALSE;
+  gboolean started = FALSE;
+  gboolean finished = FALSE;
+  gint depth = 0;
+  gssize start = -1;
+  gsize i = 0;
+  gssize n_read = 0;
+  GError *error = NULL;
+
+  stream = g_file_read (stream_data->location, cancellable, &error);
+  if (stream == NULL)
+    goto out_error;
+
+  parser = json_parser_new ();
+  buffer = g_string_sized_new (STREAM_CHUNK_SIZE);
+  batch = g_sequence_new (g_object_unref);
+  last_flush = g_get_monotonic_time ();
+
+  while (!finished)
+    {
+      gsize consumed;
+
+      g_string_set_size (buffer, buffer->len + STREAM_CHUNK_SIZE);
+      n_read = g_input_stream_read (G_INPUT_STREAM (stream),
+                                    buffer->str + buffer->len - STREAM_CHUNK_SIZE,
+                                    STREAM_CHUNK_SIZE,
+                                    cancellable,
+                                    &error);
+      g_string_set_size (buffer, buffer->len - STREAM_CHUNK_SIZE + MAX (n_read, 0));
+      if (n_read <= 0)
+        break;
+
+      for (; i < buffer->len && !finished; i++)
+        {
+          gchar c = buffer->str[i];
+
+          if (in_string)
+            {
+              if (escaped)
+                escaped = FALSE;
+              else if (c == '\\')
+                escaped = TRUE;
+              else if (c == '"')
+                in_string = FALSE;
+              continue;
+            }
+
+          switch (c)
+            {
+            case '"':
+              in_string = TRUE;
+              break;
+
+            case '{':
+            case '[':
+              if (depth == 1 && start < 0)
+                start = i;
+              depth++;
+              started = TRUE;
+              break;
+
+            case '}':
+            case ']':
+              depth--;
+              if (depth == 1 && start >= 0)
+                {
+                  GObject *item;
+
+                  if (!json_parser_load_from_data (parser, buffer->str + start,
+                                                   i + 1 - start, &error))
+                    goto out_error;
+
+                  item = stream_data->parse_func (json_parser_get_root (parser));
+                  if (item)
+                    g_sequence_append (batch, item);
+                  start = -1;
+                }
+              else if (depth <= 0)
+                finished = TRUE;
+              break;
+
+            default:
+              break;
+            }
+        }
+
+      /* Keep the element in progress only */
+      consumed = (start >= 0) ? (gsize) start : i;
+      g_string_erase (buffer, 0, consumed);
+      i -= consumed;
+      if (start >= 0)
+        start = 0;
+
+      if (g_sequence_get_length (batch) >= batch_size ||
+          g_get_monotonic_time () - last_flush >= BATCH_INTERVAL)
+        {
+          internal_flush_batch (self, stream_data, &batch);
+          batch_size = G_MAXUINT;
+          last_flush = g_get_monotonic_time ();
+        }
+    }
+
+  if (n_read < 0)
+    goto out_error;
+
+  /* An empty file is an empty list */
+  if (!finished && started)
+    {
+      g_set_error (&error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                   "Unexpected end of the json contents");
+      goto out_error;
+    }
+
+  internal_flush_batch (self, stream_data, &batch);
+  g_sequence_free (batch);
+
+  g_task_return_boolean (task, TRUE);
+  return;
+
+out_error:
+  g_clear_pointer (&batch, g_sequence_free);
   g_task_return_error (task, error);
 }
 
@@ -126,6 +395,7 @@ gyacht_service_finalize (GObject *object)
                                           G_CALLBACK (internal_file_monitor_changed_cb),
                                           self);
   g_clear_object (&priv->monitor);
+  g_free (priv->watched_name);
 
   G_OBJECT_CLASS (gyacht_service_parent_class)->finalize (object);
 }
@@ -138,16 +408,38 @@ gyacht_service_constructed (GObject *object)
   g_autoptr(GFile) location = NULL;
   g_autoptr(GError) error = NULL;
 
-  location = GYACHT_SERVICE_GET_CLASS (self)->get_json_path (self);
-  if (!gyacht_file_utils_file_exists (location, &error))
+  /* podman tells about changes through its events. The client is created
+   * here so that it emits them on the main context.
+   */
+  if (priv->source == SOURCE_PODMAN_API)
     {
-      gyacht_warn ("Unable to get json contents from file: %s",
-                   error->message);
-      priv->error = TRUE;
+      gyacht_podman_client_get_default ();
       return;
     }
 
-  priv->monitor = g_file_monitor_file (location, G_FILE_MONITOR_NONE, NULL, NULL);
+  location = GYACHT_SERVICE_GET_CLASS (self)->get_json_path (self);
+  if (gyacht_file_utils_file_exists (location, &error))
+    priv->monitor = g_file_monitor_file (location, G_FILE_MONITOR_NONE, NULL, NULL);
+  else
+    {
+      g_autoptr(GFile) parent = g_file_get_parent (location);
+
+      if (!GYACHT_SERVICE_GET_CLASS (self)->json_optional ||
+          !g_file_query_exists (parent, NULL))
+        {
+          gyacht_warn ("Unable to get json contents from file: %s",
+                       error->message);
+          priv->error = TRUE;
+          return;
+        }
+
+      /* A file monitor would poll for the file to appear. The directory
+       * tells at once, and keeps telling once the file is there.
+       */
+      priv->watched_name = g_file_get_basename (location);
+      priv->monitor = g_file_monitor_directory (parent, G_FILE_MONITOR_NONE, NULL, NULL);
+    }
+
   g_signal_connect (priv->monitor,
                     "changed",
                     G_CALLBACK (internal_file_monitor_changed_cb),
@@ -208,17 +500,19 @@ gyacht_service_set_property (GObject      *object,
 }
 
 /* --- GyachtService class definitions --- */
-static void
-gyacht_service_clear_list (GyachtService *self)
+static GFile *
+gyacht_service_get_json_path (GyachtService *self)
 {
-  /* Prevent developers forget to implement children' clear_sequence() */
+  /* Prevent developers forget to implement children' get_json_path() */
   g_assert_not_reached ();
+
+  return NULL;
 }
 
-static GFile *
-gyacht_service_get_json_path (GyachtService *self)
+static const gchar *
+gyacht_service_get_api_path (GyachtService *self)
 {
-  /* Prevent developers forget to implement children' get_json_path() */
+  /* Prevent developers forget to implement children' get_api_path() */
   g_assert_not_reached ();
 
   return NULL;
@@ -234,8 +528,8 @@ gyacht_service_class_init (GyachtServiceClass *klass)
   object_class->get_property = gyacht_service_get_property;
   object_class->set_property = gyacht_service_set_property;
 
-  klass->clear_list = gyacht_service_clear_list;
   klass->get_json_path = gyacht_service_get_json_path;
+  klass->get_api_path = gyacht_service_get_api_path;
 
   properties [PROP_RUN_LEVEL] =
     g_param_spec_uint ("run-level",
@@ -261,6 +555,43 @@ gyacht_service_class_init (GyachtServiceClass *klass)
                   G_SIGNAL_RUN_LAST,
                   0, NULL, NULL, NULL,
                   G_TYPE_NONE, 0);
+
+  /* Emitted while the first load is in progress, then once when it is done */
+  signals [LOAD_PROGRESS] =
+    g_signal_new ("load-progress",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 2,
+                  G_TYPE_UINT,      /* number of items so far */
+                  G_TYPE_BOOLEAN);  /* done */
+
+  /* The following are emitted when a single item of the list has been
+   * added, removed or modified in place, without reloading the whole list.
+   */
+  signals [ITEM_ADDED] =
+    g_signal_new ("item-added",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_OBJECT);
+
+  signals [ITEM_REMOVED] =
+    g_signal_new ("item-removed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_OBJECT);
+
+  signals [ITEM_CHANGED] =
+    g_signal_new ("item-changed",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_OBJECT);
 }
 
 static void
@@ -269,6 +600,43 @@ gyacht_service_init (GyachtService *self)
   GyachtServicePrivate *priv = gyacht_service_get_instance_private (self);
 
   priv->error = FALSE;
+  priv->loaded = FALSE;
+  priv->source = default_source;
+}
+
+/* --- Public APIs --- */
+
+/**
+ * gyacht_service_set_default_source:
+ * @source: A #GyachtSource.
+ *
+ * Sets where services created from now on get their lists from. It is
+ * meant to be called once, before any service exists.
+ */
+void
+gyacht_service_set_default_source (GyachtSource source)
+{
+  g_return_if_fail (source < N_SOURCES);
+
+  default_source = source;
+}
+
+/**
+ * gyacht_service_is_loaded:
+ * @self: A #GyachtService.
+ *
+ * Return value: %TRUE once the first load of the list is done.
+ */
+gboolean
+gyacht_service_is_loaded (GyachtService *self)
+{
+  GyachtServicePrivate *priv;
+
+  g_return_val_if_fail (GYACHT_IS_SERVICE (self), FALSE);
+
+  priv = gyacht_service_get_instance_private (self);
+
+  return priv->loaded;
 }
 
 /* --- Private APIs --- */
@@ -284,6 +652,18 @@ gyacht_service_get_run_level (GyachtService *self)
   return priv->level;
 }
 
+GyachtSource
+gyacht_service_get_source (GyachtService *self)
+{
+  GyachtServicePrivate *priv;
+
+  g_return_val_if_fail (GYACHT_IS_SERVICE (self), SOURCE_STORAGE);
+
+  priv = gyacht_service_get_instance_private (self);
+
+  return priv->source;
+}
+
 gboolean
 gyacht_service_error_occur (GyachtService *self)
 {
@@ -296,29 +676,77 @@ gyacht_service_error_occur (GyachtService *self)
   return priv->error;
 }
 
+/**
+ * gyacht_service_load_json_file_async:
+ * @self: A #GyachtService.
+ * @location: The json file to load.
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: User data for @callback.
+ *
+ * Loads @location in a worker thread and leaves the list alone, so the
+ * caller can merge the result into it. Finish it with
+ * gyacht_service_load_json_finish().
+ */
 void
-gyacht_service_load_json_async (GyachtService       *self,
-                                GCancellable        *cancellable,
-                                GAsyncReadyCallback  callback,
-                                gpointer             user_data)
+gyacht_service_load_json_file_async (GyachtService       *self,
+                                     GFile               *location,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
 {
   g_autoptr(GTask) task = NULL;
 
   GYACHT_TRACE_ENTRY;
 
   g_return_if_fail (GYACHT_IS_SERVICE (self));
-
-  GYACHT_SERVICE_GET_CLASS (self)->clear_list (self);
+  g_return_if_fail (G_IS_FILE (location));
 
   task = g_task_new (G_OBJECT (self),
                      cancellable,
                      callback,
                      user_data);
+  g_task_set_task_data (task, g_object_ref (location), g_object_unref);
   g_task_run_in_thread (task, internal_load_json_io_thread);
 
   GYACHT_TRACE_EXIT;
 }
 
+/**
+ * gyacht_service_load_api_async:
+ * @self: A #GyachtService.
+ * @path: (nullable): The request path, or %NULL for get_api_path().
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: User data for @callback.
+ *
+ * Requests @path from the podman API and leaves the list alone, like
+ * gyacht_service_load_json_file_async() does for files. Finish it with
+ * gyacht_service_load_json_finish().
+ */
+void
+gyacht_service_load_api_async (GyachtService       *self,
+                               const gchar         *path,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  GYACHT_TRACE_ENTRY;
+
+  g_return_if_fail (GYACHT_IS_SERVICE (self));
+
+  task = g_task_new (G_OBJECT (self),
+                     cancellable,
+                     callback,
+                     user_data);
+  g_task_set_task_data (task, g_strdup (path), g_free);
+  g_task_run_in_thread (task, internal_load_api_io_thread);
+
+  GYACHT_TRACE_EXIT;
+}
+
 JsonParser *
 gyacht_service_load_json_finish (GyachtService  *self,
                                  GAsyncResult   *res,
@@ -339,3 +767,94 @@ gyacht_service_load_json_finish (GyachtService  *self,
 
   return ret;
 }
+
+/**
+ * gyacht_service_stream_json_file_async:
+ * @self: A #GyachtService.
+ * @location: The json file to load, whose root is an array.
+ * @parse_func: Turns an element of the array into an item.
+ * @batch_func: Receives the items in batches.
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: User data for @batch_func and @callback.
+ *
+ * Like gyacht_service_load_json_file_async(), but the items are handed
+ * over to @batch_func while the file is still being read, so the first of
+ * them can be shown before a large file is done. Every batch is delivered
+ * before @callback is called. Finish it with
+ * gyacht_service_stream_json_finish().
+ */
+void
+gyacht_service_stream_json_file_async (GyachtService          *self,
+                                       GFile                  *location,
+                                       GyachtServiceParseFunc  parse_func,
+                                       GyachtServiceBatchFunc  batch_func,
+                                       GCancellable           *cancellable,
+                                       GAsyncReadyCallback     callback,
+                                       gpointer                user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  StreamData *stream_data;
+
+  GYACHT_TRACE_ENTRY;
+
+  g_return_if_fail (GYACHT_IS_SERVICE (self));
+  g_return_if_fail (G_IS_FILE (location));
+  g_return_if_fail (parse_func != NULL);
+  g_return_if_fail (batch_func != NULL);
+
+  stream_data = g_new0 (StreamData, 1);
+  stream_data->location = g_object_ref (location);
+  stream_data->parse_func = parse_func;
+  stream_data->batch_func = batch_func;
+  stream_data->user_data = user_data;
+  stream_data->context = g_main_context_ref_thread_default ();
+
+  task = g_task_new (G_OBJECT (self),
+                     cancellable,
+                     callback,
+                     user_data);
+  g_task_set_task_data (task, stream_data, internal_stream_data_free);
+  g_task_run_in_thread (task, internal_stream_json_io_thread);
+
+  GYACHT_TRACE_EXIT;
+}
+
+gboolean
+gyacht_service_stream_json_finish (GyachtService  *self,
+                                   GAsyncResult   *res,
+                                   GError        **error)
+{
+  g_return_val_if_fail (GYACHT_IS_SERVICE (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (res, G_OBJECT (self)), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+/**
+ * gyacht_service_report_progress:
+ * @self: A #GyachtService.
+ * @n_items: The number of items loaded so far.
+ * @done: Whether the load is complete.
+ *
+ * Emits #GyachtService::load-progress, but only until the first load is
+ * done. Later reloads are not worth telling about.
+ */
+void
+gyacht_service_report_progress (GyachtService *self,
+                                guint          n_items,
+                                gboolean       done)
+{
+  GyachtServicePrivate *priv;
+
+  g_return_if_fail (GYACHT_IS_SERVICE (self));
+
+  priv = gyacht_service_get_instance_private (self);
+
+  if (priv->loaded)
+    return;
+
+  priv->loaded = done;
+  g_signal_emit (self, signals[LOAD_PROGRESS], 0, n_items, done);
+}
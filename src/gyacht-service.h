@@ -36,8 +36,14 @@ struct _GyachtServiceClass
 {
   GObjectClass  parent_class;
 
-  void          (*clear_list)           (GyachtService *service);
   GFile *       (*get_json_path)        (GyachtService *service);
+  const gchar * (*get_api_path)         (GyachtService *service);
+
+  /* Whether the file is only created once there is something to store */
+  gboolean      json_optional;
 };
 
+void      gyacht_service_set_default_source (GyachtSource   source);
+gboolean  gyacht_service_is_loaded          (GyachtService *self);
+
 G_END_DECLS
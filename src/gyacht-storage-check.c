@@ -0,0 +1,590 @@
+/* gyacht-storage-check.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-debug.h"
+#include "gyacht-path-manager.h"
+#include "gyacht-storage-check.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* Finds what crashed builds and interrupted removals leave behind: layer
+ * directories, layer metadata and container directories which no record
+ * refers to.
+ *
+ * The three directories are listed in parallel worker threads. Each
+ * listing is then compared on the main thread against the loaded model,
+ * with a lookup in the id index of the layer service per entry, and the
+ * orphans are sized on the pool of the disk usage scanner.
+ *
+ * Entries younger than a grace period are skipped, their records may be
+ * on the way.
+ */
+
+#define ID_LENGTH           64
+#define ORPHAN_GRACE_SECS   60
+
+typedef enum
+{
+  LISTING_LAYER_DIRS = 0,
+  LISTING_LAYER_FILES,
+  LISTING_CONTAINER_DIRS,
+  N_LISTINGS
+} ListingKind;
+
+typedef struct
+{
+  ListingKind kind;
+  gchar       *dir;
+  gint64      before;   /* Entries modified since are skipped */
+} ListRequest;
+
+typedef struct
+{
+  gchar     *id;
+  gchar     *path;
+  guint64   size;     /* Of files only, directories are scanned */
+} Entry;
+
+typedef struct
+{
+  gchar     *path;
+  guint64   size;
+} Orphan;
+
+struct _GyachtStorageReport
+{
+  gint        ref_count;
+
+  GArray      *orphans;   /* Orphan, the largest first */
+  guint64     total_size;
+};
+
+typedef struct
+{
+  GyachtLayerService      *layers;
+  GyachtContainerService  *containers;
+  GyachtDiskUsage         *disk_usage;
+
+  GHashTable              *container_ids;
+  GyachtStorageReport     *report;
+  guint                   pending;    /* Listings and scans */
+  gboolean                waiting;    /* For the services to load */
+} CheckData;
+
+typedef struct
+{
+  GTask   *task;
+  guint   index;
+} SizeRequest;
+
+
+static void
+internal_orphan_clear (gpointer data)
+{
+  Orphan *orphan = data;
+
+  g_free (orphan->path);
+}
+
+static void
+internal_entry_free (gpointer data)
+{
+  Entry *entry = data;
+
+  g_free (entry->id);
+  g_free (entry->path);
+  g_free (entry);
+}
+
+static void
+internal_list_request_free (gpointer data)
+{
+  ListRequest *request = data;
+
+  g_free (request->dir);
+  g_free (request);
+}
+
+static void
+internal_check_data_free (gpointer data)
+{
+  CheckData *check = data;
+
+  g_clear_object (&check->layers);
+  g_clear_object (&check->containers);
+  g_clear_object (&check->disk_usage);
+  g_clear_pointer (&check->container_ids, g_hash_table_unref);
+  g_clear_pointer (&check->report, gyacht_storage_report_unref);
+  g_free (check);
+}
+
+static gboolean
+internal_is_id (const gchar *name,
+                gsize        length)
+{
+  gsize i;
+
+  if (length != ID_LENGTH)
+    return FALSE;
+
+  for (i = 0; i < length; i++)
+    if (!g_ascii_isxdigit (name[i]) || g_ascii_isupper (name[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Return value: The id an entry of a listing stands for, or %NULL */
+static gchar *
+internal_dup_entry_id (ListingKind  kind,
+                       const gchar *name)
+{
+  gsize length = strlen (name);
+
+  if (kind == LISTING_LAYER_FILES)
+    {
+      if (!g_str_has_suffix (name, TAR_SPLIT_SUFFIX))
+        return NULL;
+      length -= strlen (TAR_SPLIT_SUFFIX);
+    }
+
+  if (!internal_is_id (name, length))
+    return NULL;
+
+  return g_strndup (name, length);
+}
+
+static void
+internal_list_io_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  ListRequest *request = task_data;
+  g_autoptr(GPtrArray) entries = NULL;
+  struct dirent *dirent;
+  DIR *dir;
+
+  entries = g_ptr_array_new_with_free_func (internal_entry_free);
+
+  dir = opendir (request->dir);
+  if (dir == NULL)
+    {
+      gint saved_errno = errno;
+
+      /* Nothing was ever stored there */
+      if (saved_errno == ENOENT)
+        {
+          g_task_return_pointer (task, g_steal_pointer (&entries),
+                                 (GDestroyNotify) g_ptr_array_unref);
+          return;
+        }
+
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               g_io_error_from_errno (saved_errno),
+                               "Unable to list %s: %s",
+                               request->dir,
+                               g_strerror (saved_errno));
+      return;
+    }
+
+  while ((dirent = readdir (dir)) && !g_cancellable_is_cancelled (cancellable))
+    {
+      g_autofree gchar *id = NULL;
+      struct stat st;
+      Entry *entry;
+
+      id = internal_dup_entry_id (request->kind, dirent->d_name);
+      if (id == NULL)
+        continue;
+
+      if (fstatat (dirfd (dir), dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+        continue;
+
+      if (st.st_mtime >= request->before)
+        continue;
+
+      if (request->kind == LISTING_LAYER_FILES ? !S_ISREG (st.st_mode) : !S_ISDIR (st.st_mode))
+        continue;
+
+      entry = g_new0 (Entry, 1);
+      entry->id = g_steal_pointer (&id);
+      entry->path = g_build_filename (request->dir, dirent->d_name, NULL);
+      entry->size = (guint64) st.st_blocks * 512;
+      g_ptr_array_add (entries, entry);
+    }
+
+  closedir (dir);
+
+  g_task_return_pointer (task, g_steal_pointer (&entries),
+                         (GDestroyNotify) g_ptr_array_unref);
+}
+
+static gint
+internal_compare_orphans (gconstpointer a,
+                          gconstpointer b)
+{
+  const Orphan *orphan1 = a;
+  const Orphan *orphan2 = b;
+
+  if (orphan1->size != orphan2->size)
+    return orphan1->size > orphan2->size ? -1 : 1;
+
+  return g_strcmp0 (orphan1->path, orphan2->path);
+}
+
+/* Returns the report once the last listing or scan is done */
+static void
+internal_check_step_done (GTask *task)
+{
+  CheckData *check = g_task_get_task_data (task);
+  GyachtStorageReport *report = check->report;
+  guint i;
+
+  if (--check->pending > 0)
+    return;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  g_array_sort (report->orphans, internal_compare_orphans);
+  for (i = 0; i < report->orphans->len; i++)
+    report->total_size += g_array_index (report->orphans, Orphan, i).size;
+
+  g_task_return_pointer (task,
+                         g_steal_pointer (&check->report),
+                         (GDestroyNotify) gyacht_storage_report_unref);
+}
+
+static void
+internal_sized_cb (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  SizeRequest *request = user_data;
+  CheckData *check = g_task_get_task_data (request->task);
+  g_autoptr(GError) error = NULL;
+  Orphan *orphan;
+  guint64 size = 0;
+
+  orphan = &g_array_index (check->report->orphans, Orphan, request->index);
+
+  if (gyacht_disk_usage_scan_finish (GYACHT_DISK_USAGE (source_object), res, &size, &error))
+    orphan->size = size;
+  else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    gyacht_warn ("Unable to size %s: %s", orphan->path, error->message);
+
+  /* Nothing is kept for a one-off scan */
+  gyacht_disk_usage_forget (GYACHT_DISK_USAGE (source_object), orphan->path);
+
+  internal_check_step_done (request->task);
+  g_object_unref (request->task);
+  g_free (request);
+}
+
+static gboolean
+internal_is_orphan (CheckData   *check,
+                    ListingKind  kind,
+                    const gchar *id)
+{
+  if (kind == LISTING_CONTAINER_DIRS)
+    return !g_hash_table_contains (check->container_ids, id);
+
+  return gyacht_layer_service_lookup (check->layers, id) == NULL;
+}
+
+static void
+internal_listed_cb (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  CheckData *check = g_task_get_task_data (task);
+  ListRequest *request = g_task_get_task_data (G_TASK (res));
+  g_autoptr(GPtrArray) entries = NULL;
+  g_autoptr(GError) error = NULL;
+  guint i;
+
+  entries = g_task_propagate_pointer (G_TASK (res), &error);
+  if (error)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        gyacht_warn ("%s", error->message);
+      internal_check_step_done (task);
+      return;
+    }
+
+  for (i = 0; i < entries->len; i++)
+    {
+      Entry *entry = g_ptr_array_index (entries, i);
+      Orphan orphan = { NULL, entry->size };
+      SizeRequest *size_request;
+
+      if (!internal_is_orphan (check, request->kind, entry->id))
+        continue;
+
+      orphan.path = g_steal_pointer (&entry->path);
+      g_array_append_val (check->report->orphans, orphan);
+
+      if (request->kind == LISTING_LAYER_FILES)
+        continue;
+
+      size_request = g_new0 (SizeRequest, 1);
+      size_request->task = g_object_ref (task);
+      size_request->index = check->report->orphans->len - 1;
+
+      check->pending++;
+      gyacht_disk_usage_scan_async (check->disk_usage,
+                                    orphan.path,
+                                    g_task_get_cancellable (task),
+                                    internal_sized_cb,
+                                    size_request);
+    }
+
+  gyacht_debug ("%u entries listed in %s", entries->len, request->dir);
+
+  internal_check_step_done (task);
+}
+
+static void
+internal_start_listing (GTask       *task,
+                        ListingKind  kind,
+                        gchar       *dir,
+                        gint64       before)
+{
+  g_autoptr(GTask) listing = NULL;
+  ListRequest *request;
+
+  request = g_new0 (ListRequest, 1);
+  request->kind = kind;
+  request->dir = dir;
+  request->before = before;
+
+  listing = g_task_new (NULL,
+                        g_task_get_cancellable (task),
+                        internal_listed_cb,
+                        g_object_ref (task));
+  g_task_set_source_tag (listing, internal_start_listing);
+  g_task_set_task_data (listing, request, internal_list_request_free);
+  g_task_run_in_thread (listing, internal_list_io_thread);
+}
+
+static void
+internal_start_check (GTask *task)
+{
+  CheckData *check = g_task_get_task_data (task);
+  GSequence *containers;
+  GSequenceIter *iter;
+  gint64 before;
+
+  GYACHT_TRACE_ENTRY;
+
+  check->container_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  containers = gyacht_container_service_get_containers (check->containers);
+  for (iter = containers ? g_sequence_get_begin_iter (containers) : NULL;
+       iter && !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    g_hash_table_add (check->container_ids,
+                      g_strdup (gyacht_container_get_id (g_sequence_get (iter))));
+
+  check->report = g_new0 (GyachtStorageReport, 1);
+  check->report->ref_count = 1;
+  check->report->orphans = g_array_new (FALSE, FALSE, sizeof (Orphan));
+  g_array_set_clear_func (check->report->orphans, internal_orphan_clear);
+
+  before = g_get_real_time () / G_USEC_PER_SEC - ORPHAN_GRACE_SECS;
+
+  check->pending = N_LISTINGS;
+  internal_start_listing (task, LISTING_LAYER_DIRS, gyacht_dup_user_overlay_dir (), before);
+  internal_start_listing (task, LISTING_LAYER_FILES, gyacht_dup_user_layers_dir (), before);
+  internal_start_listing (task, LISTING_CONTAINER_DIRS, gyacht_dup_user_containers_dir (), before);
+
+  GYACHT_TRACE_EXIT;
+}
+
+/* Everything looks orphaned to a model which is not loaded */
+static gboolean
+internal_is_model_loaded (CheckData *check)
+{
+  return gyacht_service_is_loaded (GYACHT_SERVICE (check->layers)) &&
+         gyacht_service_is_loaded (GYACHT_SERVICE (check->containers));
+}
+
+static void
+internal_load_progress_cb (GyachtService *service,
+                           guint          n_items,
+                           gboolean       done,
+                           GTask         *task)
+{
+  CheckData *check = g_task_get_task_data (task);
+
+  if (!check->waiting || !internal_is_model_loaded (check))
+    return;
+
+  check->waiting = FALSE;
+  g_signal_handlers_disconnect_by_func (check->layers,
+                                        G_CALLBACK (internal_load_progress_cb),
+                                        task);
+  g_signal_handlers_disconnect_by_func (check->containers,
+                                        G_CALLBACK (internal_load_progress_cb),
+                                        task);
+
+  internal_start_check (task);
+  g_object_unref (task);
+}
+
+/* --- Public APIs --- */
+GyachtStorageReport *
+gyacht_storage_report_ref (GyachtStorageReport *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  g_atomic_int_inc (&self->ref_count);
+
+  return self;
+}
+
+void
+gyacht_storage_report_unref (GyachtStorageReport *self)
+{
+  g_return_if_fail (self != NULL);
+
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_array_unref (self->orphans);
+  g_free (self);
+}
+
+guint
+gyacht_storage_report_get_n_orphans (GyachtStorageReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->orphans->len;
+}
+
+const gchar *
+gyacht_storage_report_get_orphan_path (GyachtStorageReport *self,
+                                       guint                index_)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (index_ < self->orphans->len, NULL);
+
+  return g_array_index (self->orphans, Orphan, index_).path;
+}
+
+guint64
+gyacht_storage_report_get_orphan_size (GyachtStorageReport *self,
+                                       guint                index_)
+{
+  g_return_val_if_fail (self != NULL, 0);
+  g_return_val_if_fail (index_ < self->orphans->len, 0);
+
+  return g_array_index (self->orphans, Orphan, index_).size;
+}
+
+guint64
+gyacht_storage_report_get_total_size (GyachtStorageReport *self)
+{
+  g_return_val_if_fail (self != NULL, 0);
+
+  return self->total_size;
+}
+
+/**
+ * gyacht_storage_check_async:
+ * @layers: A #GyachtLayerService.
+ * @containers: A #GyachtContainerService.
+ * @disk_usage: The scanner the orphans are sized with.
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: Called with the report.
+ * @user_data: Data for @callback.
+ *
+ * Lists the storage directories and reports those entries which none of
+ * the loaded layers and containers refers to. The check waits for both
+ * services to be loaded.
+ */
+void
+gyacht_storage_check_async (GyachtLayerService     *layers,
+                            GyachtContainerService *containers,
+                            GyachtDiskUsage        *disk_usage,
+                            GCancellable           *cancellable,
+                            GAsyncReadyCallback     callback,
+                            gpointer                user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  CheckData *check;
+
+  g_return_if_fail (GYACHT_IS_LAYER_SERVICE (layers));
+  g_return_if_fail (GYACHT_IS_CONTAINER_SERVICE (containers));
+  g_return_if_fail (GYACHT_IS_DISK_USAGE (disk_usage));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gyacht_storage_check_async);
+
+  /* The layers are not known then */
+  if (gyacht_service_get_source (GYACHT_SERVICE (layers)) == SOURCE_PODMAN_API)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_NOT_SUPPORTED,
+                               "The storage is checked only when it is read directly");
+      return;
+    }
+
+  check = g_new0 (CheckData, 1);
+  check->layers = g_object_ref (layers);
+  check->containers = g_object_ref (containers);
+  check->disk_usage = g_object_ref (disk_usage);
+  g_task_set_task_data (task, check, internal_check_data_free);
+
+  if (internal_is_model_loaded (check))
+    {
+      internal_start_check (task);
+      return;
+    }
+
+  /* Either service may be the last one, the reference goes with the wait */
+  check->waiting = TRUE;
+  g_signal_connect (layers,
+                    "load-progress",
+                    G_CALLBACK (internal_load_progress_cb),
+                    task);
+  g_signal_connect (containers,
+                    "load-progress",
+                    G_CALLBACK (internal_load_progress_cb),
+                    task);
+  g_steal_pointer (&task);
+}
+
+GyachtStorageReport *
+gyacht_storage_check_finish (GAsyncResult  *res,
+                             GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (res, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
@@ -0,0 +1,54 @@
+/* gyacht-storage-check.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "gyacht-container-service.h"
+#include "gyacht-disk-usage.h"
+#include "gyacht-layer-service.h"
+
+G_BEGIN_DECLS
+
+/* Storage no record refers to, immutable once checked */
+typedef struct _GyachtStorageReport GyachtStorageReport;
+
+GyachtStorageReport * gyacht_storage_report_ref              (GyachtStorageReport *self);
+void                  gyacht_storage_report_unref            (GyachtStorageReport *self);
+guint                 gyacht_storage_report_get_n_orphans    (GyachtStorageReport *self);
+const gchar *         gyacht_storage_report_get_orphan_path  (GyachtStorageReport *self,
+                                                              guint                index_);
+guint64               gyacht_storage_report_get_orphan_size  (GyachtStorageReport *self,
+                                                              guint                index_);
+guint64               gyacht_storage_report_get_total_size   (GyachtStorageReport *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (GyachtStorageReport, gyacht_storage_report_unref)
+
+void                  gyacht_storage_check_async             (GyachtLayerService     *layers,
+                                                              GyachtContainerService *containers,
+                                                              GyachtDiskUsage        *disk_usage,
+                                                              GCancellable           *cancellable,
+                                                              GAsyncReadyCallback     callback,
+                                                              gpointer                user_data);
+GyachtStorageReport * gyacht_storage_check_finish            (GAsyncResult           *res,
+                                                              GError                **error);
+
+G_END_DECLS
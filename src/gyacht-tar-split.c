@@ -0,0 +1,182 @@
+/* gyacht-tar-split.c
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gyacht-tar-split.h"
+
+#include <json-glib/json-glib.h>
+
+/* tar-split is the metadata podman keeps to rebuild the tar stream of a
+ * layer: a gzipped line of JSON per tar header segment and per file.
+ */
+
+#define CANCEL_CHECK_LINES  4096
+
+
+static gchar *
+internal_dup_entry_name (JsonObject *object)
+{
+  JsonNode *member;
+
+  member = json_object_get_member (object, "name");
+  if (member && json_node_get_value_type (member) == G_TYPE_STRING)
+    return g_strdup (json_node_get_string (member));
+
+  /* Names which are not UTF-8 */
+  member = json_object_get_member (object, "name_raw");
+  if (member && json_node_get_value_type (member) == G_TYPE_STRING)
+    {
+      g_autofree guchar *raw = NULL;
+      gsize length;
+
+      raw = g_base64_decode (json_node_get_string (member), &length);
+      return g_strndup ((const gchar *) raw, length);
+    }
+
+  return NULL;
+}
+
+static gboolean
+internal_dispatch (JsonObject          *object,
+                   GyachtTarSplitFunc   func,
+                   gpointer             user_data,
+                   GError             **error)
+{
+  GyachtTarSplitEntry entry = { 0, };
+
+  if (!json_object_has_member (object, "type"))
+    return TRUE;
+  entry.type = json_object_get_int_member (object, "type");
+
+  if (entry.type == TAR_SPLIT_SEGMENT)
+    {
+      JsonNode *payload = json_object_get_member (object, "payload");
+      g_autofree guchar *raw = NULL;
+
+      if (payload == NULL || json_node_get_value_type (payload) != G_TYPE_STRING)
+        return TRUE;
+
+      raw = g_base64_decode (json_node_get_string (payload), &entry.payload_length);
+      entry.payload = raw;
+      return func (&entry, user_data, error);
+    }
+  else if (entry.type == TAR_SPLIT_FILE)
+    {
+      g_autofree gchar *name = NULL;
+
+      name = internal_dup_entry_name (object);
+      entry.name = name;
+      entry.size = json_object_has_member (object, "size") ?
+                   json_object_get_int_member (object, "size") : 0;
+      return func (&entry, user_data, error);
+    }
+
+  return TRUE;
+}
+
+
+/* --- Public APIs --- */
+
+/**
+ * gyacht_tar_split_foreach:
+ * @path: The gzipped tar-split file of a layer
+ * @strict: Whether a line which is not JSON is an error rather than skipped
+ * @func: Called in order for each segment and file
+ * @user_data: For @func
+ * @cancellable: (nullable): A #GCancellable
+ * @error: Return location for an error
+ *
+ * Reads the entries of tar-split one line at a time, so that the size of
+ * the file does not matter. Stops at the first error, including one set by
+ * @func returning %FALSE.
+ *
+ * Return value: %TRUE if every entry was read
+ */
+gboolean
+gyacht_tar_split_foreach (const gchar         *path,
+                          gboolean             strict,
+                          GyachtTarSplitFunc   func,
+                          gpointer             user_data,
+                          GCancellable        *cancellable,
+                          GError             **error)
+{
+  g_autoptr(GFile) file = NULL;
+  g_autoptr(GFileInputStream) file_stream = NULL;
+  g_autoptr(GZlibDecompressor) decompressor = NULL;
+  g_autoptr(GInputStream) converter = NULL;
+  g_autoptr(GDataInputStream) data_stream = NULL;
+  g_autoptr(JsonParser) parser = NULL;
+  guint n_lines = 0;
+
+  g_return_val_if_fail (path != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  file = g_file_new_for_path (path);
+  file_stream = g_file_read (file, cancellable, error);
+  if (file_stream == NULL)
+    return FALSE;
+
+  decompressor = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+  converter = g_converter_input_stream_new (G_INPUT_STREAM (file_stream),
+                                            G_CONVERTER (decompressor));
+  data_stream = g_data_input_stream_new (converter);
+  parser = json_parser_new ();
+
+  for (;;)
+    {
+      g_autofree gchar *line = NULL;
+      g_autoptr(GError) local_error = NULL;
+      JsonNode *root;
+      gsize length;
+
+      line = g_data_input_stream_read_line (data_stream, &length, cancellable, &local_error);
+      if (line == NULL)
+        {
+          if (local_error)
+            {
+              g_propagate_error (error, g_steal_pointer (&local_error));
+              return FALSE;
+            }
+          break;
+        }
+
+      if (++n_lines % CANCEL_CHECK_LINES == 0 &&
+          g_cancellable_set_error_if_cancelled (cancellable, error))
+        return FALSE;
+
+      if (!json_parser_load_from_data (parser, line, length, &local_error))
+        {
+          if (strict)
+            {
+              g_propagate_error (error, g_steal_pointer (&local_error));
+              return FALSE;
+            }
+          continue;
+        }
+
+      root = json_parser_get_root (parser);
+      if (root == NULL || !JSON_NODE_HOLDS_OBJECT (root))
+        continue;
+
+      if (!internal_dispatch (json_node_get_object (root), func, user_data, error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
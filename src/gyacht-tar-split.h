@@ -0,0 +1,54 @@
+/* gyacht-tar-split.h
+ *
+ * Copyright 2019 Yi-Soo An <yisooan@fedoraproject.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* Types of the entries of tar-split */
+typedef enum {
+  TAR_SPLIT_FILE = 1,
+  TAR_SPLIT_SEGMENT = 2
+} GyachtTarSplitType;
+
+/* An entry of tar-split, valid for the call it is given to only */
+typedef struct
+{
+  GyachtTarSplitType  type;
+  const guchar        *payload;         /* Of a segment, decoded */
+  gsize               payload_length;
+  const gchar         *name;            /* Of a file as archived, NULL if missing */
+  gint64              size;             /* Of a file */
+} GyachtTarSplitEntry;
+
+typedef gboolean (*GyachtTarSplitFunc) (const GyachtTarSplitEntry  *entry,
+                                        gpointer                    user_data,
+                                        GError                    **error);
+
+gboolean  gyacht_tar_split_foreach  (const gchar         *path,
+                                     gboolean             strict,
+                                     GyachtTarSplitFunc   func,
+                                     gpointer             user_data,
+                                     GCancellable        *cancellable,
+                                     GError             **error);
+
+G_END_DECLS
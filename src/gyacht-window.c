@@ -28,29 +28,170 @@
 struct _GyachtWindow
 {
   GtkApplicationWindow    parent_instance;
+
+  /* Template widgets */
+  GtkStack                *stack;
+  GtkWidget               *container_list_view;
+  GtkWidget               *images_page;
+
+  /* Created on the first switch to its page or once the window is idle */
+  GtkWidget               *image_list_view;
+  guint                   idle_id;
 };
 
 G_DEFINE_TYPE (GyachtWindow, gyacht_window, GTK_TYPE_APPLICATION_WINDOW)
 
 
+/* The image view creates the image service, so building it lazily also
+ * keeps the second storage file out of the way of the first paint.
+ */
+static void
+internal_ensure_image_list_view (GyachtWindow *self)
+{
+  if (self->image_list_view)
+    return;
+
+  GYACHT_TRACE_ENTRY;
+
+  if (self->idle_id)
+    {
+      g_source_remove (self->idle_id);
+      self->idle_id = 0;
+    }
+
+  self->image_list_view = g_object_new (GYACHT_TYPE_IMAGE_LIST_VIEW,
+                                        "can-focus", FALSE,
+                                        "vexpand", TRUE,
+                                        NULL);
+  gtk_container_add (GTK_CONTAINER (self->images_page), self->image_list_view);
+  gtk_widget_show (self->image_list_view);
+
+  GYACHT_TRACE_EXIT;
+}
+
+static void
+internal_visible_child_changed_cb (GtkStack     *stack,
+                                   GParamSpec   *pspec,
+                                   GyachtWindow *self)
+{
+  if (gtk_stack_get_visible_child (stack) == self->images_page)
+    internal_ensure_image_list_view (self);
+}
+
+static gboolean
+internal_idle_cb (gpointer user_data)
+{
+  GyachtWindow *self = GYACHT_WINDOW (user_data);
+
+  self->idle_id = 0;
+  internal_ensure_image_list_view (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+internal_after_paint_cb (GdkFrameClock *clock,
+                         GyachtWindow  *self)
+{
+  g_signal_handlers_disconnect_by_func (clock,
+                                        G_CALLBACK (internal_after_paint_cb),
+                                        self);
+
+  if (self->image_list_view == NULL && self->idle_id == 0)
+    self->idle_id = g_idle_add_full (G_PRIORITY_LOW,
+                                     internal_idle_cb,
+                                     self,
+                                     NULL);
+}
+
+/* --- GtkWidget --- */
+static void
+gyacht_window_realize (GtkWidget *widget)
+{
+  GyachtWindow *self = GYACHT_WINDOW (widget);
+
+  GTK_WIDGET_CLASS (gyacht_window_parent_class)->realize (widget);
+
+  if (self->image_list_view)
+    return;
+
+  /* Wait for the visible page to be painted once */
+  g_signal_connect_object (gtk_widget_get_frame_clock (widget),
+                           "after-paint",
+                           G_CALLBACK (internal_after_paint_cb),
+                           widget,
+                           0);
+}
+
+static gboolean
+gyacht_window_key_press_event (GtkWidget   *widget,
+                               GdkEventKey *event)
+{
+  GyachtWindow *self = GYACHT_WINDOW (widget);
+  GtkWidget *page = gtk_stack_get_visible_child (self->stack);
+
+  /* Typing anywhere searches the visible list */
+  if (page == self->container_list_view &&
+      gyacht_container_list_view_handle_event (GYACHT_CONTAINER_LIST_VIEW (page),
+                                               (GdkEvent *) event))
+    return GDK_EVENT_STOP;
+
+  if (page == self->images_page && self->image_list_view &&
+      gyacht_image_list_view_handle_event (GYACHT_IMAGE_LIST_VIEW (self->image_list_view),
+                                           (GdkEvent *) event))
+    return GDK_EVENT_STOP;
+
+  return GTK_WIDGET_CLASS (gyacht_window_parent_class)->key_press_event (widget, event);
+}
+
 /* --- GObject --- */
+static void
+gyacht_window_dispose (GObject *object)
+{
+  GyachtWindow *self = GYACHT_WINDOW (object);
+
+  if (self->idle_id)
+    {
+      g_source_remove (self->idle_id);
+      self->idle_id = 0;
+    }
+
+  G_OBJECT_CLASS (gyacht_window_parent_class)->dispose (object);
+}
+
 static void
 gyacht_window_class_init (GyachtWindowClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+  object_class->dispose = gyacht_window_dispose;
+
+  widget_class->realize = gyacht_window_realize;
+  widget_class->key_press_event = gyacht_window_key_press_event;
+
   /* Must calls before binding templates */
   g_type_ensure (GYACHT_TYPE_CONTAINER_LIST_VIEW);
-  g_type_ensure (GYACHT_TYPE_IMAGE_LIST_VIEW);
 
   gtk_widget_class_set_template_from_resource (widget_class,
                                                GYACHT_UI_PREFIX "gyacht-window.ui");
+  gtk_widget_class_bind_template_child (widget_class, GyachtWindow, stack);
+  gtk_widget_class_bind_template_child (widget_class, GyachtWindow, container_list_view);
+  gtk_widget_class_bind_template_child (widget_class, GyachtWindow, images_page);
 }
 
 static void
 gyacht_window_init (GyachtWindow *self)
 {
+  self->image_list_view = NULL;
+  self->idle_id = 0;
+
   gtk_widget_init_template (GTK_WIDGET (self));
+
+  g_signal_connect (self->stack,
+                    "notify::visible-child",
+                    G_CALLBACK (internal_visible_child_changed_cb),
+                    self);
 }
 
 GtkWidget *